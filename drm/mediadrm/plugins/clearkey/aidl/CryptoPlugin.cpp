@@ -136,7 +136,7 @@ using ::aidl::android::hardware::drm::Status;
 
         *_aidl_return = static_cast<ssize_t>(offset);
         return toNdkScopedAStatus(Status::OK);
-    } else if (in_args.mode == Mode::AES_CTR) {
+    } else if (in_args.mode == Mode::AES_CTR || in_args.mode == Mode::AES_CBC) {
         if (!mSession) return toNdkScopedAStatus(Status::ERROR_DRM_CANNOT_HANDLE,
                     "session not found");
         size_t bytesDecrypted{};
@@ -152,11 +152,19 @@ using ::aidl::android::hardware::drm::Status;
             return toNdkScopedAStatus(Status::ERROR_DRM_CANNOT_HANDLE, detailedError);
         }
 
-        auto res =
-                mSession->decrypt(in_args.keyId.data(), in_args.iv.data(),
-                                  srcPtr, static_cast<uint8_t*>(destPtr),
-                                  clearDataLengths, encryptedDataLengths,
-                                  &bytesDecrypted);
+        CdmResponseType res;
+        if (in_args.mode == Mode::AES_CTR) {
+            res = mSession->decrypt(in_args.keyId.data(), in_args.iv.data(),
+                                    srcPtr, static_cast<uint8_t*>(destPtr),
+                                    clearDataLengths, encryptedDataLengths,
+                                    &bytesDecrypted);
+        } else {
+            res = mSession->decryptCbcs(in_args.keyId.data(), in_args.iv.data(),
+                                        in_args.pattern.encryptBlocks, in_args.pattern.skipBlocks,
+                                        srcPtr, static_cast<uint8_t*>(destPtr),
+                                        clearDataLengths, encryptedDataLengths,
+                                        &bytesDecrypted);
+        }
         if (res == clearkeydrm::OK) {
             *_aidl_return = static_cast<ssize_t>(bytesDecrypted);
             return toNdkScopedAStatus(Status::OK);
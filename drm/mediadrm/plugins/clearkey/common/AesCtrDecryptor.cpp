@@ -17,14 +17,40 @@
 
 #include <utils/Log.h>
 
-#include <openssl/aes.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
 
 #include "AesCtrDecryptor.h"
 #include "ClearKeyTypes.h"
 
 namespace clearkeydrm {
 
-static const size_t kBlockBitCount = kBlockSize * 8;
+AesCtrDecryptor::AesCtrDecryptor()
+    : mCtrContext(EVP_CIPHER_CTX_new()), mCbcContext(EVP_CIPHER_CTX_new()) {}
+
+AesCtrDecryptor::~AesCtrDecryptor() {
+    EVP_CIPHER_CTX_free(mCtrContext);
+    EVP_CIPHER_CTX_free(mCbcContext);
+}
+
+bool AesCtrDecryptor::setKey(const std::vector<uint8_t>& key) {
+    if (mCtrContext == nullptr || mCbcContext == nullptr) {
+        return false;
+    }
+    if (key == mKey) {
+        return true;
+    }
+    mKey.clear();
+    if (EVP_DecryptInit_ex(mCtrContext, EVP_aes_128_ctr(), nullptr, key.data(), nullptr) != 1 ||
+        EVP_DecryptInit_ex(mCbcContext, EVP_aes_128_cbc(), nullptr, key.data(), nullptr) != 1 ||
+        EVP_CIPHER_CTX_set_padding(mCbcContext, 0) != 1) {
+        ALOGE("failed to set up AES key");
+        return false;
+    }
+    mKey = key;
+    return true;
+}
 
 CdmResponseType AesCtrDecryptor::decrypt(const std::vector<uint8_t>& key, const Iv iv,
                                          const uint8_t* source, uint8_t* destination,
@@ -37,31 +63,128 @@ CdmResponseType AesCtrDecryptor::decrypt(const std::vector<uint8_t>& key, const
         return clearkeydrm::ERROR_DECRYPT;
     }
 
-    uint32_t blockOffset = 0;
-    uint8_t previousEncryptedCounter[kBlockSize];
-    memset(previousEncryptedCounter, 0, kBlockSize);
+    if (!setKey(key)) {
+        return clearkeydrm::ERROR_DECRYPT;
+    }
+    // Only reloads the counter; the key schedule is kept.
+    if (EVP_DecryptInit_ex(mCtrContext, nullptr, nullptr, nullptr, iv) != 1) {
+        return clearkeydrm::ERROR_DECRYPT;
+    }
 
+    // The keystream runs on across subsamples, so encrypted ranges that are
+    // not separated by clear data are decrypted with one call.
     size_t offset = 0;
-    AES_KEY opensslKey;
-    AES_set_encrypt_key(key.data(), kBlockBitCount, &opensslKey);
-    Iv opensslIv;
-    memcpy(opensslIv, iv, sizeof(opensslIv));
+    size_t runStart = 0;
+    int runLength = 0;
+    auto flushRun = [&]() {
+        int outLength = 0;
+        if (runLength > 0 &&
+            (EVP_DecryptUpdate(mCtrContext, destination + runStart, &outLength,
+                               source + runStart, runLength) != 1 ||
+             outLength != runLength)) {
+            return false;
+        }
+        runLength = 0;
+        return true;
+    };
 
     for (size_t i = 0; i < clearDataLengths.size(); ++i) {
         int32_t numBytesOfClearData = clearDataLengths[i];
         if (numBytesOfClearData > 0) {
+            if (!flushRun()) {
+                return clearkeydrm::ERROR_DECRYPT;
+            }
             memcpy(destination + offset, source + offset, numBytesOfClearData);
             offset += numBytesOfClearData;
         }
 
         int32_t numBytesOfEncryptedData = encryptedDataLengths[i];
         if (numBytesOfEncryptedData > 0) {
-            AES_ctr128_encrypt(source + offset, destination + offset,
-                               numBytesOfEncryptedData, &opensslKey, opensslIv,
-                               previousEncryptedCounter, &blockOffset);
+            if (runLength > INT_MAX - numBytesOfEncryptedData && !flushRun()) {
+                return clearkeydrm::ERROR_DECRYPT;
+            }
+            if (runLength == 0) {
+                runStart = offset;
+            }
+            runLength += numBytesOfEncryptedData;
             offset += numBytesOfEncryptedData;
         }
     }
+    if (!flushRun()) {
+        return clearkeydrm::ERROR_DECRYPT;
+    }
+
+    *bytesDecryptedOut = offset;
+    return clearkeydrm::OK;
+}
+
+CdmResponseType AesCtrDecryptor::decryptCbcs(const std::vector<uint8_t>& key, const Iv iv,
+                                             int32_t encryptBlocks, int32_t skipBlocks,
+                                             const uint8_t* source, uint8_t* destination,
+                                             const std::vector<int32_t>& clearDataLengths,
+                                             const std::vector<int32_t>& encryptedDataLengths,
+                                             size_t* bytesDecryptedOut) {
+    if (key.size() != kBlockSize || clearDataLengths.size() != encryptedDataLengths.size()) {
+        android_errorWriteLog(0x534e4554, "63982768");
+        return clearkeydrm::ERROR_DECRYPT;
+    }
+
+    size_t encryptBytes = 0;
+    size_t skipBytes = 0;
+    if (encryptBlocks < 0 || skipBlocks < 0 ||
+        __builtin_mul_overflow(static_cast<size_t>(encryptBlocks), kBlockSize, &encryptBytes) ||
+        __builtin_mul_overflow(static_cast<size_t>(skipBlocks), kBlockSize, &skipBytes)) {
+        return clearkeydrm::BAD_VALUE;
+    }
+    if (encryptBytes == 0 && skipBytes == 0) {
+        encryptBytes = INT_MAX & ~static_cast<size_t>(kBlockSize - 1);
+    }
+
+    if (!setKey(key)) {
+        return clearkeydrm::ERROR_DECRYPT;
+    }
+
+    size_t offset = 0;
+    for (size_t i = 0; i < clearDataLengths.size(); ++i) {
+        int32_t numBytesOfClearData = clearDataLengths[i];
+        if (numBytesOfClearData > 0) {
+            memcpy(destination + offset, source + offset, numBytesOfClearData);
+            offset += numBytesOfClearData;
+        }
+
+        int32_t numBytesOfEncryptedData = encryptedDataLengths[i];
+        if (numBytesOfEncryptedData <= 0) {
+            continue;
+        }
+        if (EVP_DecryptInit_ex(mCbcContext, nullptr, nullptr, nullptr, iv) != 1) {
+            return clearkeydrm::ERROR_DECRYPT;
+        }
+        const uint8_t* src = source + offset;
+        uint8_t* dst = destination + offset;
+        size_t remaining = numBytesOfEncryptedData;
+        while (remaining >= kBlockSize) {
+            // Whole blocks of a truncated encrypted run are still encrypted.
+            size_t length = std::min(encryptBytes, remaining & ~static_cast<size_t>(kBlockSize - 1));
+            int outLength = 0;
+            if (length > 0 &&
+                (EVP_DecryptUpdate(mCbcContext, dst, &outLength, src,
+                                   static_cast<int>(length)) != 1 ||
+                 static_cast<size_t>(outLength) != length)) {
+                return clearkeydrm::ERROR_DECRYPT;
+            }
+            src += length;
+            dst += length;
+            remaining -= length;
+
+            length = std::min(skipBytes, remaining);
+            memcpy(dst, src, length);
+            src += length;
+            dst += length;
+            remaining -= length;
+        }
+        memcpy(dst, src, remaining);
+        offset += numBytesOfEncryptedData;
+    }
 
     *bytesDecryptedOut = offset;
     return clearkeydrm::OK;
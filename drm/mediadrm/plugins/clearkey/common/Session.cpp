@@ -55,6 +55,23 @@ CdmResponseType Session::provideKeyResponse(const std::vector<uint8_t>& response
     }
 }
 
+AesCtrDecryptor* Session::getDecryptor(const KeyId keyId, const std::vector<uint8_t>** key) {
+    std::vector<uint8_t> keyIdVector(keyId, keyId + kBlockSize);
+    auto itr = mKeyMap.find(keyIdVector);
+    if (itr == mKeyMap.end()) {
+        return nullptr;
+    }
+    *key = &itr->second;
+
+    // Keys are never replaced once provided, so the expanded key can be kept
+    // for the lifetime of the session.
+    std::unique_ptr<AesCtrDecryptor>& decryptor = mDecryptors[keyIdVector];
+    if (decryptor == nullptr) {
+        decryptor = std::make_unique<AesCtrDecryptor>();
+    }
+    return decryptor.get();
+}
+
 CdmResponseType Session::decrypt(const KeyId keyId, const Iv iv,
                                  const uint8_t* srcPtr, uint8_t* destPtr,
                                  const std::vector<int32_t>& clearDataLengths,
@@ -66,21 +83,39 @@ CdmResponseType Session::decrypt(const KeyId keyId, const Iv iv,
         return getMockError();
     }
 
-    std::vector<uint8_t> keyIdVector;
-    keyIdVector.clear();
-    keyIdVector.insert(keyIdVector.end(), keyId, keyId + kBlockSize);
-    std::map<std::vector<uint8_t>, std::vector<uint8_t>>::iterator itr;
-    itr = mKeyMap.find(keyIdVector);
-    if (itr == mKeyMap.end()) {
+    const std::vector<uint8_t>* key = nullptr;
+    AesCtrDecryptor* decryptor = getDecryptor(keyId, &key);
+    if (decryptor == nullptr) {
         return clearkeydrm::ERROR_NO_LICENSE;
     }
 
-    clearkeydrm::AesCtrDecryptor decryptor;
-    auto status = decryptor.decrypt(itr->second /*key*/, iv, srcPtr, destPtr,
-                                    clearDataLengths,
-                                    encryptedDataLengths,
-                                    bytesDecryptedOut);
+    auto status = decryptor->decrypt(*key, iv, srcPtr, destPtr,
+                                     clearDataLengths,
+                                     encryptedDataLengths,
+                                     bytesDecryptedOut);
     return status;
 }
 
+CdmResponseType Session::decryptCbcs(const KeyId keyId, const Iv iv,
+                                     int32_t encryptBlocks, int32_t skipBlocks,
+                                     const uint8_t* srcPtr, uint8_t* destPtr,
+                                     const std::vector<int32_t>& clearDataLengths,
+                                     const std::vector<int32_t>& encryptedDataLengths,
+                                     size_t* bytesDecryptedOut) {
+    Mutex::Autolock lock(mMapLock);
+
+    if (getMockError() != clearkeydrm::OK) {
+        return getMockError();
+    }
+
+    const std::vector<uint8_t>* key = nullptr;
+    AesCtrDecryptor* decryptor = getDecryptor(keyId, &key);
+    if (decryptor == nullptr) {
+        return clearkeydrm::ERROR_NO_LICENSE;
+    }
+
+    return decryptor->decryptCbcs(*key, iv, encryptBlocks, skipBlocks, srcPtr, destPtr,
+                                  clearDataLengths, encryptedDataLengths, bytesDecryptedOut);
+}
+
 }  // namespace clearkeydrm
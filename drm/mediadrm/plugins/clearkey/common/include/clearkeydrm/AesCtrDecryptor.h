@@ -17,13 +17,21 @@
 
 #include <cstdint>
 
+#include <openssl/evp.h>
+
 #include "ClearKeyTypes.h"
 
 namespace clearkeydrm {
 
+// Decrypts 'cenc' (AES-CTR) and 'cbcs' (AES-CBC with a block pattern) samples.
+//
+// The expanded key is kept in EVP cipher contexts between calls, so a decryptor
+// that is reused for the same key only pays for the key schedule once. Each
+// call runs all subsamples of a sample through a single context.
 class AesCtrDecryptor {
   public:
-    AesCtrDecryptor() {}
+    AesCtrDecryptor();
+    ~AesCtrDecryptor();
 
     CdmResponseType decrypt(const std::vector<uint8_t>& key, const Iv iv, const uint8_t* source,
                             uint8_t* destination,
@@ -31,8 +39,25 @@ class AesCtrDecryptor {
                             const std::vector<int32_t>& encryptedDataLengths,
                             size_t* bytesDecryptedOut);
 
+    // 'cbcs' decryption: within the encrypted part of each subsample,
+    // |encryptBlocks| 16-byte blocks are encrypted followed by |skipBlocks|
+    // clear ones, and a trailing partial block is clear. The IV is reset for
+    // every subsample. A 0:0 pattern means all whole blocks are encrypted.
+    CdmResponseType decryptCbcs(const std::vector<uint8_t>& key, const Iv iv,
+                                int32_t encryptBlocks, int32_t skipBlocks,
+                                const uint8_t* source, uint8_t* destination,
+                                const std::vector<int32_t>& clearDataLengths,
+                                const std::vector<int32_t>& encryptedDataLengths,
+                                size_t* bytesDecryptedOut);
+
   private:
     CLEARKEY_DISALLOW_COPY_AND_ASSIGN(AesCtrDecryptor);
+
+    bool setKey(const std::vector<uint8_t>& key);
+
+    std::vector<uint8_t> mKey;
+    EVP_CIPHER_CTX* mCtrContext;
+    EVP_CIPHER_CTX* mCbcContext;
 };
 
 }  // namespace clearkeydrm
@@ -19,8 +19,11 @@
 #include <utils/RefBase.h>
 
 #include <cstdint>
+#include <map>
+#include <memory>
 #include <vector>
 
+#include "AesCtrDecryptor.h"
 #include "ClearKeyTypes.h"
 
 namespace clearkeydrm {
@@ -45,14 +48,27 @@ class Session : public ::android::RefBase {
                             const std::vector<int32_t>& encryptedDataLengths,
                             size_t* bytesDecryptedOut);
 
+    CdmResponseType decryptCbcs(const KeyId keyId, const Iv iv,
+                                int32_t encryptBlocks, int32_t skipBlocks,
+                                const uint8_t* srcPtr, uint8_t* dstPtr,
+                                const std::vector<int32_t>& clearDataLengths,
+                                const std::vector<int32_t>& encryptedDataLengths,
+                                size_t* bytesDecryptedOut);
+
     void setMockError(CdmResponseType error) { mMockError = error; }
     CdmResponseType getMockError() const { return mMockError; }
 
   private:
     CLEARKEY_DISALLOW_COPY_AND_ASSIGN(Session);
 
+    // Returns the decryptor for |keyId| and its key, or nullptr if there is no
+    // such key. Called with mMapLock held.
+    AesCtrDecryptor* getDecryptor(const KeyId keyId, const std::vector<uint8_t>** key);
+
     const std::vector<uint8_t> mSessionId;
     KeyMap mKeyMap;
+    // Decryptors holding the expanded keys, by key id.
+    std::map<std::vector<uint8_t>, std::unique_ptr<AesCtrDecryptor>> mDecryptors;
     ::android::Mutex mMapLock;
 
     // For mocking error return scenarios
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <openssl/evp.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "AesCtrDecryptor.h"
+#include "Session.h"
+
+namespace clearkeydrm {
+
+namespace {
+
+// Test vectors from NIST-800-38A
+const std::vector<uint8_t> kKey = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+const uint8_t kPlaintext[64] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+    0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+    0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+    0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,
+    0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+};
+
+const Iv kCtrIv = {
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+    0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+};
+
+const uint8_t kCtrCiphertext[64] = {
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26,
+    0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+    0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff,
+    0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+    0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e,
+    0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+    0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1,
+    0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee
+};
+
+const Iv kCbcIv = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+const uint8_t kCbcCiphertext[64] = {
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46,
+    0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+    0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee,
+    0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+    0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b,
+    0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+    0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09,
+    0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7
+};
+
+// Encrypts one block with the raw cipher, for the reference encryptors below.
+void encryptBlock(const uint8_t* in, uint8_t* out) {
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    int outLength = 0;
+    EVP_EncryptInit_ex(ctx, EVP_aes_128_ecb(), nullptr, kKey.data(), nullptr);
+    EVP_CIPHER_CTX_set_padding(ctx, 0);
+    EVP_EncryptUpdate(ctx, out, &outLength, in, kBlockSize);
+    EVP_CIPHER_CTX_free(ctx);
+}
+
+// 'cenc': the encrypted parts of all subsamples form one keystream.
+std::vector<uint8_t> encryptCenc(const std::vector<uint8_t>& clear, const Iv iv,
+                                 const std::vector<int32_t>& clearLengths,
+                                 const std::vector<int32_t>& encryptedLengths) {
+    std::vector<uint8_t> out = clear;
+    uint8_t counter[kBlockSize];
+    uint8_t keystream[kBlockSize];
+    memcpy(counter, iv, kBlockSize);
+    size_t used = kBlockSize;
+    size_t offset = 0;
+    for (size_t i = 0; i < clearLengths.size(); ++i) {
+        offset += clearLengths[i];
+        for (int32_t j = 0; j < encryptedLengths[i]; ++j, ++offset) {
+            if (used == kBlockSize) {
+                encryptBlock(counter, keystream);
+                for (int k = kBlockSize - 1; k >= 0 && ++counter[k] == 0; --k) {
+                }
+                used = 0;
+            }
+            out[offset] ^= keystream[used++];
+        }
+    }
+    return out;
+}
+
+// 'cbcs': the IV restarts in every subsample and the chain skips clear blocks.
+std::vector<uint8_t> encryptCbcs(const std::vector<uint8_t>& clear, const Iv iv,
+                                 int32_t encryptBlocks, int32_t skipBlocks,
+                                 const std::vector<int32_t>& clearLengths,
+                                 const std::vector<int32_t>& encryptedLengths) {
+    std::vector<uint8_t> out = clear;
+    size_t offset = 0;
+    for (size_t i = 0; i < clearLengths.size(); ++i) {
+        offset += clearLengths[i];
+        uint8_t chain[kBlockSize];
+        memcpy(chain, iv, kBlockSize);
+        size_t numBlocks = encryptedLengths[i] / kBlockSize;
+        for (size_t block = 0; block < numBlocks; ++block) {
+            size_t period = encryptBlocks + skipBlocks;
+            if (period == 0 || block % period < (size_t)encryptBlocks) {
+                uint8_t* data = &out[offset + block * kBlockSize];
+                for (size_t k = 0; k < kBlockSize; ++k) {
+                    data[k] ^= chain[k];
+                }
+                encryptBlock(data, data);
+                memcpy(chain, data, kBlockSize);
+            }
+        }
+        offset += encryptedLengths[i];
+    }
+    return out;
+}
+
+std::vector<uint8_t> randomBytes(size_t size, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> bytes(size);
+    for (uint8_t& byte : bytes) {
+        byte = rng();
+    }
+    return bytes;
+}
+
+}  // namespace
+
+TEST(AesCtrDecryptorTest, DecryptsNistCtrVector) {
+    uint8_t destination[64] = {};
+    size_t bytesDecrypted = 0;
+    AesCtrDecryptor decryptor;
+    ASSERT_EQ(clearkeydrm::OK, decryptor.decrypt(kKey, kCtrIv, kCtrCiphertext, destination,
+                                                 {0}, {64}, &bytesDecrypted));
+    EXPECT_EQ(64u, bytesDecrypted);
+    EXPECT_EQ(0, memcmp(destination, kPlaintext, sizeof(kPlaintext)));
+}
+
+TEST(AesCtrDecryptorTest, DecryptsCtrVectorSplitAcrossSubsamples) {
+    // The keystream continues through partial blocks and empty subsamples.
+    uint8_t destination[64] = {};
+    size_t bytesDecrypted = 0;
+    AesCtrDecryptor decryptor;
+    ASSERT_EQ(clearkeydrm::OK,
+              decryptor.decrypt(kKey, kCtrIv, kCtrCiphertext, destination,
+                                {0, 0, 0, 0}, {7, 0, 29, 28}, &bytesDecrypted));
+    EXPECT_EQ(64u, bytesDecrypted);
+    EXPECT_EQ(0, memcmp(destination, kPlaintext, sizeof(kPlaintext)));
+}
+
+TEST(AesCtrDecryptorTest, DecryptsCencSubsamples) {
+    const std::vector<int32_t> clearLengths = {5, 0, 100, 0, 3000, 17};
+    const std::vector<int32_t> encryptedLengths = {33, 47, 0, 4096, 15, 1};
+    size_t total = 0;
+    for (size_t i = 0; i < clearLengths.size(); ++i) {
+        total += clearLengths[i] + encryptedLengths[i];
+    }
+    std::vector<uint8_t> clear = randomBytes(total, 1);
+    std::vector<uint8_t> encrypted =
+            encryptCenc(clear, kCtrIv, clearLengths, encryptedLengths);
+
+    AesCtrDecryptor decryptor;
+    for (int pass = 0; pass < 2; ++pass) {
+        std::vector<uint8_t> destination(total);
+        size_t bytesDecrypted = 0;
+        ASSERT_EQ(clearkeydrm::OK,
+                  decryptor.decrypt(kKey, kCtrIv, encrypted.data(), destination.data(),
+                                    clearLengths, encryptedLengths, &bytesDecrypted));
+        EXPECT_EQ(total, bytesDecrypted);
+        EXPECT_EQ(clear, destination) << "pass " << pass;
+    }
+}
+
+TEST(AesCtrDecryptorTest, DecryptsNistCbcVector) {
+    uint8_t destination[64] = {};
+    size_t bytesDecrypted = 0;
+    AesCtrDecryptor decryptor;
+    ASSERT_EQ(clearkeydrm::OK, decryptor.decryptCbcs(kKey, kCbcIv, 0, 0, kCbcCiphertext,
+                                                     destination, {0}, {64}, &bytesDecrypted));
+    EXPECT_EQ(64u, bytesDecrypted);
+    EXPECT_EQ(0, memcmp(destination, kPlaintext, sizeof(kPlaintext)));
+}
+
+TEST(AesCtrDecryptorTest, DecryptsCbcsPatterns) {
+    // The last encrypted range ends in a partial pattern and a partial block.
+    const std::vector<int32_t> clearLengths = {96, 0, 7, 2048};
+    const std::vector<int32_t> encryptedLengths = {1600, 15, 1000, 2059};
+    size_t total = 0;
+    for (size_t i = 0; i < clearLengths.size(); ++i) {
+        total += clearLengths[i] + encryptedLengths[i];
+    }
+    std::vector<uint8_t> clear = randomBytes(total, 2);
+
+    AesCtrDecryptor decryptor;
+    for (auto [encryptBlocks, skipBlocks] :
+         std::vector<std::pair<int32_t, int32_t>>{{1, 9}, {2, 8}, {5, 5}, {1, 0}, {0, 0}}) {
+        std::vector<uint8_t> encrypted = encryptCbcs(clear, kCbcIv, encryptBlocks, skipBlocks,
+                                                     clearLengths, encryptedLengths);
+        std::vector<uint8_t> destination(total);
+        size_t bytesDecrypted = 0;
+        ASSERT_EQ(clearkeydrm::OK,
+                  decryptor.decryptCbcs(kKey, kCbcIv, encryptBlocks, skipBlocks,
+                                        encrypted.data(), destination.data(),
+                                        clearLengths, encryptedLengths, &bytesDecrypted));
+        EXPECT_EQ(total, bytesDecrypted);
+        EXPECT_EQ(clear, destination) << encryptBlocks << ":" << skipBlocks;
+    }
+}
+
+TEST(AesCtrDecryptorTest, RejectsBadParameters) {
+    uint8_t destination[64] = {};
+    size_t bytesDecrypted = 0;
+    AesCtrDecryptor decryptor;
+    EXPECT_EQ(clearkeydrm::ERROR_DECRYPT,
+              decryptor.decrypt({}, kCtrIv, kCtrCiphertext, destination, {0}, {64},
+                                &bytesDecrypted));
+    EXPECT_EQ(clearkeydrm::ERROR_DECRYPT,
+              decryptor.decrypt(kKey, kCtrIv, kCtrCiphertext, destination, {0, 0}, {64},
+                                &bytesDecrypted));
+    EXPECT_EQ(clearkeydrm::BAD_VALUE,
+              decryptor.decryptCbcs(kKey, kCbcIv, -1, 9, kCbcCiphertext, destination, {0},
+                                    {64}, &bytesDecrypted));
+}
+
+TEST(AesCtrDecryptorTest, SwitchesKeys) {
+    std::vector<uint8_t> otherKey(kBlockSize, 0x42);
+    uint8_t destination[64] = {};
+    size_t bytesDecrypted = 0;
+    AesCtrDecryptor decryptor;
+    ASSERT_EQ(clearkeydrm::OK, decryptor.decrypt(otherKey, kCtrIv, kCtrCiphertext, destination,
+                                                 {0}, {64}, &bytesDecrypted));
+    EXPECT_NE(0, memcmp(destination, kPlaintext, sizeof(kPlaintext)));
+    ASSERT_EQ(clearkeydrm::OK, decryptor.decrypt(kKey, kCtrIv, kCtrCiphertext, destination,
+                                                 {0}, {64}, &bytesDecrypted));
+    EXPECT_EQ(0, memcmp(destination, kPlaintext, sizeof(kPlaintext)));
+}
+
+TEST(SessionTest, DecryptsWithProvidedKey) {
+    android::sp<Session> session = new Session({1, 2, 3});
+    // {"keys":[{"kty":"oct","kid":<00..0f>,"k":<kKey>}]}
+    const std::string response =
+            "{\"keys\":[{\"kty\":\"oct\",\"kid\":\"AAECAwQFBgcICQoLDA0ODw\","
+            "\"k\":\"K34VFiiu0qar9xWICc9PPA\"}]}";
+    ASSERT_EQ(clearkeydrm::OK, session->provideKeyResponse(
+            std::vector<uint8_t>(response.begin(), response.end())));
+
+    const KeyId keyId = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    const KeyId unknownKeyId = {};
+    uint8_t destination[64] = {};
+    size_t bytesDecrypted = 0;
+    EXPECT_EQ(clearkeydrm::ERROR_NO_LICENSE,
+              session->decrypt(unknownKeyId, kCtrIv, kCtrCiphertext, destination, {0}, {64},
+                               &bytesDecrypted));
+    for (int pass = 0; pass < 2; ++pass) {
+        memset(destination, 0, sizeof(destination));
+        ASSERT_EQ(clearkeydrm::OK,
+                  session->decrypt(keyId, kCtrIv, kCtrCiphertext, destination, {0}, {64},
+                                   &bytesDecrypted));
+        EXPECT_EQ(0, memcmp(destination, kPlaintext, sizeof(kPlaintext)));
+        memset(destination, 0, sizeof(destination));
+        ASSERT_EQ(clearkeydrm::OK,
+                  session->decryptCbcs(keyId, kCbcIv, 0, 0, kCbcCiphertext, destination, {0},
+                                       {64}, &bytesDecrypted));
+        EXPECT_EQ(0, memcmp(destination, kPlaintext, sizeof(kPlaintext)));
+    }
+}
+
+}  // namespace clearkeydrm
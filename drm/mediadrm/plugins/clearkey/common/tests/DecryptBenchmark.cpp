@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Decrypt throughput of the ClearKey decryptor on samples shaped like video
+ * access units: a short clear header per NAL unit followed by the encrypted
+ * slice data. The argument is the sample size in bytes.
+ *
+ * BM_DecryptCenc and BM_DecryptCbcs reuse one decryptor, as a session does;
+ * BM_DecryptCencNewDecryptor creates one per sample to show the cost of
+ * expanding the key every time.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "AesCtrDecryptor.h"
+
+using namespace clearkeydrm;
+
+namespace {
+
+const std::vector<uint8_t> kKey(kBlockSize, 0x3c);
+const Iv kIv = {};
+
+// Subsample layout of one sample of |size| bytes split into NAL units of
+// about 16 KB, each with a 5 byte clear header.
+void makeSubsamples(size_t size, std::vector<int32_t>* clearLengths,
+                    std::vector<int32_t>* encryptedLengths) {
+    const size_t kNalSize = 16384;
+    const int32_t kHeaderSize = 5;
+    for (size_t offset = 0; offset < size; offset += kNalSize) {
+        size_t nalSize = std::min(kNalSize, size - offset);
+        clearLengths->push_back(std::min<int32_t>(kHeaderSize, nalSize));
+        encryptedLengths->push_back(nalSize - clearLengths->back());
+    }
+}
+
+template <bool kNewDecryptor>
+void BM_DecryptCenc(benchmark::State& state) {
+    std::vector<uint8_t> source(state.range(0), 0xa5);
+    std::vector<uint8_t> destination(source.size());
+    std::vector<int32_t> clearLengths, encryptedLengths;
+    makeSubsamples(source.size(), &clearLengths, &encryptedLengths);
+
+    AesCtrDecryptor decryptor;
+    for (auto _ : state) {
+        size_t bytesDecrypted = 0;
+        CdmResponseType res;
+        if (kNewDecryptor) {
+            AesCtrDecryptor newDecryptor;
+            res = newDecryptor.decrypt(kKey, kIv, source.data(), destination.data(),
+                                       clearLengths, encryptedLengths, &bytesDecrypted);
+        } else {
+            res = decryptor.decrypt(kKey, kIv, source.data(), destination.data(),
+                                    clearLengths, encryptedLengths, &bytesDecrypted);
+        }
+        if (res != clearkeydrm::OK) {
+            state.SkipWithError("decrypt failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+void BM_DecryptCbcs(benchmark::State& state) {
+    std::vector<uint8_t> source(state.range(0), 0xa5);
+    std::vector<uint8_t> destination(source.size());
+    std::vector<int32_t> clearLengths, encryptedLengths;
+    makeSubsamples(source.size(), &clearLengths, &encryptedLengths);
+
+    AesCtrDecryptor decryptor;
+    for (auto _ : state) {
+        size_t bytesDecrypted = 0;
+        // 1:9 is the pattern used for video.
+        if (decryptor.decryptCbcs(kKey, kIv, 1, 9, source.data(), destination.data(),
+                                  clearLengths, encryptedLengths,
+                                  &bytesDecrypted) != clearkeydrm::OK) {
+            state.SkipWithError("decrypt failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+// From a small audio frame up to a large 4K key frame.
+void sampleSizes(benchmark::internal::Benchmark* b) {
+    for (int size : {1 << 10, 16 << 10, 256 << 10, 2 << 20}) {
+        b->Arg(size);
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_DecryptCenc, false)->Apply(sampleSizes);
+BENCHMARK_TEMPLATE(BM_DecryptCenc, true)->Name("BM_DecryptCencNewDecryptor")->Apply(sampleSizes);
+BENCHMARK(BM_DecryptCbcs)->Apply(sampleSizes);
+
+}  // namespace
+
+BENCHMARK_MAIN();
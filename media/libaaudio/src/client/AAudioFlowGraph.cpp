@@ -20,6 +20,7 @@
 
 #include "AAudioFlowGraph.h"
 
+#include <flowgraph/FusedFilter.h>
 #include <flowgraph/Limiter.h>
 #include <flowgraph/ManyToMultiConverter.h>
 #include <flowgraph/MonoBlend.h>
@@ -52,18 +53,22 @@ aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
           __func__, sourceFormat, sourceChannelCount, sinkFormat, sinkChannelCount,
           useMonoBlend, audioBalance, isExclusive);
 
+    // The per channel volume ramps of exclusive streams are pulled 8 frames at a time,
+    // so larger blocks only help shared streams.
+    const int32_t framesPerBuffer = isExclusive ? kDefaultBufferSize : kFusedBufferSize;
+
     switch (sourceFormat) {
         case AUDIO_FORMAT_PCM_FLOAT:
-            mSource = std::make_unique<SourceFloat>(sourceChannelCount);
+            mSource = std::make_unique<SourceFloat>(sourceChannelCount, framesPerBuffer);
             break;
         case AUDIO_FORMAT_PCM_16_BIT:
-            mSource = std::make_unique<SourceI16>(sourceChannelCount);
+            mSource = std::make_unique<SourceI16>(sourceChannelCount, framesPerBuffer);
             break;
         case AUDIO_FORMAT_PCM_24_BIT_PACKED:
-            mSource = std::make_unique<SourceI24>(sourceChannelCount);
+            mSource = std::make_unique<SourceI24>(sourceChannelCount, framesPerBuffer);
             break;
         case AUDIO_FORMAT_PCM_32_BIT:
-            mSource = std::make_unique<SourceI32>(sourceChannelCount);
+            mSource = std::make_unique<SourceI32>(sourceChannelCount, framesPerBuffer);
             break;
         default:
             ALOGE("%s() Unsupported source format = %d", __func__, sourceFormat);
@@ -71,23 +76,32 @@ aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
     }
     lastOutput = &mSource->output;
 
+    // The filters that work sample by sample are run by one FusedFilter.
+    std::vector<FlowGraphFilter *> fusedFilters;
+
     if (useMonoBlend) {
         mMonoBlend = std::make_unique<MonoBlend>(sourceChannelCount);
-        lastOutput->connect(&mMonoBlend->input);
-        lastOutput = &mMonoBlend->output;
+        fusedFilters.push_back(mMonoBlend.get());
     }
 
     // For a pure float graph, there is chance that the data range may be very large.
     // So we should limit to a reasonable value that allows a little headroom.
     if (sourceFormat == AUDIO_FORMAT_PCM_FLOAT && sinkFormat == AUDIO_FORMAT_PCM_FLOAT) {
         mLimiter = std::make_unique<Limiter>(sourceChannelCount);
-        lastOutput->connect(&mLimiter->input);
-        lastOutput = &mLimiter->output;
+        fusedFilters.push_back(mLimiter.get());
+    }
+
+    if (!fusedFilters.empty()) {
+        mFusedFilter = std::make_unique<FusedFilter>(sourceChannelCount,
+                std::move(fusedFilters), framesPerBuffer);
+        lastOutput->connect(&mFusedFilter->input);
+        lastOutput = &mFusedFilter->output;
     }
 
     // Expand the number of channels if required.
     if (sourceChannelCount == 1 && sinkChannelCount > 1) {
-        mChannelConverter = std::make_unique<MonoToMultiConverter>(sinkChannelCount);
+        mChannelConverter = std::make_unique<MonoToMultiConverter>(sinkChannelCount,
+                framesPerBuffer);
         lastOutput->connect(&mChannelConverter->input);
         lastOutput = &mChannelConverter->output;
     } else if (sourceChannelCount != sinkChannelCount) {
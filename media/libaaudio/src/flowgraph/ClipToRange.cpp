@@ -26,13 +26,16 @@ ClipToRange::ClipToRange(int32_t channelCount)
 }
 
 int32_t ClipToRange::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
+    processBlock(input.getBuffer(), output.getBuffer(), numFrames);
+    return numFrames;
+}
 
+void ClipToRange::processBlock(const float *inputBuffer, float *outputBuffer,
+                               int32_t numFrames) {
+    const float minimum = mMinimum;
+    const float maximum = mMaximum;
     int32_t numSamples = numFrames * output.getSamplesPerFrame();
     for (int32_t i = 0; i < numSamples; i++) {
-        *outputBuffer++ = std::min(mMaximum, std::max(mMinimum, *inputBuffer++));
+        outputBuffer[i] = std::min(maximum, std::max(minimum, inputBuffer[i]));
     }
-
-    return numFrames;
 }
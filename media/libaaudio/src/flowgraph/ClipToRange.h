@@ -38,6 +38,12 @@ public:
 
     int32_t onProcess(int32_t numFrames) override;
 
+    bool isFusible() const override {
+        return true;
+    }
+
+    void processBlock(const float *inputBuffer, float *outputBuffer, int32_t numFrames) override;
+
     void setMinimum(float min) {
         mMinimum = min;
     }
@@ -229,8 +229,10 @@ private:
   */
 class FlowGraphPortFloatOutput : public FlowGraphPortFloat {
 public:
-    FlowGraphPortFloatOutput(FlowGraphNode &parent, int32_t samplesPerFrame)
-            : FlowGraphPortFloat(parent, samplesPerFrame) {
+    FlowGraphPortFloatOutput(FlowGraphNode &parent,
+                             int32_t samplesPerFrame,
+                             int32_t framesPerBuffer = kDefaultBufferSize)
+            : FlowGraphPortFloat(parent, samplesPerFrame, framesPerBuffer) {
     }
 
     virtual ~FlowGraphPortFloatOutput() = default;
@@ -347,8 +349,9 @@ private:
  */
 class FlowGraphSource : public FlowGraphNode {
 public:
-    explicit FlowGraphSource(int32_t channelCount)
-            : output(*this, channelCount) {
+    explicit FlowGraphSource(int32_t channelCount,
+                             int32_t framesPerBuffer = kDefaultBufferSize)
+            : output(*this, channelCount, framesPerBuffer) {
     }
 
     virtual ~FlowGraphSource() = default;
@@ -365,8 +368,9 @@ public:
  */
 class FlowGraphSourceBuffered : public FlowGraphSource {
 public:
-    explicit FlowGraphSourceBuffered(int32_t channelCount)
-            : FlowGraphSource(channelCount) {}
+    explicit FlowGraphSourceBuffered(int32_t channelCount,
+                                     int32_t framesPerBuffer = kDefaultBufferSize)
+            : FlowGraphSource(channelCount, framesPerBuffer) {}
 
     virtual ~FlowGraphSourceBuffered() = default;
 
@@ -434,13 +438,39 @@ protected:
  */
 class FlowGraphFilter : public FlowGraphNode {
 public:
-    explicit FlowGraphFilter(int32_t channelCount)
+    explicit FlowGraphFilter(int32_t channelCount,
+                             int32_t framesPerBuffer = kDefaultBufferSize)
             : input(*this, channelCount)
-            , output(*this, channelCount) {
+            , output(*this, channelCount, framesPerBuffer) {
     }
 
     virtual ~FlowGraphFilter() = default;
 
+    /**
+     * A filter is fusible if each output frame only depends on the same input frame
+     * and on the state of the filter, so that it can process a block of any size in place.
+     * Consecutive fusible filters can be run as one node by a FusedFilter.
+     *
+     * @return true if processBlock() is implemented
+     */
+    virtual bool isFusible() const {
+        return false;
+    }
+
+    /**
+     * Process frames without using the ports. Only called if isFusible().
+     *
+     * @param inputBuffer numFrames frames of input
+     * @param outputBuffer numFrames frames of output, may be the same as inputBuffer
+     * @param numFrames number of frames to process, may be more than the port buffers hold
+     */
+    virtual void processBlock(const float *inputBuffer, float *outputBuffer, int32_t numFrames) {
+        (void) inputBuffer;
+        (void) outputBuffer;
+        (void) numFrames;
+        assert(false);
+    }
+
     FlowGraphPortFloatInput input;
     FlowGraphPortFloatOutput output;
 };
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include "FlowGraphNode.h"
+#include "FusedFilter.h"
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+FusedFilter::FusedFilter(int32_t channelCount,
+                         std::vector<FlowGraphFilter *> filters,
+                         int32_t framesPerBuffer)
+        : FlowGraphFilter(channelCount, framesPerBuffer)
+        , mFilters(std::move(filters)) {
+    for (FlowGraphFilter *filter : mFilters) {
+        assert(filter->isFusible());
+        assert(filter->output.getSamplesPerFrame() == channelCount);
+        (void) filter;
+    }
+}
+
+int32_t FusedFilter::onProcess(int32_t numFrames) {
+    processBlock(input.getBuffer(), output.getBuffer(), numFrames);
+    return numFrames;
+}
+
+void FusedFilter::processBlock(const float *inputBuffer, float *outputBuffer,
+                               int32_t numFrames) {
+    if (mFilters.empty()) {
+        if (inputBuffer != outputBuffer) {
+            memcpy(outputBuffer, inputBuffer,
+                   numFrames * output.getSamplesPerFrame() * sizeof(float));
+        }
+        return;
+    }
+    for (FlowGraphFilter *filter : mFilters) {
+        filter->processBlock(inputBuffer, outputBuffer, numFrames);
+        inputBuffer = outputBuffer; // the other filters run in place
+    }
+}
+
+void FusedFilter::reset() {
+    FlowGraphFilter::reset();
+    for (FlowGraphFilter *filter : mFilters) {
+        filter->reset();
+    }
+}
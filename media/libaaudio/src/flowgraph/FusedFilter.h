@@ -0,0 +1,84 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOWGRAPH_FUSED_FILTER_H
+#define FLOWGRAPH_FUSED_FILTER_H
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <vector>
+
+#include "FlowGraphNode.h"
+
+namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
+
+// Default block size of a FusedFilter.
+// The whole chain runs on one block, so it should stay in the L1 cache.
+// 64 frames of 8 channels is 2 KiB.
+constexpr int kFusedBufferSize = 64;
+
+/**
+ * Run a chain of fusible filters, see FlowGraphFilter::isFusible(), as a single node.
+ *
+ * Connected as separate nodes, each filter would pull its input, write a block to
+ * its own output buffer and have it read back by the next filter.
+ * A FusedFilter pulls its input once per block, runs the first filter into its
+ * output buffer and the other filters in place on that buffer.
+ * It can also use larger blocks than the filters' own ports.
+ *
+ * The filters must not be connected to other nodes. They are not owned by the FusedFilter.
+ */
+class FusedFilter : public FlowGraphFilter {
+public:
+    /**
+     * @param channelCount of the filters
+     * @param filters in processing order, each one must be fusible
+     * @param framesPerBuffer block size
+     */
+    FusedFilter(int32_t channelCount,
+                std::vector<FlowGraphFilter *> filters,
+                int32_t framesPerBuffer = kFusedBufferSize);
+
+    virtual ~FusedFilter() = default;
+
+    int32_t onProcess(int32_t numFrames) override;
+
+    bool isFusible() const override {
+        return true;
+    }
+
+    void processBlock(const float *inputBuffer, float *outputBuffer, int32_t numFrames) override;
+
+    /**
+     * Also reset the fused filters.
+     */
+    void reset() override;
+
+    const char *getName() override {
+        return "FusedFilter";
+    }
+
+    const std::vector<FlowGraphFilter *> &getFilters() const {
+        return mFilters;
+    }
+
+private:
+    const std::vector<FlowGraphFilter *> mFilters;
+};
+
+} /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
+
+#endif //FLOWGRAPH_FUSED_FILTER_H
@@ -27,41 +27,46 @@ Limiter::Limiter(int32_t channelCount)
 }
 
 int32_t Limiter::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
+    processBlock(input.getBuffer(), output.getBuffer(), numFrames);
+    return numFrames;
+}
 
+void Limiter::processBlock(const float *inputBuffer, float *outputBuffer, int32_t numFrames) {
     int32_t numSamples = numFrames * output.getSamplesPerFrame();
 
-    // Cache the last valid output to reduce memory read/write
-    float lastValidOutput = mLastValidOutput;
-
+    // The samples are independent here so that the loop can be vectorized.
+    // NaN inputs are passed through and replaced below.
+    int32_t numNaN = 0;
     for (int32_t i = 0; i < numSamples; i++) {
-        // Use the previous output if the input is NaN
-        if (!isnan(*inputBuffer)) {
-            lastValidOutput = processFloat(*inputBuffer);
+        const float out = processFloat(inputBuffer[i]);
+        numNaN += isnan(out);
+        outputBuffer[i] = out;
+    }
+
+    // Use the previous output if the input is NaN
+    float lastValidOutput = mLastValidOutput;
+    if (numNaN > 0) {
+        for (int32_t i = 0; i < numSamples; i++) {
+            if (isnan(outputBuffer[i])) {
+                outputBuffer[i] = lastValidOutput;
+            } else {
+                lastValidOutput = outputBuffer[i];
+            }
         }
-        inputBuffer++;
-        *outputBuffer++ = lastValidOutput;
+    } else if (numSamples > 0) {
+        lastValidOutput = outputBuffer[numSamples - 1];
     }
     mLastValidOutput = lastValidOutput;
-
-    return numFrames;
 }
 
 float Limiter::processFloat(float in)
 {
+    // Selects rather than branches, so that processBlock() can be vectorized.
+    // A NaN input gives a NaN output.
     float in_abs = fabsf(in);
-    if (in_abs <= 1) {
-        return in;
-    }
-    float out;
-    if (in_abs < kXWhenYis3Decibels) {
-        out = (kPolynomialSplineA * in_abs + kPolynomialSplineB) * in_abs + kPolynomialSplineC;
-    } else {
-        out = M_SQRT2;
-    }
-    if (in < 0) {
-        out = -out;
-    }
-    return out;
+    float spline = (kPolynomialSplineA * in_abs + kPolynomialSplineB) * in_abs
+            + kPolynomialSplineC;
+    float out = in_abs >= kXWhenYis3Decibels ? (float) M_SQRT2 : spline;
+    out = in_abs <= 1 ? in_abs : out;
+    return copysignf(out, in);
 }
@@ -31,6 +31,12 @@ public:
 
     int32_t onProcess(int32_t numFrames) override;
 
+    bool isFusible() const override {
+        return true;
+    }
+
+    void processBlock(const float *inputBuffer, float *outputBuffer, int32_t numFrames) override;
+
     const char *getName() override {
         return "Limiter";
     }
@@ -52,6 +58,7 @@ private:
      * If between -kXWhenYis3Decibels and -1, use the absolute value for the spline and flip it.
      * The derivative of the spline is 1 at 1 and 0 at kXWhenYis3Decibels.
      * This way, the graph is both continuous and differentiable.
+     * If NaN, return NaN.
      */
     float processFloat(float in);
 
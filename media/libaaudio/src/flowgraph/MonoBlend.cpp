@@ -27,20 +27,32 @@ MonoBlend::MonoBlend(int32_t channelCount)
 }
 
 int32_t MonoBlend::onProcess(int32_t numFrames) {
+    processBlock(input.getBuffer(), output.getBuffer(), numFrames);
+    return numFrames;
+}
+
+void MonoBlend::processBlock(const float *inputBuffer, float *outputBuffer, int32_t numFrames) {
     int32_t channelCount = output.getSamplesPerFrame();
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
 
-    for (size_t i = 0; i < numFrames; ++i) {
+    // Each frame is read before it is written, so this also works in place.
+    if (channelCount == 2) { // the common case, with a loop that can be vectorized
+        for (int32_t i = 0; i < numFrames; ++i) {
+            // same rounding as the generic loop, which starts from 0
+            float accum = (0.0f + inputBuffer[2 * i]) + inputBuffer[2 * i + 1];
+            accum *= mInvChannelCount;
+            outputBuffer[2 * i] = accum;
+            outputBuffer[2 * i + 1] = accum;
+        }
+        return;
+    }
+    for (int32_t i = 0; i < numFrames; ++i) {
         float accum = 0;
-        for (size_t j = 0; j < channelCount; ++j) {
+        for (int32_t j = 0; j < channelCount; ++j) {
             accum += *inputBuffer++;
         }
         accum *= mInvChannelCount;
-        for (size_t j = 0; j < channelCount; ++j) {
+        for (int32_t j = 0; j < channelCount; ++j) {
             *outputBuffer++ = accum;
         }
     }
-
-    return numFrames;
 }
@@ -36,6 +36,12 @@ public:
 
     int32_t onProcess(int32_t numFrames) override;
 
+    bool isFusible() const override {
+        return true;
+    }
+
+    void processBlock(const float *inputBuffer, float *outputBuffer, int32_t numFrames) override;
+
     const char *getName() override {
         return "MonoBlend";
     }
@@ -30,7 +30,8 @@ namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
  */
 class MonoToMultiConverter : public FlowGraphNode {
 public:
-    explicit MonoToMultiConverter(int32_t outputChannelCount);
+    explicit MonoToMultiConverter(int32_t outputChannelCount,
+                                  int32_t framesPerBuffer = kDefaultBufferSize);
 
     virtual ~MonoToMultiConverter() = default;
 
@@ -33,7 +33,7 @@ void RampLinear::setLengthInFrames(int32_t frames) {
 void RampLinear::setTarget(float target) {
     mTarget.store(target);
     // If the ramp has not been used then start immediately at this level.
-    if (mLastCallCount == kInitialCallCount) {
+    if (!mStarted) {
         forceCurrent(target);
     }
 }
@@ -43,10 +43,14 @@ float RampLinear::interpolateCurrent() {
 }
 
 int32_t RampLinear::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
+    processBlock(input.getBuffer(), output.getBuffer(), numFrames);
+    return numFrames;
+}
+
+void RampLinear::processBlock(const float *inputBuffer, float *outputBuffer, int32_t numFrames) {
     int32_t channelCount = output.getSamplesPerFrame();
 
+    mStarted = true;
     float target = getTarget();
     if (target != mLevelTo) {
         // Start new ramp. Continue from previous level.
@@ -72,10 +76,14 @@ int32_t RampLinear::onProcess(int32_t numFrames) {
     }
 
     // Process any frames after the ramp.
+    const float level = mLevelTo;
     int32_t samplesLeft = framesLeft * channelCount;
     for (int i = 0; i < samplesLeft; i++) {
-        *outputBuffer++ = *inputBuffer++ * mLevelTo;
+        outputBuffer[i] = inputBuffer[i] * level;
     }
+}
 
-    return numFrames;
+void RampLinear::reset() {
+    FlowGraphFilter::reset();
+    mStarted = false;
 }
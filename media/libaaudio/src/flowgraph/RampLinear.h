@@ -41,6 +41,12 @@ public:
 
     int32_t onProcess(int32_t numFrames) override;
 
+    bool isFusible() const override {
+        return true;
+    }
+
+    void processBlock(const float *inputBuffer, float *outputBuffer, int32_t numFrames) override;
+
     /**
      * This is used for the next ramp.
      * Calling this does not affect a ramp that is in progress.
@@ -78,6 +84,8 @@ public:
         return "RampLinear";
     }
 
+    void reset() override;
+
 private:
 
     float interpolateCurrent();
@@ -89,6 +97,7 @@ private:
     float               mScaler          = 0.0f;
     float               mLevelFrom       = 0.0f;
     float               mLevelTo         = 0.0f;
+    bool                mStarted         = false; // processed since the last reset()
 };
 
 } /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
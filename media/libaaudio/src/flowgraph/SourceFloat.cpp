@@ -21,8 +21,8 @@
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
 
-SourceFloat::SourceFloat(int32_t channelCount)
-        : FlowGraphSourceBuffered(channelCount) {
+SourceFloat::SourceFloat(int32_t channelCount, int32_t framesPerBuffer)
+        : FlowGraphSourceBuffered(channelCount, framesPerBuffer) {
 }
 
 int32_t SourceFloat::onProcess(int32_t numFrames) {
@@ -29,7 +29,7 @@ namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
  */
 class SourceFloat : public FlowGraphSourceBuffered {
 public:
-    explicit SourceFloat(int32_t channelCount);
+    explicit SourceFloat(int32_t channelCount, int32_t framesPerBuffer = kDefaultBufferSize);
     ~SourceFloat() override = default;
 
     int32_t onProcess(int32_t numFrames) override;
@@ -26,8 +26,8 @@
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
 
-SourceI16::SourceI16(int32_t channelCount)
-        : FlowGraphSourceBuffered(channelCount) {
+SourceI16::SourceI16(int32_t channelCount, int32_t framesPerBuffer)
+        : FlowGraphSourceBuffered(channelCount, framesPerBuffer) {
 }
 
 int32_t SourceI16::onProcess(int32_t numFrames) {
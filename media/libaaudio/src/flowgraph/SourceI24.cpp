@@ -28,8 +28,8 @@ using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
 
 constexpr int kBytesPerI24Packed = 3;
 
-SourceI24::SourceI24(int32_t channelCount)
-        : FlowGraphSourceBuffered(channelCount) {
+SourceI24::SourceI24(int32_t channelCount, int32_t framesPerBuffer)
+        : FlowGraphSourceBuffered(channelCount, framesPerBuffer) {
 }
 
 int32_t SourceI24::onProcess(int32_t numFrames) {
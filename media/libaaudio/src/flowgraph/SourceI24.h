@@ -29,7 +29,7 @@ namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
  */
 class SourceI24 : public FlowGraphSourceBuffered {
 public:
-    explicit SourceI24(int32_t channelCount);
+    explicit SourceI24(int32_t channelCount, int32_t framesPerBuffer = kDefaultBufferSize);
 
     int32_t onProcess(int32_t numFrames) override;
 
@@ -25,7 +25,7 @@ namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
 
 class SourceI32 : public FlowGraphSourceBuffered {
 public:
-    explicit SourceI32(int32_t channelCount);
+    explicit SourceI32(int32_t channelCount, int32_t framesPerBuffer = kDefaultBufferSize);
     ~SourceI32() override = default;
 
     int32_t onProcess(int32_t numFrames) override;
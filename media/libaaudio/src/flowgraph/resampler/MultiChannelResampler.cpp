@@ -119,6 +119,54 @@ void MultiChannelResampler::writeFrame(const float *frame) {
     }
 }
 
+void MultiChannelResampler::convolve(const float *xFrame,
+                                     const float *coefficients,
+                                     float *sums) const {
+    const int32_t channelCount = getChannelCount();
+    int32_t channel = 0;
+    for (; channel + 8 <= channelCount; channel += 8) {
+        convolveBlock<8>(&xFrame[channel], coefficients, mNumTaps, channelCount, &sums[channel]);
+    }
+    if (channel + 4 <= channelCount) {
+        convolveBlock<4>(&xFrame[channel], coefficients, mNumTaps, channelCount, &sums[channel]);
+        channel += 4;
+    }
+    if (channel + 2 <= channelCount) {
+        convolveBlock<2>(&xFrame[channel], coefficients, mNumTaps, channelCount, &sums[channel]);
+        channel += 2;
+    }
+    if (channel < channelCount) {
+        convolveBlock<1>(&xFrame[channel], coefficients, mNumTaps, channelCount, &sums[channel]);
+    }
+}
+
+void MultiChannelResampler::convolve2(const float *xFrame,
+                                      const float *coefficientsLow,
+                                      const float *coefficientsHigh,
+                                      float *sumsLow,
+                                      float *sumsHigh) const {
+    const int32_t channelCount = getChannelCount();
+    int32_t channel = 0;
+    for (; channel + 8 <= channelCount; channel += 8) {
+        convolveBlock2<8>(&xFrame[channel], coefficientsLow, coefficientsHigh,
+                          mNumTaps, channelCount, &sumsLow[channel], &sumsHigh[channel]);
+    }
+    if (channel + 4 <= channelCount) {
+        convolveBlock2<4>(&xFrame[channel], coefficientsLow, coefficientsHigh,
+                          mNumTaps, channelCount, &sumsLow[channel], &sumsHigh[channel]);
+        channel += 4;
+    }
+    if (channel + 2 <= channelCount) {
+        convolveBlock2<2>(&xFrame[channel], coefficientsLow, coefficientsHigh,
+                          mNumTaps, channelCount, &sumsLow[channel], &sumsHigh[channel]);
+        channel += 2;
+    }
+    if (channel < channelCount) {
+        convolveBlock2<1>(&xFrame[channel], coefficientsLow, coefficientsHigh,
+                          mNumTaps, channelCount, &sumsLow[channel], &sumsHigh[channel]);
+    }
+}
+
 float MultiChannelResampler::sinc(float radians) {
     if (abs(radians) < 1.0e-9) return 1.0f;   // avoid divide by zero
     return sinf(radians) / radians;   // Sinc function
@@ -244,6 +244,82 @@ protected:
         return mIntegerPhase;
     }
 
+    /**
+     * Run the FIR on a block of CHANNELS channels starting at xFrame.
+     * The sums are kept in local arrays so that the compiler can hold them in
+     * registers and convert the loop over channels to SIMD.
+     * Each channel is summed in tap order, like the scalar code.
+     *
+     * @param xFrame first sample of the block in the delay line
+     * @param coefficients numTaps coefficients
+     * @param numTaps number of taps
+     * @param stride samples between successive taps, the channel count
+     * @param sums CHANNELS results
+     */
+    template <int CHANNELS>
+    static void convolveBlock(const float *xFrame,
+                              const float *coefficients,
+                              int32_t numTaps,
+                              int32_t stride,
+                              float *sums) {
+        float acc[CHANNELS] = {};
+        for (int32_t tap = 0; tap < numTaps; tap++) {
+            const float coefficient = coefficients[tap];
+            for (int channel = 0; channel < CHANNELS; channel++) {
+                acc[channel] += xFrame[channel] * coefficient;
+            }
+            xFrame += stride;
+        }
+        for (int channel = 0; channel < CHANNELS; channel++) {
+            sums[channel] = acc[channel];
+        }
+    }
+
+    /**
+     * Like convolveBlock() but run two sets of coefficients on the same input,
+     * for interpolating between rows of the coefficient table.
+     */
+    template <int CHANNELS>
+    static void convolveBlock2(const float *xFrame,
+                               const float *coefficientsLow,
+                               const float *coefficientsHigh,
+                               int32_t numTaps,
+                               int32_t stride,
+                               float *sumsLow,
+                               float *sumsHigh) {
+        float accLow[CHANNELS] = {};
+        float accHigh[CHANNELS] = {};
+        for (int32_t tap = 0; tap < numTaps; tap++) {
+            const float coefficientLow = coefficientsLow[tap];
+            const float coefficientHigh = coefficientsHigh[tap];
+            for (int channel = 0; channel < CHANNELS; channel++) {
+                const float sample = xFrame[channel];
+                accLow[channel] += sample * coefficientLow;
+                accHigh[channel] += sample * coefficientHigh;
+            }
+            xFrame += stride;
+        }
+        for (int channel = 0; channel < CHANNELS; channel++) {
+            sumsLow[channel] = accLow[channel];
+            sumsHigh[channel] = accHigh[channel];
+        }
+    }
+
+    /**
+     * Run the FIR on every channel of the frame at xFrame,
+     * in blocks of 8, 4, 2 and 1 channels.
+     */
+    void convolve(const float *xFrame, const float *coefficients, float *sums) const;
+
+    /**
+     * Run two sets of coefficients on every channel of the frame at xFrame.
+     */
+    void convolve2(const float *xFrame,
+                   const float *coefficientsLow,
+                   const float *coefficientsHigh,
+                   float *sumsLow,
+                   float *sumsHigh) const;
+
     static constexpr int kMaxCoefficients = 8 * 1024;
     std::vector<float>   mCoefficients;
 
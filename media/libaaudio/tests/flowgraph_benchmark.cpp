@@ -0,0 +1,117 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Benchmark of the flowgraph with the fusible filters
+ * (MonoBlend, Limiter, RampLinear and ClipToRange) as separate nodes or fused.
+ *
+ * BM_FlowGraphSeparate connects the filters as separate nodes.
+ * BM_FlowGraphFused runs them in a FusedFilter with the default 8 frame blocks,
+ * BM_FlowGraphFusedBlock64 also uses larger blocks, as AAudioFlowGraph does.
+ *
+ * Arguments are the channel count and the burst size in frames,
+ * the number of frames converted per call as for one AAudio burst.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "flowgraph/ClipToRange.h"
+#include "flowgraph/FusedFilter.h"
+#include "flowgraph/Limiter.h"
+#include "flowgraph/MonoBlend.h"
+#include "flowgraph/RampLinear.h"
+#include "flowgraph/SinkI16.h"
+#include "flowgraph/SourceFloat.h"
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+namespace {
+
+class FusibleGraph {
+public:
+    FusibleGraph(int32_t channelCount, bool fused, int32_t framesPerBuffer)
+            : source(channelCount, framesPerBuffer)
+            , monoBlend(channelCount)
+            , limiter(channelCount)
+            , ramp(channelCount)
+            , clipper(channelCount)
+            , sink(channelCount) {
+        if (fused) {
+            fusedFilter = std::make_unique<FusedFilter>(channelCount,
+                    std::vector<FlowGraphFilter *>{&monoBlend, &limiter, &ramp, &clipper},
+                    framesPerBuffer);
+            source.output.connect(&fusedFilter->input);
+            fusedFilter->output.connect(&sink.input);
+        } else {
+            source.output.connect(&monoBlend.input);
+            monoBlend.output.connect(&limiter.input);
+            limiter.output.connect(&ramp.input);
+            ramp.output.connect(&clipper.input);
+            clipper.output.connect(&sink.input);
+        }
+        ramp.setTarget(0.5f);
+    }
+
+    SourceFloat source;
+    MonoBlend monoBlend;
+    Limiter limiter;
+    RampLinear ramp;
+    ClipToRange clipper;
+    std::unique_ptr<FusedFilter> fusedFilter;
+    SinkI16 sink;
+};
+
+template <bool kFused, int kFramesPerBuffer>
+void BM_FlowGraph(benchmark::State& state) {
+    const int32_t channelCount = state.range(0);
+    const int32_t burstFrames = state.range(1);
+    std::vector<float> input(burstFrames * channelCount);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = (i % 97) * (2.0f / 97) - 1.0f;
+    }
+    std::vector<int16_t> output(burstFrames * channelCount);
+    FusibleGraph graph(channelCount, kFused, kFramesPerBuffer);
+
+    for (auto _ : state) {
+        graph.source.setData(input.data(), burstFrames);
+        graph.sink.read(output.data(), burstFrames);
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * burstFrames);
+}
+
+void flowGraphArgs(benchmark::internal::Benchmark* b) {
+    for (int channelCount : {1, 2, 8}) {
+        for (int burstFrames : {32, 96, 192, 480, 960}) {
+            b->Args({channelCount, burstFrames});
+        }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_FlowGraph, false, kDefaultBufferSize)
+        ->Name("BM_FlowGraphSeparate")->Apply(flowGraphArgs);
+BENCHMARK_TEMPLATE(BM_FlowGraph, true, kDefaultBufferSize)
+        ->Name("BM_FlowGraphFused")->Apply(flowGraphArgs);
+BENCHMARK_TEMPLATE(BM_FlowGraph, true, kFusedBufferSize)
+        ->Name("BM_FlowGraphFusedBlock64")->Apply(flowGraphArgs);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Benchmark of the MultiChannelResampler.
+ *
+ * Each iteration produces one 10 msec buffer of output frames and
+ * reports output frames per second.
+ *
+ * Arguments are the channel count, the quality and the input and output rates.
+ * Ratios with a small reduced denominator use the polyphase resamplers,
+ * the others, such as 44100 to 44101, use the sinc resamplers.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "flowgraph/resampler/MultiChannelResampler.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+static void BM_MultiChannelResampler(benchmark::State& state) {
+    const int32_t channelCount = state.range(0);
+    const auto quality = static_cast<MultiChannelResampler::Quality>(state.range(1));
+    const int32_t inputRate = state.range(2);
+    const int32_t outputRate = state.range(3);
+    const int32_t numOutputFrames = outputRate / 100;
+
+    std::unique_ptr<MultiChannelResampler> resampler(MultiChannelResampler::make(
+            channelCount, inputRate, outputRate, quality));
+    std::vector<float> inputFrame(channelCount);
+    std::vector<float> output(static_cast<size_t>(numOutputFrames) * channelCount);
+    for (int32_t channel = 0; channel < channelCount; channel++) {
+        inputFrame[channel] = 0.1f * (channel + 1);
+    }
+
+    for (auto _ : state) {
+        float *outputFrame = output.data();
+        int32_t framesLeft = numOutputFrames;
+        while (framesLeft > 0) {
+            if (resampler->isWriteNeeded()) {
+                inputFrame[0] = -inputFrame[0];
+                resampler->writeNextFrame(inputFrame.data());
+            } else {
+                resampler->readNextFrame(outputFrame);
+                outputFrame += channelCount;
+                framesLeft--;
+            }
+        }
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * numOutputFrames);
+}
+
+static void resamplerArgs(benchmark::internal::Benchmark* b) {
+    constexpr int32_t kRates[][2] = {
+        {44100, 48000},
+        {48000, 44100},
+        {16000, 48000},
+        {96000, 48000},
+        {48000, 96000},
+        {44100, 44101}, // sinc
+    };
+    for (int32_t channelCount : {1, 2, 6, 8, 12}) {
+        for (auto quality : {MultiChannelResampler::Quality::Medium,
+                             MultiChannelResampler::Quality::High,
+                             MultiChannelResampler::Quality::Best}) {
+            for (const auto& rates : kRates) {
+                b->Args({channelCount, static_cast<int32_t>(quality), rates[0], rates[1]});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_MultiChannelResampler)->Apply(resamplerArgs);
+
+BENCHMARK_MAIN();
@@ -21,11 +21,15 @@
  * sometimes that have caused compiler bugs.
  */
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include "flowgraph/ClipToRange.h"
+#include "flowgraph/FusedFilter.h"
 #include "flowgraph/Limiter.h"
 #include "flowgraph/MonoBlend.h"
 #include "flowgraph/MonoToMultiConverter.h"
@@ -394,3 +398,77 @@ TEST(test_flowgraph, module_limiter_nan) {
         EXPECT_NEAR(expected[i], output[i], tolerance);
     }
 }
+
+// MonoBlend, Limiter, RampLinear and ClipToRange, as separate nodes or fused.
+struct FusibleChain {
+    FusibleChain(int32_t channelCount, bool fused)
+            : source(channelCount, fused ? kFusedBufferSize : kDefaultBufferSize)
+            , monoBlend(channelCount)
+            , limiter(channelCount)
+            , ramp(channelCount)
+            , clipper(channelCount)
+            , sink(channelCount) {
+        if (fused) {
+            fusedFilter = std::make_unique<FusedFilter>(channelCount,
+                    std::vector<FlowGraphFilter *>{&monoBlend, &limiter, &ramp, &clipper});
+            source.output.connect(&fusedFilter->input);
+            fusedFilter->output.connect(&sink.input);
+        } else {
+            source.output.connect(&monoBlend.input);
+            monoBlend.output.connect(&limiter.input);
+            limiter.output.connect(&ramp.input);
+            ramp.output.connect(&clipper.input);
+            clipper.output.connect(&sink.input);
+        }
+    }
+
+    SourceFloat source;
+    MonoBlend monoBlend;
+    Limiter limiter;
+    RampLinear ramp;
+    ClipToRange clipper;
+    std::unique_ptr<FusedFilter> fusedFilter;
+    SinkFloat sink;
+};
+
+TEST(test_flowgraph, module_fused_filter) {
+    constexpr int numChannels = 2;
+    constexpr int numFrames = 300;
+    constexpr int rampSize = 50;
+    constexpr float rampTarget = 2.5f;
+
+    float input[numFrames * numChannels];
+    for (int i = 0; i < numFrames * numChannels; i++) {
+        input[i] = 3.0f * sinf(i * 0.05f);
+    }
+    input[17] = NAN;
+    input[18] = NAN;
+
+    FusibleChain separate{numChannels, false /* fused */};
+    FusibleChain fused{numChannels, true /* fused */};
+    for (FusibleChain *chain : {&separate, &fused}) {
+        chain->ramp.setLengthInFrames(rampSize);
+        chain->ramp.setTarget(0.5f);
+        chain->clipper.setMaximum(1.0f);
+        chain->source.setData(input, numFrames);
+    }
+
+    float expected[numFrames * numChannels];
+    float output[numFrames * numChannels];
+
+    // Start a ramp in the middle, on the same frame in both chains.
+    constexpr int firstRead = 100;
+    ASSERT_EQ(firstRead, separate.sink.read(expected, firstRead));
+    ASSERT_EQ(firstRead, fused.sink.read(output, firstRead));
+    separate.ramp.setTarget(rampTarget);
+    fused.ramp.setTarget(rampTarget);
+    constexpr int secondRead = numFrames - firstRead;
+    ASSERT_EQ(secondRead, separate.sink.read(&expected[firstRead * numChannels], secondRead));
+    ASSERT_EQ(secondRead, fused.sink.read(&output[firstRead * numChannels], secondRead));
+
+    for (int i = 0; i < numFrames * numChannels; i++) {
+        EXPECT_EQ(expected[i], output[i]) << "sample " << i;
+    }
+    // The ramp ran and the output was clipped.
+    EXPECT_EQ(1.0f, *std::max_element(std::begin(output), std::end(output)));
+}
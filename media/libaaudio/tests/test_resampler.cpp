@@ -22,6 +22,8 @@
  */
 
 #include <iostream>
+#include <math.h>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -219,3 +221,72 @@ TEST(test_resampler, resampler_48000_44100_best) {
 TEST(test_resampler, resampler_44100_11025_best) {
     checkResampler(44100, 11025, MultiChannelResampler::Quality::Best);
 }
+
+/**
+ * Resample a multichannel signal with a different sine wave in each channel
+ * and check that each channel matches a mono resampler run on that channel alone.
+ * This covers the channel blocking in the polyphase and sinc FIR.
+ */
+static void checkMultiChannelResampler(int32_t channelCount,
+        int32_t sourceRate, int32_t sinkRate,
+        MultiChannelResampler::Quality quality) {
+    const int kNumInputFrames = 2000;
+
+    std::vector<float> input(static_cast<size_t>(kNumInputFrames) * channelCount);
+    for (int frame = 0; frame < kNumInputFrames; frame++) {
+        for (int channel = 0; channel < channelCount; channel++) {
+            input[frame * channelCount + channel] =
+                    sinf(frame * 0.01f * (channel + 1)) * (1.0f - 0.03f * channel);
+        }
+    }
+
+    auto resample = [&](int32_t numChannels, int32_t channelOffset) {
+        std::unique_ptr<MultiChannelResampler> mcResampler(MultiChannelResampler::make(
+                numChannels, sourceRate, sinkRate, quality));
+        std::vector<float> frameIn(numChannels);
+        std::vector<float> frameOut(numChannels);
+        std::vector<float> output;
+        int inputFrame = 0;
+        while (inputFrame < kNumInputFrames) {
+            if (mcResampler->isWriteNeeded()) {
+                for (int channel = 0; channel < numChannels; channel++) {
+                    frameIn[channel] = input[inputFrame * channelCount
+                                             + channelOffset + channel];
+                }
+                mcResampler->writeNextFrame(frameIn.data());
+                inputFrame++;
+            } else {
+                mcResampler->readNextFrame(frameOut.data());
+                output.insert(output.end(), frameOut.begin(), frameOut.end());
+            }
+        }
+        return output;
+    };
+
+    const std::vector<float> multiOutput = resample(channelCount, 0);
+    const size_t numFrames = multiOutput.size() / channelCount;
+    ASSERT_GT(numFrames, 0);
+    for (int channel = 0; channel < channelCount; channel++) {
+        const std::vector<float> monoOutput = resample(1, channel);
+        ASSERT_EQ(numFrames, monoOutput.size());
+        for (size_t frame = 0; frame < numFrames; frame++) {
+            ASSERT_NEAR(monoOutput[frame], multiOutput[frame * channelCount + channel], 1e-5)
+                    << "channel " << channel << ", frame " << frame;
+        }
+    }
+}
+
+TEST(test_resampler, resampler_multichannel_polyphase) {
+    for (int32_t channelCount : {3, 4, 6, 8, 13, 16}) {
+        checkMultiChannelResampler(channelCount, 44100, 48000,
+                                   MultiChannelResampler::Quality::High);
+    }
+}
+
+TEST(test_resampler, resampler_multichannel_sinc) {
+    // 48000 to 44101 has too many phases for the polyphase table.
+    for (int32_t channelCount : {3, 4, 6, 8, 13, 16}) {
+        checkMultiChannelResampler(channelCount, 48000, 44101,
+                                   MultiChannelResampler::Quality::Medium);
+    }
+}
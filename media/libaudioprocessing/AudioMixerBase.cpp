@@ -26,8 +26,10 @@
 #include <cutils/compiler.h>
 #include <media/AudioMixerBase.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 
 #include "AudioMixerOps.h"
+#include "AudioMixerWorkerPool.h"
 
 // The FCC_2 macro refers to the Fixed Channel Count of 2 for the legacy integer mixer.
 #ifndef FCC_2
@@ -52,10 +54,29 @@
 // TODO: remove BLOCKSIZE unit of processing - it isn't needed anymore.
 static constexpr int BLOCKSIZE = 16;
 
+// Parallel resampling falls back to serial after this many consecutive cycles over
+// budget, for kResampleSerialCycles cycles.
+static constexpr int kResampleOverBudgetLimit = 3;
+static constexpr int kResampleSerialCycles = 1000;
+
 namespace android {
 
 // ----------------------------------------------------------------------------
 
+AudioMixerBase::~AudioMixerBase() = default;
+
+void AudioMixerBase::setResampleThreads(size_t threadCount, int64_t budgetNs)
+{
+    const size_t current = mResamplePool != nullptr ? mResamplePool->threadCount() : 0;
+    if (threadCount != current) {
+        mResamplePool.reset(threadCount > 0 ? new AudioMixerWorkerPool(threadCount) : nullptr);
+        invalidate(); // allocates the track buffers.
+    }
+    mResampleBudgetNs = budgetNs;
+    mResampleOverBudgetCycles = 0;
+    mResampleSerialCycles = 0;
+}
+
 bool AudioMixerBase::isValidFormat(audio_format_t format) const
 {
     switch (format) {
@@ -713,6 +734,16 @@ void AudioMixerBase::process__validate()
             if (mResampleTemp.get() == nullptr) {
                 mResampleTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
             }
+            if (mResamplePool != nullptr) {
+                for (const int name : mEnabled) {
+                    const std::shared_ptr<TrackBase> &t = mTracks[name];
+                    if (t->doesResample() && t->mParallelOut.get() == nullptr) {
+                        t->mParallelOut.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+                        t->mParallelTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+                    }
+                }
+                mParallelTracks.reserve(mEnabled.size());
+            }
             mHook = &AudioMixerBase::process__genericResampling;
         } else {
             // we keep temp arrays around.
@@ -1090,6 +1121,97 @@ void AudioMixerBase::process__nop()
     }
 }
 
+bool AudioMixerBase::TrackBase::isFusedMix() const
+{
+    // Float stereo tracks mixed with one volume per channel; MIXTYPE_MULTI and
+    // MIXTYPE_MULTI_STEREOVOL are the same for two channels.
+    return (needs & NEEDS_AUX) == 0
+            && mMixerChannelCount == FCC_2
+            && (hook == (hook_t) &TrackBase::track__NoResample<
+                            MIXTYPE_MULTI, float /*TO*/, float /*TI*/, TYPE_AUX>
+                    || hook == (hook_t) &TrackBase::track__NoResample<
+                            MIXTYPE_MULTI_STEREOVOL, float /*TO*/, float /*TI*/, TYPE_AUX>);
+}
+
+/* Mixes the tracks of a group for which isFusedMix() is true into out, up to
+ * kMaxFusedTracks tracks per pass over out, with volumeRampMultiTrack().
+ * The track hooks would instead read and write out once per track.
+ *
+ * The track buffers must have been acquired. framesLeft is the number of frames
+ * left to mix in this process call, and is requested when a buffer runs out.
+ */
+void AudioMixerBase::mixFusedTracks(const std::vector<int>& group, float* out,
+        size_t frameCount, size_t framesLeft)
+{
+    static constexpr size_t kMaxFusedTracks = 16;
+    TrackBase* tracks[kMaxFusedTracks];
+    MixTrack<float, float> mix[kMaxFusedTracks];
+    bool ramp[kMaxFusedTracks];
+
+    for (auto it = group.begin(); it != group.end(); ) {
+        size_t count = 0;
+        for (; it != group.end() && count < kMaxFusedTracks; ++it) {
+            TrackBase* t = mTracks[*it].get();
+            // t->mIn == nullptr can happen if the track was flushed just after having
+            // been enabled for mixing.
+            if (t->isFusedMix() && t->mIn != nullptr) {
+                tracks[count++] = t;
+            }
+        }
+
+        for (size_t done = 0; count > 0 && done < frameCount; ) {
+            // get the next buffer of the tracks that used up theirs, keeping track order.
+            size_t kept = 0;
+            for (size_t i = 0; i < count; ++i) {
+                TrackBase* t = tracks[i];
+                if (t->frameCount == 0) {
+                    t->bufferProvider->releaseBuffer(&t->buffer);
+                    t->buffer.frameCount = framesLeft - done;
+                    t->bufferProvider->getNextBuffer(&t->buffer);
+                    t->mIn = t->buffer.raw;
+                    if (t->mIn == nullptr) {
+                        continue;
+                    }
+                    t->frameCount = t->buffer.frameCount;
+                }
+                tracks[kept++] = t;
+            }
+            count = kept;
+            if (count == 0) {
+                break;
+            }
+
+            size_t frames = frameCount - done;
+            for (size_t i = 0; i < count; ++i) {
+                frames = std::min(frames, (size_t)tracks[i]->frameCount);
+            }
+            for (size_t i = 0; i < count; ++i) {
+                TrackBase* t = tracks[i];
+                ramp[i] = t->needsRamp();
+                mix[i].in = static_cast<const float*>(t->mIn);
+                for (int j = 0; j < FCC_2; ++j) {
+                    mix[i].vol[j] = ramp[i] ? t->mPrevVolume[j] : t->mVolume[j];
+                    mix[i].volinc[j] = ramp[i] ? t->mVolumeInc[j] : 0.f;
+                }
+            }
+
+            volumeRampMultiTrack<FCC_2>(out + done * FCC_2, frames, mix, count);
+
+            for (size_t i = 0; i < count; ++i) {
+                TrackBase* t = tracks[i];
+                t->mIn = mix[i].in;
+                t->frameCount -= frames;
+                if (ramp[i]) {
+                    t->mPrevVolume[0] = mix[i].vol[0];
+                    t->mPrevVolume[1] = mix[i].vol[1];
+                    t->adjustVolumeRamp(false /* aux */, true /* useFloat */);
+                }
+            }
+            done += frames;
+        }
+    }
+}
+
 // generic code without resampling
 void AudioMixerBase::process__genericNoResampling()
 {
@@ -1115,8 +1237,13 @@ void AudioMixerBase::process__genericNoResampling()
         do {
             const size_t frameCount = std::min((size_t)BLOCKSIZE, mFrameCount - numFrames);
             memset(outTemp, 0, sizeof(outTemp));
+            mixFusedTracks(group, reinterpret_cast<float*>(outTemp), frameCount,
+                    mFrameCount - numFrames);
             for (const int name : group) {
                 const std::shared_ptr<TrackBase> &t = mTracks[name];
+                if (t->isFusedMix()) {
+                    continue;
+                }
                 int32_t *aux = NULL;
                 if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
                     aux = t->auxBuffer + numFrames;
@@ -1170,6 +1297,50 @@ void AudioMixerBase::process__genericNoResampling()
     }
 }
 
+/* Resamples the tracks of group that can run on the resample pool, each into its
+ * mParallelOut buffer. Returns false if the group is to be resampled serially.
+ */
+bool AudioMixerBase::resampleInParallel(const std::vector<int>& group)
+{
+    if (mResamplePool == nullptr || mResampleSerialCycles > 0) {
+        return false;
+    }
+    mParallelTracks.clear();
+    for (const int name : group) {
+        TrackBase* t = mTracks[name].get();
+        // aux buffers may be shared by several tracks.
+        if ((t->needs & (NEEDS_RESAMPLE | NEEDS_AUX)) == NEEDS_RESAMPLE
+                && t->mParallelOut.get() != nullptr) {
+            mParallelTracks.push_back(t);
+        }
+    }
+    if (mParallelTracks.size() < 2) {
+        return false;
+    }
+
+    const nsecs_t start = systemTime();
+    mResamplePool->run(mParallelTracks.size(), [this](size_t i) {
+        TrackBase* t = mParallelTracks[i];
+        int32_t* out = t->mParallelOut.get();
+        memset(out, 0, mFrameCount * t->mMixerChannelCount * sizeof(*out));
+        (t->*t->hook)(out, mFrameCount, t->mParallelTemp.get(), nullptr /* aux */);
+    });
+    const nsecs_t elapsed = systemTime() - start;
+
+    if (mResampleBudgetNs > 0 && elapsed > mResampleBudgetNs) {
+        if (++mResampleOverBudgetCycles >= kResampleOverBudgetLimit) {
+            ALOGW("%s: %zu tracks took %lld ns, over the %lld ns budget, resampling serially",
+                    __func__, mParallelTracks.size(), (long long)elapsed,
+                    (long long)mResampleBudgetNs);
+            mResampleOverBudgetCycles = 0;
+            mResampleSerialCycles = kResampleSerialCycles;
+        }
+    } else {
+        mResampleOverBudgetCycles = 0;
+    }
+    return true;
+}
+
 // generic code with resampling
 void AudioMixerBase::process__genericResampling()
 {
@@ -1177,14 +1348,45 @@ void AudioMixerBase::process__genericResampling()
     int32_t * const outTemp = mOutputTemp.get(); // naked ptr
     size_t numFrames = mFrameCount;
 
+    if (mResampleSerialCycles > 0) {
+        --mResampleSerialCycles;
+    }
+
     for (const auto &pair : mGroups) {
         const auto &group = pair.second;
         const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
+        const bool parallel = resampleInParallel(group);
 
         // clear temp buffer
         memset(outTemp, 0, sizeof(*outTemp) * t1->mMixerChannelCount * mFrameCount);
+
+        // the fused tracks are mixed together, the others one at a time below.
+        bool fused = false;
+        for (const int name : group) {
+            const std::shared_ptr<TrackBase> &t = mTracks[name];
+            if (t->isFusedMix()) {
+                t->buffer.frameCount = numFrames;
+                t->bufferProvider->getNextBuffer(&t->buffer);
+                t->frameCount = t->buffer.frameCount;
+                t->mIn = t->buffer.raw;
+                fused = true;
+            }
+        }
+        if (fused) {
+            mixFusedTracks(group, reinterpret_cast<float*>(outTemp), numFrames, numFrames);
+            for (const int name : group) {
+                const std::shared_ptr<TrackBase> &t = mTracks[name];
+                if (t->isFusedMix()) {
+                    t->bufferProvider->releaseBuffer(&t->buffer);
+                }
+            }
+        }
+
         for (const int name : group) {
             const std::shared_ptr<TrackBase> &t = mTracks[name];
+            if (t->isFusedMix()) {
+                continue;
+            }
             int32_t *aux = NULL;
             if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
                 aux = t->auxBuffer;
@@ -1193,7 +1395,17 @@ void AudioMixerBase::process__genericResampling()
             // this is a little goofy, on the resampling case we don't
             // acquire/release the buffers because it's done by
             // the resampler.
-            if (t->needs & NEEDS_RESAMPLE) {
+            if (parallel && (t->needs & (NEEDS_RESAMPLE | NEEDS_AUX)) == NEEDS_RESAMPLE
+                    && t->mParallelOut.get() != nullptr) {
+                // already resampled by resampleInParallel(), add in track order.
+                const size_t sampleCount = numFrames * t->mMixerChannelCount;
+                if (t->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT) {
+                    accumulate_float(reinterpret_cast<float*>(outTemp),
+                            reinterpret_cast<const float*>(t->mParallelOut.get()), sampleCount);
+                } else {
+                    accumulate_i32(outTemp, t->mParallelOut.get(), sampleCount);
+                }
+            } else if (t->needs & NEEDS_RESAMPLE) {
                 (t.get()->*t->hook)(outTemp, numFrames, mResampleTemp.get() /* naked ptr */, aux);
             } else {
 
@@ -17,10 +17,18 @@
 #ifndef ANDROID_AUDIO_MIXER_OPS_H
 #define ANDROID_AUDIO_MIXER_OPS_H
 
+#include <algorithm>
+
 #include <audio_utils/channels.h>
 #include <audio_utils/primitives.h>
 #include <system/audio.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 namespace android {
 
 // Hack to make static_assert work in a constexpr
@@ -604,6 +612,181 @@ inline void volumeMulti(TO* out, size_t frameCount,
     }
 }
 
+
+/*
+ * MixTrack is one input track of volumeRampMultiTrack.
+ *
+ *   in:     NCHAN interleaved input channels, advanced past the frames mixed.
+ *   vol:    per channel volume, ramped in place.
+ *   volinc: per frame volume increment, zero for a constant volume.
+ */
+template <typename TI, typename TV>
+struct MixTrack {
+    const TI* in;
+    TV vol[2];
+    TV volinc[2];
+};
+
+/*
+ * volumeRampMultiTrack accumulates trackCount tracks into the out pointer as
+ * MIXTYPE_MULTI does (NCHAN <= 2, one volume per channel), but in a single pass
+ * over out: a tile of output frames is loaded once, every track is added to it
+ * and it is stored once, rather than reading and writing out once per track.
+ *
+ * Tracks are added in order, so the scalar version gives the same result as
+ * calling volumeRampMulti<MIXTYPE_MULTI> for each track in turn. The NEON and
+ * AVX2 versions for stereo float compute the ramp as vol + n * volinc across
+ * the vector rather than by repeated addition, so a ramped volume may differ
+ * from the scalar one in the last bits.
+ */
+template <int NCHAN, typename TO, typename TI, typename TV>
+inline void volumeRampMultiTrackScalar(TO* out, size_t frameCount,
+        MixTrack<TI, TV>* tracks, size_t trackCount)
+{
+    static_assert(NCHAN > 0 && NCHAN <= 2);
+    constexpr size_t TILE_FRAMES = 16;
+    TO tile[TILE_FRAMES * NCHAN];
+
+    while (frameCount > 0) {
+        const size_t frames = std::min(frameCount, TILE_FRAMES);
+        std::copy(out, out + frames * NCHAN, tile);
+        for (size_t t = 0; t < trackCount; ++t) {
+            MixTrack<TI, TV>& track = tracks[t];
+            TO* acc = tile;
+            for (size_t f = 0; f < frames; ++f) {
+                for (int i = 0; i < NCHAN; ++i) {
+                    *acc++ += MixMul<TO, TI, TV>(*track.in++, track.vol[i]);
+                    track.vol[i] += track.volinc[i];
+                }
+            }
+        }
+        std::copy(tile, tile + frames * NCHAN, out);
+        out += frames * NCHAN;
+        frameCount -= frames;
+    }
+}
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+
+// Stereo float, 8 frames (4 vectors) per tile.
+inline void volumeRampMultiTrackStereoNeon(float* out, size_t frameCount,
+        MixTrack<float, float>* tracks, size_t trackCount)
+{
+    constexpr size_t TILE_FRAMES = 8;
+    static const float32x4_t ramp0 = {0.f, 0.f, 1.f, 1.f}; // frame index of each lane
+
+    for (; frameCount >= TILE_FRAMES; frameCount -= TILE_FRAMES) {
+        float32x4_t acc0 = vld1q_f32(out);
+        float32x4_t acc1 = vld1q_f32(out + 4);
+        float32x4_t acc2 = vld1q_f32(out + 8);
+        float32x4_t acc3 = vld1q_f32(out + 12);
+        for (size_t t = 0; t < trackCount; ++t) {
+            MixTrack<float, float>& track = tracks[t];
+            const float32x2_t volLR = vld1_f32(track.vol);
+            const float32x2_t volincLR = vld1_f32(track.volinc);
+            const float32x4_t volinc = vcombine_f32(volincLR, volincLR);
+            const float32x4_t step = vaddq_f32(volinc, volinc);
+            const float32x4_t vol0 = vaddq_f32(vcombine_f32(volLR, volLR),
+                    vmulq_f32(volinc, ramp0));
+            const float32x4_t vol1 = vaddq_f32(vol0, step);
+            const float32x4_t vol2 = vaddq_f32(vol1, step);
+            const float32x4_t vol3 = vaddq_f32(vol2, step);
+            const float* in = track.in;
+            acc0 = vaddq_f32(acc0, vmulq_f32(vld1q_f32(in), vol0));
+            acc1 = vaddq_f32(acc1, vmulq_f32(vld1q_f32(in + 4), vol1));
+            acc2 = vaddq_f32(acc2, vmulq_f32(vld1q_f32(in + 8), vol2));
+            acc3 = vaddq_f32(acc3, vmulq_f32(vld1q_f32(in + 12), vol3));
+            track.in = in + TILE_FRAMES * 2;
+            vst1_f32(track.vol, vadd_f32(volLR, vmul_n_f32(volincLR, float(TILE_FRAMES))));
+        }
+        vst1q_f32(out, acc0);
+        vst1q_f32(out + 4, acc1);
+        vst1q_f32(out + 8, acc2);
+        vst1q_f32(out + 12, acc3);
+        out += TILE_FRAMES * 2;
+    }
+    if (frameCount > 0) {
+        volumeRampMultiTrackScalar<2>(out, frameCount, tracks, trackCount);
+    }
+}
+
+#elif defined(__x86_64__) || defined(__i386__)
+
+// Stereo float, 16 frames (4 vectors) per tile.
+__attribute__((target("avx2")))
+inline void volumeRampMultiTrackStereoAvx2(float* out, size_t frameCount,
+        MixTrack<float, float>* tracks, size_t trackCount)
+{
+    constexpr size_t TILE_FRAMES = 16;
+    const __m256 ramp0 = _mm256_setr_ps(0.f, 0.f, 1.f, 1.f, 2.f, 2.f, 3.f, 3.f);
+    const __m256 stepFrames = _mm256_set1_ps(4.f);
+
+    for (; frameCount >= TILE_FRAMES; frameCount -= TILE_FRAMES) {
+        __m256 acc0 = _mm256_loadu_ps(out);
+        __m256 acc1 = _mm256_loadu_ps(out + 8);
+        __m256 acc2 = _mm256_loadu_ps(out + 16);
+        __m256 acc3 = _mm256_loadu_ps(out + 24);
+        for (size_t t = 0; t < trackCount; ++t) {
+            MixTrack<float, float>& track = tracks[t];
+            const __m256 vol = _mm256_setr_ps(track.vol[0], track.vol[1], track.vol[0],
+                    track.vol[1], track.vol[0], track.vol[1], track.vol[0], track.vol[1]);
+            const __m256 volinc = _mm256_setr_ps(track.volinc[0], track.volinc[1],
+                    track.volinc[0], track.volinc[1], track.volinc[0], track.volinc[1],
+                    track.volinc[0], track.volinc[1]);
+            const __m256 step = _mm256_mul_ps(volinc, stepFrames);
+            const __m256 vol0 = _mm256_add_ps(vol, _mm256_mul_ps(volinc, ramp0));
+            const __m256 vol1 = _mm256_add_ps(vol0, step);
+            const __m256 vol2 = _mm256_add_ps(vol1, step);
+            const __m256 vol3 = _mm256_add_ps(vol2, step);
+            const float* in = track.in;
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(in), vol0));
+            acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(in + 8), vol1));
+            acc2 = _mm256_add_ps(acc2, _mm256_mul_ps(_mm256_loadu_ps(in + 16), vol2));
+            acc3 = _mm256_add_ps(acc3, _mm256_mul_ps(_mm256_loadu_ps(in + 24), vol3));
+            track.in = in + TILE_FRAMES * 2;
+            track.vol[0] += track.volinc[0] * TILE_FRAMES;
+            track.vol[1] += track.volinc[1] * TILE_FRAMES;
+        }
+        _mm256_storeu_ps(out, acc0);
+        _mm256_storeu_ps(out + 8, acc1);
+        _mm256_storeu_ps(out + 16, acc2);
+        _mm256_storeu_ps(out + 24, acc3);
+        out += TILE_FRAMES * 2;
+    }
+    if (frameCount > 0) {
+        volumeRampMultiTrackScalar<2>(out, frameCount, tracks, trackCount);
+    }
+}
+
+inline bool mixerOpsHaveAvx2() {
+    static const bool haveAvx2 = __builtin_cpu_supports("avx2");
+    return haveAvx2;
+}
+
+#endif
+
+template <int NCHAN, typename TO, typename TI, typename TV>
+inline void volumeRampMultiTrack(TO* out, size_t frameCount,
+        MixTrack<TI, TV>* tracks, size_t trackCount)
+{
+#ifdef ALOGVV
+    ALOGVV("volumeRampMultiTrack NCHAN:%d tracks:%zu\n", NCHAN, trackCount);
+#endif
+    if constexpr (NCHAN == 2 && std::is_same_v<TO, float>
+            && std::is_same_v<TI, float> && std::is_same_v<TV, float>) {
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+        volumeRampMultiTrackStereoNeon(out, frameCount, tracks, trackCount);
+        return;
+#elif defined(__x86_64__) || defined(__i386__)
+        if (mixerOpsHaveAvx2()) {
+            volumeRampMultiTrackStereoAvx2(out, frameCount, tracks, trackCount);
+            return;
+        }
+#endif
+    }
+    volumeRampMultiTrackScalar<NCHAN>(out, frameCount, tracks, trackCount);
+}
+
 };
 
 #endif /* ANDROID_AUDIO_MIXER_OPS_H */
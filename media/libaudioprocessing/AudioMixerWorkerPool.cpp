@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AudioMixerWorkerPool"
+//#define LOG_NDEBUG 0
+
+#include <pthread.h>
+
+#include <system/thread_defs.h>
+#include <utils/AndroidThreads.h>
+#include <utils/Log.h>
+
+#include "AudioMixerWorkerPool.h"
+
+namespace android {
+
+AudioMixerWorkerPool::AudioMixerWorkerPool(size_t threadCount)
+{
+    mThreads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        mThreads.emplace_back(&AudioMixerWorkerPool::threadLoop, this);
+        pthread_setname_np(mThreads.back().native_handle(), "AudioMixerWorker");
+    }
+}
+
+AudioMixerWorkerPool::~AudioMixerWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExit = true;
+    }
+    mWorkCv.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void AudioMixerWorkerPool::run(size_t count, const std::function<void(size_t)>& job)
+{
+    if (count == 0) {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mLock);
+        // a worker may still be leaving runJobs() of the previous run.
+        mDoneCv.wait(lock, [this] { return mActiveWorkers == 0; });
+        mJob = &job;
+        mJobCount = count;
+        mNextJob.store(0, std::memory_order_relaxed);
+        mPendingJobs.store(count, std::memory_order_relaxed);
+        ++mGeneration;
+    }
+    mWorkCv.notify_all();
+
+    runJobs();
+
+    std::unique_lock<std::mutex> lock(mLock);
+    mDoneCv.wait(lock, [this] {
+        return mPendingJobs.load(std::memory_order_acquire) == 0;
+    });
+}
+
+void AudioMixerWorkerPool::runJobs()
+{
+    for (size_t i; (i = mNextJob.fetch_add(1, std::memory_order_relaxed)) < mJobCount; ) {
+        (*mJob)(i);
+        if (mPendingJobs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // last job: take the lock so that run() cannot miss the notification.
+            std::lock_guard<std::mutex> lock(mLock);
+            mDoneCv.notify_one();
+        }
+    }
+}
+
+void AudioMixerWorkerPool::threadLoop()
+{
+    androidSetThreadPriority(0 /* tid (0 = current) */, ANDROID_PRIORITY_URGENT_AUDIO);
+    uint64_t generation = 0;
+    std::unique_lock<std::mutex> lock(mLock);
+    while (true) {
+        mWorkCv.wait(lock, [&] { return mExit || mGeneration != generation; });
+        if (mExit) {
+            return;
+        }
+        generation = mGeneration;
+        ++mActiveWorkers;
+        lock.unlock();
+        runJobs();
+        lock.lock();
+        if (--mActiveWorkers == 0) {
+            mDoneCv.notify_one();
+        }
+    }
+}
+
+} // namespace android
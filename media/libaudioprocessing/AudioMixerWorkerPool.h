@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXER_WORKER_POOL_H
+#define ANDROID_AUDIO_MIXER_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+
+/* AudioMixerWorkerPool runs the per-track jobs of one mixer cycle on a fixed
+ * set of worker threads, which run at the urgent audio priority.
+ *
+ * run() is called by one thread at a time (the mixer thread), which also takes
+ * jobs itself, so that run() makes progress even if no worker gets scheduled.
+ */
+class AudioMixerWorkerPool {
+public:
+    explicit AudioMixerWorkerPool(size_t threadCount);
+    ~AudioMixerWorkerPool();
+
+    size_t threadCount() const { return mThreads.size(); }
+
+    // Calls job(i) once for each i in [0, count), each call on any of the workers
+    // or on the calling thread. Returns when all calls have returned.
+    void run(size_t count, const std::function<void(size_t)>& job);
+
+private:
+    void threadLoop();
+
+    // Takes and runs jobs of the current run() until there are none left.
+    void runJobs();
+
+    std::vector<std::thread> mThreads;
+
+    std::mutex mLock;
+    std::condition_variable mWorkCv;    // signals workers of a new run() or exit.
+    std::condition_variable mDoneCv;    // signals run() that the last job has returned,
+                                        // or that the last worker has left runJobs().
+    uint64_t mGeneration = 0;           // incremented by each run(), under mLock.
+    size_t mActiveWorkers = 0;          // workers in runJobs(), under mLock.
+    bool mExit = false;                 // under mLock.
+
+    // The current run(), set only while no worker is in runJobs().
+
+    const std::function<void(size_t)>* mJob = nullptr;
+    size_t mJobCount = 0;
+    std::atomic<size_t> mNextJob{0};
+    std::atomic<size_t> mPendingJobs{0};
+};
+
+} // namespace android
+
+#endif // ANDROID_AUDIO_MIXER_WORKER_POOL_H
@@ -314,6 +314,11 @@ void AudioResampler::reset() {
     mBuffer.frameCount = 0;
 }
 
+// static
+std::string AudioResampler::dumpFilterCache() {
+    return AudioResamplerDynFilterCache::getInstance().dump();
+}
+
 // ----------------------------------------------------------------------------
 
 size_t AudioResamplerOrder1::resample(int32_t* out, size_t outFrameCount,
@@ -31,6 +31,7 @@
 #include "AudioResamplerFirOps.h" // USE_NEON, USE_SSE and USE_INLINE_ASSEMBLY defined here
 #include "AudioResamplerFirProcess.h"
 #include "AudioResamplerFirProcessNeon.h"
+#include "AudioResamplerFirProcessAVX.h"
 #include "AudioResamplerFirProcessSSE.h"
 #include "AudioResamplerFirGen.h" // requires math.h
 #include "AudioResamplerDyn.h"
@@ -42,6 +43,145 @@ constexpr size_t CACHE_LINE_SIZE = 64;
 
 namespace android {
 
+// static
+AudioResamplerDynFilterCache& AudioResamplerDynFilterCache::getInstance()
+{
+    static AudioResamplerDynFilterCache* cache = new AudioResamplerDynFilterCache(); // never deleted
+    return *cache;
+}
+
+std::shared_ptr<const AudioResamplerDynFilterCache::Filter>
+AudioResamplerDynFilterCache::find(const Key& key)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    auto it = mFilters.find(key);
+    if (it == mFilters.end()) {
+        return nullptr;
+    }
+    std::shared_ptr<const Filter> filter = it->second.lock();
+    if (filter == nullptr) {
+        mFilters.erase(it);
+        return nullptr;
+    }
+    ++mHits;
+    retain_l(filter);
+    return filter;
+}
+
+std::shared_ptr<const AudioResamplerDynFilterCache::Filter>
+AudioResamplerDynFilterCache::insert(const Key& key, std::shared_ptr<const Filter> filter)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    // another resampler may have designed the same filter while we were designing ours.
+    std::weak_ptr<const Filter>& entry = mFilters[key];
+    if (std::shared_ptr<const Filter> existing = entry.lock()) {
+        ++mHits;
+        filter = std::move(existing);
+    } else {
+        ++mMisses;
+        entry = filter;
+    }
+    retain_l(filter);
+
+    // purge the entries of filters no longer in use.
+    for (auto it = mFilters.begin(); it != mFilters.end(); ) {
+        if (it->second.expired()) {
+            it = mFilters.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return filter;
+}
+
+void AudioResamplerDynFilterCache::retain_l(const std::shared_ptr<const Filter>& filter)
+{
+    for (auto it = mRetained.begin(); it != mRetained.end(); ++it) {
+        if (*it == filter) {
+            mRetained.erase(it);
+            break;
+        }
+    }
+    mRetained.push_back(filter);
+    if (mRetained.size() > kRetainedFilters) {
+        mRetained.pop_front();
+    }
+}
+
+void AudioResamplerDynFilterCache::clearRetained()
+{
+    std::deque<std::shared_ptr<const Filter>> retained;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        retained.swap(mRetained);
+    }
+    // filters are freed outside of the lock.
+}
+
+size_t AudioResamplerDynFilterCache::size()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    size_t size = 0;
+    for (const auto& [key, filter] : mFilters) {
+        size += !filter.expired();
+    }
+    return size;
+}
+
+std::string AudioResamplerDynFilterCache::dump()
+{
+    static const char* const kCoefTypes[] = {"s16", "s32", "float"};
+    std::lock_guard<std::mutex> lock(mLock);
+    std::string result;
+    std::string lines;
+    size_t count = 0;
+    size_t totalBytes = 0;
+    char line[128];
+    for (const auto& [key, weakFilter] : mFilters) {
+        std::shared_ptr<const Filter> filter = weakFilter.lock();
+        if (filter == nullptr) {
+            continue;
+        }
+        bool retained = false;
+        for (const auto& r : mRetained) {
+            retained |= r == filter;
+        }
+        // discount our own reference and the retained one.
+        const long users = filter.use_count() - 1 - retained;
+        snprintf(line, sizeof(line), "  %7d %7d %7d %5s %6d %6d %5ld %8zu\n",
+                key.inSampleRate, key.outSampleRate, key.quality,
+                kCoefTypes[key.coefType], filter->mL, filter->mHalfNumCoefs,
+                users, filter->mSizeBytes);
+        lines.append(line);
+        ++count;
+        totalBytes += filter->mSizeBytes;
+    }
+    snprintf(line, sizeof(line),
+            "Resampler filter cache: %zu filters, %zu bytes, %zu retained, "
+            "%llu hits, %llu misses\n",
+            count, totalBytes, mRetained.size(),
+            (unsigned long long)mHits, (unsigned long long)mMisses);
+    result.append(line);
+    if (count > 0) {
+        result.append("   inRate outRate quality  coef phases  halfL users    bytes\n");
+        result.append(lines);
+    }
+    return result;
+}
+
+template<typename TC>
+static constexpr AudioResamplerDynFilterCache::coef_type coefTypeOf()
+{
+    if constexpr (is_same<TC, int16_t>::value) {
+        return AudioResamplerDynFilterCache::COEF_INT16;
+    } else if constexpr (is_same<TC, int32_t>::value) {
+        return AudioResamplerDynFilterCache::COEF_INT32;
+    } else {
+        static_assert(is_same<TC, float>::value, "unsupported coefficient type");
+        return AudioResamplerDynFilterCache::COEF_FLOAT;
+    }
+}
+
 /*
  * InBuffer is a type agnostic input buffer.
  *
@@ -181,8 +321,7 @@ template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
-      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY)
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -207,7 +346,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -239,7 +377,7 @@ template<typename T> T max(T a, T b) {return a > b ? a : b;}
 template<typename T> T absdiff(T a, T b) {return a > b ? a - b : b - a;}
 
 template<typename TC, typename TI, typename TO>
-void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
+void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Filter &filter, const Constants &c,
         double stopBandAtten, int inSampleRate, int outSampleRate, double tbwCheat)
 {
     // compute the normalized transition bandwidth
@@ -252,11 +390,11 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     } else { // downsample
         fcr = max(0.5 * tbwCheat * outSampleRate / inSampleRate - halfbw, halfbw);
     }
-    createKaiserFir(c, stopBandAtten, fcr);
+    createKaiserFir(filter, c, stopBandAtten, fcr);
 }
 
 template<typename TC, typename TI, typename TO>
-void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
+void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Filter &filter, const Constants &c,
         double stopBandAtten, double fcr) {
     // compute the normalized transition bandwidth
     const double tbw = firKaiserTbw(c.mHalfNumCoefs, stopBandAtten);
@@ -265,14 +403,16 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
 
     // create buffer
     TC *coefs = nullptr;
+    const size_t sizeBytes = (phases + 1) * halfLength * sizeof(TC);
     int ret = posix_memalign(
             reinterpret_cast<void **>(&coefs),
             CACHE_LINE_SIZE /* alignment */,
-            (phases + 1) * halfLength * sizeof(TC));
+            sizeBytes);
     LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
+    filter.mCoefs = coefs;
+    filter.mSizeBytes = sizeBytes;
+    filter.mL = phases;
+    filter.mHalfNumCoefs = halfLength;
 
     // square the computed minimum passband value (extra safety).
     double attenuation =
@@ -282,12 +422,12 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     // design filter
     firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
 
-    // update the design criteria
-    mNormalizedCutoffFrequency = fcr;
-    mNormalizedTransitionBandwidth = tbw;
-    mFilterAttenuation = attenuation;
-    mStopbandAttenuationDb = stopBandAtten;
-    mPassbandRippleDb = computeWindowedSincPassbandRippleDb(stopBandAtten);
+    // record the design criteria
+    filter.mNormalizedCutoffFrequency = fcr;
+    filter.mNormalizedTransitionBandwidth = tbw;
+    filter.mFilterAttenuation = attenuation;
+    filter.mStopbandAttenuationDb = stopBandAtten;
+    filter.mPassbandRippleDb = computeWindowedSincPassbandRippleDb(stopBandAtten);
 
 #if 0
     // Keep this debug code in case an app causes resampler design issues.
@@ -509,14 +649,33 @@ void AudioResamplerDyn<TC, TI, TO>::setSampleRate(int32_t inSampleRate)
             phases = 127;
         }
 
-        // create the filter
+        // create the filter, or share one already designed with the same parameters.
+        // The property based design parameters are read-only, so they are the same
+        // for every resampler and need not be part of the key.
         mConstants.set(phases, halfLength, inSampleRate, mSampleRate);
-        if (fcr > 0.) {
-            createKaiserFir(mConstants, stopBandAtten, fcr);
-        } else {
-            createKaiserFir(mConstants, stopBandAtten,
-                    inSampleRate, mSampleRate, tbwCheat);
-        }
+        const AudioResamplerDynFilterCache::Key key{
+                inSampleRate, mSampleRate, mFilterQuality, coefTypeOf<TC>()};
+        mFilter = AudioResamplerDynFilterCache::getInstance().get(key, [&]() {
+            auto filter = std::make_shared<Filter>();
+            if (fcr > 0.) {
+                createKaiserFir(*filter, mConstants, stopBandAtten, fcr);
+            } else {
+                createKaiserFir(*filter, mConstants, stopBandAtten,
+                        inSampleRate, mSampleRate, tbwCheat);
+            }
+            return filter;
+        });
+        LOG_ALWAYS_FATAL_IF(mFilter->mL != phases || mFilter->mHalfNumCoefs != halfLength,
+                "Cached filter (%d, %d) does not match design (%d, %d)",
+                mFilter->mL, mFilter->mHalfNumCoefs, phases, halfLength);
+        mConstants.mFirCoefs = static_cast<const TC*>(mFilter->mCoefs);
+
+        // update the design criteria
+        mNormalizedCutoffFrequency = mFilter->mNormalizedCutoffFrequency;
+        mNormalizedTransitionBandwidth = mFilter->mNormalizedTransitionBandwidth;
+        mFilterAttenuation = mFilter->mFilterAttenuation;
+        mStopbandAttenuationDb = mFilter->mStopbandAttenuationDb;
+        mPassbandRippleDb = mFilter->mPassbandRippleDb;
     } // End Kaiser filter
 
     // update phase and state based on the new filter.
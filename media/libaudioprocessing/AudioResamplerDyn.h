@@ -18,13 +18,106 @@
 #define ANDROID_AUDIO_RESAMPLER_DYN_H
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <sys/types.h>
 #include <android/log.h>
 
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
 #include <media/AudioResampler.h>
 
 namespace android {
 
+/* AudioResamplerDynFilterCache
+ *
+ * Process-wide cache of the polyphase filter banks designed by AudioResamplerDyn.
+ *
+ * Designing a filter bank is expensive, and all resamplers with the same input rate,
+ * output rate, quality and coefficient type design the same one. The filters are
+ * immutable once designed, so they are shared by reference count between resamplers.
+ * A filter is freed when the last resampler using it drops it, unless it is one of the
+ * kRetainedFilters most recently requested, which are kept so that restarting a track
+ * does not redesign its filter.
+ *
+ * The cache is thread safe. Filters are designed outside of the lock.
+ */
+class AudioResamplerDynFilterCache {
+public:
+    enum coef_type {
+        COEF_INT16,
+        COEF_INT32,
+        COEF_FLOAT,
+    };
+
+    struct Key {
+        int32_t inSampleRate;   // rate the filter is designed for
+        int32_t outSampleRate;
+        AudioResampler::src_quality quality;
+        coef_type coefType;
+
+        bool operator<(const Key& other) const {
+            return std::tie(inSampleRate, outSampleRate, quality, coefType)
+                    < std::tie(other.inSampleRate, other.outSampleRate,
+                            other.quality, other.coefType);
+        }
+    };
+
+    class Filter { // an immutable filter bank and its design criteria.
+    public:
+        Filter() = default;
+        ~Filter() { free(mCoefs); }
+        Filter(const Filter&) = delete;
+        Filter& operator=(const Filter&) = delete;
+
+        void* mCoefs = nullptr;        // (mL + 1) * mHalfNumCoefs coefficients
+        size_t mSizeBytes = 0;
+        int mL = 0;
+        int mHalfNumCoefs = 0;
+        double mStopbandAttenuationDb = 0.;
+        double mPassbandRippleDb = 0.;
+        double mNormalizedTransitionBandwidth = 0.;
+        double mFilterAttenuation = 0.;
+        double mNormalizedCutoffFrequency = 0.;
+    };
+
+    static constexpr size_t kRetainedFilters = 8;
+
+    static AudioResamplerDynFilterCache& getInstance();
+
+    // Returns the filter for key, calling design() to create it if it is not cached.
+    template <typename F>
+    std::shared_ptr<const Filter> get(const Key& key, F design) {
+        if (auto filter = find(key)) {
+            return filter;
+        }
+        return insert(key, design());
+    }
+
+    // Drops the retained filters. Filters in use stay cached until released.
+    void clearRetained();
+
+    // Number of live filters.
+    size_t size();
+
+    std::string dump();
+
+private:
+    std::shared_ptr<const Filter> find(const Key& key);
+    std::shared_ptr<const Filter> insert(const Key& key, std::shared_ptr<const Filter> filter);
+    void retain_l(const std::shared_ptr<const Filter>& filter);
+
+    std::mutex mLock;
+    std::map<Key, std::weak_ptr<const Filter>> mFilters;  // guarded by mLock
+    std::deque<std::shared_ptr<const Filter>> mRetained;  // guarded by mLock, most recent last
+    uint64_t mHits = 0;                                   // guarded by mLock
+    uint64_t mMisses = 0;                                 // guarded by mLock
+};
+
 /* AudioResamplerDyn
  *
  * This class template is used for floating point and integer resamplers.
@@ -147,10 +240,13 @@ private:
         size_t mStateCount; // size of state in units of TI.
     };
 
-    void createKaiserFir(Constants &c, double stopBandAtten,
+    typedef AudioResamplerDynFilterCache::Filter Filter;
+
+    static void createKaiserFir(Filter &filter, const Constants &c, double stopBandAtten,
             int inSampleRate, int outSampleRate, double tbwCheat);
 
-    void createKaiserFir(Constants &c, double stopBandAtten, double fcr);
+    static void createKaiserFir(Filter &filter, const Constants &c, double stopBandAtten,
+            double fcr);
 
     template<int CHANNELS, bool LOCKED, int STRIDE>
     size_t resample(TO* out, size_t outFrameCount, AudioBufferProvider* provider);
@@ -166,7 +262,7 @@ private:
      resample_ABP_t mResampleFunc;     // called function for resampling
             int32_t mFilterSampleRate; // designed filter sample rate.
         src_quality mFilterQuality;    // designed filter quality.
-              void* mCoefBuffer;       // if a filter is created, this is not null
+    std::shared_ptr<const Filter> mFilter; // shared filter bank, if one is created
 
     // Property selected design parameters.
               // This will enable fixed high quality resampling.
@@ -0,0 +1,484 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX_H
+#define ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX_H
+
+// depends on AudioResamplerFirOps.h, AudioResamplerFirProcess.h
+
+#if USE_SSE
+#include <immintrin.h>
+#endif
+
+namespace android {
+
+#if USE_SSE
+
+//
+// AVX2 and AVX-512 kernels for Process() and ProcessL().
+//
+// The x86 ABI only guarantees SSSE3, so the kernels are compiled with target attributes
+// and selected at run time. Float multichannel and int16 mono and stereo are specialized
+// here, and fall back to ProcessBase() on older CPUs.
+//
+// Float mono and stereo stay with the SSE kernels of AudioResamplerFirProcessSSE.h:
+// with 16 to 32 taps per side, wider vectors did not make them faster.
+//
+// The float multichannel kernels vectorize across the channels of a frame, so they sum
+// the taps in the same order as ProcessBase() but may round differently (fma).
+// The int16 kernels compute the same integer sums as ProcessBase() (with wraparound),
+// so their output is bit exact. The int16 count (halfNumCoefs) is a multiple of 8.
+//
+
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#define AVX512_TARGET __attribute__((target("avx512f,avx2,fma")))
+
+static inline bool resamplerFirHasAvx2()
+{
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return hasAvx2;
+}
+
+static inline bool resamplerFirHasAvx512()
+{
+    static const bool hasAvx512 = resamplerFirHasAvx2() && __builtin_cpu_supports("avx512f");
+    return hasAvx512;
+}
+
+// Returns the interpolated positive and negative coefficients of tap i, as ProcessBase().
+template <bool FIXED>
+static inline void interpolateTap(float& posCoef, float& negCoef, int i,
+        const float* coefsP, const float* coefsN,
+        const float* coefsP1, const float* coefsN1, float lerpP)
+{
+    if (FIXED) {
+        posCoef = coefsP[i];
+        negCoef = coefsN[i];
+    } else {
+        posCoef = interpolate(coefsP[i], coefsP1[i], lerpP);
+        negCoef = interpolate(coefsN1[i], coefsN[i], lerpP);
+    }
+}
+
+// Loads block b of the 8 channel blocks of a frame; the samples past the last channel
+// are not read and are zero.
+template <int CHANNELS>
+AVX2_TARGET
+static inline __m256 loadChannels8AVX(const float* p, int b, __m256i lastMask)
+{
+    if ((CHANNELS & 7) != 0 && b == (CHANNELS + 7) / 8 - 1) {
+        return _mm256_maskload_ps(p + b * 8, lastMask);
+    }
+    return _mm256_loadu_ps(p + b * 8);
+}
+
+template <int CHANNELS, bool FIXED>
+AVX2_TARGET
+static void ProcessAVX2(float* const out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* sP,
+        const float* sN,
+        const float* const volumeLR,
+        float lerpP,
+        const float* coefsP1,
+        const float* coefsN1)
+{
+    static_assert(CHANNELS > 2, "mono and stereo use the SSE kernels");
+    ALOG_ASSERT(count > 0);
+    // Vectorize across the channels of a frame, 8 at a time; the last block is masked.
+    constexpr int BLOCKS = (CHANNELS + 7) / 8;
+    constexpr int REMAINDER = CHANNELS & 7;
+    const __m256i lastMask = _mm256_cmpgt_epi32(
+            _mm256_set1_epi32(REMAINDER), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256 acc[BLOCKS];
+    for (int b = 0; b < BLOCKS; ++b) {
+        acc[b] = _mm256_setzero_ps();
+    }
+    for (int i = 0; i < count; ++i) {
+        float posCoef, negCoef;
+        interpolateTap<FIXED>(posCoef, negCoef, i, coefsP, coefsN, coefsP1, coefsN1, lerpP);
+        const __m256 posCoefs = _mm256_set1_ps(posCoef);
+        const __m256 negCoefs = _mm256_set1_ps(negCoef);
+        for (int b = 0; b < BLOCKS; ++b) {
+            acc[b] = _mm256_fmadd_ps(
+                    loadChannels8AVX<CHANNELS>(sP, b, lastMask), posCoefs, acc[b]);
+            acc[b] = _mm256_fmadd_ps(
+                    loadChannels8AVX<CHANNELS>(sN, b, lastMask), negCoefs, acc[b]);
+        }
+        sP -= CHANNELS;
+        sN += CHANNELS;
+    }
+    const __m256 volume = _mm256_set1_ps(volumeLR[0]);
+    for (int b = 0; b < BLOCKS; ++b) {
+        const __m256 outSamp = _mm256_fmadd_ps(
+                acc[b], volume, loadChannels8AVX<CHANNELS>(out, b, lastMask));
+        if (REMAINDER != 0 && b == BLOCKS - 1) {
+            _mm256_maskstore_ps(out + b * 8, lastMask, outSamp);
+        } else {
+            _mm256_storeu_ps(out + b * 8, outSamp);
+        }
+    }
+}
+
+// Loads block b of the 16 channel blocks of a frame, as loadChannels8AVX().
+template <int CHANNELS>
+AVX512_TARGET
+static inline __m512 loadChannels16AVX512(const float* p, int b, __mmask16 lastMask)
+{
+    return _mm512_maskz_loadu_ps(b == (CHANNELS + 15) / 16 - 1 ? lastMask : 0xffff, p + b * 16);
+}
+
+template <int CHANNELS, bool FIXED>
+AVX512_TARGET
+static void ProcessAVX512(float* const out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* sP,
+        const float* sN,
+        const float* const volumeLR,
+        float lerpP,
+        const float* coefsP1,
+        const float* coefsN1)
+{
+    static_assert(CHANNELS > 2, "mono and stereo use the SSE kernels");
+    ALOG_ASSERT(count > 0);
+    // Vectorize across the channels of a frame, 16 at a time; the last block is masked.
+    constexpr int BLOCKS = (CHANNELS + 15) / 16;
+    constexpr int REMAINDER = CHANNELS & 15;
+    const __mmask16 lastMask = REMAINDER != 0 ? (1u << REMAINDER) - 1 : 0xffff;
+    __m512 acc[BLOCKS];
+    for (int b = 0; b < BLOCKS; ++b) {
+        acc[b] = _mm512_setzero_ps();
+    }
+    for (int i = 0; i < count; ++i) {
+        float posCoef, negCoef;
+        interpolateTap<FIXED>(posCoef, negCoef, i, coefsP, coefsN, coefsP1, coefsN1, lerpP);
+        const __m512 posCoefs = _mm512_set1_ps(posCoef);
+        const __m512 negCoefs = _mm512_set1_ps(negCoef);
+        for (int b = 0; b < BLOCKS; ++b) {
+            acc[b] = _mm512_fmadd_ps(
+                    loadChannels16AVX512<CHANNELS>(sP, b, lastMask), posCoefs, acc[b]);
+            acc[b] = _mm512_fmadd_ps(
+                    loadChannels16AVX512<CHANNELS>(sN, b, lastMask), negCoefs, acc[b]);
+        }
+        sP -= CHANNELS;
+        sN += CHANNELS;
+    }
+    const __m512 volume = _mm512_set1_ps(volumeLR[0]);
+    for (int b = 0; b < BLOCKS; ++b) {
+        _mm512_mask_storeu_ps(out + b * 16, b == BLOCKS - 1 ? lastMask : 0xffff,
+                _mm512_fmadd_ps(acc[b], volume, loadChannels16AVX512<CHANNELS>(out, b, lastMask)));
+    }
+}
+
+// Runs the widest float kernel the CPU supports. Returns false if there is none.
+template <int CHANNELS, bool FIXED>
+static inline bool ProcessAVX(float* const out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* sP,
+        const float* sN,
+        const float* const volumeLR,
+        float lerpP,
+        const float* coefsP1,
+        const float* coefsN1)
+{
+    if (resamplerFirHasAvx512()) {
+        ProcessAVX512<CHANNELS, FIXED>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                lerpP, coefsP1, coefsN1);
+        return true;
+    }
+    if (resamplerFirHasAvx2()) {
+        ProcessAVX2<CHANNELS, FIXED>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                lerpP, coefsP1, coefsN1);
+        return true;
+    }
+    return false;
+}
+
+// Returns interpolate(coef0, coef1, lerp) for 8 int16 coefficients:
+// (lerp * (coef1 - coef0) >> 15) + coef0, with the product taken to 32 bits.
+AVX2_TARGET
+static inline __m128i interpolate8AVX(__m128i coef0, __m128i coef1, __m128i lerp)
+{
+    const __m128i diff = _mm_sub_epi16(coef1, coef0);
+    const __m128i product = _mm_or_si128(
+            _mm_slli_epi16(_mm_mulhi_epi16(lerp, diff), 1),
+            _mm_srli_epi16(_mm_mullo_epi16(lerp, diff), 15));
+    return _mm_add_epi16(product, coef0);
+}
+
+// Returns the interpolated positive and negative coefficients of 8 int16 taps.
+template <bool FIXED>
+AVX2_TARGET
+static inline void loadCoefs8Int16AVX(__m128i& posCoef, __m128i& negCoef,
+        const int16_t*& coefsP, const int16_t*& coefsN,
+        const int16_t*& coefsP1, const int16_t*& coefsN1, __m128i interp)
+{
+    posCoef = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefsP));
+    negCoef = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefsN));
+    coefsP += 8;
+    coefsN += 8;
+    if (!FIXED) {
+        posCoef = interpolate8AVX(posCoef,
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefsP1)), interp);
+        negCoef = interpolate8AVX(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefsN1)), negCoef, interp);
+        coefsP1 += 8;
+        coefsN1 += 8;
+    }
+}
+
+template <int CHANNELS, bool FIXED>
+AVX2_TARGET
+static void ProcessAVX2(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        const int32_t* const volumeLR,
+        uint32_t lerpP,
+        const int16_t* coefsP1,
+        const int16_t* coefsN1)
+{
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    const __m128i interp = _mm_set1_epi16(static_cast<int16_t>(lerpP));
+    // reverses the order of the 16 bit words of each 128 bit lane.
+    const __m128i reverse16 = _mm_setr_epi8(
+            14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+
+    __m256i acc = _mm256_setzero_si256();
+    if (CHANNELS == 1) {
+        const __m256i reverse = _mm256_broadcastsi128_si256(reverse16);
+        for (; count >= 16; count -= 16) {
+            __m128i posCoef0, negCoef0, posCoef1, negCoef1;
+            loadCoefs8Int16AVX<FIXED>(posCoef0, negCoef0, coefsP, coefsN, coefsP1, coefsN1, interp);
+            loadCoefs8Int16AVX<FIXED>(posCoef1, negCoef1, coefsP, coefsN, coefsP1, coefsN1, interp);
+            const __m256i posCoef = _mm256_set_m128i(posCoef1, posCoef0);
+            const __m256i negCoef = _mm256_set_m128i(negCoef1, negCoef0);
+            // the positive side runs backwards from sP.
+            const __m256i posSamp = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sP - 15)), reverse),
+                    0x4E);
+            const __m256i negSamp = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sN));
+            sP -= 16;
+            sN += 16;
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(posSamp, posCoef));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(negSamp, negCoef));
+        }
+        if (count != 0) { // 8 taps left
+            __m128i posCoef, negCoef;
+            loadCoefs8Int16AVX<FIXED>(posCoef, negCoef, coefsP, coefsN, coefsP1, coefsN1, interp);
+            const __m128i posSamp = _mm_shuffle_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(sP - 7)), reverse16);
+            const __m128i negSamp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sN));
+            const __m128i acc8 = _mm_add_epi32(_mm_madd_epi16(posSamp, posCoef),
+                    _mm_madd_epi16(negSamp, negCoef));
+            acc = _mm256_add_epi32(acc, _mm256_castsi128_si256(acc8));
+        }
+        __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        const int32_t l = _mm_cvtsi128_si32(sum);
+        out[0] += volumeAdjust(l, volumeLR[0]);
+        out[1] += volumeAdjust(l, volumeLR[1]);
+    } else {
+        // Each 128 bit lane holds 4 frames, deinterleaved to L L L L R R R R.
+        // The coefficients are arranged to match, and madd sums pairs of taps.
+        const __m256i deinterleave = _mm256_setr_epi8(
+                0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+                0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+        const __m256i spread = _mm256_setr_epi32(0, 1, 0, 1, 2, 3, 2, 3);
+        do {
+            __m128i posCoef, negCoef;
+            loadCoefs8Int16AVX<FIXED>(posCoef, negCoef, coefsP, coefsN, coefsP1, coefsN1, interp);
+            // the positive side runs backwards from sP, so reverse its coefficients.
+            const __m256i posCoefs = _mm256_permutevar8x32_epi32(
+                    _mm256_castsi128_si256(_mm_shuffle_epi8(posCoef, reverse16)), spread);
+            const __m256i negCoefs = _mm256_permutevar8x32_epi32(
+                    _mm256_castsi128_si256(negCoef), spread);
+            const __m256i posSamp = _mm256_shuffle_epi8(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sP - 14)), deinterleave);
+            const __m256i negSamp = _mm256_shuffle_epi8(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sN)), deinterleave);
+            sP -= 16;
+            sN += 16;
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(posSamp, posCoefs));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(negSamp, negCoefs));
+        } while (count -= 8);
+        // lanes 0, 1, 4, 5 hold left sums and lanes 2, 3, 6, 7 right sums.
+        __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        const int32_t l = _mm_cvtsi128_si32(sum);
+        const int32_t r = _mm_extract_epi32(sum, 2);
+        out[0] += volumeAdjust(l, volumeLR[0]);
+        out[1] += volumeAdjust(r, volumeLR[1]);
+    }
+}
+
+//
+// Specializations for float multichannel and int16 mono and stereo.
+//
+
+template<>
+inline void ProcessL<1, 16>(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        const int32_t* const volumeLR)
+{
+    if (resamplerFirHasAvx2()) {
+        ProcessAVX2<1, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
+        return;
+    }
+    ProcessBase<1, 16, InterpNull>(out, count, coefsP, coefsN, sP, sN, 0, volumeLR);
+}
+
+template<>
+inline void ProcessL<2, 16>(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        const int32_t* const volumeLR)
+{
+    if (resamplerFirHasAvx2()) {
+        ProcessAVX2<2, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
+        return;
+    }
+    ProcessBase<2, 16, InterpNull>(out, count, coefsP, coefsN, sP, sN, 0, volumeLR);
+}
+
+template<>
+inline void Process<1, 16>(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* coefsP1,
+        const int16_t* coefsN1,
+        const int16_t* sP,
+        const int16_t* sN,
+        uint32_t lerpP,
+        const int32_t* const volumeLR)
+{
+    if (resamplerFirHasAvx2()) {
+        ProcessAVX2<1, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                lerpP, coefsP1, coefsN1);
+        return;
+    }
+    ProcessBase<1, 16, InterpCompute>(out, count, coefsP, coefsN, sP, sN, lerpP, volumeLR);
+}
+
+template<>
+inline void Process<2, 16>(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* coefsP1,
+        const int16_t* coefsN1,
+        const int16_t* sP,
+        const int16_t* sN,
+        uint32_t lerpP,
+        const int32_t* const volumeLR)
+{
+    if (resamplerFirHasAvx2()) {
+        ProcessAVX2<2, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                lerpP, coefsP1, coefsN1);
+        return;
+    }
+    ProcessBase<2, 16, InterpCompute>(out, count, coefsP, coefsN, sP, sN, lerpP, volumeLR);
+}
+
+#pragma push_macro("AUDIORESAMPLERFIR_AVX_MULTICHANNEL")
+#undef AUDIORESAMPLERFIR_AVX_MULTICHANNEL
+#define AUDIORESAMPLERFIR_AVX_MULTICHANNEL(CHANNELS) \
+template<> \
+inline void ProcessL<CHANNELS, 16>(float* const out, \
+        int count, \
+        const float* coefsP, \
+        const float* coefsN, \
+        const float* sP, \
+        const float* sN, \
+        const float* const volumeLR) \
+{ \
+    if (!ProcessAVX<CHANNELS, true>(out, count, coefsP, coefsN, sP, sN, volumeLR, \
+            0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/)) { \
+        ProcessBase<CHANNELS, 16, InterpNull>(out, count, coefsP, coefsN, sP, sN, \
+                0.f, volumeLR); \
+    } \
+} \
+template<> \
+inline void Process<CHANNELS, 16>(float* const out, \
+        int count, \
+        const float* coefsP, \
+        const float* coefsN, \
+        const float* coefsP1, \
+        const float* coefsN1, \
+        const float* sP, \
+        const float* sN, \
+        float lerpP, \
+        const float* const volumeLR) \
+{ \
+    if (!ProcessAVX<CHANNELS, false>(out, count, coefsP, coefsN, sP, sN, volumeLR, \
+            lerpP, coefsP1, coefsN1)) { \
+        ProcessBase<CHANNELS, 16, InterpCompute>(out, count, coefsP, coefsN, sP, sN, \
+                lerpP, volumeLR); \
+    } \
+}
+
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(3)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(4)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(5)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(6)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(7)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(8)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(9)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(10)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(11)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(12)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(13)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(14)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(15)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(16)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(17)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(18)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(19)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(20)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(21)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(22)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(23)
+AUDIORESAMPLERFIR_AVX_MULTICHANNEL(24)
+#pragma pop_macro("AUDIORESAMPLERFIR_AVX_MULTICHANNEL")
+
+#undef AVX2_TARGET
+#undef AVX512_TARGET
+
+#endif //USE_SSE
+
+} // namespace android
+
+#endif /*ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX_H*/
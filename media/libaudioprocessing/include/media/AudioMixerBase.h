@@ -36,6 +36,8 @@
 
 namespace android {
 
+class AudioMixerWorkerPool;
+
 // ----------------------------------------------------------------------------
 
 // AudioMixerBase is functional on its own if only mixing and resampling
@@ -96,7 +98,7 @@ public:
         , mFrameCount(frameCount) {
     }
 
-    virtual ~AudioMixerBase() {}
+    virtual ~AudioMixerBase();
 
     virtual bool isValidFormat(audio_format_t format) const;
     virtual bool isValidChannelMask(audio_channel_mask_t channelMask) const;
@@ -139,6 +141,20 @@ public:
 
     std::string trackNames() const;
 
+    // Resample the tracks on threadCount worker threads as well as the calling thread.
+    // Each track is resampled, and its volume applied, into a buffer of its own;
+    // the buffers are then added up on the calling thread in track order, so the
+    // mix is the same as when the tracks are resampled one after the other.
+    // The buffer providers of the tracks are then called from the worker threads.
+    //
+    // If resampling takes longer than budgetNs in several cycles in a row,
+    // the mixer resamples serially for a while before trying the workers again.
+    // budgetNs 0 disables this.
+    //
+    // Tracks with an aux send are always resampled serially.
+    // threadCount 0, the default, always resamples serially.
+    void        setResampleThreads(size_t threadCount, int64_t budgetNs);
+
   protected:
     // Set kUseNewMixer to true to use the new mixer engine always. Otherwise the
     // original code will be used for stereo sinks, the new mixer for everything else.
@@ -232,6 +248,8 @@ public:
 
         bool        useStereoVolume() const { return channelMask == AUDIO_CHANNEL_OUT_STEREO
                                         && isAudioChannelPositionMask(mMixerChannelMask); }
+        // true if the track is mixed by mixFusedTracks() rather than by its hook.
+        bool        isFusedMix() const;
 
         static hook_t getTrackHook(int trackType, uint32_t channelCount,
                 audio_format_t mixerInFormat, audio_format_t mixerOutFormat);
@@ -297,6 +315,10 @@ public:
 
         int32_t        mTeeBufferFrameCount;
 
+        // output and temp buffers for resampling on a worker thread.
+        std::unique_ptr<int32_t[]> mParallelOut;
+        std::unique_ptr<int32_t[]> mParallelTemp;
+
         uint32_t       mInputFrameSize; // The track input frame size, used for tee buffer
 
         // consider volume muted only if all channel volume (floating point) is 0.f
@@ -352,6 +374,10 @@ public:
     void process__genericResampling();
     void process__oneTrack16BitsStereoNoResampling();
 
+    void mixFusedTracks(const std::vector<int>& group, float* out,
+            size_t frameCount, size_t framesLeft);
+    bool resampleInParallel(const std::vector<int>& group);
+
     template <int MIXTYPE, typename TO, typename TI, typename TA>
     void process__noResampleOneTrack();
 
@@ -373,6 +399,13 @@ public:
     std::unique_ptr<int32_t[]> mOutputTemp;
     std::unique_ptr<int32_t[]> mResampleTemp;
 
+    // parallel resampling, see setResampleThreads().
+    std::unique_ptr<AudioMixerWorkerPool> mResamplePool;
+    int64_t mResampleBudgetNs = 0;
+    int mResampleOverBudgetCycles = 0;  // consecutive cycles over budget.
+    int mResampleSerialCycles = 0;      // cycles left to resample serially.
+    std::vector<TrackBase*> mParallelTracks;
+
     // track names grouped by main buffer, in no particular order of main buffer.
     // however names for a particular main buffer are in order (by construction).
     std::unordered_map<void * /* mainBuffer */, std::vector<int /* name */>> mGroups;
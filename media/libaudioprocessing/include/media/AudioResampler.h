@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <string>
+
 #include <cutils/compiler.h>
 #include <utils/Compat.h>
 
@@ -80,6 +82,10 @@ public:
     virtual void reset();
     virtual size_t getUnreleasedFrames() const { return mInputIndex; }
 
+    // Returns a description of the filters shared by the dynamic quality resamplers,
+    // for dumpsys.
+    static std::string dumpFilterCache();
+
     // called from destructor, so must not be virtual
     src_quality getQuality() const { return mQuality; }
 
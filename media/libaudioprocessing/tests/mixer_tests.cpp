@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "mixer_tests"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <log/log.h>
+#include <media/AudioMixer.h>
+
+#include "../AudioMixerWorkerPool.h"
+#include "test_utils.h"
+
+using namespace android;
+
+TEST(mixer, workerpool_runs_each_job_once) {
+    for (size_t threads : {1, 2, 4}) {
+        AudioMixerWorkerPool pool(threads);
+        EXPECT_EQ(threads, pool.threadCount());
+        for (size_t count : {0, 1, 3, 16, 100}) {
+            for (int run = 0; run < 20; ++run) {
+                std::vector<std::atomic<int>> calls(count);
+                pool.run(count, [&calls](size_t i) { calls[i]++; });
+                for (size_t i = 0; i < count; ++i) {
+                    ASSERT_EQ(1, calls[i].load()) << "threads " << threads
+                            << " count " << count << " job " << i;
+                }
+            }
+        }
+    }
+}
+
+// Mixes resampled tracks for a few seconds and returns the output.
+static std::vector<float> mixResampled(size_t resampleThreads, bool ramp) {
+    constexpr uint32_t kSampleRate = 48000;
+    constexpr size_t kFrameCount = 480;
+    constexpr size_t kCycles = 200;
+    constexpr uint32_t kChannels = 2;
+    const uint32_t trackRates[] = {44100, 22050, 32000, 44100, 16000, 11025};
+
+    std::vector<SignalProvider> providers(std::size(trackRates));
+    std::vector<float> output(kCycles * kFrameCount * kChannels);
+    AudioMixer mixer(kFrameCount, kSampleRate);
+    mixer.setResampleThreads(resampleThreads, 0 /* budgetNs */);
+
+    float volume = AudioMixer::UNITY_GAIN_FLOAT / providers.size();
+    float zero = 0.f;
+    for (size_t i = 0; i < providers.size(); ++i) {
+        providers[i].setChirp<float>(kChannels, 100., trackRates[i] / 2., trackRates[i],
+                kCycles * kFrameCount / (double)kSampleRate + 1.);
+        const int name = i;
+        const status_t status = mixer.create(name, AUDIO_CHANNEL_OUT_STEREO,
+                AUDIO_FORMAT_PCM_FLOAT, AUDIO_SESSION_OUTPUT_MIX);
+        LOG_ALWAYS_FATAL_IF(status != OK);
+        mixer.setBufferProvider(name, &providers[i]);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER, output.data());
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+                (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::FORMAT,
+                (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
+                (void *)(uintptr_t)AUDIO_CHANNEL_OUT_STEREO);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::CHANNEL_MASK,
+                (void *)(uintptr_t)AUDIO_CHANNEL_OUT_STEREO);
+        mixer.setParameter(name, AudioMixer::RESAMPLE, AudioMixer::SAMPLE_RATE,
+                (void *)(uintptr_t)trackRates[i]);
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0,
+                ramp ? &zero : &volume);
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1,
+                ramp ? &zero : &volume);
+        mixer.enable(name);
+    }
+
+    for (size_t cycle = 0; cycle < kCycles; ++cycle) {
+        float* out = output.data() + cycle * kFrameCount * kChannels;
+        for (size_t i = 0; i < providers.size(); ++i) {
+            mixer.setParameter(i, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER, out);
+            if (ramp && cycle % 50 == 0) {
+                float v = volume * (cycle % 100 == 0 ? 1.f : 0.5f);
+                mixer.setParameter(i, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME0, &v);
+                mixer.setParameter(i, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME1, &v);
+            }
+        }
+        mixer.process();
+    }
+    return output;
+}
+
+// Resampling on worker threads must give exactly the same mix as serial resampling.
+TEST(mixer, parallel_resample_matches_serial) {
+    for (bool ramp : {false, true}) {
+        const std::vector<float> serial = mixResampled(0 /* resampleThreads */, ramp);
+        for (size_t threads : {1, 3}) {
+            const std::vector<float> parallel = mixResampled(threads, ramp);
+            ASSERT_EQ(serial.size(), parallel.size());
+            size_t mismatch = 0;
+            while (mismatch < serial.size() && serial[mismatch] == parallel[mismatch]) {
+                ++mismatch;
+            }
+            EXPECT_EQ(serial.size(), mismatch) << "ramp " << ramp << " threads " << threads
+                    << " first mismatch at sample " << mismatch;
+        }
+    }
+}
@@ -16,6 +16,7 @@
 
 #include <inttypes.h>
 #include <type_traits>
+#include <vector>
 #define LOG_ALWAYS_FATAL(...)
 
 #include <../AudioMixerOps.h>
@@ -72,6 +73,37 @@ static void BM_VolumeMulti(benchmark::State& state) {
     }
 }
 
+// Mixing NTRACKS stereo float tracks with a volume ramp into one output buffer,
+// one track at a time as the track hooks do, and fused in a single pass.
+template <bool FUSED, int NTRACKS>
+static void BM_VolumeRampMultiTrack(benchmark::State& state) {
+    constexpr int NCHAN = 2;
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+
+    std::vector<float> out(SAMPLE_COUNT);
+    std::vector<std::vector<float>> in(NTRACKS, std::vector<float>(SAMPLE_COUNT));
+    MixTrack<float, float> tracks[NTRACKS];
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out.data());
+        for (int t = 0; t < NTRACKS; ++t) {
+            tracks[t] = {in[t].data(), {0.f, 0.f}, {0.0001f, 0.0001f}};
+        }
+        if (FUSED) {
+            volumeRampMultiTrack<NCHAN>(out.data(), FRAME_COUNT, tracks, NTRACKS);
+        } else {
+            for (int t = 0; t < NTRACKS; ++t) {
+                volumeRampMulti<MIXTYPE_MULTI, NCHAN>(out.data(), FRAME_COUNT, tracks[t].in,
+                        (float *)nullptr, tracks[t].vol, tracks[t].volinc,
+                        (float *)nullptr, 0.f);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * FRAME_COUNT * NTRACKS);
+}
+
 // MULTI mode and MULTI_SAVEONLY mode are not used by AudioMixer for channels > 2,
 // which is ensured by a static_assert (won't compile for those configurations).
 // So we benchmark MIXTYPE_MULTI_MONOVOL and MIXTYPE_MULTI_SAVEONLY_MONOVOL compared
@@ -101,4 +133,13 @@ BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8);
 
+BENCHMARK_TEMPLATE(BM_VolumeRampMultiTrack, false, 2);
+BENCHMARK_TEMPLATE(BM_VolumeRampMultiTrack, true, 2);
+BENCHMARK_TEMPLATE(BM_VolumeRampMultiTrack, false, 4);
+BENCHMARK_TEMPLATE(BM_VolumeRampMultiTrack, true, 4);
+BENCHMARK_TEMPLATE(BM_VolumeRampMultiTrack, false, 8);
+BENCHMARK_TEMPLATE(BM_VolumeRampMultiTrack, true, 8);
+BENCHMARK_TEMPLATE(BM_VolumeRampMultiTrack, false, 16);
+BENCHMARK_TEMPLATE(BM_VolumeRampMultiTrack, true, 16);
+
 BENCHMARK_MAIN();
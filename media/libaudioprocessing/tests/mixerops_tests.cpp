@@ -18,8 +18,10 @@
 #define LOG_TAG "mixerop_tests"
 #include <log/log.h>
 
+#include <array>
 #include <inttypes.h>
 #include <type_traits>
+#include <vector>
 
 #include <../AudioMixerOps.h>
 #include <gtest/gtest.h>
@@ -173,3 +175,56 @@ TEST(mixerops, channel_equivalence) {
         EXPECT_EQ(system, actual);
     }
 }
+
+// The fused multi-track mix must match mixing the tracks one at a time.
+static void testMultiTrack(size_t trackCount, size_t frameCount, bool ramp) {
+    constexpr int NCHAN = 2;
+    std::vector<std::vector<float>> in(trackCount);
+    std::vector<MixTrack<float, float>> tracks(trackCount);
+    std::vector<std::array<float, 2>> expectedVol(trackCount);
+    std::vector<float> expected(frameCount * NCHAN);
+    std::vector<float> out(frameCount * NCHAN);
+    for (size_t i = 0; i < frameCount * NCHAN; ++i) {
+        expected[i] = out[i] = 0.001f * (i % 97);
+    }
+    for (size_t t = 0; t < trackCount; ++t) {
+        in[t].resize(frameCount * NCHAN);
+        for (size_t i = 0; i < in[t].size(); ++i) {
+            in[t][i] = ((i * 7 + t * 13) % 101) * 0.01f - 0.5f;
+        }
+        float vol[2] = {0.1f + 0.05f * t, 0.9f - 0.05f * t};
+        float volinc[2] = {ramp ? 1e-4f : 0.f, ramp ? -2e-4f : 0.f};
+        tracks[t] = {in[t].data(), {vol[0], vol[1]}, {volinc[0], volinc[1]}};
+        volumeRampMulti<MIXTYPE_MULTI, NCHAN>(expected.data(), frameCount, in[t].data(),
+                (float *)nullptr, vol, volinc, (float *)nullptr, 0.f);
+        expectedVol[t] = {vol[0], vol[1]};
+    }
+
+    volumeRampMultiTrack<NCHAN>(out.data(), frameCount, tracks.data(), trackCount);
+
+    for (size_t i = 0; i < frameCount * NCHAN; ++i) {
+        ASSERT_NEAR(expected[i], out[i], 1e-4f) << "tracks " << trackCount << " sample " << i;
+    }
+    for (size_t t = 0; t < trackCount; ++t) {
+        EXPECT_EQ(in[t].data() + frameCount * NCHAN, tracks[t].in);
+        EXPECT_NEAR(expectedVol[t][0], tracks[t].vol[0], 1e-4f);
+        EXPECT_NEAR(expectedVol[t][1], tracks[t].vol[1], 1e-4f);
+    }
+}
+
+TEST(mixerops, multitrack) {
+    for (size_t trackCount : {1, 2, 3, 8, 16}) {
+        // odd frame counts exercise the scalar tail of the vector versions.
+        for (size_t frameCount : {1, 7, 16, 33, 1000}) {
+            testMultiTrack(trackCount, frameCount, false /* ramp */);
+        }
+    }
+}
+
+TEST(mixerops, multitrack_ramp) {
+    for (size_t trackCount : {1, 2, 3, 8, 16}) {
+        for (size_t frameCount : {1, 7, 16, 33, 1000}) {
+            testMultiTrack(trackCount, frameCount, true /* ramp */);
+        }
+    }
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Benchmarks of the dynamic resampler.
+ *
+ * Track start latency: creating a resampler, setting its input rate and producing
+ * the first mixer period, as AudioMixer does when a track starts.
+ *
+ * BM_ResamplerTrackStart uses a filter already in the filter cache, as when a track
+ * starts at the rate of another one. BM_ResamplerTrackStartUncached empties the
+ * cache first, so every start designs its filter.
+ *
+ * Arguments are the quality and the input sample rate; the output rate is 48 kHz.
+ *
+ * Throughput: BM_ResamplerThroughput resamples one mixer period per iteration and
+ * reports output frames per second. Arguments are the channel count, the quality and
+ * the input sample rate. On x86 the float multichannel and the int16 cases run the
+ * AVX2 or AVX-512 FIR kernels when the CPU has them.
+ */
+
+#include <algorithm>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/AudioBufferProvider.h>
+#include <media/AudioResampler.h>
+
+#include "../AudioResamplerDyn.h"
+
+using namespace android;
+
+namespace {
+
+constexpr int32_t kOutSampleRate = 48000;
+constexpr size_t kChannelCount = 2;
+constexpr size_t kPeriodFrames = 960; // 20 ms
+
+// Provides silence forever.
+class SilenceProvider : public AudioBufferProvider {
+public:
+    SilenceProvider(size_t frameCount, size_t frameSize)
+        : mFrameCount(frameCount), mBuffer(frameCount * frameSize) {}
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        buffer->frameCount = std::min(buffer->frameCount, mFrameCount);
+        buffer->raw = mBuffer.data();
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        buffer->frameCount = 0;
+        buffer->raw = nullptr;
+    }
+
+private:
+    const size_t mFrameCount;
+    std::vector<uint8_t> mBuffer;
+};
+
+template <bool kCached>
+void BM_ResamplerTrackStart(benchmark::State& state) {
+    const auto quality = static_cast<AudioResampler::src_quality>(state.range(0));
+    const int32_t inSampleRate = state.range(1);
+    SilenceProvider provider(kPeriodFrames * 4, kChannelCount * sizeof(float));
+    std::vector<float> out(kPeriodFrames * kChannelCount);
+
+    // keeps the filter in the cache for the cached case.
+    std::unique_ptr<AudioResampler> running(AudioResampler::create(
+            AUDIO_FORMAT_PCM_FLOAT, kChannelCount, kOutSampleRate, quality));
+    running->setSampleRate(inSampleRate);
+    if (!kCached) {
+        running.reset();
+    }
+
+    for (auto _ : state) {
+        if (!kCached) {
+            AudioResamplerDynFilterCache::getInstance().clearRetained();
+        }
+        std::unique_ptr<AudioResampler> resampler(AudioResampler::create(
+                AUDIO_FORMAT_PCM_FLOAT, kChannelCount, kOutSampleRate, quality));
+        resampler->setSampleRate(inSampleRate);
+        resampler->setVolume(AudioResampler::UNITY_GAIN_FLOAT,
+                AudioResampler::UNITY_GAIN_FLOAT);
+        resampler->resample(reinterpret_cast<int32_t*>(out.data()), kPeriodFrames, &provider);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+}
+
+void trackStartArgs(benchmark::internal::Benchmark* b) {
+    for (int quality : {AudioResampler::DYN_LOW_QUALITY,
+                        AudioResampler::DYN_MED_QUALITY,
+                        AudioResampler::DYN_HIGH_QUALITY}) {
+        for (int inSampleRate : {44100, 96000}) {
+            b->Args({quality, inSampleRate});
+        }
+    }
+}
+
+template <audio_format_t kFormat>
+void BM_ResamplerThroughput(benchmark::State& state) {
+    const int channelCount = state.range(0);
+    const auto quality = static_cast<AudioResampler::src_quality>(state.range(1));
+    const int32_t inSampleRate = state.range(2);
+    const size_t sampleSize = kFormat == AUDIO_FORMAT_PCM_FLOAT ? sizeof(float) : sizeof(int16_t);
+    SilenceProvider provider(kPeriodFrames * 4, channelCount * sampleSize);
+    // float and Q4.27 output samples are both 32 bits; mono is output as stereo.
+    std::vector<int32_t> out(kPeriodFrames * std::max(channelCount, 2));
+
+    std::unique_ptr<AudioResampler> resampler(AudioResampler::create(
+            kFormat, channelCount, kOutSampleRate, quality));
+    resampler->setSampleRate(inSampleRate);
+    resampler->setVolume(AudioResampler::UNITY_GAIN_FLOAT, AudioResampler::UNITY_GAIN_FLOAT);
+    for (auto _ : state) {
+        resampler->resample(out.data(), kPeriodFrames, &provider);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kPeriodFrames);
+}
+
+void throughputArgs(benchmark::internal::Benchmark* b, std::initializer_list<int> channelCounts) {
+    for (int channelCount : channelCounts) {
+        for (int quality : {AudioResampler::DYN_MED_QUALITY, AudioResampler::DYN_HIGH_QUALITY}) {
+            for (int inSampleRate : {44100, 96000}) {
+                b->Args({channelCount, quality, inSampleRate});
+            }
+        }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_ResamplerTrackStart, true)->Apply(trackStartArgs);
+BENCHMARK_TEMPLATE(BM_ResamplerTrackStart, false)
+        ->Name("BM_ResamplerTrackStartUncached")->Apply(trackStartArgs);
+BENCHMARK_TEMPLATE(BM_ResamplerThroughput, AUDIO_FORMAT_PCM_FLOAT)
+        ->Name("BM_ResamplerThroughputFloat")
+        ->Apply([](benchmark::internal::Benchmark* b) { throughputArgs(b, {1, 2, 6, 8}); });
+BENCHMARK_TEMPLATE(BM_ResamplerThroughput, AUDIO_FORMAT_PCM_16_BIT)
+        ->Name("BM_ResamplerThroughputInt16")
+        ->Apply([](benchmark::internal::Benchmark* b) { throughputArgs(b, {1, 2}); });
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -30,6 +30,8 @@
 
 #include <iostream>
 #include <memory>
+#include <random>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -40,6 +42,9 @@
 #include <media/AudioResampler.h>
 #include "../AudioResamplerDyn.h"
 #include "../AudioResamplerFirGen.h"
+#include "../AudioResamplerFirOps.h"
+#include "../AudioResamplerFirProcess.h"
+#include "../AudioResamplerFirProcessAVX.h"
 #include "test_utils.h"
 
 template <typename T>
@@ -601,3 +606,151 @@ TEST(audioflinger_resampler, generalresponse) {
         }
     }
 }
+
+// Resamplers designing the same filter share one copy of the coefficients.
+TEST(audioflinger_resampler, filtercache) {
+    using android::AudioResampler;
+    using ResamplerType = android::AudioResamplerDyn<float, float, float>;
+    auto create = [](unsigned inputFreq, AudioResampler::src_quality quality) {
+        std::unique_ptr<ResamplerType> rdyn(
+                static_cast<ResamplerType *>(
+                        AudioResampler::create(
+                                AUDIO_FORMAT_PCM_FLOAT,
+                                2 /* channels */,
+                                48000 /* outputFreq */,
+                                quality)));
+        rdyn->setSampleRate(inputFreq);
+        return rdyn;
+    };
+    android::AudioResamplerDynFilterCache& cache =
+            android::AudioResamplerDynFilterCache::getInstance();
+    cache.clearRetained();
+
+    auto r1 = create(44100, AudioResampler::DYN_HIGH_QUALITY);
+    auto r2 = create(44100, AudioResampler::DYN_HIGH_QUALITY);
+    auto r3 = create(44100, AudioResampler::DYN_MED_QUALITY);
+    auto r4 = create(32000, AudioResampler::DYN_HIGH_QUALITY);
+    const float *coefs = r1->getFilterCoefs();
+    EXPECT_EQ(coefs, r2->getFilterCoefs());
+    EXPECT_NE(coefs, r3->getFilterCoefs());
+    EXPECT_NE(coefs, r4->getFilterCoefs());
+    EXPECT_EQ(r1->getPhases(), r2->getPhases());
+    EXPECT_EQ(r1->getHalfLength(), r2->getHalfLength());
+    EXPECT_EQ(r1->getStopbandAttenuationDb(), r2->getStopbandAttenuationDb());
+    EXPECT_EQ(r1->getNormalizedCutoffFrequency(), r2->getNormalizedCutoffFrequency());
+    EXPECT_EQ(3u, cache.size());
+
+    // A filter no longer in use is still shared while it is retained.
+    r1.reset();
+    r2.reset();
+    auto r5 = create(44100, AudioResampler::DYN_HIGH_QUALITY);
+    EXPECT_EQ(coefs, r5->getFilterCoefs());
+
+    // A filter neither in use nor retained is freed.
+    r5.reset();
+    cache.clearRetained();
+    EXPECT_EQ(2u, cache.size());
+
+    const std::string dump = AudioResampler::dumpFilterCache();
+    EXPECT_NE(std::string::npos, dump.find("Resampler filter cache: 2 filters"));
+}
+
+#if USE_SSE
+// Runs the x86 AVX2 and AVX-512 FIR kernels on random data and compares them against
+// ProcessBase(). int16 kernels must match exactly, float kernels within rounding.
+template <int CHANNELS, bool FIXED, typename TC, typename TI, typename TO, typename TINTERP,
+        typename KERNEL>
+void testFirKernel(KERNEL kernel, int count, TINTERP lerpP)
+{
+    constexpr int OUTPUT_CHANNELS = CHANNELS < 2 ? 2 : CHANNELS;
+    std::minstd_rand random(count * 100 + CHANNELS);
+    auto value = [&random](auto max) {
+        return static_cast<decltype(max)>(
+                std::uniform_real_distribution<double>(-1., 1.)(random) * max);
+    };
+    // keep the integer sums in range, ProcessBase() does not saturate.
+    const TC coefMax = is_same<TC, float>::value ? TC(1) : TC(256);
+    const TI sampleMax = is_same<TI, float>::value ? TI(1) : TI(32767);
+
+    // two adjacent phases for the positive and the negative side, cache line aligned.
+    std::vector<TC> coefStorage(4 * count + 64);
+    TC* const coefs = reinterpret_cast<TC*>(
+            (reinterpret_cast<uintptr_t>(coefStorage.data()) + 63) & ~uintptr_t(63));
+    for (int i = 0; i < 4 * count; ++i) {
+        coefs[i] = value(coefMax);
+    }
+    std::vector<TI> samples((2 * count + 1) * CHANNELS);
+    for (auto& sample : samples) {
+        sample = value(sampleMax);
+    }
+    const TC* const coefsP = coefs;
+    const TC* const coefsN = coefs + 2 * count;
+    const TI* const sP = samples.data() + (count - 1) * CHANNELS;
+    const TI* const sN = sP + CHANNELS;
+    const TO volumeLR[2] = {
+        is_same<TO, float>::value ? TO(0.75) : TO(0x0c000000),
+        is_same<TO, float>::value ? TO(0.5) : TO(0x08000000),
+    };
+
+    std::vector<TO> expected(OUTPUT_CHANNELS, TO(1));
+    std::vector<TO> actual(expected);
+    if (FIXED) {
+        android::ProcessBase<CHANNELS, 16, android::InterpNull>(
+                expected.data(), count, coefsP, coefsN, sP, sN, lerpP, volumeLR);
+    } else {
+        android::ProcessBase<CHANNELS, 16, android::InterpCompute>(
+                expected.data(), count, coefsP, coefsN, sP, sN, lerpP, volumeLR);
+    }
+    kernel(actual.data(), count, coefsP, coefsN, sP, sN, volumeLR, lerpP,
+            coefsP + count, coefsN + count);
+
+    for (int i = 0; i < OUTPUT_CHANNELS; ++i) {
+        if (is_same<TO, float>::value) {
+            EXPECT_NEAR(expected[i], actual[i], 1e-4 * count)
+                    << "channels " << CHANNELS << " count " << count << " sample " << i;
+        } else {
+            EXPECT_EQ(expected[i], actual[i])
+                    << "channels " << CHANNELS << " count " << count << " sample " << i;
+        }
+    }
+}
+
+template <int CHANNELS, typename TC, typename TI, typename TO, typename TINTERP>
+void testFirKernels(TINTERP lerpP)
+{
+    for (int count : {8, 16, 24, 32, 40, 48, 64}) {
+        if (android::resamplerFirHasAvx2()) {
+            testFirKernel<CHANNELS, true, TC, TI, TO>(
+                    [](auto... args) { android::ProcessAVX2<CHANNELS, true>(args...); },
+                    count, TINTERP(0));
+            testFirKernel<CHANNELS, false, TC, TI, TO>(
+                    [](auto... args) { android::ProcessAVX2<CHANNELS, false>(args...); },
+                    count, lerpP);
+        }
+        if constexpr (is_same<TC, float>::value) {
+            if (android::resamplerFirHasAvx512()) {
+                testFirKernel<CHANNELS, true, TC, TI, TO>(
+                        [](auto... args) { android::ProcessAVX512<CHANNELS, true>(args...); },
+                        count, TINTERP(0));
+                testFirKernel<CHANNELS, false, TC, TI, TO>(
+                        [](auto... args) { android::ProcessAVX512<CHANNELS, false>(args...); },
+                        count, lerpP);
+            }
+        }
+    }
+}
+
+TEST(audioflinger_resampler, firkernels_avx) {
+    if (!android::resamplerFirHasAvx2()) {
+        GTEST_SKIP() << "AVX2 not supported";
+    }
+    testFirKernels<3, float, float, float>(0.3f);
+    testFirKernels<6, float, float, float>(0.3f);
+    testFirKernels<8, float, float, float>(0.3f);
+    testFirKernels<13, float, float, float>(0.3f);
+    testFirKernels<16, float, float, float>(0.3f);
+    testFirKernels<24, float, float, float>(0.3f);
+    testFirKernels<1, int16_t, int16_t, int32_t>(0x2345u);
+    testFirKernels<2, int16_t, int16_t, int32_t>(0x2345u);
+}
+#endif // USE_SSE
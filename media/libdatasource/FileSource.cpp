@@ -24,6 +24,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 
@@ -33,7 +34,11 @@ FileSource::FileSource(const char *filename)
     : mFd(-1),
       mOffset(0),
       mLength(-1),
-      mName("<null>") {
+      mName("<null>"),
+      mReadMode(kReadModeSeek),
+      mMapBase(NULL),
+      mMapSize(0),
+      mMappedData(NULL) {
 
     if (filename) {
         mName = String8::format("FileSource(%s)", filename);
@@ -52,7 +57,11 @@ FileSource::FileSource(int fd, int64_t offset, int64_t length)
     : mFd(fd),
       mOffset(offset),
       mLength(length),
-      mName("<null>") {
+      mName("<null>"),
+      mReadMode(kReadModeSeek),
+      mMapBase(NULL),
+      mMapSize(0),
+      mMappedData(NULL) {
     ALOGV("fd=%d (%s), offset=%lld, length=%lld",
             fd, nameForFd(fd).c_str(), (long long) offset, (long long) length);
 
@@ -90,6 +99,7 @@ FileSource::FileSource(int fd, int64_t offset, int64_t length)
 }
 
 FileSource::~FileSource() {
+    unmapRange();
     if (mFd >= 0) {
         ::close(mFd);
         mFd = -1;
@@ -105,7 +115,17 @@ ssize_t FileSource::readAt(off64_t offset, void *data, size_t size) {
         return NO_INIT;
     }
 
+    if (mReadMode != kReadModeSeek) {
+        // mOffset and mLength are fixed after construction, and neither pread64()
+        // nor the mapping touch the shared file position, so no lock is needed.
+        return clampAndReadAt(offset, data, size);
+    }
+
     Mutex::Autolock autoLock(mLock);
+    return clampAndReadAt(offset, data, size);
+}
+
+ssize_t FileSource::clampAndReadAt(off64_t offset, void *data, size_t size) {
     if (mLength >= 0) {
         if (offset < 0) {
             return UNKNOWN_ERROR;
@@ -122,6 +142,27 @@ ssize_t FileSource::readAt(off64_t offset, void *data, size_t size) {
 }
 
 ssize_t FileSource::readAt_l(off64_t offset, void *data, size_t size) {
+    switch (mReadMode) {
+        case kReadModeMapped:
+        {
+            if (offset < 0 || (uint64_t)offset >= (uint64_t)mLength) {
+                return 0;
+            }
+            uint64_t numAvailable = mLength - offset;
+            if ((uint64_t)size > numAvailable) {
+                size = numAvailable;
+            }
+            memcpy(data, mMappedData + offset, size);
+            return size;
+        }
+
+        case kReadModePositional:
+            return pread64(mFd, data, size, offset + mOffset);
+
+        default:
+            break;
+    }
+
     off64_t result = lseek64(mFd, offset + mOffset, SEEK_SET);
     if (result == -1) {
         ALOGE("seek to %lld failed", (long long)(offset + mOffset));
@@ -131,6 +172,73 @@ ssize_t FileSource::readAt_l(off64_t offset, void *data, size_t size) {
     return ::read(mFd, data, size);
 }
 
+status_t FileSource::setReadMode(ReadMode mode) {
+    Mutex::Autolock autoLock(mLock);
+
+    if (mFd < 0) {
+        return NO_INIT;
+    }
+
+    if (mode == mReadMode) {
+        return OK;
+    }
+
+    if (mReadMode == kReadModeMapped) {
+        unmapRange();
+    }
+
+    if (mode == kReadModeMapped && mapRange() != OK) {
+        ALOGW("%s: mmap unavailable, using positional reads", mName.c_str());
+        mode = kReadModePositional;
+    }
+
+    mReadMode = mode;
+    return OK;
+}
+
+const void *FileSource::getMappedData(off64_t offset, size_t size) const {
+    if (mMappedData == NULL || offset < 0 || (uint64_t)offset > (uint64_t)mLength
+            || (uint64_t)size > (uint64_t)(mLength - offset)) {
+        return NULL;
+    }
+    return mMappedData + offset;
+}
+
+status_t FileSource::mapRange() {
+    if (mLength <= 0) {
+        return ERROR_UNSUPPORTED;
+    }
+
+    // mmap() wants a page-aligned file offset; map from the preceding page
+    // boundary and remember where mOffset lands inside the mapping.
+    const int64_t pageSize = sysconf(_SC_PAGESIZE);
+    const int64_t alignedOffset = mOffset - (mOffset % pageSize);
+    const uint64_t mapSize = (uint64_t)(mOffset - alignedOffset) + (uint64_t)mLength;
+    if (mapSize > SIZE_MAX) {
+        return ERROR_UNSUPPORTED;
+    }
+
+    void *base = mmap(NULL, (size_t)mapSize, PROT_READ, MAP_SHARED, mFd, alignedOffset);
+    if (base == MAP_FAILED) {
+        ALOGW("mmap of %llu bytes failed (%s)", (unsigned long long)mapSize, strerror(errno));
+        return UNKNOWN_ERROR;
+    }
+
+    mMapBase = base;
+    mMapSize = (size_t)mapSize;
+    mMappedData = (const uint8_t *)base + (mOffset - alignedOffset);
+    return OK;
+}
+
+void FileSource::unmapRange() {
+    if (mMapBase != NULL) {
+        munmap(mMapBase, mMapSize);
+        mMapBase = NULL;
+        mMapSize = 0;
+        mMappedData = NULL;
+    }
+}
+
 status_t FileSource::getSize(off64_t *size) {
     Mutex::Autolock autoLock(mLock);
 
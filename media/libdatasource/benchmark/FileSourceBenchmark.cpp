@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <datasource/FileSource.h>
+
+using namespace android;
+
+// Simulates the access pattern of an extractor with several tracks sharing one
+// FileSource: each track reads its own interleaved chunk of every "sample group".
+static constexpr size_t kFileSize = 32 * 1024 * 1024;
+static constexpr size_t kSampleSize = 16 * 1024;
+
+static int createTestFile() {
+    char path[] = "/data/local/tmp/filesource_benchmark_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return -1;
+    }
+    unlink(path);
+    std::vector<uint8_t> chunk(1024 * 1024);
+    for (size_t i = 0; i < chunk.size(); ++i) {
+        chunk[i] = (uint8_t)i;
+    }
+    for (size_t written = 0; written < kFileSize; written += chunk.size()) {
+        if (write(fd, chunk.data(), chunk.size()) != (ssize_t)chunk.size()) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+static void BM_FileSourceReadAt(benchmark::State& state) {
+    const FileSource::ReadMode mode = (FileSource::ReadMode)state.range(0);
+    const size_t numTracks = state.range(1);
+
+    int fd = createTestFile();
+    if (fd < 0) {
+        state.SkipWithError("cannot create test file");
+        return;
+    }
+    sp<FileSource> source = new FileSource(fd, 0, kFileSize);
+    source->setReadMode(mode);
+
+    const size_t groupSize = kSampleSize * numTracks;
+    const size_t numGroups = kFileSize / groupSize;
+
+    for (auto _ : state) {
+        std::vector<std::thread> tracks;
+        for (size_t t = 0; t < numTracks; ++t) {
+            tracks.emplace_back([&source, t, groupSize, numGroups]() {
+                std::vector<uint8_t> buffer(kSampleSize);
+                for (size_t g = 0; g < numGroups; ++g) {
+                    source->readAt(g * groupSize + t * kSampleSize, buffer.data(), kSampleSize);
+                    benchmark::DoNotOptimize(buffer.data());
+                }
+            });
+        }
+        for (auto& track : tracks) {
+            track.join();
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * numGroups * groupSize);
+}
+
+static void FileSourceArgs(benchmark::internal::Benchmark* b) {
+    for (int mode : {FileSource::kReadModeSeek, FileSource::kReadModePositional,
+                     FileSource::kReadModeMapped}) {
+        for (int tracks : {1, 2, 4, 8}) {
+            b->Args({mode, tracks});
+        }
+    }
+}
+
+BENCHMARK(BM_FileSourceReadAt)->Apply(FileSourceArgs)->UseRealTime();
+
+BENCHMARK_MAIN();
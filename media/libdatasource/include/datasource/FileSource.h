@@ -28,6 +28,18 @@ namespace android {
 
 class FileSource : public DataSource {
 public:
+    enum ReadMode {
+        // lseek64() followed by read(), serialized on mLock.
+        kReadModeSeek,
+        // pread64() without taking mLock, so concurrent readers (e.g. the
+        // tracks of one extractor) do not contend with each other.
+        kReadModePositional,
+        // The whole range is mmap()ed. readAt() copies out of the mapping
+        // without a syscall and getMappedData() hands out zero-copy views.
+        // Only use this for files that will not be truncated while mapped.
+        kReadModeMapped,
+    };
+
     FileSource(const char *filename);
     // FileSource takes ownership and will close the fd
     FileSource(int fd, int64_t offset, int64_t length);
@@ -46,6 +58,20 @@ public:
         return mName;
     }
 
+    // Selects how readAt() accesses the file. Must be called before the
+    // source is handed to other threads. If the range cannot be mapped,
+    // kReadModeMapped falls back to kReadModePositional.
+    status_t setReadMode(ReadMode mode);
+
+    ReadMode getReadMode() const {
+        return mReadMode;
+    }
+
+    // Returns a pointer to |size| bytes at |offset| inside the mapping, or
+    // NULL if the source is not mapped or the range is out of bounds. The
+    // pointer stays valid for the lifetime of this FileSource.
+    const void *getMappedData(off64_t offset, size_t size) const;
+
 protected:
     virtual ~FileSource();
     virtual ssize_t readAt_l(off64_t offset, void *data, size_t size);
@@ -57,6 +83,17 @@ protected:
 
 private:
     String8 mName;
+    ReadMode mReadMode;
+
+    // Page-aligned mapping returned by mmap() and the start of [mOffset, mOffset + mLength)
+    // within it.
+    void *mMapBase;
+    size_t mMapSize;
+    const uint8_t *mMappedData;
+
+    ssize_t clampAndReadAt(off64_t offset, void *data, size_t size);
+    status_t mapRange();
+    void unmapRange();
 
     FileSource(const FileSource &);
     FileSource &operator=(const FileSource &);
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FileSourceTest"
+#include <utils/Log.h>
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <android-base/file.h>
+#include <datasource/FileSource.h>
+#include <gtest/gtest.h>
+
+using namespace android;
+
+// Three pages and a bit, so that the sub-range below neither starts nor ends on a page.
+static constexpr size_t kFileSize = 3 * 4096 + 123;
+static constexpr int64_t kRangeOffset = 1000;
+static constexpr int64_t kRangeLength = 2 * 4096 + 77;
+
+static uint8_t byteAt(size_t position) {
+    return (uint8_t)(position * 7 + (position >> 8));
+}
+
+class FileSourceTest : public ::testing::TestWithParam<FileSource::ReadMode> {
+  public:
+    void SetUp() override {
+        std::vector<uint8_t> data(kFileSize);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = byteAt(i);
+        }
+        ASSERT_TRUE(android::base::WriteFully(mFile.fd, data.data(), data.size()));
+    }
+
+    // Returns a source for [offset, offset + length) of the file, using the read mode
+    // under test.
+    sp<FileSource> createSource(int64_t offset, int64_t length) {
+        sp<FileSource> source = new FileSource(dup(mFile.fd), offset, length);
+        EXPECT_EQ(OK, source->initCheck());
+        EXPECT_EQ(OK, source->setReadMode(GetParam()));
+        EXPECT_EQ(GetParam(), source->getReadMode());
+        return source;
+    }
+
+    // Checks that |size| bytes read at |offset| of a source starting at |rangeOffset|
+    // are the bytes of the file.
+    static void checkData(const uint8_t *data, int64_t rangeOffset, off64_t offset,
+            size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            ASSERT_EQ(byteAt(rangeOffset + offset + i), data[i]) << "at " << offset + i;
+        }
+    }
+
+    TemporaryFile mFile;
+};
+
+TEST_P(FileSourceTest, ReadWithinRange) {
+    for (const auto &[rangeOffset, rangeLength] : {
+            std::make_pair<int64_t, int64_t>(0, kFileSize),
+            std::make_pair(kRangeOffset, kRangeLength)}) {
+        sp<FileSource> source = createSource(rangeOffset, rangeLength);
+        off64_t size;
+        ASSERT_EQ(OK, source->getSize(&size));
+        ASSERT_EQ(rangeLength, size);
+
+        std::vector<uint8_t> buffer(rangeLength);
+        for (off64_t offset : {(off64_t)0, (off64_t)1, (off64_t)4095, (off64_t)4096,
+                (off64_t)rangeLength - 100}) {
+            const size_t toRead = 100;
+            ASSERT_EQ((ssize_t)toRead, source->readAt(offset, buffer.data(), toRead));
+            checkData(buffer.data(), rangeOffset, offset, toRead);
+        }
+        ASSERT_EQ(rangeLength, source->readAt(0, buffer.data(), rangeLength));
+        checkData(buffer.data(), rangeOffset, 0, rangeLength);
+    }
+}
+
+TEST_P(FileSourceTest, ReadAcrossEnd) {
+    for (const auto &[rangeOffset, rangeLength] : {
+            std::make_pair<int64_t, int64_t>(0, kFileSize),
+            std::make_pair(kRangeOffset, kRangeLength)}) {
+        sp<FileSource> source = createSource(rangeOffset, rangeLength);
+        // Only the bytes up to the end of the range are returned, even when the file
+        // goes on.
+        std::vector<uint8_t> buffer(200, 0xa5);
+        const off64_t offset = rangeLength - 10;
+        ASSERT_EQ(10, source->readAt(offset, buffer.data(), buffer.size()));
+        checkData(buffer.data(), rangeOffset, offset, 10);
+        for (size_t i = 10; i < buffer.size(); ++i) {
+            ASSERT_EQ(0xa5, buffer[i]) << "written past the end at " << i;
+        }
+    }
+}
+
+TEST_P(FileSourceTest, ReadPastEnd) {
+    for (const auto &[rangeOffset, rangeLength] : {
+            std::make_pair<int64_t, int64_t>(0, kFileSize),
+            std::make_pair(kRangeOffset, kRangeLength)}) {
+        sp<FileSource> source = createSource(rangeOffset, rangeLength);
+        uint8_t buffer[16];
+        EXPECT_EQ(0, source->readAt(rangeLength, buffer, sizeof(buffer)));
+        EXPECT_EQ(0, source->readAt(rangeLength + 1, buffer, sizeof(buffer)));
+        EXPECT_EQ(0, source->readAt(kFileSize + 4096, buffer, sizeof(buffer)));
+        EXPECT_EQ(0, source->readAt(INT64_MAX, buffer, sizeof(buffer)));
+        EXPECT_LT(source->readAt(-1, buffer, sizeof(buffer)), 0);
+    }
+}
+
+TEST_P(FileSourceTest, MappedData) {
+    sp<FileSource> source = createSource(kRangeOffset, kRangeLength);
+    const uint8_t *data = (const uint8_t *)source->getMappedData(0, kRangeLength);
+    if (GetParam() != FileSource::kReadModeMapped) {
+        EXPECT_EQ(nullptr, data);
+        return;
+    }
+    ASSERT_NE(nullptr, data);
+    checkData(data, kRangeOffset, 0, kRangeLength);
+    EXPECT_EQ(data + kRangeLength, source->getMappedData(kRangeLength, 0));
+    EXPECT_EQ(nullptr, source->getMappedData(kRangeLength - 10, 11));
+    EXPECT_EQ(nullptr, source->getMappedData(kRangeLength + 1, 0));
+    EXPECT_EQ(nullptr, source->getMappedData(-1, 1));
+}
+
+// Switching modes on a source keeps reading the same data.
+TEST_P(FileSourceTest, ChangeReadMode) {
+    sp<FileSource> source = createSource(kRangeOffset, kRangeLength);
+    std::vector<uint8_t> buffer(kRangeLength);
+    for (FileSource::ReadMode mode : {FileSource::kReadModeSeek,
+            FileSource::kReadModePositional, FileSource::kReadModeMapped, GetParam()}) {
+        ASSERT_EQ(OK, source->setReadMode(mode));
+        ASSERT_EQ(mode, source->getReadMode());
+        ASSERT_EQ(kRangeLength, source->readAt(0, buffer.data(), buffer.size()));
+        checkData(buffer.data(), kRangeOffset, 0, kRangeLength);
+        EXPECT_EQ(mode == FileSource::kReadModeMapped,
+                source->getMappedData(0, kRangeLength) != nullptr);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(FileSourceTestAll, FileSourceTest,
+        ::testing::Values(FileSource::kReadModeSeek,
+                          FileSource::kReadModePositional,
+                          FileSource::kReadModeMapped));
+
+// An empty range cannot be mapped.
+TEST(FileSourceMapFallbackTest, EmptyFile) {
+    TemporaryFile file;
+    sp<FileSource> source = new FileSource(dup(file.fd), 0, 0);
+    ASSERT_EQ(OK, source->initCheck());
+    ASSERT_EQ(OK, source->setReadMode(FileSource::kReadModeMapped));
+    EXPECT_EQ(FileSource::kReadModePositional, source->getReadMode());
+    EXPECT_EQ(nullptr, source->getMappedData(0, 0));
+    uint8_t buffer[16];
+    EXPECT_EQ(0, source->readAt(0, buffer, sizeof(buffer)));
+}
+
+// sysfs attributes report a size but cannot be mapped: mmap() fails.
+TEST(FileSourceMapFallbackTest, MmapFails) {
+    const char *path = "/sys/devices/system/cpu/online";
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        GTEST_SKIP() << "cannot open " << path << ": " << strerror(errno);
+    }
+    char expected[64] = {};
+    const ssize_t expectedSize = pread(fd, expected, sizeof(expected), 0);
+    ASSERT_GT(expectedSize, 0);
+
+    sp<FileSource> source = new FileSource(fd, 0, 4096);
+    ASSERT_EQ(OK, source->initCheck());
+    ASSERT_EQ(OK, source->setReadMode(FileSource::kReadModeMapped));
+    if (source->getReadMode() == FileSource::kReadModeMapped) {
+        GTEST_SKIP() << path << " can be mapped";
+    }
+    EXPECT_EQ(FileSource::kReadModePositional, source->getReadMode());
+    EXPECT_EQ(nullptr, source->getMappedData(0, 1));
+    char buffer[64] = {};
+    ASSERT_EQ(expectedSize, source->readAt(0, buffer, sizeof(buffer)));
+    EXPECT_EQ(0, memcmp(expected, buffer, expectedSize));
+}
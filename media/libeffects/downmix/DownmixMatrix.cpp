@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "DownmixMatrix"
+//#define LOG_NDEBUG 0
+#include <log/log.h>
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+
+#include <audio_utils/ChannelMix.h>
+
+#include "DownmixMatrix.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#ifndef USE_NEON
+#define USE_NEON (true)
+#endif
+#else
+#define USE_NEON (false)
+#endif
+#if USE_NEON
+#include <arm_neon.h>
+#define USE_SSE (false)
+#elif defined(__SSE2__)  // Should be supported in x86 ABI for both 32 & 64-bit.
+#define USE_SSE (true)
+#include <emmintrin.h>
+#else
+#define USE_SSE (false)
+#endif
+
+namespace android {
+
+namespace {
+
+inline float clampFloat(float value) {
+    return fmin(fmax(value, -1.f), 1.f);
+}
+
+// Returns the position in a sum of the term added after the given number of pairs of
+// other terms, or SIZE_MAX if no position matches. 0 pairs stand for position 0 or 1.
+inline size_t positionAfterPairs(size_t pairs) {
+    size_t position = 1;
+    while (position * (position - 1) / 2 < pairs) {
+        ++position;
+    }
+    return position * (position - 1) / 2 == pairs ? position : SIZE_MAX;
+}
+
+// 4 lane float vector operations used by DownmixMatrix::process().
+// A lane holds one frame, so that the additions for each frame are done in the same order
+// as in DownmixMatrix::processScalar().
+#if USE_NEON
+using vfloat = float32x4_t;
+
+inline vfloat vload(const float *p) { return vld1q_f32(p); }
+inline vfloat vzero() { return vdupq_n_f32(0.f); }
+inline vfloat vmul(vfloat a, float b) { return vmulq_n_f32(a, b); }
+inline vfloat vadd(vfloat a, vfloat b) { return vaddq_f32(a, b); }
+inline vfloat vclamp(vfloat a) {
+    return vminq_f32(vmaxq_f32(a, vdupq_n_f32(-1.f)), vdupq_n_f32(1.f));
+}
+
+// Transposes 4 rows of 4 samples, so that each vector holds one channel of 4 frames.
+inline void vtranspose(vfloat &a, vfloat &b, vfloat &c, vfloat &d) {
+    const float32x4x2_t ab = vtrnq_f32(a, b);
+    const float32x4x2_t cd = vtrnq_f32(c, d);
+    a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+
+inline void vloadStereo(const float *p, vfloat &left, vfloat &right) {
+    const float32x4x2_t lr = vld2q_f32(p);
+    left = lr.val[0];
+    right = lr.val[1];
+}
+
+inline void vstoreStereo(float *p, vfloat left, vfloat right) {
+    const float32x4x2_t lr = {{left, right}};
+    vst2q_f32(p, lr);
+}
+#elif USE_SSE
+using vfloat = __m128;
+
+inline vfloat vload(const float *p) { return _mm_loadu_ps(p); }
+inline vfloat vzero() { return _mm_setzero_ps(); }
+inline vfloat vmul(vfloat a, float b) { return _mm_mul_ps(a, _mm_set1_ps(b)); }
+inline vfloat vadd(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+inline vfloat vclamp(vfloat a) {
+    return _mm_min_ps(_mm_max_ps(a, _mm_set1_ps(-1.f)), _mm_set1_ps(1.f));
+}
+
+inline void vtranspose(vfloat &a, vfloat &b, vfloat &c, vfloat &d) {
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+}
+
+inline void vloadStereo(const float *p, vfloat &left, vfloat &right) {
+    const __m128 lr01 = _mm_loadu_ps(p);
+    const __m128 lr23 = _mm_loadu_ps(p + 4);
+    left = _mm_shuffle_ps(lr01, lr23, _MM_SHUFFLE(2, 0, 2, 0));
+    right = _mm_shuffle_ps(lr01, lr23, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+inline void vstoreStereo(float *p, vfloat left, vfloat right) {
+    _mm_storeu_ps(p, _mm_unpacklo_ps(left, right));
+    _mm_storeu_ps(p + 4, _mm_unpackhi_ps(left, right));
+}
+#endif
+
+}  // namespace
+
+bool DownmixMatrix::setInputChannelMask(audio_channel_mask_t inputChannelMask)
+{
+    mInputChannelCount = 0;
+    const size_t channelCount = audio_channel_count_from_out_mask(inputChannelMask);
+    if (channelCount == 0 || channelCount > kMaxInputChannels) {
+        return false;
+    }
+
+    // Fold one frame per input channel, with only that channel set to 1:
+    // the output of frame i is the pair of gains of channel i.
+    float identity[kMaxInputChannels * kMaxInputChannels]{};
+    for (size_t i = 0; i < channelCount; ++i) {
+        identity[i * channelCount + i] = 1.f;
+    }
+    float gains[kMaxInputChannels * FCC_2];
+    audio_utils::channels::ChannelMix<AUDIO_CHANNEL_OUT_STEREO> channelMix;
+    if (!channelMix.process(identity, gains, channelCount, false /* accumulate */,
+            inputChannelMask)) {
+        ALOGE("%s: channel mask %#x is not supported", __func__, inputChannelMask);
+        return false;
+    }
+    for (size_t s = 0; s < FCC_2; ++s) {
+        Side &side = mSides[s];
+        side.termCount = 0;
+        for (size_t i = 0; i < channelCount; ++i) {
+            side.gains[i] = gains[i * FCC_2 + s];
+            if (side.gains[i] != 0.f) {
+                side.order[side.termCount++] = i;
+            }
+        }
+        side.accumulateAt = side.termCount;
+    }
+
+    // ChannelMix adds the products of some masks in its own order. Find it out with frames
+    // where the terms y and z nearly cancel out, so that their sum is exact, and the term x
+    // is too small to be kept when added to either of them: the output differs from the sum
+    // of y and z only if x is added after both. The terms are the products and the output
+    // being accumulated, which stands for input channel channelCount.
+    constexpr float kTiny = 0x1p-40f;
+    const auto addedLast = [&](size_t s, size_t x, size_t y, size_t z) {
+        const Side &side = mSides[s];
+        float in[kMaxInputChannels]{};
+        float out[FCC_2]{};
+        const auto setTerm = [&](size_t t, float value) {
+            if (t == channelCount) {
+                out[s] = value;
+                return value;
+            }
+            in[t] = value / side.gains[t];
+            return in[t] * side.gains[t];
+        };
+        setTerm(x, kTiny);
+        const float sum = setTerm(y, 1.f) + setTerm(z, -1.f);
+        channelMix.process(in, out, 1, true /* accumulate */, inputChannelMask);
+        return out[s] != sum;
+    };
+    for (size_t s = 0; s < FCC_2; ++s) {
+        Side &side = mSides[s];
+        size_t terms[kMaxInputChannels + 1];
+        const size_t n = side.termCount + 1;
+        std::copy(side.order, side.order + side.termCount, terms);
+        terms[side.termCount] = channelCount;
+
+        // The number of pairs of terms added before a term gives its position, but for
+        // the first two, which may be added in either order.
+        size_t order[kMaxInputChannels + 1];
+        bool placed[kMaxInputChannels + 1]{};
+        size_t firstTwo = 0;
+        bool consistent = true;
+        for (size_t t = 0; t < n && consistent; ++t) {
+            size_t pairs = 0;
+            for (size_t u = 0; u < n; ++u) {
+                for (size_t v = u + 1; v < n; ++v) {
+                    if (u != t && v != t && addedLast(s, terms[t], terms[u], terms[v])) {
+                        ++pairs;
+                    }
+                }
+            }
+            const size_t position = pairs == 0 ? firstTwo++ : positionAfterPairs(pairs);
+            consistent = position < n && !placed[position];
+            if (consistent) {
+                placed[position] = true;
+                order[position] = terms[t];
+            }
+        }
+        if (!consistent) {
+            ALOGW("%s: channel mask %#x: cannot tell the order of the side %zu products,"
+                    " adding them in channel order", __func__, inputChannelMask, s);
+            continue;
+        }
+        for (size_t t = 0, k = 0; t < n; ++t) {
+            if (order[t] == channelCount) {
+                side.accumulateAt = k;
+            } else {
+                side.order[k++] = order[t];
+            }
+        }
+    }
+    mInputChannelCount = channelCount;
+    return true;
+}
+
+void DownmixMatrix::processScalar(
+        const float *src, float *dst, size_t frameCount, bool accumulate) const
+{
+    const size_t channelCount = mInputChannelCount;
+    for (size_t i = 0; i < frameCount; ++i) {
+        float out[FCC_2];
+        for (size_t s = 0; s < FCC_2; ++s) {
+            const Side &side = mSides[s];
+            float sum = 0.f;
+            size_t t = 0;
+            for (; t < side.accumulateAt; ++t) {
+                sum += src[side.order[t]] * side.gains[side.order[t]];
+            }
+            if (accumulate) {
+                sum += dst[s];
+            }
+            for (; t < side.termCount; ++t) {
+                sum += src[side.order[t]] * side.gains[side.order[t]];
+            }
+            out[s] = clampFloat(sum);
+        }
+        dst[0] = out[0];
+        dst[1] = out[1];
+        src += channelCount;
+        dst += FCC_2;
+    }
+}
+
+void DownmixMatrix::process(
+        const float *src, float *dst, size_t frameCount, bool accumulate) const
+{
+#if USE_NEON || USE_SSE
+    const size_t channelCount = mInputChannelCount;
+    const size_t blockCount = frameCount / 4;
+    vfloat column[kMaxInputChannels];  // column[c] holds channel c of the 4 frames
+    for (size_t i = 0; i < blockCount; ++i) {
+        const float * const frame0 = src;
+        const float * const frame1 = frame0 + channelCount;
+        const float * const frame2 = frame1 + channelCount;
+        const float * const frame3 = frame2 + channelCount;
+        size_t c = 0;
+        for (; c + 4 <= channelCount; c += 4) {
+            column[c] = vload(frame0 + c);
+            column[c + 1] = vload(frame1 + c);
+            column[c + 2] = vload(frame2 + c);
+            column[c + 3] = vload(frame3 + c);
+            vtranspose(column[c], column[c + 1], column[c + 2], column[c + 3]);
+        }
+        for (; c < channelCount; ++c) {
+            const float samples[4] = {frame0[c], frame1[c], frame2[c], frame3[c]};
+            column[c] = vload(samples);
+        }
+        vfloat out[FCC_2];
+        if (accumulate) {
+            vloadStereo(dst, out[0], out[1]);
+        }
+        for (size_t s = 0; s < FCC_2; ++s) {
+            const Side &side = mSides[s];
+            vfloat sum = vzero();
+            size_t t = 0;
+            for (; t < side.accumulateAt; ++t) {
+                sum = vadd(sum, vmul(column[side.order[t]], side.gains[side.order[t]]));
+            }
+            if (accumulate) {
+                sum = vadd(sum, out[s]);
+            }
+            for (; t < side.termCount; ++t) {
+                sum = vadd(sum, vmul(column[side.order[t]], side.gains[side.order[t]]));
+            }
+            out[s] = vclamp(sum);
+        }
+        vstoreStereo(dst, out[0], out[1]);
+        src += 4 * channelCount;
+        dst += 4 * FCC_2;
+    }
+    frameCount -= blockCount * 4;
+#endif
+    processScalar(src, dst, frameCount, accumulate);
+}
+
+}  // namespace android
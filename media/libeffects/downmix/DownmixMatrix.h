@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_DOWNMIX_MATRIX_H_
+#define ANDROID_DOWNMIX_MATRIX_H_
+
+#include <stddef.h>
+
+#include <system/audio.h>
+
+namespace android {
+
+// DownmixMatrix folds interleaved float multichannel audio to stereo.
+//
+// The gains of each input channel are computed once per channel mask, together with the order
+// in which ChannelMix adds the products for each output channel, and process() multiplies
+// 4 frames at a time with SIMD. Each output sample adds the products in that order, so
+// process() and processScalar() are bit exact with ChannelMix on all architectures.
+class DownmixMatrix {
+public:
+    static constexpr size_t kMaxInputChannels = FCC_26;
+
+    // Computes the gains and the summation order for inputChannelMask. Both are read from
+    // audio_utils::channels::ChannelMix, which remains the reference for the fold down.
+    // Returns false if the mask is not supported, in which case inputChannelCount() is 0.
+    bool setInputChannelMask(audio_channel_mask_t inputChannelMask);
+
+    size_t inputChannelCount() const { return mInputChannelCount; }
+
+    // Gain from input channel to the left (side 0) or right (side 1) output.
+    float gain(size_t channel, size_t side) const {
+        return mSides[side].gains[channel];
+    }
+
+    // Folds frameCount frames of src to stereo dst, adding to the contents of dst
+    // if accumulate is true. The output is clamped to [-1, 1].
+    void process(const float *src, float *dst, size_t frameCount, bool accumulate) const;
+
+    // Same as process(), one frame at a time without SIMD.
+    void processScalar(const float *src, float *dst, size_t frameCount, bool accumulate) const;
+
+private:
+    // One output channel: the input channels with a non zero gain in the order in which
+    // their products are added, and the number of products added before the output when
+    // accumulating.
+    struct Side {
+        float gains[kMaxInputChannels]{};
+        size_t order[kMaxInputChannels]{};
+        size_t termCount = 0;
+        size_t accumulateAt = 0;
+    };
+
+    size_t mInputChannelCount = 0;
+    Side mSides[FCC_2];
+};
+
+}  // namespace android
+
+#endif  // ANDROID_DOWNMIX_MATRIX_H_
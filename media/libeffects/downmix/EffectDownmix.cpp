@@ -18,8 +18,8 @@
 //#define LOG_NDEBUG 0
 #include <log/log.h>
 
+#include "DownmixMatrix.h"
 #include "EffectDownmix.h"
-#include <audio_utils/ChannelMix.h>
 
 // Do not submit with DOWNMIX_TEST_CHANNEL_INDEX defined, strictly for testing
 //#define DOWNMIX_TEST_CHANNEL_INDEX 0
@@ -40,7 +40,7 @@ struct downmix_object_t {
     downmix_type_t type;
     bool apply_volume_correction;
     uint8_t input_channel_count;
-    android::audio_utils::channels::ChannelMix<AUDIO_CHANNEL_OUT_STEREO> channelMix;
+    android::DownmixMatrix matrix;  // fold down gains of the input channel mask
 };
 
 typedef struct downmix_module_s {
@@ -369,12 +369,12 @@ static int32_t Downmix_Process(effect_handle_t self,
           break;
 
       case DOWNMIX_TYPE_FOLD: {
-            if (!pDownmixer->channelMix.process(
-                    pSrc, pDst, numFrames, accumulate, downmixInputChannelMask)) {
+            if (pDownmixer->matrix.inputChannelCount() == 0) {
                 ALOGE("Multichannel configuration %#x is not supported",
                       downmixInputChannelMask);
                 return -EINVAL;
             }
+            pDownmixer->matrix.process(pSrc, pDst, numFrames, accumulate);
         }
         break;
 
@@ -668,6 +668,9 @@ static int Downmix_Configure(downmix_module_t *pDwmModule, effect_config_t *pCon
         pDownmixer->input_channel_count =
                 audio_channel_count_from_out_mask(pConfig->inputCfg.channels);
     }
+    // an unsupported mask is reported by Downmix_Process() in DOWNMIX_TYPE_FOLD
+    (void)pDownmixer->matrix.setInputChannelMask(
+            (audio_channel_mask_t)pConfig->inputCfg.channels);
 
     Downmix_Reset(pDownmixer, init);
 
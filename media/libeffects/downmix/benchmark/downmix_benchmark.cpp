@@ -18,6 +18,7 @@
 #include <vector>
 
 #include <audio_effects/effect_downmix.h>
+#include <audio_utils/ChannelMix.h>
 #include <audio_utils/channels.h>
 #include <audio_utils/primitives.h>
 #include <audio_utils/Statistics.h>
@@ -60,7 +61,7 @@ static constexpr effect_uuid_t downmix_uuid = {
 static constexpr size_t kFrameCount = 1000;
 
 /*
-Pixel 7
+Pixel 7, measured when the effect used ChannelMix (now BM_ChannelMix)
 $ atest downmix_benchmark
 
 --------------------------------------------------------
@@ -171,6 +172,32 @@ static void BM_Downmix(benchmark::State& state) {
     }
 }
 
+// The reference ChannelMix fold down, which the downmix effect replaces by DownmixMatrix.
+static void BM_ChannelMix(benchmark::State& state) {
+    const audio_channel_mask_t channelMask = kChannelPositionMasks[state.range(0)];
+    const size_t channelCount = audio_channel_count_from_out_mask(channelMask);
+
+    std::minstd_rand gen(channelMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(kFrameCount * channelCount);
+    std::vector<float> output(kFrameCount * FCC_2);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+    android::audio_utils::channels::ChannelMix<AUDIO_CHANNEL_OUT_STEREO> channelMix;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+        channelMix.process(input.data(), output.data(), kFrameCount, false /* accumulate */,
+                channelMask);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetComplexityN(channelCount);
+    state.SetLabel(audio_channel_out_mask_to_string(channelMask));
+}
+
 static void DownmixArgs(benchmark::internal::Benchmark* b) {
     for (int i = 0; i < (int)std::size(kChannelPositionMasks); i++) {
         b->Args({i});
@@ -178,5 +205,6 @@ static void DownmixArgs(benchmark::internal::Benchmark* b) {
 }
 
 BENCHMARK(BM_Downmix)->Apply(DownmixArgs);
+BENCHMARK(BM_ChannelMix)->Apply(DownmixArgs);
 
 BENCHMARK_MAIN();
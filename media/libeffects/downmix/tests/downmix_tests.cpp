@@ -14,10 +14,13 @@
  * limitations under the License.
  */
 
+#include <random>
 #include <vector>
 
+#include "DownmixMatrix.h"
 #include "EffectDownmix.h"
 
+#include <audio_utils/ChannelMix.h>
 #include <audio_utils/channels.h>
 #include <audio_utils/primitives.h>
 #include <audio_utils/Statistics.h>
@@ -355,3 +358,84 @@ INSTANTIATE_TEST_SUITE_P(
                 + "_" + std::to_string(std::get<0>(info.param)) + "_" + std::to_string(index);
             return name;
         });
+
+// Frame counts which exercise the SIMD blocks of 4 frames and the scalar remainder.
+static constexpr size_t kMatrixFrameCounts[] = {1, 3, 4, 7, 256, 1027};
+
+static std::vector<float> randomFloats(size_t count, float amplitude, unsigned seed) {
+    std::minstd_rand gen(seed);
+    std::uniform_real_distribution<float> dis(-amplitude, amplitude);
+    std::vector<float> result(count);
+    for (auto& value : result) {
+        value = dis(gen);
+    }
+    return result;
+}
+
+class DownmixMatrixTest : public ::testing::TestWithParam<int /* channel mask index */> {};
+
+// process() must give the same bits as the scalar matrix multiply, including the clamping
+// of the accumulated output.
+TEST_P(DownmixMatrixTest, bitExactWithScalar) {
+    const audio_channel_mask_t channelMask = kChannelPositionMasks[GetParam()];
+    const size_t channelCount = audio_channel_count_from_out_mask(channelMask);
+    android::DownmixMatrix matrix;
+    ASSERT_TRUE(matrix.setInputChannelMask(channelMask));
+    ASSERT_EQ(channelCount, matrix.inputChannelCount());
+
+    for (size_t frames : kMatrixFrameCounts) {
+        for (bool accumulate : {false, true}) {
+            const std::vector<float> input =
+                    randomFloats(frames * channelCount, 1.f, channelMask + frames);
+            std::vector<float> output = randomFloats(frames * FCC_2, 1.f, frames);
+            std::vector<float> expected = output;
+            matrix.process(input.data(), output.data(), frames, accumulate);
+            matrix.processScalar(input.data(), expected.data(), frames, accumulate);
+            ASSERT_EQ(0, memcmp(expected.data(), output.data(), output.size() * sizeof(float)))
+                    << "frames " << frames << " accumulate " << accumulate;
+        }
+    }
+}
+
+// The fold down gains and result must be those of the reference ChannelMix, bit for bit:
+// DownmixMatrix adds the products in the order ChannelMix does for each mask.
+TEST_P(DownmixMatrixTest, matchesChannelMix) {
+    const audio_channel_mask_t channelMask = kChannelPositionMasks[GetParam()];
+    const size_t channelCount = audio_channel_count_from_out_mask(channelMask);
+    android::DownmixMatrix matrix;
+    ASSERT_TRUE(matrix.setInputChannelMask(channelMask));
+
+    for (size_t i = 0, channel = channelMask; channel != 0; ++i) {
+        const int index = __builtin_ctz(channel);
+        channel &= ~(1 << index);
+        if (channelMask & AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2) {
+            continue;  // LFE gains depend on the presence of LFE2, checked by DownmixTest
+        }
+        EXPECT_NEAR(kScaleFromChannelIdxLeft[index], matrix.gain(i, 0), 1e-5) << i;
+        EXPECT_NEAR(kScaleFromChannelIdxRight[index], matrix.gain(i, 1), 1e-5) << i;
+    }
+
+    android::audio_utils::channels::ChannelMix<AUDIO_CHANNEL_OUT_STEREO> channelMix;
+    for (size_t frames : kMatrixFrameCounts) {
+        for (bool accumulate : {false, true}) {
+            const std::vector<float> input =
+                    randomFloats(frames * channelCount, 1.f, channelMask + frames);
+            std::vector<float> output = randomFloats(frames * FCC_2, 1.f, frames);
+            std::vector<float> expected = output;
+            matrix.process(input.data(), output.data(), frames, accumulate);
+            ASSERT_TRUE(channelMix.process(
+                    input.data(), expected.data(), frames, accumulate, channelMask));
+            ASSERT_EQ(0, memcmp(expected.data(), output.data(), output.size() * sizeof(float)))
+                    << "frames " << frames << " accumulate " << accumulate;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        DownmixMatrixAll, DownmixMatrixTest,
+        ::testing::Range(0, (int)std::size(kChannelPositionMasks)),
+        [](const testing::TestParamInfo<DownmixMatrixTest::ParamType>& info) {
+            const audio_channel_mask_t channelMask = kChannelPositionMasks[info.param];
+            return std::string(audio_channel_out_mask_to_string(channelMask))
+                    + "_" + std::to_string(info.param);
+        });
@@ -753,6 +753,20 @@ status_t StagefrightRecorder::setParamMovieTimeScale(int32_t timeScale) {
     return OK;
 }
 
+status_t StagefrightRecorder::setParamFragmentDurationUs(int64_t durationUs) {
+    ALOGV("setParamFragmentDurationUs: %lld", (long long)durationUs);
+
+    // 0 turns fragmentation off. Fragments shorter than 100 ms mostly add
+    // moof overhead, and longer than a minute defeat the purpose.
+    if (durationUs != 0 && (durationUs < 100000LL || durationUs > 60000000LL)) {
+        ALOGE("Fragment duration (%lld us) is out of range [100 ms, 60 s]",
+                (long long)durationUs);
+        return BAD_VALUE;
+    }
+    mFragmentDurationUs = durationUs;
+    return OK;
+}
+
 status_t StagefrightRecorder::setParamVideoTimeScale(int32_t timeScale) {
     ALOGV("setParamVideoTimeScale: %d", timeScale);
 
@@ -959,6 +973,17 @@ status_t StagefrightRecorder::setParameter(
         if (safe_strtoi32(value.string(), &timeScale)) {
             return setParamMovieTimeScale(timeScale);
         }
+    } else if (key == "param-fragment-duration-us") {
+        int64_t durationUs;
+        if (safe_strtoi64(value.string(), &durationUs)) {
+            return setParamFragmentDurationUs(durationUs);
+        }
+    } else if (key == "param-fragment-segment-index") {
+        int32_t useSegmentIndex;
+        if (safe_strtoi32(value.string(), &useSegmentIndex)) {
+            mUseFragmentSegmentIndex = (useSegmentIndex != 0);
+            return OK;
+        }
     } else if (key == "param-use-64bit-offset") {
         int32_t use64BitOffset;
         if (safe_strtoi32(value.string(), &use64BitOffset)) {
@@ -2270,6 +2295,10 @@ void StagefrightRecorder::setupMPEG4orWEBMMetaData(sp<MetaData> *meta) {
     if (mOutputFormat == OUTPUT_FORMAT_MPEG_4 || mOutputFormat == OUTPUT_FORMAT_THREE_GPP) {
         (*meta)->setInt32(kKeyEmptyTrackMalFormed, true);
         (*meta)->setInt32(kKey4BitTrackIds, true);
+        if (mFragmentDurationUs > 0) {
+            (*meta)->setInt64(kKeyFragmentDurationUs, mFragmentDurationUs);
+            (*meta)->setInt32(kKeyFragmentSegmentIndex, mUseFragmentSegmentIndex);
+        }
     }
 }
 
@@ -2484,6 +2513,8 @@ status_t StagefrightRecorder::reset() {
     mMaxFileDurationUs = 0;
     mMaxFileSizeBytes = 0;
     mTrackEveryTimeDurationUs = 0;
+    mFragmentDurationUs = 0;
+    mUseFragmentSegmentIndex = false;
     mCaptureFpsEnable = false;
     mCaptureFps = -1.0;
     mCameraSourceTimeLapse = NULL;
@@ -2648,6 +2679,9 @@ status_t StagefrightRecorder::dump(
     result.append(buffer);
     snprintf(buffer, SIZE, "     Progress notification: %" PRId64 " us\n", mTrackEveryTimeDurationUs);
     result.append(buffer);
+    snprintf(buffer, SIZE, "     Fragment duration (us): %" PRId64 "%s\n", mFragmentDurationUs,
+            mUseFragmentSegmentIndex ? " with sidx" : "");
+    result.append(buffer);
     snprintf(buffer, SIZE, "   Audio\n");
     result.append(buffer);
     snprintf(buffer, SIZE, "     Source: %d\n", mAudioSource);
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "FanoutPipe"
+//#define LOG_NDEBUG 0
+
+#include <algorithm>
+#include <string.h>
+
+#include <cutils/compiler.h>
+#include <utils/Log.h>
+#include <media/nbaio/FanoutPipe.h>
+#include <media/nbaio/FanoutPipeReader.h>
+#include <audio_utils/roundup.h>
+
+namespace android {
+
+FanoutPipe::FanoutPipe(size_t maxFrames, const NBAIO_Format& format, bool backpressure,
+        void *buffer) :
+        NBAIO_Sink(format),
+        mMaxFrames(roundup(maxFrames)),
+        mBuffer(buffer == NULL ? malloc(mMaxFrames * mFrameSize) : buffer),
+        mBackpressure(backpressure),
+        mFreeBufferInDestructor(buffer == NULL)
+{
+    for (auto& front : mFronts) {
+        front.store(kFree, std::memory_order_relaxed);
+    }
+}
+
+FanoutPipe::~FanoutPipe()
+{
+    // Readers hold a reference to the pipe, so they are all gone.
+    ALOG_ASSERT(readers() == 0);
+    if (mFreeBufferInDestructor) {
+        free(mBuffer);
+    }
+}
+
+sp<FanoutPipeReader> FanoutPipe::newReader()
+{
+    // The writer may be running, start at the last frame it published.
+    const int64_t rear = mRear.load(std::memory_order_acquire);
+    for (size_t i = 0; i < kMaxReaders; i++) {
+        int64_t expected = kFree;
+        if (mFronts[i].compare_exchange_strong(expected, rear, std::memory_order_acq_rel)) {
+            return new FanoutPipeReader(sp<FanoutPipe>::fromExisting(this), i, rear);
+        }
+    }
+    ALOGW("%s: already %zu readers", __func__, kMaxReaders);
+    return nullptr;
+}
+
+size_t FanoutPipe::readers() const
+{
+    size_t readers = 0;
+    for (const auto& front : mFronts) {
+        if (front.load(std::memory_order_relaxed) != kFree) {
+            readers++;
+        }
+    }
+    return readers;
+}
+
+namespace {
+
+using Word = uintptr_t;
+static_assert(sizeof(std::atomic<Word>) == sizeof(Word) && std::atomic<Word>::is_always_lock_free);
+static_assert(sizeof(std::atomic<uint8_t>) == 1 && std::atomic<uint8_t>::is_always_lock_free);
+
+// Bytes of shared before its first aligned word.
+size_t headSize(const void *shared, size_t size)
+{
+    return std::min(size, (size_t) (-(uintptr_t) shared & (sizeof(Word) - 1)));
+}
+
+}   // namespace
+
+// static
+void FanoutPipe::copyToShared(void *shared, const void *buffer, size_t size)
+{
+    auto *dst = (std::atomic<uint8_t> *) shared;
+    const uint8_t *src = (const uint8_t *) buffer;
+    for (size_t head = headSize(shared, size); head > 0; head--, size--) {
+        (dst++)->store(*src++, std::memory_order_relaxed);
+    }
+    for (; size >= sizeof(Word); size -= sizeof(Word)) {
+        Word word;
+        memcpy(&word, src, sizeof(word));
+        ((std::atomic<Word> *) dst)->store(word, std::memory_order_relaxed);
+        dst += sizeof(Word);
+        src += sizeof(Word);
+    }
+    for (; size > 0; size--) {
+        (dst++)->store(*src++, std::memory_order_relaxed);
+    }
+}
+
+// static
+void FanoutPipe::copyFromShared(void *buffer, const void *shared, size_t size)
+{
+    uint8_t *dst = (uint8_t *) buffer;
+    const auto *src = (const std::atomic<uint8_t> *) shared;
+    for (size_t head = headSize(shared, size); head > 0; head--, size--) {
+        *dst++ = (src++)->load(std::memory_order_relaxed);
+    }
+    for (; size >= sizeof(Word); size -= sizeof(Word)) {
+        const Word word = ((const std::atomic<Word> *) src)->load(std::memory_order_relaxed);
+        memcpy(dst, &word, sizeof(word));
+        dst += sizeof(Word);
+        src += sizeof(Word);
+    }
+    for (; size > 0; size--) {
+        *dst++ = (src++)->load(std::memory_order_relaxed);
+    }
+}
+
+int64_t FanoutPipe::minFront(int64_t rear) const
+{
+    int64_t result = rear;
+    for (const auto& entry : mFronts) {
+        // acquire so that the reader is done with the frames before we overwrite them
+        const int64_t front = entry.load(std::memory_order_acquire);
+        if (front != kFree && front < result) {
+            result = front;
+        }
+    }
+    return result;
+}
+
+int64_t FanoutPipe::maxLag() const
+{
+    const int64_t rear = mRear.load(std::memory_order_acquire);
+    return rear - minFront(rear);
+}
+
+ssize_t FanoutPipe::availableToWrite()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    if (!mBackpressure) {
+        return mMaxFrames;
+    }
+    const int64_t rear = mRear.load(std::memory_order_relaxed);  // only the writer changes it
+    const int64_t filled = rear - minFront(rear);
+    return filled >= (int64_t) mMaxFrames ? 0 : mMaxFrames - (size_t) filled;
+}
+
+ssize_t FanoutPipe::write(const void *buffer, size_t count)
+{
+    // count == 0 is unlikely and not worth checking for
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    const ssize_t avail = availableToWrite();
+    if (count > (size_t) avail) {
+        count = avail;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    const int64_t rear = mRear.load(std::memory_order_relaxed);
+    // Tell readers which frames are about to be overwritten before touching them.
+    mRearReserved.store(rear + count, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const size_t offset = (size_t) rear & (mMaxFrames - 1);
+    const size_t part1 = std::min(count, mMaxFrames - offset);
+    copyToShared((char *) mBuffer + offset * mFrameSize, buffer, part1 * mFrameSize);
+    if (part1 < count) {
+        copyToShared(mBuffer, (const char *) buffer + part1 * mFrameSize,
+                (count - part1) * mFrameSize);
+    }
+
+    mRear.store(rear + count, std::memory_order_release);
+    mFramesWritten += count;
+    return count;
+}
+
+}   // namespace android
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "FanoutPipeReader"
+//#define LOG_NDEBUG 0
+
+#include <algorithm>
+
+#include <cutils/compiler.h>
+#include <utils/Log.h>
+#include <media/nbaio/FanoutPipeReader.h>
+
+namespace android {
+
+FanoutPipeReader::FanoutPipeReader(const sp<FanoutPipe>& pipe, size_t index, int64_t front) :
+        NBAIO_Source(pipe->mFormat),
+        mPipe(pipe), mIndex(index), mFront(front),
+        mFramesOverrun(0),
+        mOverruns(0)
+{
+}
+
+FanoutPipeReader::~FanoutPipeReader()
+{
+    mPipe->mFronts[mIndex].store(FanoutPipe::kFree, std::memory_order_release);
+}
+
+void FanoutPipeReader::publishFront()
+{
+    // release so that the writer does not overwrite frames we are still copying
+    mPipe->mFronts[mIndex].store(mFront, std::memory_order_release);
+}
+
+void FanoutPipeReader::overrun(int64_t rear)
+{
+    mFramesOverrun += rear - mFront;
+    ++mOverruns;
+    mFront = rear;
+    publishFront();
+}
+
+int64_t FanoutPipeReader::framesLag() const
+{
+    return mPipe->mRear.load(std::memory_order_acquire) - mFront;
+}
+
+ssize_t FanoutPipeReader::availableToRead()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    const int64_t rear = mPipe->mRear.load(std::memory_order_acquire);
+    const int64_t filled = rear - mFront;
+    if (filled > (int64_t) mPipe->mMaxFrames) {
+        overrun(rear);
+        return OVERRUN;
+    }
+    return filled;
+}
+
+ssize_t FanoutPipeReader::read(void *buffer, size_t count)
+{
+    const FanoutPipe& pipe = *mPipe;
+    const int64_t rear = pipe.mRear.load(std::memory_order_acquire);
+    const int64_t filled = rear - mFront;
+    if (filled > (int64_t) pipe.mMaxFrames) {
+        overrun(rear);
+        return OVERRUN;
+    }
+    if ((int64_t) count > filled) {
+        count = filled;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    const size_t offset = (size_t) mFront & (pipe.mMaxFrames - 1);
+    const size_t part1 = std::min(count, pipe.mMaxFrames - offset);
+    FanoutPipe::copyFromShared(buffer, (const char *) pipe.mBuffer + offset * mFrameSize,
+            part1 * mFrameSize);
+    if (part1 < count) {
+        FanoutPipe::copyFromShared((char *) buffer + part1 * mFrameSize, pipe.mBuffer,
+                (count - part1) * mFrameSize);
+    }
+
+    // If the writer started overwriting the frames while we copied them, the copy is not valid.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const int64_t reserved = pipe.mRearReserved.load(std::memory_order_relaxed);
+    if (reserved - mFront > (int64_t) pipe.mMaxFrames) {
+        // Frames up to reserved may not be published yet, skip to the published ones.
+        overrun(pipe.mRear.load(std::memory_order_acquire));
+        return OVERRUN;
+    }
+
+    mFront += count;
+    publishFront();
+    mFramesRead += count;
+    return count;
+}
+
+ssize_t FanoutPipeReader::flush()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    const int64_t rear = mPipe->mRear.load(std::memory_order_acquire);
+    const int64_t filled = rear - mFront;
+    if (filled > (int64_t) mPipe->mMaxFrames) {
+        overrun(rear);
+        return OVERRUN;
+    }
+    mFront = rear;
+    publishFront();
+    mFramesRead += filled;  // we consider flushed frames as read, but not lost frames
+    return filled;
+}
+
+}   // namespace android
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_FANOUT_PIPE_H
+#define ANDROID_AUDIO_FANOUT_PIPE_H
+
+#include <atomic>
+
+#include <media/nbaio/NBAIO.h>
+
+namespace android {
+
+class FanoutPipeReader;
+
+// FanoutPipe broadcasts the frames written by a single writer thread to up to kMaxReaders
+// readers (see FanoutPipeReader), all reading from the same shared buffer, so that each
+// consumer does not need its own copy of the data.
+//
+// Unlike Pipe, the writer can see how far behind each reader is. Each reader counts its own
+// overruns, and maxLag() reports the lag of the slowest reader.
+// With backpressure enabled, availableToWrite() and write() are limited by the slowest reader,
+// so that no reader overruns; a reader that stops reading then stalls the writer.
+// Without backpressure, the writer never waits and slow readers overrun, as with Pipe.
+//
+// The writer and the readers are lock-free. Readers can be added and removed dynamically,
+// and it's OK to have no readers.
+class FanoutPipe : public NBAIO_Sink {
+    friend class FanoutPipeReader;
+
+public:
+    static constexpr size_t kMaxReaders = 8;
+
+    // maxFrames will be rounded up to a power of 2, and all slots are available. Must be >= 2.
+    // buffer is an optional parameter specifying the virtual address of the pipe buffer,
+    // which must be of size roundup(maxFrames) * Format_frameSize(format) bytes.
+    FanoutPipe(size_t maxFrames, const NBAIO_Format& format, bool backpressure = false,
+            void *buffer = NULL);
+
+    // If a buffer was specified in the constructor, it is not automatically freed by destructor.
+    virtual ~FanoutPipe();
+
+    // Attach a new reader, which starts reading at the frames written after this call.
+    // Returns NULL if kMaxReaders readers are already attached.
+    // Thread safe. The reader keeps the pipe alive, and detaches when destroyed.
+    sp<FanoutPipeReader> newReader();
+
+    // NBAIO_Port interface
+
+    //virtual ssize_t negotiate(const NBAIO_Format offers[], size_t numOffers,
+    //                          NBAIO_Format counterOffers[], size_t& numCounterOffers);
+    //virtual NBAIO_Format format() const;
+
+    // NBAIO_Sink interface
+
+    //virtual int64_t framesWritten() const;
+    //virtual int64_t framesUnderrun() const;
+    //virtual int64_t underruns() const;
+
+    // Without backpressure this is always the pipe size, as for Pipe.
+    // With backpressure it is the space left by the slowest reader.
+    virtual ssize_t availableToWrite();
+
+    virtual ssize_t write(const void *buffer, size_t count);
+
+    //virtual ssize_t writeVia(writeVia_t via, size_t total, void *user, size_t block);
+
+    // Number of readers currently attached.
+    size_t readers() const;
+
+    // Frames written but not yet read by the slowest reader, 0 if there are no readers.
+    // Can be larger than the pipe size when a reader has overrun without backpressure.
+    int64_t maxLag() const;
+
+    bool hasBackpressure() const { return mBackpressure; }
+
+private:
+    // Value of a free entry in mFronts.
+    static constexpr int64_t kFree = -1;
+
+    // Lowest front of the attached readers, or rear if there are none.
+    int64_t minFront(int64_t rear) const;
+
+    // Copy size bytes to or from the shared buffer with relaxed atomic accesses, a word at a
+    // time where the shared buffer is aligned. A reader may copy frames while the writer
+    // overwrites them, and then discards the torn copy, so plain memcpy() would be a data race.
+    static void copyToShared(void *shared, const void *buffer, size_t size);
+    static void copyFromShared(void *buffer, const void *shared, size_t size);
+
+    const size_t    mMaxFrames;     // always a power of 2
+    void * const    mBuffer;
+    const bool      mBackpressure;
+    const bool      mFreeBufferInDestructor;
+
+    // Frames published to readers.
+    std::atomic<int64_t> mRear{0};
+    // Set by the writer before it copies frames up to this position, so that readers
+    // can detect frames overwritten while they were reading them.
+    std::atomic<int64_t> mRearReserved{0};
+    // Front of the reader using each entry, or kFree.
+    std::atomic<int64_t> mFronts[kMaxReaders];
+};
+
+}   // namespace android
+
+#endif  // ANDROID_AUDIO_FANOUT_PIPE_H
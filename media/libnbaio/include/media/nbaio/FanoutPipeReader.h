@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_FANOUT_PIPE_READER_H
+#define ANDROID_AUDIO_FANOUT_PIPE_READER_H
+
+#include "FanoutPipe.h"
+
+namespace android {
+
+// FanoutPipeReader is safe for only a single thread.
+// Create with FanoutPipe::newReader().
+class FanoutPipeReader : public NBAIO_Source {
+    friend class FanoutPipe;
+
+public:
+    virtual ~FanoutPipeReader();
+
+    // NBAIO_Port interface
+
+    //virtual ssize_t negotiate(const NBAIO_Format offers[], size_t numOffers,
+    //                          NBAIO_Format counterOffers[], size_t& numCounterOffers);
+    //virtual NBAIO_Format format() const;
+
+    // NBAIO_Source interface
+
+    //virtual size_t framesRead() const;
+    virtual int64_t framesOverrun() { return mFramesOverrun; }
+    virtual int64_t overruns()  { return mOverruns; }
+
+    virtual ssize_t availableToRead();
+
+    virtual ssize_t read(void *buffer, size_t count);
+
+    virtual ssize_t flush();
+
+    // NBAIO_Source end
+
+    // Frames written to the pipe but not yet read by this reader.
+    int64_t framesLag() const;
+
+    const sp<FanoutPipe>& pipe() const { return mPipe; }
+
+private:
+    FanoutPipeReader(const sp<FanoutPipe>& pipe, size_t index, int64_t front);
+
+    // Called when more than the pipe size is unread: skip to rear and count the lost frames.
+    void overrun(int64_t rear);
+
+    // Make mFront visible to the writer.
+    void publishFront();
+
+    const sp<FanoutPipe> mPipe;
+    const size_t mIndex;        // entry in mPipe->mFronts
+    int64_t     mFront;
+    int64_t     mFramesOverrun;
+    int64_t     mOverruns;
+};
+
+}   // namespace android
+
+#endif  // ANDROID_AUDIO_FANOUT_PIPE_READER_H
@@ -0,0 +1,453 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "FanoutPipeTest"
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/nbaio/FanoutPipe.h>
+#include <media/nbaio/FanoutPipeReader.h>
+#include <utils/Log.h>
+
+namespace android {
+
+namespace {
+
+constexpr size_t kPipeFrames = 64;
+
+const NBAIO_Format kStereo16 = Format_from_SR_C(48000, 2, AUDIO_FORMAT_PCM_16_BIT);
+
+void negotiate(NBAIO_Port *port, const NBAIO_Format& format) {
+    NBAIO_Format offers[1] = {format};
+    size_t numCounterOffers = 0;
+    ASSERT_EQ(port->negotiate(offers, 1, nullptr, numCounterOffers), 0);
+}
+
+// Writes and checks frames whose samples count up from 0, as a sample counter truncated to the
+// width of the samples, so that a frame read from the wrong place or torn is caught.
+class SampleCounter {
+  public:
+    explicit SampleCounter(const NBAIO_Format& format) :
+            mChannelCount(Format_channelCount(format)),
+            mSampleSize(Format_frameSize(format) / mChannelCount) {}
+
+    size_t frameSize() const { return mChannelCount * mSampleSize; }
+
+    // The frames from frame index first.
+    std::vector<uint8_t> frames(int64_t first, size_t count) const {
+        std::vector<uint8_t> data(count * frameSize());
+        for (size_t i = 0; i < count * mChannelCount; i++) {
+            const uint32_t sample = (uint32_t) (first * mChannelCount + i);
+            memcpy(&data[i * mSampleSize], &sample, mSampleSize);  // little endian
+        }
+        return data;
+    }
+
+    // Returns the index of the first sample of data that is not the one of frame first + i.
+    size_t check(const void *data, int64_t first, size_t count) const {
+        const std::vector<uint8_t> expected = frames(first, count);
+        for (size_t i = 0; i < count * mChannelCount; i++) {
+            if (memcmp((const uint8_t *) data + i * mSampleSize, &expected[i * mSampleSize],
+                    mSampleSize) != 0) {
+                return i;
+            }
+        }
+        return count * mChannelCount;
+    }
+
+    size_t samples(size_t frames) const { return frames * mChannelCount; }
+
+  private:
+    const size_t mChannelCount;
+    const size_t mSampleSize;
+};
+
+}  // namespace
+
+class FanoutPipeTest : public ::testing::Test {
+  protected:
+    void SetUp() override { createPipe(false /*backpressure*/); }
+
+    void createPipe(bool backpressure, size_t frames = kPipeFrames,
+            const NBAIO_Format& format = kStereo16) {
+        mFormat = format;
+        mPipe = new FanoutPipe(frames, format, backpressure);
+        negotiate(mPipe.get(), format);
+        mWritten = 0;
+    }
+
+    sp<FanoutPipeReader> newReader() {
+        sp<FanoutPipeReader> reader = mPipe->newReader();
+        if (reader != nullptr) {
+            negotiate(reader.get(), mFormat);
+        }
+        return reader;
+    }
+
+    // Writes the next count frames, returns what write() returned.
+    ssize_t write(size_t count) {
+        const SampleCounter counter(mFormat);
+        const std::vector<uint8_t> frames = counter.frames(mWritten, count);
+        const ssize_t written = mPipe->write(frames.data(), count);
+        if (written > 0) {
+            mWritten += written;
+        }
+        return written;
+    }
+
+    // Reads up to count frames, which must be the frames from first, returns what read()
+    // returned.
+    ssize_t read(const sp<FanoutPipeReader>& reader, size_t count, int64_t first) {
+        const SampleCounter counter(mFormat);
+        std::vector<uint8_t> buffer(count * counter.frameSize());
+        const ssize_t read = reader->read(buffer.data(), count);
+        if (read > 0) {
+            EXPECT_EQ(counter.check(buffer.data(), first, read), counter.samples(read));
+        }
+        return read;
+    }
+
+    NBAIO_Format mFormat;
+    sp<FanoutPipe> mPipe;
+    int64_t mWritten;
+};
+
+TEST_F(FanoutPipeTest, OverrunTest) {
+    sp<FanoutPipeReader> slow = newReader();
+    sp<FanoutPipeReader> fast = newReader();
+    ASSERT_NE(slow, nullptr);
+    ASSERT_NE(fast, nullptr);
+    EXPECT_EQ(mPipe->readers(), 2u);
+
+    // A full pipe is not an overrun.
+    EXPECT_EQ(write(kPipeFrames), (ssize_t) kPipeFrames);
+    EXPECT_EQ(slow->availableToRead(), (ssize_t) kPipeFrames);
+    EXPECT_EQ(read(fast, kPipeFrames, 0), (ssize_t) kPipeFrames);
+    EXPECT_EQ(mPipe->maxLag(), (int64_t) kPipeFrames);
+    EXPECT_EQ(read(slow, 10, 0), 10);
+
+    // Without backpressure the writer does not wait for the slow reader.
+    EXPECT_EQ(mPipe->availableToWrite(), (ssize_t) kPipeFrames);
+    EXPECT_EQ(write(kPipeFrames), (ssize_t) kPipeFrames);
+    EXPECT_EQ(read(fast, kPipeFrames, kPipeFrames), (ssize_t) kPipeFrames);
+    EXPECT_EQ(slow->framesLag(), (int64_t) (2 * kPipeFrames - 10));
+    EXPECT_EQ(mPipe->maxLag(), (int64_t) (2 * kPipeFrames - 10));
+
+    // read() skips the lost frames and counts them, the next read continues from the rear.
+    EXPECT_EQ(read(slow, kPipeFrames, 0), (ssize_t) OVERRUN);
+    EXPECT_EQ(slow->overruns(), 1);
+    EXPECT_EQ(slow->framesOverrun(), (int64_t) (2 * kPipeFrames - 10));
+    EXPECT_EQ(slow->framesLag(), 0);
+    EXPECT_EQ(slow->availableToRead(), 0);
+    EXPECT_EQ(write(5), 5);
+    EXPECT_EQ(read(slow, kPipeFrames, 2 * kPipeFrames), 5);
+
+    // So does availableToRead().
+    EXPECT_EQ(write(kPipeFrames), (ssize_t) kPipeFrames);
+    EXPECT_EQ(write(1), 1);
+    EXPECT_EQ(slow->availableToRead(), (ssize_t) OVERRUN);
+    EXPECT_EQ(slow->overruns(), 2);
+    EXPECT_EQ(slow->framesOverrun(), (int64_t) (3 * kPipeFrames - 10 + 1));
+    EXPECT_EQ(slow->availableToRead(), 0);
+
+    // And flush(), which otherwise skips the frames and counts them as read, not lost.
+    EXPECT_EQ(write(kPipeFrames + 1), (ssize_t) kPipeFrames);
+    EXPECT_EQ(write(1), 1);
+    EXPECT_EQ(slow->flush(), (ssize_t) OVERRUN);
+    EXPECT_EQ(slow->overruns(), 3);
+    EXPECT_EQ(slow->framesOverrun(), (int64_t) (4 * kPipeFrames - 10 + 2));
+    EXPECT_EQ(write(kPipeFrames), (ssize_t) kPipeFrames);
+    EXPECT_EQ(slow->flush(), (ssize_t) kPipeFrames);
+    EXPECT_EQ(slow->overruns(), 3);
+    EXPECT_EQ(slow->framesLag(), 0);
+
+    // Every frame written is either read, flushed or lost.
+    EXPECT_EQ(slow->framesRead() + slow->framesOverrun(), mWritten);
+    EXPECT_EQ(mPipe->framesWritten(), mWritten);
+
+    // The overruns of the slow reader are not counted for the fast one.
+    EXPECT_EQ(fast->overruns(), 0);
+    EXPECT_EQ(fast->framesOverrun(), 0);
+}
+
+TEST_F(FanoutPipeTest, BackpressureTest) {
+    createPipe(true /*backpressure*/);
+    ASSERT_TRUE(mPipe->hasBackpressure());
+
+    // Without readers the writer never waits.
+    EXPECT_EQ(mPipe->availableToWrite(), (ssize_t) kPipeFrames);
+    EXPECT_EQ(write(kPipeFrames), (ssize_t) kPipeFrames);
+    EXPECT_EQ(write(kPipeFrames), (ssize_t) kPipeFrames);
+    EXPECT_EQ(mPipe->maxLag(), 0);
+
+    sp<FanoutPipeReader> slow = newReader();
+    sp<FanoutPipeReader> fast = newReader();
+    ASSERT_NE(slow, nullptr);
+    ASSERT_NE(fast, nullptr);
+    const int64_t first = mWritten;
+
+    // The writer is limited by the slowest reader.
+    EXPECT_EQ(write(kPipeFrames + 10), (ssize_t) kPipeFrames);
+    EXPECT_EQ(mPipe->availableToWrite(), 0);
+    EXPECT_EQ(write(1), 0);
+    EXPECT_EQ(read(fast, kPipeFrames, first), (ssize_t) kPipeFrames);
+    EXPECT_EQ(mPipe->availableToWrite(), 0);
+    EXPECT_EQ(read(slow, 10, first), 10);
+    EXPECT_EQ(mPipe->availableToWrite(), 10);
+    EXPECT_EQ(write(20), 10);
+    EXPECT_EQ(mPipe->maxLag(), (int64_t) kPipeFrames);
+
+    // A reader that flushes frees its frames like one that reads them.
+    EXPECT_EQ(slow->flush(), (ssize_t) kPipeFrames);
+    EXPECT_EQ(mPipe->availableToWrite(), (ssize_t) kPipeFrames - 10);
+    EXPECT_EQ(read(fast, kPipeFrames, first + kPipeFrames), 10);
+
+    // A stalled reader stalls the writer until it is removed.
+    EXPECT_EQ(write(kPipeFrames), (ssize_t) kPipeFrames);
+    EXPECT_EQ(read(fast, kPipeFrames, mWritten - kPipeFrames), (ssize_t) kPipeFrames);
+    EXPECT_EQ(mPipe->availableToWrite(), 0);
+    slow.clear();
+    EXPECT_EQ(mPipe->availableToWrite(), (ssize_t) kPipeFrames);
+
+    // No reader lost frames.
+    EXPECT_EQ(fast->overruns(), 0);
+    EXPECT_EQ(fast->framesRead(), mWritten - first);
+}
+
+TEST_F(FanoutPipeTest, AttachDetachTest) {
+    EXPECT_EQ(mPipe->readers(), 0u);
+    EXPECT_EQ(mPipe->maxLag(), 0);
+
+    // A reader starts at the frames written after it is attached.
+    EXPECT_EQ(write(10), 10);
+    sp<FanoutPipeReader> reader = mPipe->newReader();
+    ASSERT_NE(reader, nullptr);
+    EXPECT_EQ(reader->availableToRead(), (ssize_t) NEGOTIATE);
+    negotiate(reader.get(), mFormat);
+    EXPECT_EQ(reader->pipe(), mPipe);
+    EXPECT_EQ(reader->availableToRead(), 0);
+    EXPECT_EQ(write(5), 5);
+    EXPECT_EQ(read(reader, kPipeFrames, 10), 5);
+
+    // Up to kMaxReaders readers, and entries are reused once readers are gone.
+    std::vector<sp<FanoutPipeReader>> readers = {reader};
+    while (readers.size() < FanoutPipe::kMaxReaders) {
+        readers.push_back(newReader());
+        ASSERT_NE(readers.back(), nullptr);
+    }
+    EXPECT_EQ(mPipe->readers(), FanoutPipe::kMaxReaders);
+    EXPECT_EQ(newReader(), nullptr);
+    readers[3].clear();
+    EXPECT_EQ(mPipe->readers(), FanoutPipe::kMaxReaders - 1);
+    EXPECT_EQ(write(3), 3);
+    readers[3] = newReader();
+    ASSERT_NE(readers[3], nullptr);
+    EXPECT_EQ(readers[3]->availableToRead(), 0);
+    EXPECT_EQ(readers[4]->availableToRead(), 3);
+    EXPECT_EQ(mPipe->maxLag(), 3);
+
+    // Readers keep the pipe alive.
+    FanoutPipe *pipe = mPipe.get();
+    mPipe.clear();
+    readers.clear();
+    EXPECT_EQ(pipe->readers(), 1u);
+    EXPECT_EQ(reader->pipe().get(), pipe);
+}
+
+// Readers attach, read and detach while the writer writes, each reads the frames written after
+// it was attached, in order.
+TEST_F(FanoutPipeTest, AttachDetachWhileWritingTest) {
+    // The sample counter identifies the frames for 2^31 frames.
+    const NBAIO_Format format = Format_from_SR_C(48000, 2, AUDIO_FORMAT_PCM_FLOAT);
+    for (bool backpressure : {false, true}) {
+        SCOPED_TRACE(backpressure ? "backpressure" : "no backpressure");
+        createPipe(backpressure, 256, format);
+        const SampleCounter counter(format);
+        std::atomic<bool> done{false};
+        std::atomic<int64_t> written{0};
+        std::thread writer([&] {
+            int64_t rear = 0;
+            while (!done.load()) {
+                const std::vector<uint8_t> frames = counter.frames(rear, 32);
+                const ssize_t count = mPipe->write(frames.data(), 32);
+                ASSERT_GE(count, 0);
+                rear += count;
+                written.store(rear);
+                // Without backpressure, slow enough for a reader to keep up.
+                if (backpressure) {
+                    std::this_thread::yield();
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds(20));
+                }
+            }
+        });
+
+        auto attachReadDetach = [&] {
+            std::vector<uint8_t> buffer(64 * counter.frameSize());
+            for (int i = 0; i < 500; i++) {
+                const int64_t attached = written.load();
+                sp<FanoutPipeReader> reader = newReader();
+                ASSERT_NE(reader, nullptr);
+                // The frame the reader reads next, unknown until the first read or after
+                // an overrun.
+                int64_t front = -1;
+                for (int reads = 0; reads < 5;) {
+                    const ssize_t count = reader->read(buffer.data(), 64);
+                    if (count == (ssize_t) OVERRUN) {
+                        ASSERT_FALSE(backpressure);
+                        front = -1;
+                        continue;
+                    }
+                    ASSERT_GE(count, 0);
+                    if (count == 0) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    uint32_t sample;
+                    memcpy(&sample, buffer.data(), sizeof(sample));
+                    const int64_t frame = sample / 2;
+                    if (front < 0) {
+                        ASSERT_GE(frame, attached) << "frame written before the reader";
+                    } else {
+                        ASSERT_EQ(frame, front) << "frames skipped";
+                    }
+                    ASSERT_EQ(counter.check(buffer.data(), frame, count), counter.samples(count));
+                    front = frame + count;
+                    reads++;
+                }
+            }
+        };
+        attachReadDetach();
+        done = true;
+        writer.join();
+        EXPECT_EQ(mPipe->readers(), 0u);
+    }
+}
+
+// Readers of several speeds read while the writer writes, all the frames they return are
+// the frames that were written, and the frames they do not return are counted as lost.
+TEST_F(FanoutPipeTest, StressTest) {
+    const NBAIO_Format formats[] = {
+        Format_from_SR_C(48000, 1, AUDIO_FORMAT_PCM_16_BIT),     // frames of 2 bytes
+        kStereo16,
+        Format_from_SR_C(48000, 6, AUDIO_FORMAT_PCM_FLOAT),      // frames of 24 bytes
+    };
+    constexpr int64_t kFrames = 1 << 19;
+    constexpr size_t kReaders = 4;
+    for (bool backpressure : {false, true}) {
+        for (const NBAIO_Format& format : formats) {
+            SCOPED_TRACE(testing::Message() << (backpressure ? "backpressure" : "no backpressure")
+                    << " frame size " << Format_frameSize(format));
+            createPipe(backpressure, 1024, format);
+            const SampleCounter counter(format);
+            std::vector<sp<FanoutPipeReader>> readers;
+            for (size_t i = 0; i < kReaders; i++) {
+                readers.push_back(newReader());
+                ASSERT_NE(readers.back(), nullptr);
+            }
+
+            struct Result {
+                int64_t framesRead = 0;
+                int64_t framesOverrun = 0;
+                int64_t overruns = 0;
+            };
+            std::vector<Result> results(kReaders);
+            std::atomic<bool> done{false};
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < kReaders; i++) {
+                threads.emplace_back([&, i] {
+                    // Detach when done, or on failure, so that the writer does not stall.
+                    const sp<FanoutPipeReader> reader = readers[i];
+                    readers[i].clear();
+                    std::minstd_rand random(i);
+                    std::vector<uint8_t> buffer(1000 * counter.frameSize());
+                    while (true) {
+                        // Reader 0 reads as fast as it can. Reader 1 waits until the pipe is
+                        // almost full, so that the writer overwrites frames while it reads
+                        // them. The others read less at a time and reader 3 sleeps.
+                        if (i == 1 && !done.load()) {
+                            const ssize_t available = reader->availableToRead();
+                            if (available >= 0 && available < 900) {
+                                std::this_thread::yield();
+                                continue;
+                            }
+                        }
+                        // The reader started at frame 0, and availableToRead() can overrun too.
+                        const int64_t front = reader->framesRead() + reader->framesOverrun();
+                        const size_t count = i <= 1 ? 1000 : 1 + random() % (300 / i);
+                        const ssize_t read = reader->read(buffer.data(), count);
+                        if (read == OVERRUN) {
+                            ASSERT_FALSE(backpressure) << "overrun with backpressure";
+                            continue;
+                        }
+                        ASSERT_GE(read, 0);
+                        if (read == 0) {
+                            if (done.load() && reader->availableToRead() == 0) {
+                                break;
+                            }
+                            std::this_thread::yield();
+                            continue;
+                        }
+                        ASSERT_EQ(counter.check(buffer.data(), front, read),
+                                counter.samples(read)) << "torn read at frame " << front;
+                        if (i == 3) {
+                            std::this_thread::sleep_for(std::chrono::microseconds(50));
+                        }
+                    }
+                    results[i] = {reader->framesRead(), reader->framesOverrun(),
+                            reader->overruns()};
+                });
+            }
+
+            const std::vector<uint8_t> frames = counter.frames(0, kFrames);
+            auto write = [&] {
+                std::minstd_rand random(0);
+                int64_t written = 0;
+                while (written < kFrames) {
+                    const size_t count = std::min<int64_t>(1 + random() % 700, kFrames - written);
+                    const ssize_t result = mPipe->write(
+                            &frames[written * counter.frameSize()], count);
+                    ASSERT_GE(result, 0);
+                    written += result;
+                    // Let the readers run even on a single core.
+                    std::this_thread::yield();
+                }
+            };
+            write();
+            done = true;
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            for (const Result& result : results) {
+                EXPECT_EQ(result.framesRead + result.framesOverrun, kFrames);
+                if (backpressure) {
+                    EXPECT_EQ(result.overruns, 0);
+                }
+            }
+            EXPECT_EQ(mPipe->readers(), 0u);
+        }
+    }
+}
+
+}  // namespace android
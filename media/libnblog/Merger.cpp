@@ -167,6 +167,9 @@ void MergeReader::processSnapshot(Snapshot &snapshot, int author)
             const double timeMs = it.payload<double>();
             data.warmupHist.add(timeMs);
         } break;
+        case EVENT_CYCLE_SUMMARY: {
+            data.addCycleSummary(it.payload<cycle_summary_t>());
+        } break;
         case EVENT_UNDERRUN: {
             const int64_t ts = it.payload<int64_t>();
             data.underruns++;
@@ -229,7 +232,7 @@ void MergeReader::dump(int fd, const Vector<String16>& args)
 {
     // TODO: add a mutex around media.log dump
     // Options for dumpsys
-    bool pa = false, json = false, plots = false, retro = false;
+    bool pa = false, json = false, plots = false, retro = false, cycles = false;
     for (const auto &arg : args) {
         if (arg == String16("--pa")) {
             pa = true;
@@ -239,6 +242,8 @@ void MergeReader::dump(int fd, const Vector<String16>& args)
             plots = true;
         } else if (arg == String16("--retro")) {
             retro = true;
+        } else if (arg == String16("--cycles")) {
+            cycles = true;
         }
     }
     if (pa) {
@@ -253,6 +258,9 @@ void MergeReader::dump(int fd, const Vector<String16>& args)
     if (retro) {
         ReportPerformance::dumpRetro(fd, mThreadPerformanceData);
     }
+    if (cycles) {
+        ReportPerformance::dumpCycles(fd, mThreadPerformanceData);
+    }
 }
 
 void MergeReader::handleAuthor(const AbstractEntry &entry, String8 *body)
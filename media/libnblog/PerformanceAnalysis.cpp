@@ -50,7 +50,7 @@
 namespace android {
 namespace ReportPerformance {
 
-void Histogram::add(double value)
+void Histogram::add(double value, uint64_t count)
 {
     if (mBinSize <= 0 || mBins.size() < 2) {
         return;
@@ -60,8 +60,28 @@ void Histogram::add(double value)
     // std::clamp is introduced in C++17
     //const int index = std::clamp(unboundedIndex, 0, (int)(mBins.size() - 1));
     const int index = std::max(0, std::min((int)(mBins.size() - 1), unboundedIndex));
-    mBins[index]++;
-    mTotalCount++;
+    mBins[index] += count;
+    mTotalCount += count;
+}
+
+void PerformanceData::addCycleSummary(const NBLog::cycle_summary_t& summary)
+{
+    using NBLog::cycle_summary_t;
+    // The bins have the same layout, add the cycles at the value of each bin.
+    for (size_t i = 0; i < cycle_summary_t::kNumBins; i++) {
+        const double offsetMs = (i - 1.) * cycle_summary_t::kBinNs * 1e-6;
+        jitterHist.add(cycle_summary_t::kJitterLowNs * 1e-6 + offsetMs, summary.jitterBins[i]);
+        cycleWorkHist.add(cycle_summary_t::kTimeLowNs * 1e-6 + offsetMs, summary.workBins[i]);
+        halHist.add(cycle_summary_t::kTimeLowNs * 1e-6 + offsetMs, summary.halBins[i]);
+    }
+    emptyTrackCycles += summary.emptyTrackCycles;
+    partialTrackCycles += summary.partialTrackCycles;
+    emptyTracks |= summary.emptyTracks;
+    partialTracks |= summary.partialTracks;
+    cycleSummaries.push_back(summary);
+    if (cycleSummaries.size() > kMaxCycleSummariesToStore) {
+        cycleSummaries.pop_front();
+    }
 }
 
 void Histogram::clear()
@@ -274,6 +274,13 @@ void DumpReader::dump(int fd, size_t indent)
             const thread_params_t params = it.payload<thread_params_t>();
             body.appendFormat("EVENT_THREAD_PARAMS,%zu,%u", params.frameCount, params.sampleRate);
         } break;
+        case EVENT_CYCLE_SUMMARY: {
+            const cycle_summary_t summary = it.payload<cycle_summary_t>();
+            body.appendFormat("EVENT_CYCLE_SUMMARY,%u,%d,%d,%d,%d,%u,%u,%#x,%#x", summary.cycles,
+                    summary.minJitterNs, summary.maxJitterNs, summary.maxWorkNs,
+                    summary.maxHalNs, summary.emptyTrackCycles, summary.partialTrackCycles,
+                    summary.emptyTracks, summary.partialTracks);
+        } break;
         case EVENT_FMT_END:
         case EVENT_RESERVED:
         case EVENT_UPPER_BOUND:
@@ -55,6 +55,13 @@ static std::unique_ptr<Json::Value> dumpToJson(const PerformanceData& data)
     root["overruns"] = (Json::Value::Int64)data.overruns;
     root["activeMs"] = (Json::Value::Int64)ns2ms(data.active);
     root["durationMs"] = (Json::Value::Int64)ns2ms(systemTime() - data.start);
+    root["jitterMsHist"] = data.jitterHist.toString();
+    root["cycleWorkMsHist"] = data.cycleWorkHist.toString();
+    root["halMsHist"] = data.halHist.toString();
+    root["emptyTrackCycles"] = (Json::Value::Int64)data.emptyTrackCycles;
+    root["partialTrackCycles"] = (Json::Value::Int64)data.partialTrackCycles;
+    root["emptyTracks"] = (Json::Value::UInt)data.emptyTracks;
+    root["partialTracks"] = (Json::Value::UInt)data.partialTracks;
     return rootPtr;
 }
 
@@ -69,6 +76,11 @@ static std::string dumpHistogramsToString(const PerformanceData& data)
     ss << "  Thread work times in ms:\n" << data.workHist.asciiArtString(4 /*indent*/);
     ss << "  Thread latencies in ms:\n" << data.latencyHist.asciiArtString(4 /*indent*/);
     ss << "  Thread warmup times in ms:\n" << data.warmupHist.asciiArtString(4 /*indent*/);
+    if (data.jitterHist.totalCount() > 0) {
+        ss << "  Cycle jitter in ms:\n" << data.jitterHist.asciiArtString(4 /*indent*/);
+        ss << "  Cycle mix times in ms:\n" << data.cycleWorkHist.asciiArtString(4 /*indent*/);
+        ss << "  Cycle HAL times in ms:\n" << data.halHist.asciiArtString(4 /*indent*/);
+    }
     return ss.str();
 }
 
@@ -148,6 +160,43 @@ void dumpRetro(int fd, const std::map<int, PerformanceData>& threadDataMap)
     }
 }
 
+void dumpCycles(int fd, const std::map<int, PerformanceData>& threadDataMap)
+{
+    if (fd < 0) {
+        return;
+    }
+
+    static constexpr uint32_t kCyclesVersion = 2;
+    static_assert(sizeof(NBLog::cycle_summary_t) == 100,
+            "cycle_summary_t is part of the file format");
+
+    std::string out("NBCT", 4);
+    auto append = [&out](const auto& value) {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    };
+    uint32_t threads = 0;
+    for (const auto &item : threadDataMap) {
+        threads += !item.second.cycleSummaries.empty();
+    }
+    append(kCyclesVersion);
+    append(threads);
+    for (const auto &item : threadDataMap) {
+        const ReportPerformance::PerformanceData& data = item.second;
+        if (data.cycleSummaries.empty()) {
+            continue;
+        }
+        append((int32_t)data.threadInfo.id);
+        append((int32_t)data.threadInfo.type);
+        append((uint32_t)data.threadParams.sampleRate);
+        append((uint32_t)data.threadParams.frameCount);
+        append((uint32_t)data.cycleSummaries.size());
+        for (const NBLog::cycle_summary_t &summary : data.cycleSummaries) {
+            append(summary);
+        }
+    }
+    write(fd, out.data(), out.size());
+}
+
 bool sendToMediaMetrics(const PerformanceData& data)
 {
     // See documentation for these metrics here:
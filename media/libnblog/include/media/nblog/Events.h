@@ -20,6 +20,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <system/audio.h>
+#include <algorithm>
 #include <type_traits>
 
 namespace android {
@@ -68,6 +69,7 @@ enum Event : uint8_t {
     EVENT_WARMUP_TIME,          // thread warmup time
     EVENT_WORK_TIME,            // the time a thread takes to do work, e.g. read, write, etc.
     EVENT_THREAD_PARAMS,        // see thread_params_t below
+    EVENT_CYCLE_SUMMARY,        // see cycle_summary_t below
 
     EVENT_UPPER_BOUND,          // to check for invalid events
 };
@@ -132,6 +134,74 @@ struct thread_params_t {
     unsigned sampleRate = 0;        // in frames per second
 };
 
+// Measured by the fast threads in each warm cycle, to trace where the time of the cycle
+// goes. Times are in nanoseconds. Not logged, see cycle_summary_t.
+struct cycle_times_t {
+    int32_t jitterNs = 0;           // time since the previous cycle minus the expected period
+    int32_t workNs = 0;             // FastMixer: mixing. FastCapture: delivery to the pipe.
+    int32_t halNs = 0;              // time spent in the HAL write (FastMixer) or read
+                                    // (FastCapture)
+    uint32_t emptyTracks = 0;       // bit i is set if fast track i had no frames ready
+    uint32_t partialTracks = 0;     // bit i is set if fast track i had some but not enough frames
+};
+
+// mapped from EVENT_CYCLE_SUMMARY
+// A record per cycle would overrun the log of a fast thread between two merges, so the
+// cycle_times_t are aggregated on the fast thread, which logs a summary every kMaxCycles
+// warm cycles, and when its state changes.
+struct cycle_summary_t {
+    static constexpr uint32_t kMaxCycles = 250;         // the bin counts are 8-bit
+    // Bin 0 counts the times below low, bin i counts those that round to
+    // low + (i - 1) * kBinNs, and the last bin those above. This is the layout of the bins
+    // of ReportPerformance::Histogram.
+    static constexpr size_t kNumBins = 24;
+    static constexpr int32_t kBinNs = 250000;
+    static constexpr int32_t kJitterLowNs = -2000000;   // jitter bins cover -2 ms to 3.5 ms
+    static constexpr int32_t kTimeLowNs = 0;            // work and HAL bins cover 0 to 5.5 ms
+
+    uint8_t cycles = 0;
+    uint8_t emptyTrackCycles = 0;   // cycles where at least one fast track had no frames
+    uint8_t partialTrackCycles = 0; // cycles where at least one fast track had too few frames
+    uint8_t reserved = 0;
+    uint32_t emptyTracks = 0;       // bit i is set if fast track i had no frames in a cycle
+    uint32_t partialTracks = 0;     // bit i is set if fast track i had too few frames in a cycle
+    int32_t minJitterNs = 0;
+    int32_t maxJitterNs = 0;
+    int32_t maxWorkNs = 0;
+    int32_t maxHalNs = 0;
+    uint8_t jitterBins[kNumBins] = {};
+    uint8_t workBins[kNumBins] = {};
+    uint8_t halBins[kNumBins] = {};
+
+    bool full() const { return cycles >= kMaxCycles; }
+
+    void add(const cycle_times_t &times) {
+        if (cycles == 0) {
+            minJitterNs = maxJitterNs = times.jitterNs;
+        }
+        minJitterNs = std::min(minJitterNs, times.jitterNs);
+        maxJitterNs = std::max(maxJitterNs, times.jitterNs);
+        maxWorkNs = std::max(maxWorkNs, times.workNs);
+        maxHalNs = std::max(maxHalNs, times.halNs);
+        ++jitterBins[binIndex(times.jitterNs, kJitterLowNs)];
+        ++workBins[binIndex(times.workNs, kTimeLowNs)];
+        ++halBins[binIndex(times.halNs, kTimeLowNs)];
+        emptyTrackCycles += times.emptyTracks != 0;
+        partialTrackCycles += times.partialTracks != 0;
+        emptyTracks |= times.emptyTracks;
+        partialTracks |= times.partialTracks;
+        ++cycles;
+    }
+
+    // Rounds half away from zero, as Histogram::add() does.
+    static size_t binIndex(int32_t ns, int32_t lowNs) {
+        const int64_t delta = (int64_t)ns - lowNs;
+        const int64_t index = delta >= 0 ? (delta + kBinNs / 2) / kBinNs + 1
+                : 1 - (-delta + kBinNs / 2) / kBinNs;
+        return std::max((int64_t)0, std::min((int64_t)kNumBins - 1, index));
+    }
+};
+
 template <Event E> struct get_mapped;
 #define MAP_EVENT_TO_TYPE(E, T) \
 template<> struct get_mapped<E> { \
@@ -149,6 +219,7 @@ MAP_EVENT_TO_TYPE(EVENT_UNDERRUN, int64_t);
 MAP_EVENT_TO_TYPE(EVENT_WARMUP_TIME, double);
 MAP_EVENT_TO_TYPE(EVENT_WORK_TIME, int64_t);
 MAP_EVENT_TO_TYPE(EVENT_THREAD_PARAMS, thread_params_t);
+MAP_EVENT_TO_TYPE(EVENT_CYCLE_SUMMARY, cycle_summary_t);
 
 }   // namespace NBLog
 }   // namespace android
@@ -35,6 +35,14 @@ void dumpPlots(int fd, const std::map<int, PerformanceData>& threadDataMap);
 // Dumps snapshots at important events in the past.
 void dumpRetro(int fd, const std::map<int, PerformanceData>& threadDataMap);
 
+// Dumps the most recent cycle summaries of each thread in a compact binary format,
+// for a host tool to compute latency percentiles. All fields are little-endian:
+//   header:     char magic[4] = "NBCT", uint32_t version = 2, uint32_t number of threads
+//   per thread: int32_t ioHandle, int32_t NBLog::ThreadType, uint32_t sampleRate,
+//               uint32_t frameCount, uint32_t number of summaries,
+//               then that many NBLog::cycle_summary_t, oldest first.
+void dumpCycles(int fd, const std::map<int, PerformanceData>& threadDataMap);
+
 // Send one thread's data to media metrics, if the performance data is nontrivial (i.e. not
 // all zero values). Return true if data was sent, false if there is nothing to write
 // or an error occurred while writing.
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "NBLogCycleSummaryTest"
+#include <utils/Log.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <media/nblog/Events.h>
+#include <media/nblog/Merger.h>
+#include <media/nblog/PerformanceAnalysis.h>
+#include <media/nblog/Reader.h>
+#include <media/nblog/Timeline.h>
+#include <media/nblog/Writer.h>
+#include <utils/String16.h>
+#include <utils/Vector.h>
+
+using namespace android;
+using NBLog::cycle_summary_t;
+using NBLog::cycle_times_t;
+using ReportPerformance::Histogram;
+using ReportPerformance::PerformanceData;
+
+namespace {
+
+// Log sizes of FastCapture and FastMixer, see Threads.h.
+constexpr size_t kFastCaptureLogSize = 4 * 1024;
+constexpr size_t kFastMixerLogSize = 8 * 1024;
+
+// Random cycle times around a 2 ms period, with some outliers.
+cycle_times_t randomCycle(std::mt19937 *random) {
+    cycle_times_t times;
+    times.jitterNs = (int32_t)((*random)() % 7000000) - 2500000;
+    times.workNs = (*random)() % 1500000;
+    times.halNs = (*random)() % 6000000;
+    times.emptyTracks = (*random)() % 50 == 0 ? 1u << ((*random)() % 32) : 0;
+    times.partialTracks = (*random)() % 30 == 0 ? 1u << ((*random)() % 32) : 0;
+    return times;
+}
+
+// The summaries of numCycles random cycles, as logged by FastThread.
+std::vector<cycle_summary_t> summarize(std::mt19937 *random, size_t numCycles,
+                                       std::vector<cycle_times_t> *cycles = nullptr) {
+    std::vector<cycle_summary_t> summaries;
+    cycle_summary_t summary;
+    for (size_t i = 0; i < numCycles; ++i) {
+        const cycle_times_t times = randomCycle(random);
+        if (cycles != nullptr) cycles->push_back(times);
+        summary.add(times);
+        if (summary.full()) {
+            summaries.push_back(summary);
+            summary = {};
+        }
+    }
+    if (summary.cycles > 0) {
+        summaries.push_back(summary);
+    }
+    return summaries;
+}
+
+// Whether value is half way between two bins, where rounding in milliseconds
+// may differ from rounding in nanoseconds.
+bool isHalfWay(int32_t ns, int32_t lowNs) {
+    return std::abs((int64_t)ns - lowNs) % cycle_summary_t::kBinNs == cycle_summary_t::kBinNs / 2;
+}
+
+// A log in local memory, with a merger that reads it as MediaLogService does.
+class TestLog {
+  public:
+    explicit TestLog(size_t size)
+        : mShared(NBLog::Timeline::sharedSize(size)),
+          mMergerShared(NBLog::Timeline::sharedSize(kMergerSize)) {
+        new (mShared.data()) NBLog::Shared;
+        new (mMergerShared.data()) NBLog::Shared;
+        mWriter = new NBLog::Writer(mShared.data(), size);
+        mWriter->enable();
+        mMerger = new NBLog::Merger(mMergerShared.data(), kMergerSize);
+        mMerger->addReader(new NBLog::Reader(mShared.data(), size, "test"));
+        mMergeReader = new NBLog::MergeReader(mMergerShared.data(), kMergerSize, *mMerger);
+    }
+
+    NBLog::Writer &writer() { return *mWriter; }
+
+    // Processes the log, then returns what MergeReader::dump() writes for option.
+    std::string mergeAndDump(const char *option) {
+        mMergeReader->getAndProcessSnapshot();
+        FILE *file = tmpfile();
+        EXPECT_NE(file, nullptr);
+        if (file == nullptr) return "";
+        Vector<String16> args;
+        args.add(String16(option));
+        mMergeReader->dump(fileno(file), args);
+        std::string out;
+        rewind(file);
+        char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            out.append(buffer, n);
+        }
+        fclose(file);
+        return out;
+    }
+
+  private:
+    static constexpr size_t kMergerSize = 16 * 1024;
+    std::vector<uint8_t> mShared;
+    std::vector<uint8_t> mMergerShared;
+    sp<NBLog::Writer> mWriter;
+    sp<NBLog::Merger> mMerger;
+    sp<NBLog::MergeReader> mMergeReader;
+};
+
+// Parses the output of dumpCycles() for a single thread.
+struct CyclesDump {
+    int32_t ioHandle;
+    int32_t threadType;
+    uint32_t sampleRate;
+    uint32_t frameCount;
+    std::vector<cycle_summary_t> summaries;
+};
+
+void parseCyclesDump(const std::string &out, std::vector<CyclesDump> *threads) {
+    size_t offset = 0;
+    auto read = [&](auto *value) {
+        ASSERT_LE(offset + sizeof(*value), out.size()) << "truncated dump";
+        memcpy(value, out.data() + offset, sizeof(*value));
+        offset += sizeof(*value);
+    };
+    ASSERT_GE(out.size(), 4u);
+    ASSERT_EQ(out.substr(0, 4), "NBCT");
+    offset = 4;
+    uint32_t version, numThreads;
+    ASSERT_NO_FATAL_FAILURE(read(&version));
+    ASSERT_EQ(version, 2u);
+    ASSERT_NO_FATAL_FAILURE(read(&numThreads));
+    for (uint32_t i = 0; i < numThreads; ++i) {
+        CyclesDump thread;
+        uint32_t numSummaries;
+        ASSERT_NO_FATAL_FAILURE(read(&thread.ioHandle));
+        ASSERT_NO_FATAL_FAILURE(read(&thread.threadType));
+        ASSERT_NO_FATAL_FAILURE(read(&thread.sampleRate));
+        ASSERT_NO_FATAL_FAILURE(read(&thread.frameCount));
+        ASSERT_NO_FATAL_FAILURE(read(&numSummaries));
+        thread.summaries.resize(numSummaries);
+        for (cycle_summary_t &summary : thread.summaries) {
+            ASSERT_NO_FATAL_FAILURE(read(&summary));
+        }
+        threads->push_back(thread);
+    }
+    ASSERT_EQ(offset, out.size()) << "trailing data in dump";
+}
+
+}  // namespace
+
+TEST(NBLogCycleSummaryTest, SummaryMatchesHistogramsTest) {
+    std::mt19937 random(1);
+    std::vector<cycle_times_t> cycles;
+    const std::vector<cycle_summary_t> summaries = summarize(&random, 5000, &cycles);
+    ASSERT_EQ(summaries.size(), 20u);
+
+    // The histograms of PerformanceData built from the summaries are those of the cycles.
+    PerformanceData fromSummaries;
+    for (const cycle_summary_t &summary : summaries) {
+        fromSummaries.addCycleSummary(summary);
+    }
+    Histogram jitterHist(PerformanceData::kJitterConfig);
+    Histogram workHist(PerformanceData::kCycleWorkConfig);
+    Histogram halHist(PerformanceData::kHalConfig);
+    int64_t emptyTrackCycles = 0;
+    int64_t partialTrackCycles = 0;
+    uint32_t emptyTracks = 0;
+    uint32_t partialTracks = 0;
+    for (size_t i = 0; i < cycles.size(); ++i) {
+        cycle_times_t &times = cycles[i];
+        // Each summary keeps which tracks underran in its cycles.
+        const cycle_summary_t &summary = summaries[i / cycle_summary_t::kMaxCycles];
+        EXPECT_EQ(summary.emptyTracks & times.emptyTracks, times.emptyTracks) << "cycle " << i;
+        EXPECT_EQ(summary.partialTracks & times.partialTracks, times.partialTracks)
+                << "cycle " << i;
+        emptyTracks |= times.emptyTracks;
+        partialTracks |= times.partialTracks;
+
+        // Values half way between bins are rounded away from zero in nanoseconds, but
+        // may not be in milliseconds; move them off the boundary.
+        if (isHalfWay(times.jitterNs, cycle_summary_t::kJitterLowNs)) times.jitterNs++;
+        if (isHalfWay(times.workNs, cycle_summary_t::kTimeLowNs)) times.workNs++;
+        if (isHalfWay(times.halNs, cycle_summary_t::kTimeLowNs)) times.halNs++;
+        jitterHist.add(times.jitterNs * 1e-6);
+        workHist.add(times.workNs * 1e-6);
+        halHist.add(times.halNs * 1e-6);
+        emptyTrackCycles += times.emptyTracks != 0;
+        partialTrackCycles += times.partialTracks != 0;
+    }
+    EXPECT_EQ(fromSummaries.jitterHist.totalCount(), cycles.size());
+    EXPECT_EQ(fromSummaries.jitterHist.toString(), jitterHist.toString());
+    EXPECT_EQ(fromSummaries.cycleWorkHist.toString(), workHist.toString());
+    EXPECT_EQ(fromSummaries.halHist.toString(), halHist.toString());
+    EXPECT_EQ(fromSummaries.emptyTrackCycles, emptyTrackCycles);
+    EXPECT_EQ(fromSummaries.partialTrackCycles, partialTrackCycles);
+    EXPECT_EQ(fromSummaries.emptyTracks, emptyTracks);
+    EXPECT_EQ(fromSummaries.partialTracks, partialTracks);
+    uint32_t summaryEmptyTracks = 0;
+    uint32_t summaryPartialTracks = 0;
+    for (const cycle_summary_t &summary : summaries) {
+        summaryEmptyTracks |= summary.emptyTracks;
+        summaryPartialTracks |= summary.partialTracks;
+    }
+    // No bits other than those of the cycles.
+    EXPECT_EQ(summaryEmptyTracks, emptyTracks);
+    EXPECT_EQ(summaryPartialTracks, partialTracks);
+    EXPECT_EQ(fromSummaries.cycleSummaries.size(), summaries.size());
+
+    // Bins at the boundaries, including the outliers.
+    for (int32_t ns : {INT32_MIN, -2125001, -2124999, -2000000, -1875001, -1874999, 0, 124999,
+                       125001, 3499999, 3500000, 3624999, 3625001, INT32_MAX}) {
+        Histogram expected(PerformanceData::kJitterConfig);
+        expected.add(ns * 1e-6);
+        cycle_summary_t summary;
+        cycle_times_t times;
+        times.jitterNs = ns;
+        summary.add(times);
+        PerformanceData data;
+        data.addCycleSummary(summary);
+        EXPECT_EQ(data.jitterHist.toString(), expected.toString()) << "jitter " << ns;
+        EXPECT_EQ(summary.minJitterNs, ns);
+        EXPECT_EQ(summary.maxJitterNs, ns);
+    }
+}
+
+TEST(NBLogCycleSummaryTest, MergerTest) {
+    TestLog log(kFastMixerLogSize);
+    NBLog::thread_info_t info;
+    info.id = 13;
+    info.type = NBLog::FASTMIXER;
+    log.writer().log<NBLog::EVENT_THREAD_INFO>(info);
+    NBLog::thread_params_t params;
+    params.frameCount = 96;
+    params.sampleRate = 48000;
+    log.writer().log<NBLog::EVENT_THREAD_PARAMS>(params);
+
+    // Two merges, the merger accumulates.
+    std::mt19937 random(2);
+    std::vector<cycle_summary_t> summaries = summarize(&random, 1000);
+    for (const cycle_summary_t &summary : summaries) {
+        log.writer().log<NBLog::EVENT_CYCLE_SUMMARY>(summary);
+    }
+    log.mergeAndDump("--cycles");
+    std::vector<cycle_summary_t> moreSummaries = summarize(&random, 600);
+    for (const cycle_summary_t &summary : moreSummaries) {
+        log.writer().log<NBLog::EVENT_CYCLE_SUMMARY>(summary);
+    }
+    summaries.insert(summaries.end(), moreSummaries.begin(), moreSummaries.end());
+
+    std::vector<CyclesDump> threads;
+    ASSERT_NO_FATAL_FAILURE(parseCyclesDump(log.mergeAndDump("--cycles"), &threads));
+    ASSERT_EQ(threads.size(), 1u);
+    EXPECT_EQ(threads[0].ioHandle, 13);
+    EXPECT_EQ(threads[0].threadType, NBLog::FASTMIXER);
+    EXPECT_EQ(threads[0].sampleRate, 48000u);
+    EXPECT_EQ(threads[0].frameCount, 96u);
+    ASSERT_EQ(threads[0].summaries.size(), summaries.size());
+    int64_t emptyTrackCycles = 0;
+    int64_t partialTrackCycles = 0;
+    PerformanceData expected;
+    for (size_t i = 0; i < summaries.size(); ++i) {
+        EXPECT_EQ(memcmp(&threads[0].summaries[i], &summaries[i], sizeof(cycle_summary_t)), 0)
+                << "summary " << i;
+        emptyTrackCycles += summaries[i].emptyTrackCycles;
+        partialTrackCycles += summaries[i].partialTrackCycles;
+        expected.addCycleSummary(summaries[i]);
+    }
+
+    // The histograms and counters of the JSON dump.
+    Json::Value root;
+    std::string errors;
+    const std::string json = log.mergeAndDump("--json");
+    std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+    ASSERT_TRUE(reader->parse(json.data(), json.data() + json.size(), &root, &errors)) << errors;
+    ASSERT_TRUE(root.isArray());
+    ASSERT_EQ(root.size(), 1u);
+    EXPECT_EQ(root[0]["emptyTrackCycles"].asInt64(), emptyTrackCycles);
+    EXPECT_EQ(root[0]["partialTrackCycles"].asInt64(), partialTrackCycles);
+    EXPECT_EQ(root[0]["emptyTracks"].asUInt(), expected.emptyTracks);
+    EXPECT_EQ(root[0]["partialTracks"].asUInt(), expected.partialTracks);
+    EXPECT_EQ(root[0]["jitterMsHist"].asString(), expected.jitterHist.toString());
+    EXPECT_EQ(root[0]["cycleWorkMsHist"].asString(), expected.cycleWorkHist.toString());
+    EXPECT_EQ(root[0]["halMsHist"].asString(), expected.halHist.toString());
+}
+
+// The merger drains the logs about once per second. The smallest log, that of FastCapture,
+// must hold well over a second of summaries at the shortest cycle times.
+TEST(NBLogCycleSummaryTest, LogSizeTest) {
+    TestLog log(kFastCaptureLogSize);
+    std::mt19937 random(3);
+    // 5 seconds of 1 ms cycles.
+    const std::vector<cycle_summary_t> summaries = summarize(&random, 5000);
+    for (const cycle_summary_t &summary : summaries) {
+        log.writer().log<NBLog::EVENT_CYCLE_SUMMARY>(summary);
+    }
+    std::vector<CyclesDump> threads;
+    ASSERT_NO_FATAL_FAILURE(parseCyclesDump(log.mergeAndDump("--cycles"), &threads));
+    ASSERT_EQ(threads.size(), 1u);
+    ASSERT_EQ(threads[0].summaries.size(), summaries.size()) << "log overrun";
+}
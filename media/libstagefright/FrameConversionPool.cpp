@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FrameConversionPool"
+
+#include "include/FrameConversionPool.h"
+
+#include <algorithm>
+
+#include <cutils/properties.h>
+#include <media/stagefright/ColorConverter.h>
+#include <media/stagefright/MediaErrors.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <utils/Log.h>
+
+namespace android {
+
+// Bands smaller than this are not worth a thread hand-off.
+static const size_t kMinBandRows = 64;
+static const size_t kMaxDefaultThreads = 4;
+
+status_t FrameConversionPool::Job::wait() {
+    std::unique_lock<std::mutex> lock(mLock);
+    mCondition.wait(lock, [this] { return mPendingBands == 0; });
+    return mStatus;
+}
+
+void FrameConversionPool::Job::onBandDone(status_t err) {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mStatus == OK) {
+        mStatus = err;
+    }
+    if (--mPendingBands == 0) {
+        mCondition.notify_all();
+    }
+}
+
+// static
+FrameConversionPool &FrameConversionPool::getInstance() {
+    // never destroyed, so workers stay valid until the process exits
+    static FrameConversionPool *sInstance = [] {
+        long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        int32_t defaultThreads = (int32_t)std::clamp(
+                numCpus, 1L, (long)kMaxDefaultThreads);
+        int32_t numThreads = property_get_int32(
+                "media.stagefright.frame-conversion-threads", defaultThreads);
+        ALOGV("using %d frame conversion threads", numThreads);
+        return new FrameConversionPool(std::max(numThreads, 0));
+    }();
+    return *sInstance;
+}
+
+FrameConversionPool::FrameConversionPool(size_t numThreads)
+    : mQuit(false) {
+    for (size_t i = 0; i < numThreads; ++i) {
+        mThreads.emplace_back([this] {
+            pthread_setname_np(pthread_self(), "FrameConvert");
+            threadLoop();
+        });
+    }
+}
+
+FrameConversionPool::~FrameConversionPool() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mQuit = true;
+    }
+    mCondition.notify_all();
+    for (std::thread &thread : mThreads) {
+        thread.join();
+    }
+}
+
+std::shared_ptr<FrameConversionPool::Job> FrameConversionPool::submit(const Params &params) {
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+
+    if (mThreads.empty()) {
+        job->mStatus = convert(params);
+        return job;
+    }
+
+    // Split into bands of an even number of rows, so that every band starts on
+    // the same chroma row a single conversion would use.
+    size_t height = params.mSrcCropBottom - params.mSrcCropTop + 1;
+    size_t numBands = std::clamp(height / kMinBandRows, (size_t)1, mThreads.size());
+    size_t bandRows = ((height + numBands - 1) / numBands + 1) & ~(size_t)1;
+
+    std::vector<Band> bands;
+    for (size_t top = 0; top < height; top += bandRows) {
+        size_t rows = std::min(bandRows, height - top);
+        Band band = { job, params };
+        band.mParams.mSrcCropTop = params.mSrcCropTop + top;
+        band.mParams.mSrcCropBottom = band.mParams.mSrcCropTop + rows - 1;
+        band.mParams.mDstCropTop = params.mDstCropTop + top;
+        band.mParams.mDstCropBottom = band.mParams.mDstCropTop + rows - 1;
+        bands.push_back(std::move(band));
+    }
+    job->mPendingBands = bands.size();
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (Band &band : bands) {
+            mQueue.push_back(std::move(band));
+        }
+    }
+    mCondition.notify_all();
+
+    ALOGV("submitted %zu rows in %zu bands", height, job->mPendingBands);
+    return job;
+}
+
+void FrameConversionPool::threadLoop() {
+    std::unique_lock<std::mutex> lock(mLock);
+    for (;;) {
+        mCondition.wait(lock, [this] { return mQuit || !mQueue.empty(); });
+        if (mQuit) {
+            return;
+        }
+        Band band = std::move(mQueue.front());
+        mQueue.pop_front();
+
+        lock.unlock();
+        band.mJob->onBandDone(convert(band.mParams));
+        band.mJob.reset();
+        lock.lock();
+    }
+}
+
+// static
+status_t FrameConversionPool::convert(const Params &params) {
+    ColorConverter converter(params.mSrcFormat, params.mDstFormat);
+    if (params.mSrcImage) {
+        converter.setSrcMediaImage2(*params.mSrcImage);
+    }
+    converter.setSrcColorSpace(params.mStandard, params.mRange, params.mTransfer);
+    if (!converter.isValid()) {
+        return ERROR_UNSUPPORTED;
+    }
+    return converter.convert(
+            params.mSrcBits,
+            params.mSrcWidth, params.mSrcHeight, params.mSrcStride,
+            params.mSrcCropLeft, params.mSrcCropTop,
+            params.mSrcCropRight, params.mSrcCropBottom,
+            params.mDstBits,
+            params.mDstWidth, params.mDstHeight, params.mDstStride,
+            params.mDstCropLeft, params.mDstCropTop,
+            params.mDstCropRight, params.mDstCropBottom);
+}
+
+}  // namespace android
@@ -453,7 +453,11 @@ status_t FrameDecoder::extractInternal() {
                 ALOGV("Output buffers changed");
                 err = OK;
             } else {
-                if (err == -EAGAIN /* INFO_TRY_AGAIN_LATER */ && --retriesLeft > 0) {
+                if (err == -EAGAIN /* INFO_TRY_AGAIN_LATER */ && mPendingConversion) {
+                    // the decoder may be waiting for the buffer held by the conversion
+                    finishPendingConversion();
+                    err = OK;
+                } else if (err == -EAGAIN /* INFO_TRY_AGAIN_LATER */ && --retriesLeft > 0) {
                     ALOGV("Timed-out waiting for output.. retries left = %zu", retriesLeft);
                     err = OK;
                 } else if (err == OK) {
@@ -470,8 +474,16 @@ status_t FrameDecoder::extractInternal() {
                         mDecoder->renderOutputBufferAndRelease(index);
                         err = onOutputReceived(videoFrameBuffer, mOutputFormat, ptsUs, &done);
                     } else {
+                        // keep at most one conversion in flight
+                        finishPendingConversion();
                         err = onOutputReceived(videoFrameBuffer, mOutputFormat, ptsUs, &done);
-                        mDecoder->releaseOutputBuffer(index);
+                        if (mStartedConversion != nullptr) {
+                            mPendingConversion = PendingConversion{
+                                    mStartedConversion, index, videoFrameBuffer };
+                            mStartedConversion.reset();
+                        } else {
+                            mDecoder->releaseOutputBuffer(index);
+                        }
                     }
                 } else {
                     ALOGW("Received error %d (%s) instead of output", err, asString(err));
@@ -482,6 +494,8 @@ status_t FrameDecoder::extractInternal() {
         }
     } while (err == OK && !done);
 
+    finishPendingConversion();
+
     if (err != OK) {
         ALOGE("failed to get video frame (err %d)", err);
     }
@@ -489,6 +503,23 @@ status_t FrameDecoder::extractInternal() {
     return err;
 }
 
+void FrameDecoder::convertOutputAsync(const FrameConversionPool::Params &params) {
+    CHECK(mStartedConversion == nullptr);
+    mStartedConversion = FrameConversionPool::getInstance().submit(params);
+}
+
+void FrameDecoder::finishPendingConversion() {
+    if (!mPendingConversion) {
+        return;
+    }
+    status_t err = mPendingConversion->mJob->wait();
+    if (err != OK) {
+        ALOGW("color conversion failed: %d", err);
+    }
+    mDecoder->releaseOutputBuffer(mPendingConversion->mIndex);
+    mPendingConversion.reset();
+}
+
 //////////////////////////////////////////////////////////////////////
 
 VideoFrameDecoder::VideoFrameDecoder(
@@ -700,12 +731,14 @@ status_t VideoFrameDecoder::onOutputReceived(
     if (!outputFormat->findInt32("color-transfer", (int32_t*)&transfer)) {
         transfer = 0;
     }
+    std::optional<MediaImage2> srcImage;
     sp<ABuffer> imgObj;
     if (videoFrameBuffer->meta()->findBuffer("image-data", &imgObj)) {
         MediaImage2 *imageData = nullptr;
         imageData = (MediaImage2 *)(imgObj.get()->data());
         if (imageData != nullptr) {
             converter.setSrcMediaImage2(*imageData);
+            srcImage = *imageData;
         }
     }
     if (srcFormat == COLOR_FormatYUV420Flexible && imgObj.get() == nullptr) {
@@ -713,15 +746,17 @@ status_t VideoFrameDecoder::onOutputReceived(
     }
     converter.setSrcColorSpace(standard, range, transfer);
     if (converter.isValid()) {
-        converter.convert(
-                (const uint8_t *)videoFrameBuffer->data(),
-                width, height, stride,
-                crop_left, crop_top, crop_right, crop_bottom,
+        convertOutputAsync({
+                (OMX_COLOR_FORMATTYPE)srcFormat, dstFormat(), srcImage,
+                standard, range, transfer,
+                videoFrameBuffer->data(),
+                (size_t)width, (size_t)height, (size_t)stride,
+                (size_t)crop_left, (size_t)crop_top, (size_t)crop_right, (size_t)crop_bottom,
                 mFrame->getFlattenedData(),
                 mFrame->mWidth, mFrame->mHeight, mFrame->mRowBytes,
                 // since the frame is allocated with top-left adjusted,
                 // the dst rect should start at {0,0} as well.
-                0, 0, mFrame->mWidth - 1, mFrame->mHeight - 1);
+                0, 0, mFrame->mWidth - 1, mFrame->mHeight - 1 });
         return OK;
     }
 
@@ -979,12 +1014,14 @@ status_t MediaImageDecoder::onOutputReceived(
     if (!outputFormat->findInt32("color-transfer", (int32_t*)&transfer)) {
         transfer = 0;
     }
+    std::optional<MediaImage2> srcImage;
     sp<ABuffer> imgObj;
     if (videoFrameBuffer->meta()->findBuffer("image-data", &imgObj)) {
         MediaImage2 *imageData = nullptr;
         imageData = (MediaImage2 *)(imgObj.get()->data());
         if (imageData != nullptr) {
             converter.setSrcMediaImage2(*imageData);
+            srcImage = *imageData;
         }
     }
     if (srcFormat == COLOR_FormatYUV420Flexible && imgObj.get() == nullptr) {
@@ -1028,13 +1065,17 @@ status_t MediaImageDecoder::onOutputReceived(
     *done = (++mTilesDecoded >= mTargetTiles);
 
     if (converter.isValid()) {
-        converter.convert(
-                (const uint8_t *)videoFrameBuffer->data(),
-                width, height, stride,
-                crop_left, crop_top, crop_right, crop_bottom,
+        // tiles write disjoint parts of the frame, so this tile is converted
+        // while the decoder works on the next one
+        convertOutputAsync({
+                (OMX_COLOR_FORMATTYPE)srcFormat, dstFormat(), srcImage,
+                standard, range, transfer,
+                videoFrameBuffer->data(),
+                (size_t)width, (size_t)height, (size_t)stride,
+                (size_t)crop_left, (size_t)crop_top, (size_t)crop_right, (size_t)crop_bottom,
                 mFrame->getFlattenedData(),
                 mFrame->mWidth, mFrame->mHeight, mFrame->mRowBytes,
-                dstLeft, dstTop, dstRight, dstBottom);
+                (size_t)dstLeft, (size_t)dstTop, (size_t)dstRight, (size_t)dstBottom });
         return OK;
     }
 
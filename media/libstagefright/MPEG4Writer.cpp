@@ -72,6 +72,9 @@ static const uint8_t kNalUnitTypePicParamSet = 0x08;
 static const int64_t kInitialDelayTimeUs     = 700000LL;
 static const int64_t kMaxMetadataSize = 0x4000000LL;   // 64MB max per-frame metadata size
 static const int64_t kMaxCttsOffsetTimeUs = 30 * 60 * 1000000LL;  // 30 minutes
+// Video fragments are cut at sync samples only, unless no sync sample shows up
+// for this many fragment durations.
+static const int64_t kMaxFragmentDurationFactor = 4;
 static const size_t kESDSScratchBufferSize = 10;  // kMaxAtomSize in Mpeg4Extractor 64MB
 
 static const char kMetaKey_Version[]    = "com.android.version";
@@ -153,6 +156,7 @@ public:
     void writeTrackHeader();
     int64_t getMinCttsOffsetTimeUs();
     void bufferChunk(int64_t timestampUs);
+    void bufferFragment(int64_t timestampUs);
     bool isAvc() const { return mIsAvc; }
     bool isHevc() const { return mIsHevc; }
     bool isAv1() const { return mIsAv1; }
@@ -174,6 +178,11 @@ public:
     void resetInternal();
     int64_t trackMetaDataSize();
 
+    // Fragmented mode
+    void writeTrexBox();
+    void writeSidxBox(const Chunk &chunk, int64_t movieStartTimeUs, off64_t *referencedSizeOffset);
+    void writeTrafBox(const Chunk &chunk, int64_t movieStartTimeUs, off64_t *dataOffsetOffset);
+
 private:
     // A helper class to handle faster write box with table entries
     template<class TYPE, unsigned ENTRY_SIZE>
@@ -344,6 +353,21 @@ private:
 
     List<MediaBuffer *> mChunkSamples;
 
+    // Number of samples written, whether or not they went to mStszTableEntries.
+    uint32_t mNumSamples;
+    // Number of sync samples, whether or not they went to mStssTableEntries.
+    uint32_t mNumSyncSamples;
+    // Fragmented mode: samples of the fragment being built, and the decoding
+    // time of its first sample.
+    std::vector<FragmentSample> mFragmentSamples;
+    int64_t mFragmentDecodeTimeTicks;
+    // Fragmented mode: whether the track buffered a fragment, and whether the
+    // init segment has a sample entry for it. The writer thread writes the init
+    // segment while this thread keeps adding samples, so it only reads these,
+    // set once before the first fragment is handed over under the owner lock.
+    bool mFragmentBuffered;
+    bool mInitHasSampleEntry;
+
     bool mSamplesHaveSameSize;
     ListTableEntries<uint32_t, 1> *mStszTableEntries;
     ListTableEntries<off64_t, 1> *mCo64TableEntries;
@@ -416,6 +440,7 @@ private:
 
     int64_t getStartTimeOffsetTimeUs() const;
     int32_t getStartTimeOffsetScaledTime() const;
+    int64_t getFragmentDecodeTimeTicks(const Chunk &chunk, int64_t movieStartTimeUs) const;
 
     static void *ThreadWrapper(void *me);
     status_t threadEntry();
@@ -492,6 +517,7 @@ private:
     void writeAudioFourCCBox();
     void writeVideoFourCCBox();
     void writeMetadataFourCCBox();
+    void writeStsdBox();
     void writeStblBox();
     void writeEdtsBox();
 
@@ -526,6 +552,10 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
     mInitCheck = mFd < 0? NO_INIT: OK;
 
     mInterleaveDurationUs = 1000000;
+    mFragmentDurationUs = 0;
+    mWriteSegmentIndex = false;
+    mInitSegmentWritten = false;
+    mFragmentSequenceNumber = 0;
 
     mStartTimestampUs = -1LL;
     mStartTimeOffsetMs = -1;
@@ -627,7 +657,7 @@ status_t MPEG4Writer::Track::dump(
     snprintf(buffer, SIZE, "       reached EOS: %s\n",
             mReachedEOS? "true": "false");
     result.append(buffer);
-    snprintf(buffer, SIZE, "       frames encoded : %d\n", mStszTableEntries->count());
+    snprintf(buffer, SIZE, "       frames encoded : %d\n", mNumSamples);
     result.append(buffer);
     snprintf(buffer, SIZE, "       duration encoded : %" PRId64 " us\n", mTrackDurationUs);
     result.append(buffer);
@@ -947,15 +977,32 @@ status_t MPEG4Writer::start(MetaData *param) {
     CHECK_GT(mTimeScale, 0);
     ALOGV("movie time scale: %d", mTimeScale);
 
+    int64_t fragmentDurationUs;
+    if (param && param->findInt64(kKeyFragmentDurationUs, &fragmentDurationUs) &&
+            fragmentDurationUs > 0) {
+        if (mHasFileLevelMeta) {
+            ALOGE("Fragmented output is not supported with image tracks");
+            return ERROR_UNSUPPORTED;
+        }
+        int32_t writeSegmentIndex;
+        mFragmentDurationUs = fragmentDurationUs;
+        mWriteSegmentIndex = param->findInt32(kKeyFragmentSegmentIndex, &writeSegmentIndex) &&
+                writeSegmentIndex;
+        ALOGI("fragment duration: %" PRId64 " us, sidx: %d", mFragmentDurationUs,
+                mWriteSegmentIndex);
+    }
+
     /*
      * When the requested file size limit is small, the priority
      * is to meet the file size limit requirement, rather than
      * to make the file streamable. mStreamableFile does not tell
      * whether the actual recorded file is streamable or not.
+     * A fragmented file writes its moov up front and needs no reservation.
      */
     mStreamableFile =
         (mMaxFileSizeLimitBytes != 0 &&
-         mMaxFileSizeLimitBytes >= kMinStreamableFileSizeInBytes);
+         mMaxFileSizeLimitBytes >= kMinStreamableFileSizeInBytes &&
+         !isFragmented());
 
     /*
      * mWriteBoxToMemory is true if the amount of data in a file-level meta or
@@ -1024,7 +1071,7 @@ status_t MPEG4Writer::start(MetaData *param) {
 
     mFreeBoxOffset = mOffset;
 
-    if (mInMemoryCacheSize == 0) {
+    if (mInMemoryCacheSize == 0 && !isFragmented()) {
         int32_t bitRate = -1;
         if (mHasFileLevelMeta) {
             mFileLevelMetaDataSize = estimateFileLevelMetaSize(param);
@@ -1062,7 +1109,11 @@ status_t MPEG4Writer::start(MetaData *param) {
 
     mOffset = mMdatOffset;
     seekOrPostError(mFd, mMdatOffset, SEEK_SET);
-    write("\x00\x00\x00\x01mdat????????", 16);
+    // In fragmented mode, the writer thread appends the moov box and then
+    // one mdat per fragment.
+    if (!isFragmented()) {
+        write("\x00\x00\x00\x01mdat????????", 16);
+    }
 
     /* Confirm whether the writing of the initial file atoms, ftyp and free,
      * are written to the file properly by posting kWhatNoIOErrorSoFar to the
@@ -1357,6 +1408,24 @@ status_t MPEG4Writer::reset(bool stopSource, bool waitForAnyPreviousCallToComple
         return mResetStatus;
     }
 
+    if (isFragmented()) {
+        // All fragments are complete in the file already. Only a session
+        // that never produced a fragment still misses its init segment.
+        if (!mInitSegmentWritten) {
+            writeMoovBox(0);
+            mInitSegmentWritten = true;
+        }
+        mMdatEndOffset = mOffset;
+        CHECK(mBoxes.empty());
+
+        status_t errRelease = release();
+        if (err == OK) {
+            err = errRelease;
+        }
+        mResetStatus = err;
+        return mResetStatus;
+    }
+
     // Fix up the size of the 'mdat' chunk.
     seekOrPostError(mFd, mMdatOffset + 8, SEEK_SET);
     uint64_t size = mOffset - mMdatOffset;
@@ -1497,6 +1566,17 @@ void MPEG4Writer::writeMoovBox(int64_t durationUs) {
         writeUdtaBox();
     }
     writeMoovLevelMetaBox();
+    if (isFragmented()) {
+        // Samples and their timing are described by the fragments, which
+        // use signed composition offsets instead of shifting the movie start.
+        for (List<Track *>::iterator it = mTracks.begin();
+            it != mTracks.end(); ++it) {
+            (*it)->writeTrackHeader();
+        }
+        writeMvexBox();
+        endBox();  // moov
+        return;
+    }
     // Loop through all the tracks to get the global time offset if there is
     // any ctts table appears in a video track.
     int64_t minCttsOffsetTimeUs = kMaxCttsOffsetTimeUs;
@@ -1525,6 +1605,15 @@ void MPEG4Writer::writeMoovBox(int64_t durationUs) {
     endBox();  // moov
 }
 
+void MPEG4Writer::writeMvexBox() {
+    beginBox("mvex");
+    for (List<Track *>::iterator it = mTracks.begin();
+        it != mTracks.end(); ++it) {
+        (*it)->writeTrexBox();
+    }
+    endBox();  // mvex
+}
+
 void MPEG4Writer::writeFtypBox(MetaData *param) {
     beginBox("ftyp");
 
@@ -1546,6 +1635,8 @@ void MPEG4Writer::writeFtypBox(MetaData *param) {
             } else {
                 writeFourcc("heic");
             }
+        } else if (isFragmented()) {
+            writeFourcc("iso6");
         } else {
             writeFourcc("mp42");
         }
@@ -1561,6 +1652,12 @@ void MPEG4Writer::writeFtypBox(MetaData *param) {
             }
         }
         if (mHasMoovBox) {
+            if (isFragmented()) {
+                // tfdt and signed trun offsets need iso6; cmfc marks the
+                // single track per fragment CMAF layout.
+                writeFourcc("iso6");
+                writeFourcc("cmfc");
+            }
             writeFourcc("isom");
             writeFourcc("mp42");
         }
@@ -2200,6 +2297,11 @@ MPEG4Writer::Track::Track(
       mTrackId(aTrackId),
       mTrackDurationUs(0),
       mEstimatedTrackSizeBytes(0),
+      mNumSamples(0),
+      mNumSyncSamples(0),
+      mFragmentDecodeTimeTicks(0),
+      mFragmentBuffered(false),
+      mInitHasSampleEntry(false),
       mSamplesHaveSameSize(true),
       mStszTableEntries(new ListTableEntries<uint32_t, 1>(1000)),
       mCo64TableEntries(new ListTableEntries<off64_t, 1>(1000)),
@@ -2289,6 +2391,12 @@ void MPEG4Writer::Track::resetInternal() {
     mIsMalformed = false;
     mTrackDurationUs = 0;
     mEstimatedTrackSizeBytes = 0;
+    mNumSamples = 0;
+    mNumSyncSamples = 0;
+    mFragmentSamples.clear();
+    mFragmentDecodeTimeTicks = 0;
+    mFragmentBuffered = false;
+    mInitHasSampleEntry = false;
     mSamplesHaveSameSize = false;
     if (mStszTableEntries != NULL) {
         delete mStszTableEntries;
@@ -2775,6 +2883,11 @@ void MPEG4Writer::writeChunkToFile(Chunk* chunk) {
     ALOGV("writeChunkToFile: %" PRId64 " from %s track",
         chunk->mTimeStampUs, chunk->mTrack->getTrackType());
 
+    if (isFragmented()) {
+        writeFragmentToFile(chunk);
+        return;
+    }
+
     int32_t isFirstSample = true;
     while (!chunk->mSamples.empty()) {
         List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
@@ -2804,6 +2917,77 @@ void MPEG4Writer::writeChunkToFile(Chunk* chunk) {
     chunk->mSamples.clear();
 }
 
+bool MPEG4Writer::isReadyForInitSegment_l() {
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+         it != mChunkInfos.end(); ++it) {
+        if (it->mChunks.empty() && !it->mTrack->reachedEOS()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MPEG4Writer::writeFragmentToFile(Chunk* chunk) {
+    ALOGV("writeFragmentToFile: %" PRId64 " from %s track, %zu samples",
+        chunk->mTimeStampUs, chunk->mTrack->getTrackType(), chunk->mFragmentSamples.size());
+    CHECK_EQ(chunk->mFragmentSamples.size(), chunk->mSamples.size());
+
+    if (!mInitSegmentWritten) {
+        // This may run without mLock while the track threads keep adding
+        // samples. The init segment only describes the sample entries, which
+        // are final once each track handed over its first fragment under mLock.
+        writeMoovBox(0);
+        mInitSegmentWritten = true;
+        ALOGI("Init segment was written to the file");
+    }
+
+    // mStartTimestampUs is final here: no fragment is written before every
+    // track has buffered one, see isReadyForInitSegment_l().
+    off64_t referencedSizeOffset = -1;
+    if (mWriteSegmentIndex) {
+        chunk->mTrack->writeSidxBox(*chunk, mStartTimestampUs, &referencedSizeOffset);
+    }
+
+    off64_t moofOffset = mOffset;
+    off64_t dataOffsetOffset = -1;
+    beginBox("moof");
+    beginBox("mfhd");
+    writeInt32(0);  // version=0, flags=0
+    writeInt32(++mFragmentSequenceNumber);
+    endBox();  // mfhd
+    chunk->mTrack->writeTrafBox(*chunk, mStartTimestampUs, &dataOffsetOffset);
+    endBox();  // moof
+
+    // The trun data offset is relative to the moof box and points right past
+    // the header of the mdat box that follows it.
+    uint32_t dataOffset = htonl(mOffset - moofOffset + 8);
+    seekOrPostError(mFd, dataOffsetOffset, SEEK_SET);
+    writeOrPostError(mFd, &dataOffset, 4);
+    seekOrPostError(mFd, mOffset, SEEK_SET);
+
+    beginBox("mdat");
+    bool usePrefix = chunk->mTrack->usePrefix();
+    while (!chunk->mSamples.empty()) {
+        List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
+
+        size_t bytesWritten;
+        addSample_l(*it, usePrefix, 0 /* tiffHdrOffset */, &bytesWritten);
+
+        (*it)->release();
+        (*it) = NULL;
+        chunk->mSamples.erase(it);
+    }
+    endBox();  // mdat
+
+    if (referencedSizeOffset >= 0) {
+        // reference_type (0: media) shares its 32 bits with referenced_size.
+        uint32_t referencedSize = htonl((mOffset - moofOffset) & 0x7fffffff);
+        seekOrPostError(mFd, referencedSizeOffset, SEEK_SET);
+        writeOrPostError(mFd, &referencedSize, 4);
+        seekOrPostError(mFd, mOffset, SEEK_SET);
+    }
+}
+
 void MPEG4Writer::writeAllChunks() {
     ALOGV("writeAllChunks");
     size_t outstandingChunks = 0;
@@ -2822,6 +3006,10 @@ void MPEG4Writer::writeAllChunks() {
 bool MPEG4Writer::findChunkToWrite(Chunk *chunk) {
     ALOGV("findChunkToWrite");
 
+    if (isFragmented() && !mInitSegmentWritten && !isReadyForInitSegment_l()) {
+        return false;
+    }
+
     int64_t minTimestampUs = 0x7FFFFFFFFFFFFFFFLL;
     Track *track = NULL;
     for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
@@ -3497,6 +3685,9 @@ status_t MPEG4Writer::Track::threadEntry() {
     int64_t lastSampleDurationUs = -1;      // Duration calculated from EOS buffer and its timestamp
     int64_t lastSampleDurationTicks = -1;   // Timescale based ticks
     int64_t sampleFileOffset = -1;
+    const bool isFragmented = mOwner->isFragmented();
+    const int64_t fragmentDurationUs = mOwner->mFragmentDurationUs;
+    int64_t compositionOffsetTicks = 0;     // Signed ctts offset, fragmented mode only
 
     if (mIsAudio) {
         prctl(PR_SET_NAME, (unsigned long)"MP4WtrAudTrkThread", 0, 0, 0);
@@ -3653,6 +3844,15 @@ status_t MPEG4Writer::Track::threadEntry() {
             lastSample = -1;
         }
         ALOGV("sampleFileOffset:%lld", (long long)sampleFileOffset);
+        if (isFragmented && sampleFileOffset != -1) {
+            ALOGE("Samples at a given file offset can not be fragmented for %s track",
+                    trackName);
+            buffer->release();
+            buffer = nullptr;
+            mSource->stop();
+            mIsMalformed = true;
+            break;
+        }
 
         /*
          * Reserve space in the file for the current sample + to be written MOOV box. If reservation
@@ -3747,7 +3947,7 @@ status_t MPEG4Writer::Track::threadEntry() {
         }
 ////////////////////////////////////////////////////////////////////////////////
         if (!mIsHeif) {
-            if (mStszTableEntries->count() == 0) {
+            if (mNumSamples == 0) {
                 mFirstSampleTimeRealUs = systemTime() / 1000;
                 if (timestampUs < 0 && mFirstSampleStartOffsetUs == 0) {
                     mFirstSampleStartOffsetUs = -timestampUs;
@@ -3841,7 +4041,11 @@ status_t MPEG4Writer::Track::threadEntry() {
                     break;
                 }
 
-                if (mStszTableEntries->count() == 0) {
+                if (isFragmented) {
+                    // Fragments carry a signed offset per sample in their trun box.
+                    compositionOffsetTicks = currCttsOffsetTimeTicks -
+                            (kMaxCttsOffsetTimeUs * mTimeScale + 500000LL) / 1000000LL;
+                } else if (mNumSamples == 0) {
                     // Force the first ctts table entry to have one single entry
                     // so that we can do adjustment for the initial track start
                     // time offset easily in writeCttsBox().
@@ -3859,7 +4063,7 @@ status_t MPEG4Writer::Track::threadEntry() {
                 }
 
                 // Update ctts time offset range
-                if (mStszTableEntries->count() == 0) {
+                if (mNumSamples == 0) {
                     mMinCttsOffsetTicks = currCttsOffsetTimeTicks;
                     mMaxCttsOffsetTicks = currCttsOffsetTimeTicks;
                 } else {
@@ -3925,9 +4129,18 @@ status_t MPEG4Writer::Track::threadEntry() {
                     timestampUs += deltaUs;
                 }
             }
-            mStszTableEntries->add(htonl(sampleSize));
+            ++mNumSamples;
+            if (isFragmented) {
+                // The duration of a sample is only known once the next one
+                // arrives, and the previous sample is always still pending.
+                if (!mFragmentSamples.empty()) {
+                    mFragmentSamples.back().mDurationTicks = currDurationTicks;
+                }
+            } else {
+                mStszTableEntries->add(htonl(sampleSize));
+            }
 
-            if (mStszTableEntries->count() > 2) {
+            if (mNumSamples > 2 && !isFragmented) {
 
                 // Force the first sample to have its own stts entry so that
                 // we can adjust its value later to maintain the A/V sync.
@@ -3939,7 +4152,7 @@ status_t MPEG4Writer::Track::threadEntry() {
                 }
             }
             if (mSamplesHaveSameSize) {
-                if (mStszTableEntries->count() >= 2 && previousSampleSize != sampleSize) {
+                if (mNumSamples >= 2 && previousSampleSize != sampleSize) {
                     mSamplesHaveSameSize = false;
                 }
                 previousSampleSize = sampleSize;
@@ -3951,7 +4164,11 @@ status_t MPEG4Writer::Track::threadEntry() {
             lastTimestampUs = timestampUs;
 
             if (isSync != 0) {
-                addOneStssTableEntry(mStszTableEntries->count());
+                ++mNumSyncSamples;
+                // Fragments flag their sync samples in trun.
+                if (!isFragmented) {
+                    addOneStssTableEntry(mNumSamples);
+                }
             }
 
             if (mTrackingProgressStatus) {
@@ -3961,6 +4178,29 @@ status_t MPEG4Writer::Track::threadEntry() {
                 trackProgressStatus(timestampUs);
             }
         }
+        if (isFragmented) {
+            if (!mChunkSamples.empty()) {
+                // Cut video fragments at sync samples so that each one can be
+                // decoded on its own, but do not let them grow without bound.
+                int64_t durationUs = timestampUs - chunkTimestampUs;
+                if ((durationUs >= fragmentDurationUs && (!mIsVideo || isSync)) ||
+                        durationUs >= kMaxFragmentDurationFactor * fragmentDurationUs) {
+                    bufferFragment(chunkTimestampUs);
+                }
+            }
+            if (mChunkSamples.empty()) {
+                chunkTimestampUs = timestampUs;
+            }
+            FragmentSample sample;
+            sample.mSize = sampleSize;
+            sample.mDurationTicks = 0;
+            sample.mCompositionOffsetTicks = compositionOffsetTicks;
+            sample.mIsSync = !mIsVideo || isSync;
+            mFragmentSamples.push_back(sample);
+            mChunkSamples.push_back(copy);
+            continue;
+        }
+
         if (!hasMultipleTracks) {
             size_t bytesWritten;
             off64_t offset = mOwner->addSample_l(
@@ -4016,16 +4256,27 @@ status_t MPEG4Writer::Track::threadEntry() {
     mOwner->trackProgressStatus(mTrackId.getId(), -1, err);
 
     // Add final entries only for non-empty tracks.
-    if (mStszTableEntries->count() > 0) {
+    if (mNumSamples > 0) {
         if (mIsHeif) {
             if (!mChunkSamples.empty()) {
                 bufferChunk(0);
                 ++nChunks;
             }
+        } else if (isFragmented) {
+            // Same rule as for the last stts entry below.
+            if (lastSampleDurationUs < 0) {
+                lastSampleDurationUs = (mNumSamples == 1) ? 0 : lastDurationUs;
+                lastSampleDurationTicks = (mNumSamples == 1) ? 0 : lastDurationTicks;
+            }
+            if (!mFragmentSamples.empty()) {
+                mFragmentSamples.back().mDurationTicks = lastSampleDurationTicks;
+                bufferFragment(chunkTimestampUs);
+            }
+            mTrackDurationUs += lastSampleDurationUs;
         } else {
             // Last chunk
             if (!hasMultipleTracks) {
-                addOneStscTableEntry(1, mStszTableEntries->count());
+                addOneStscTableEntry(1, mNumSamples);
             } else if (!mChunkSamples.empty()) {
                 addOneStscTableEntry(++nChunks, mChunkSamples.size());
                 bufferChunk(timestampUs);
@@ -4034,7 +4285,7 @@ status_t MPEG4Writer::Track::threadEntry() {
             // We don't really know how long the last frame lasts, since
             // there is no frame time after it, just repeat the previous
             // frame's duration.
-            if (mStszTableEntries->count() == 1) {
+            if (mNumSamples == 1) {
                 if (lastSampleDurationUs >= 0) {
                     addOneSttsTableEntry(sampleCount, lastSampleDurationTicks);
                 } else {
@@ -4069,7 +4320,7 @@ status_t MPEG4Writer::Track::threadEntry() {
     sendTrackSummary(hasMultipleTracks);
 
     ALOGI("Received total/0-length (%d/%d) buffers and encoded %d frames. - %s",
-            count, nZeroLengthFrames, mStszTableEntries->count(), trackName);
+            count, nZeroLengthFrames, mNumSamples, trackName);
     if (mIsAudio) {
         ALOGI("Audio track drift time: %" PRId64 " us", mOwner->getDriftTimeUs());
     }
@@ -4090,26 +4341,26 @@ bool MPEG4Writer::Track::isTrackMalFormed() {
         mOwner->mStartMeta->findInt32(kKeyEmptyTrackMalFormed, &emptyTrackMalformed) &&
         emptyTrackMalformed) {
         // MediaRecorder(sets kKeyEmptyTrackMalFormed by default) report empty tracks as malformed.
-        if (!mIsHeif && mStszTableEntries->count() == 0) {  // no samples written
+        if (!mIsHeif && mNumSamples == 0) {  // no samples written
             ALOGE("The number of recorded samples is 0");
             mIsMalformed = true;
             return true;
         }
-        if (mIsVideo && mStssTableEntries->count() == 0) {  // no sync frames for video
+        if (mIsVideo && mNumSyncSamples == 0) {  // no sync frames for video
             ALOGE("There are no sync frames for video track");
             mIsMalformed = true;
             return true;
         }
     } else {
         // Through MediaMuxer, empty tracks can be added. No sync frames for video.
-        if (mIsVideo && mStszTableEntries->count() > 0 && mStssTableEntries->count() == 0) {
+        if (mIsVideo && mNumSamples > 0 && mNumSyncSamples == 0) {
             ALOGE("There are no sync frames for video track");
             mIsMalformed = true;
             return true;
         }
     }
     // Don't check for CodecSpecificData when track is empty.
-    if (mStszTableEntries->count() > 0 && OK != checkCodecSpecificData()) {
+    if (mNumSamples > 0 && OK != checkCodecSpecificData()) {
         // No codec specific data.
         mIsMalformed = true;
         return true;
@@ -4137,7 +4388,7 @@ void MPEG4Writer::Track::sendTrackSummary(bool hasMultipleTracks) {
 
     mOwner->notify(MEDIA_RECORDER_TRACK_EVENT_INFO,
                     trackNum | MEDIA_RECORDER_TRACK_INFO_ENCODED_FRAMES,
-                    mStszTableEntries->count());
+                    mNumSamples);
 
     {
         // The system delay time excluding the requested initial delay that
@@ -4231,6 +4482,10 @@ bool MPEG4Writer::isBackgroundMode() const {
     return mIsBackgroundMode;
 }
 
+bool MPEG4Writer::isFragmented() const {
+    return mFragmentDurationUs > 0;
+}
+
 bool MPEG4Writer::useNalLengthFour() {
     return mUse4ByteNalLength;
 }
@@ -4243,6 +4498,26 @@ void MPEG4Writer::Track::bufferChunk(int64_t timestampUs) {
     mChunkSamples.clear();
 }
 
+void MPEG4Writer::Track::bufferFragment(int64_t timestampUs) {
+    ALOGV("bufferFragment");
+
+    if (!mFragmentBuffered) {
+        // The sample entry is final once a sample was received, see the
+        // handling of codec config buffers in threadEntry().
+        mFragmentBuffered = true;
+        mInitHasSampleEntry = !mIsMalformed && checkCodecSpecificData() == OK;
+    }
+
+    Chunk chunk(this, timestampUs, mChunkSamples);
+    chunk.mBaseDecodeTimeTicks = mFragmentDecodeTimeTicks;
+    for (const FragmentSample &sample : mFragmentSamples) {
+        mFragmentDecodeTimeTicks += sample.mDurationTicks;
+    }
+    chunk.mFragmentSamples.swap(mFragmentSamples);
+    mOwner->bufferChunk(chunk);
+    mChunkSamples.clear();
+}
+
 int64_t MPEG4Writer::Track::getDurationUs() const {
     return mTrackDurationUs + getStartTimeOffsetTimeUs() + mOwner->getStartTimeOffsetBFramesUs();
 }
@@ -4333,7 +4608,9 @@ void MPEG4Writer::Track::writeTrackHeader() {
     uint32_t now = getMpeg4Time();
     mOwner->beginBox("trak");
         writeTkhdBox(now);
-        writeEdtsBox();
+        if (!mOwner->isFragmented()) {
+            writeEdtsBox();
+        }
         mOwner->beginBox("mdia");
             writeMdhdBox(now);
             writeHdlrBox();
@@ -4362,21 +4639,46 @@ int64_t MPEG4Writer::Track::getMinCttsOffsetTimeUs() {
     return mMinCttsOffsetTimeUs;
 }
 
+void MPEG4Writer::Track::writeStsdBox() {
+    mOwner->beginBox("stsd");
+    mOwner->writeInt32(0);               // version=0, flags=0
+    mOwner->writeInt32(1);               // entry count
+    if (mIsAudio) {
+        writeAudioFourCCBox();
+    } else if (mIsVideo) {
+        writeVideoFourCCBox();
+    } else {
+        writeMetadataFourCCBox();
+    }
+    mOwner->endBox();  // stsd
+}
+
 void MPEG4Writer::Track::writeStblBox() {
     mOwner->beginBox("stbl");
-    // Add subboxes for only non-empty and well-formed tracks.
-    if (mStszTableEntries->count() > 0 && !isTrackMalFormed()) {
-        mOwner->beginBox("stsd");
-        mOwner->writeInt32(0);               // version=0, flags=0
-        mOwner->writeInt32(1);               // entry count
-        if (mIsAudio) {
-            writeAudioFourCCBox();
-        } else if (mIsVideo) {
-            writeVideoFourCCBox();
-        } else {
-            writeMetadataFourCCBox();
+    if (mOwner->isFragmented()) {
+        // The fragments describe the samples, so the tables are empty. The
+        // track thread may still be adding samples: only use what it set
+        // before buffering its first fragment.
+        if (mInitHasSampleEntry) {
+            writeStsdBox();
+            for (const char *type : {"stts", "stsc", "stco"}) {
+                mOwner->beginBox(type);
+                mOwner->writeInt32(0);       // version=0, flags=0
+                mOwner->writeInt32(0);       // entry count
+                mOwner->endBox();
+            }
+            mOwner->beginBox("stsz");
+            mOwner->writeInt32(0);           // version=0, flags=0
+            mOwner->writeInt32(0);           // sample size
+            mOwner->writeInt32(0);           // sample count
+            mOwner->endBox();  // stsz
         }
-        mOwner->endBox();  // stsd
+        mOwner->endBox();  // stbl
+        return;
+    }
+    // Add subboxes for only non-empty and well-formed tracks.
+    if (mNumSamples > 0 && !isTrackMalFormed()) {
+        writeStsdBox();
         writeSttsBox();
         if (mIsVideo) {
             writeCttsBox();
@@ -4751,7 +5053,8 @@ void MPEG4Writer::Track::writeTkhdBox(uint32_t now) {
     mOwner->writeInt32(now);           // modification time
     mOwner->writeInt32(mTrackId.getId()); // track id starts with 1
     mOwner->writeInt32(0);             // reserved
-    int64_t trakDurationUs = getDurationUs();
+    // The init segment of a fragmented file has no duration.
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int32_t mvhdTimeScale = mOwner->getTimeScale();
     int32_t tkhdDuration =
         (trakDurationUs * mvhdTimeScale + 5E5) / 1E6;
@@ -4954,7 +5257,7 @@ void MPEG4Writer::Track::writeEdtsBox() {
 }
 
 void MPEG4Writer::Track::writeMdhdBox(uint32_t now) {
-    int64_t trakDurationUs = getDurationUs();
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int64_t mdhdDuration = (trakDurationUs * mTimeScale + 5E5) / 1E6;
     mOwner->beginBox("mdhd");
 
@@ -5119,6 +5422,106 @@ int32_t MPEG4Writer::Track::getStartTimeOffsetScaledTime() const {
     return (getStartTimeOffsetTimeUs() * mTimeScale + 500000LL) / 1000000LL;
 }
 
+int64_t MPEG4Writer::Track::getFragmentDecodeTimeTicks(
+        const Chunk &chunk, int64_t movieStartTimeUs) const {
+    // Without an edit list, a track starting after the movie is delayed by
+    // the decoding time of its fragments instead.
+    int64_t startOffsetUs = 0;
+    if (mStartTimestampUs > movieStartTimeUs && movieStartTimeUs >= 0) {
+        startOffsetUs = mStartTimestampUs - movieStartTimeUs;
+    }
+    return chunk.mBaseDecodeTimeTicks + (startOffsetUs * mTimeScale + 500000LL) / 1000000LL;
+}
+
+void MPEG4Writer::Track::writeTrexBox() {
+    mOwner->beginBox("trex");
+    mOwner->writeInt32(0);                 // version=0, flags=0
+    mOwner->writeInt32(mTrackId.getId());  // track id
+    mOwner->writeInt32(1);                 // default sample description index
+    mOwner->writeInt32(0);                 // default sample duration
+    mOwner->writeInt32(0);                 // default sample size
+    mOwner->writeInt32(0);                 // default sample flags
+    mOwner->endBox();  // trex
+}
+
+void MPEG4Writer::Track::writeSidxBox(
+        const Chunk &chunk, int64_t movieStartTimeUs, off64_t *referencedSizeOffset) {
+    int64_t decodeTimeTicks = getFragmentDecodeTimeTicks(chunk, movieStartTimeUs);
+    int64_t earliestPresentationTimeTicks = INT64_MAX;
+    int64_t durationTicks = 0;
+    for (const FragmentSample &sample : chunk.mFragmentSamples) {
+        earliestPresentationTimeTicks = std::min(earliestPresentationTimeTicks,
+                decodeTimeTicks + durationTicks + sample.mCompositionOffsetTicks);
+        durationTicks += sample.mDurationTicks;
+    }
+    earliestPresentationTimeTicks = std::max((int64_t)0, earliestPresentationTimeTicks);
+    bool startsWithSap = !chunk.mFragmentSamples.empty() && chunk.mFragmentSamples[0].mIsSync;
+
+    mOwner->beginBox("sidx");
+    mOwner->writeInt32(1 << 24);           // version=1, flags=0
+    mOwner->writeInt32(mTrackId.getId());  // reference id
+    mOwner->writeInt32(mTimeScale);        // timescale
+    mOwner->writeInt64(earliestPresentationTimeTicks);
+    mOwner->writeInt64(0);                 // first offset: the moof follows
+    mOwner->writeInt16(0);                 // reserved
+    mOwner->writeInt16(1);                 // reference count
+    *referencedSizeOffset = mOwner->mOffset;
+    mOwner->writeInt32(0);                 // reference type and size, set later
+    mOwner->writeInt32(durationTicks);     // subsegment duration
+    // starts_with_SAP, SAP_type 1, SAP_delta_time 0
+    mOwner->writeInt32(startsWithSap ? 0x90000000 : 0);
+    mOwner->endBox();  // sidx
+}
+
+void MPEG4Writer::Track::writeTrafBox(
+        const Chunk &chunk, int64_t movieStartTimeUs, off64_t *dataOffsetOffset) {
+    mOwner->beginBox("traf");
+
+    mOwner->beginBox("tfhd");
+    mOwner->writeInt32(0x020000);          // version=0, flags=default-base-is-moof
+    mOwner->writeInt32(mTrackId.getId());  // track id
+    mOwner->endBox();  // tfhd
+
+    mOwner->beginBox("tfdt");
+    mOwner->writeInt32(1 << 24);           // version=1, flags=0
+    mOwner->writeInt64(getFragmentDecodeTimeTicks(chunk, movieStartTimeUs));
+    mOwner->endBox();  // tfdt
+
+    // data offset, sample duration, sample size and sample flags present,
+    // plus sample composition time offsets for video.
+    uint32_t flags = 0x000001 | 0x000100 | 0x000200 | 0x000400;
+    if (mIsVideo) {
+        flags |= 0x000800;
+    }
+    mOwner->beginBox("trun");
+    // Version 1 allows negative composition offsets.
+    mOwner->writeInt32((1 << 24) | flags);
+    mOwner->writeInt32(chunk.mFragmentSamples.size());
+    *dataOffsetOffset = mOwner->mOffset;
+    mOwner->writeInt32(0);                 // data offset, set once the moof size is known
+
+    // Build the sample table in memory so that it is written in one go.
+    const size_t valuesPerSample = mIsVideo ? 4 : 3;
+    std::vector<uint32_t> entries;
+    entries.reserve(chunk.mFragmentSamples.size() * valuesPerSample);
+    for (const FragmentSample &sample : chunk.mFragmentSamples) {
+        entries.push_back(htonl(sample.mDurationTicks));
+        entries.push_back(htonl(sample.mSize));
+        // sample_depends_on: 2 (I frame) or 1 (not I frame), and
+        // sample_is_non_sync_sample.
+        entries.push_back(htonl(sample.mIsSync ? 0x02000000 : 0x01010000));
+        if (mIsVideo) {
+            entries.push_back(htonl((uint32_t)sample.mCompositionOffsetTicks));
+        }
+    }
+    if (!entries.empty()) {
+        mOwner->write(entries.data(), sizeof(uint32_t), entries.size());
+    }
+    mOwner->endBox();  // trun
+
+    mOwner->endBox();  // traf
+}
+
 void MPEG4Writer::Track::writeSttsBox() {
     mOwner->beginBox("stts");
     mOwner->writeInt32(0);  // version=0, flags=0
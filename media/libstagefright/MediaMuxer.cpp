@@ -170,6 +170,33 @@ status_t MediaMuxer::setLocation(int latitude, int longitude) {
     return static_cast<MPEG4Writer*>(mWriter.get())->setGeoData(latitude, longitude);
 }
 
+status_t MediaMuxer::setFragmentDuration(int64_t durationUs, bool writeSegmentIndex) {
+    Mutex::Autolock autoLock(mMuxerLock);
+    if (mState != INITIALIZED) {
+        ALOGE("setFragmentDuration() must be called before start().");
+        return INVALID_OPERATION;
+    }
+    if (mFormat != OUTPUT_FORMAT_MPEG_4 && mFormat != OUTPUT_FORMAT_THREE_GPP) {
+        ALOGE("setFragmentDuration() is only supported for .mp4 or .3gp output.");
+        return INVALID_OPERATION;
+    }
+    if (durationUs < 0) {
+        ALOGE("setFragmentDuration() get invalid duration %lld", (long long)durationUs);
+        return -EINVAL;
+    }
+
+    ALOGV("Setting fragment duration: %lld us, sidx %d", (long long)durationUs,
+            writeSegmentIndex);
+    if (durationUs == 0) {
+        mFileMeta->remove(kKeyFragmentDurationUs);
+        mFileMeta->remove(kKeyFragmentSegmentIndex);
+    } else {
+        mFileMeta->setInt64(kKeyFragmentDurationUs, durationUs);
+        mFileMeta->setInt32(kKeyFragmentSegmentIndex, writeSegmentIndex);
+    }
+    return OK;
+}
+
 status_t MediaMuxer::start() {
     Mutex::Autolock autoLock(mMuxerLock);
     if (mState == INITIALIZED) {
@@ -38,8 +38,20 @@
 #include <media/stagefright/Utils.h>
 #include <media/stagefright/FoundationUtils.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace android {
 
+// Bounds of the samples read ahead for a track.
+static const size_t kMaxPrefetchedSamplesPerFetch = 8;  // times mMaxFetchCount
+static const size_t kMaxPrefetchedBytes = 4 * 1024 * 1024;
+
+// Delay before reading again when the extractor had no buffer to read into.
+static const auto kPrefetchRetryDelay = std::chrono::milliseconds(5);
+
 NuMediaExtractor::Sample::Sample()
     : mBuffer(NULL),
       mSampleTimeUs(-1LL) {
@@ -50,13 +62,166 @@ NuMediaExtractor::Sample::Sample(MediaBufferBase *buffer, int64_t timeUs)
       mSampleTimeUs(timeUs) {
 }
 
+// Reads the samples of a track ahead of the client, so that the extractor reads the next
+// samples while the client processes the previous ones. Samples are read in batches with
+// readMultiple(), which takes a single transaction with the extractor for the whole batch,
+// and are copied out of the buffers of the extractor, which come from small pools that
+// the extractor needs back to read further.
+struct NuMediaExtractor::TrackPrefetcher {
+    TrackPrefetcher(const sp<IMediaSource> &source, size_t trackIndex, size_t maxFetchCount);
+    ~TrackPrefetcher();
+
+    // Waits for the next samples of the track, and moves up to maxCount of them to the end
+    // of samples. Returns OK while the track may have more samples, and the final result of
+    // the reads after the last one.
+    status_t takeSamples(std::list<Sample> *samples, size_t maxCount);
+
+    // Stops reading and moves all the samples read ahead to the end of samples. Returns
+    // the final result of the reads if the track has no more samples to read, OK otherwise.
+    status_t stop(std::list<Sample> *samples);
+
+private:
+    const sp<IMediaSource> mSource;
+    const size_t mTrackIndex;
+    const size_t mMaxQueuedSamples;
+    // Size of the largest sample of the track, from its format or the largest read so far,
+    // 0 if not known yet. Only used by the thread.
+    size_t mMaxSampleSize;
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::list<Sample> mQueue;
+    size_t mQueuedBytes;
+    status_t mFinalResult;
+    bool mStopping;
+    std::thread mThread;
+
+    void threadLoop();
+
+    DISALLOW_EVIL_CONSTRUCTORS(TrackPrefetcher);
+};
+
+NuMediaExtractor::TrackPrefetcher::TrackPrefetcher(
+        const sp<IMediaSource> &source, size_t trackIndex, size_t maxFetchCount)
+    : mSource(source),
+      mTrackIndex(trackIndex),
+      mMaxQueuedSamples(maxFetchCount * kMaxPrefetchedSamplesPerFetch),
+      mMaxSampleSize(0),
+      mQueuedBytes(0),
+      mFinalResult(OK),
+      mStopping(false) {
+    sp<MetaData> meta = mSource->getFormat();
+    int32_t maxInputSize;
+    if (meta != NULL && meta->findInt32(kKeyMaxInputSize, &maxInputSize) && maxInputSize > 0) {
+        mMaxSampleSize = maxInputSize;
+    }
+    mThread = std::thread(&TrackPrefetcher::threadLoop, this);
+}
+
+NuMediaExtractor::TrackPrefetcher::~TrackPrefetcher() {
+    std::list<Sample> samples;
+    stop(&samples);
+    for (const Sample &sample : samples) {
+        sample.mBuffer->release();
+    }
+}
+
+void NuMediaExtractor::TrackPrefetcher::threadLoop() {
+    std::unique_lock<std::mutex> lock(mLock);
+    for (;;) {
+        mCondition.wait(lock, [this] {
+            return mStopping
+                    || (mQueue.size() < mMaxQueuedSamples
+                            && mQueuedBytes < kMaxPrefetchedBytes);
+        });
+        if (mStopping) {
+            break;
+        }
+        size_t maxCount = std::min(
+                mMaxQueuedSamples - mQueue.size(), (size_t)IMediaSource::kMaxNumReadMultiple);
+        // The extractor reads a whole batch, so read no more samples than fit in the bytes
+        // left at the size of the largest one: the queue then goes over kMaxPrefetchedBytes
+        // by less than a sample, as if each sample was checked against it.
+        if (mMaxSampleSize == 0) {
+            maxCount = 1;
+        } else {
+            maxCount = std::clamp(
+                    (kMaxPrefetchedBytes - mQueuedBytes) / mMaxSampleSize, (size_t)1, maxCount);
+        }
+
+        lock.unlock();
+        std::list<Sample> samples;
+        MediaSource::ReadOptions options;
+        status_t err = readSamples(mSource, maxCount, &options, true /* copy */, &samples);
+        lock.lock();
+
+        for (const Sample &sample : samples) {
+            mQueuedBytes += sample.mBuffer->range_length();
+            mMaxSampleSize = std::max(mMaxSampleSize, sample.mBuffer->range_length());
+        }
+        const bool readAny = !samples.empty();
+        mQueue.splice(mQueue.end(), samples);
+
+        if (err == WOULD_BLOCK) {
+            // The extractor is out of buffers for now.
+            if (!readAny) {
+                mCondition.wait_for(lock, kPrefetchRetryDelay, [this] { return mStopping; });
+            }
+        } else if (err != OK) {
+            ALOGW_IF(err != ERROR_END_OF_STREAM,
+                    "read on track %zu failed with error %d", mTrackIndex, err);
+            mFinalResult = err;
+            mCondition.notify_all();
+            break;
+        }
+        if (readAny) {
+            mCondition.notify_all();
+        }
+    }
+}
+
+status_t NuMediaExtractor::TrackPrefetcher::takeSamples(
+        std::list<Sample> *samples, size_t maxCount) {
+    std::unique_lock<std::mutex> lock(mLock);
+    mCondition.wait(lock, [this] { return !mQueue.empty() || mFinalResult != OK; });
+
+    auto end = mQueue.begin();
+    for (size_t count = 0; count < maxCount && end != mQueue.end(); ++count, ++end) {
+        mQueuedBytes -= end->mBuffer->range_length();
+    }
+    samples->splice(samples->end(), mQueue, mQueue.begin(), end);
+    mCondition.notify_all();
+
+    return mQueue.empty() ? mFinalResult : OK;
+}
+
+status_t NuMediaExtractor::TrackPrefetcher::stop(std::list<Sample> *samples) {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mStopping = true;
+    }
+    mCondition.notify_all();
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+    samples->splice(samples->end(), mQueue);
+    mQueuedBytes = 0;
+    return mFinalResult;
+}
+
 NuMediaExtractor::NuMediaExtractor(EntryPoint entryPoint)
     : mEntryPoint(entryPoint),
       mTotalBitrate(-1LL),
-      mDurationUs(-1LL) {
+      mDurationUs(-1LL),
+      mPrefetchEnabled(false) {
 }
 
 NuMediaExtractor::~NuMediaExtractor() {
+    for (size_t i = 0; i < mSelectedTracks.size(); ++i) {
+        stopPrefetching(&mSelectedTracks.editItemAt(i));
+    }
     releaseAllTrackSamples();
 
     for (size_t i = 0; i < mSelectedTracks.size(); ++i) {
@@ -431,6 +596,10 @@ status_t NuMediaExtractor::selectTrack(size_t index,
         fetchTrackSamples(info, startTimeUs, mode);
     }
 
+    if (mPrefetchEnabled) {
+        startPrefetching(info);
+    }
+
     return OK;
 }
 
@@ -461,6 +630,7 @@ status_t NuMediaExtractor::unselectTrack(size_t index) {
 
     TrackInfo *info = &mSelectedTracks.editItemAt(i);
 
+    stopPrefetching(info);
     releaseTrackSamples(info);
 
     CHECK_EQ((status_t)OK, info->mSource->stop());
@@ -543,30 +713,48 @@ void NuMediaExtractor::fetchTrackSamples(TrackInfo *info,
     MediaSource::ReadOptions options;
     if (seekTimeUs >= 0LL) {
         options.setSeekTo(seekTimeUs, mode);
+        // The samples read ahead are discarded along with the others, and the
+        // reads after the seek are prefetched again.
+        stopPrefetching(info);
         info->mFinalResult = OK;
         releaseTrackSamples(info);
     } else if (info->mFinalResult != OK || !info->mSamples.empty()) {
         return;
+    } else if (info->mPrefetcher != nullptr) {
+        info->mFinalResult = info->mPrefetcher->takeSamples(
+                &info->mSamples, info->mMaxFetchCount);
+        return;
+    }
+
+    status_t err = readSamples(
+            info->mSource, info->mMaxFetchCount, &options, false /* copy */, &info->mSamples);
+    info->mFinalResult = err;
+    if (err != OK && err != ERROR_END_OF_STREAM) {
+        ALOGW("read on track %zu failed with error %d", info->mTrackIndex, err);
     }
 
+    if (seekTimeUs >= 0LL && mPrefetchEnabled) {
+        startPrefetching(info);
+    }
+}
+
+// static
+status_t NuMediaExtractor::readSamples(
+        const sp<IMediaSource> &source, size_t maxCount,
+        MediaSource::ReadOptions *options, bool copy, std::list<Sample> *samples) {
     status_t err = OK;
     Vector<MediaBufferBase *> mediaBuffers;
-    if (info->mSource->supportReadMultiple()) {
-        options.setNonBlocking();
-        err = info->mSource->readMultiple(&mediaBuffers, info->mMaxFetchCount, &options);
+    if (source->supportReadMultiple()) {
+        options->setNonBlocking();
+        err = source->readMultiple(&mediaBuffers, maxCount, options);
     } else {
         MediaBufferBase *mbuf = NULL;
-        err = info->mSource->read(&mbuf, &options);
+        err = source->read(&mbuf, options);
         if (err == OK && mbuf != NULL) {
             mediaBuffers.push_back(mbuf);
         }
     }
 
-    info->mFinalResult = err;
-    if (err != OK && err != ERROR_END_OF_STREAM) {
-        ALOGW("read on track %zu failed with error %d", info->mTrackIndex, err);
-    }
-
     size_t count = mediaBuffers.size();
     bool releaseRemaining = false;
     for (size_t id = 0; id < count; ++id) {
@@ -579,15 +767,64 @@ void NuMediaExtractor::fetchTrackSamples(TrackInfo *info,
             mbuf->release();
             continue;
         }
-        if (mbuf->meta_data().findInt64(kKeyTime, &timeUs)) {
-            info->mSamples.emplace_back(mbuf, timeUs);
-        } else {
+        if (!mbuf->meta_data().findInt64(kKeyTime, &timeUs)) {
             mbuf->meta_data().dumpToLog();
-            info->mFinalResult = ERROR_MALFORMED;
+            err = ERROR_MALFORMED;
             mbuf->release();
             releaseRemaining = true;
+            continue;
+        }
+        if (copy) {
+            const size_t length = mbuf->range_length();
+            MediaBuffer *copied = new MediaBuffer(length);
+            if (length > 0 && copied->data() == NULL) {
+                copied->release();
+                err = NO_MEMORY;
+                mbuf->release();
+                releaseRemaining = true;
+                continue;
+            }
+            memcpy(copied->data(), (const uint8_t *)mbuf->data() + mbuf->range_offset(), length);
+            copied->meta_data() = mbuf->meta_data();
+            mbuf->release();
+            mbuf = copied;
         }
+        samples->emplace_back(mbuf, timeUs);
     }
+    return err;
+}
+
+void NuMediaExtractor::startPrefetching(TrackInfo *info) {
+    if (info->mPrefetcher == nullptr && info->mFinalResult == OK) {
+        info->mPrefetcher = std::make_shared<TrackPrefetcher>(
+                info->mSource, info->mTrackIndex, info->mMaxFetchCount);
+    }
+}
+
+void NuMediaExtractor::stopPrefetching(TrackInfo *info) {
+    if (info->mPrefetcher != nullptr) {
+        status_t err = info->mPrefetcher->stop(&info->mSamples);
+        if (info->mFinalResult == OK) {
+            info->mFinalResult = err;
+        }
+        info->mPrefetcher.reset();
+    }
+}
+
+status_t NuMediaExtractor::setPrefetchEnabled(bool enabled) {
+    Mutex::Autolock autoLock(mLock);
+
+    mPrefetchEnabled = enabled;
+    for (size_t i = 0; i < mSelectedTracks.size(); ++i) {
+        TrackInfo *info = &mSelectedTracks.editItemAt(i);
+        if (enabled) {
+            startPrefetching(info);
+        } else {
+            // The samples read ahead are kept, the next ones are read on demand.
+            stopPrefetching(info);
+        }
+    }
+    return OK;
 }
 
 status_t NuMediaExtractor::seekTo(
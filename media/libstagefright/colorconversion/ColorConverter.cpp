@@ -26,25 +26,18 @@
 #include <media/stagefright/MediaCodecConstants.h>
 #include <media/stagefright/MediaErrors.h>
 
+#include "ColorConverterKernels.h"
+
 #include "libyuv/convert_from.h"
 #include "libyuv/convert_argb.h"
 #include "libyuv/planar_functions.h"
 #include "libyuv/video_common.h"
 #include <functional>
 #include <sys/time.h>
+#include <vector>
 
 #define PERF_PROFILING 0
 
-#if defined(__aarch64__) || defined(__ARM_NEON__)
-#define USE_NEON_Y410 1
-#else
-#define USE_NEON_Y410 0
-#endif
-
-#if USE_NEON_Y410
-#include <arm_neon.h>
-#endif
-
 namespace android {
 typedef const struct libyuv::YuvConstants LibyuvConstants;
 
@@ -452,8 +445,25 @@ const struct ColorConverter::Coeffs BT2020_LTD_10BIT = { 299, 431,  48, 167, 550
 constexpr int CLIP_RANGE_MIN_8BIT = -294;
 constexpr int CLIP_RANGE_MAX_8BIT = 552;
 
-constexpr int CLIP_RANGE_MIN_10BIT = -1175;
-constexpr int CLIP_RANGE_MAX_10BIT = 2218;
+YuvToRgbCoeffs getKernelCoeffs(const ColorConverter::Coeffs *matrix, int32_t c16) {
+    return { matrix->_y, matrix->_r_v, matrix->_g_u, matrix->_g_v, matrix->_b_u, c16 };
+}
+
+bool getRgbLayout(OMX_COLOR_FORMATTYPE format, RgbLayout *layout) {
+    switch ((int32_t)format) {
+        case OMX_COLOR_Format16bitRGB565:
+            *layout = kRgbLayout565;
+            return true;
+        case OMX_COLOR_Format32BitRGBA8888:
+            *layout = kRgbLayoutRGBA8888;
+            return true;
+        case OMX_COLOR_Format32bitBGRA8888:
+            *layout = kRgbLayoutBGRA8888;
+            return true;
+        default:
+            return false;
+    }
+}
 
 }
 
@@ -462,15 +472,12 @@ ColorConverter::ColorConverter(
     : mSrcFormat(from),
       mDstFormat(to),
       mSrcColorSpace({0, 0, 0}),
-      mClip(NULL),
-      mClip10Bit(NULL) {
+      mClip(NULL) {
 }
 
 ColorConverter::~ColorConverter() {
     delete[] mClip;
     mClip = NULL;
-    delete[] mClip10Bit;
-    mClip10Bit = NULL;
 }
 
 // Set MediaImage2 Flexible formats
@@ -776,14 +783,9 @@ status_t ColorConverter::convertCbYCrY(
         return ERROR_UNSUPPORTED;
     }
 
-    signed _b_u = matrix->_b_u;
-    signed _neg_g_u = -matrix->_g_u;
-    signed _neg_g_v = -matrix->_g_v;
-    signed _r_v = matrix->_r_v;
-    signed _y = matrix->_y;
-    signed _c16 = mSrcColorSpace.mRange == ColorUtils::kColorRangeLimited ? 16 : 0;
-
-    uint8_t *kAdjustedClip = initClip();
+    const YuvToRgbCoeffs coeffs = getKernelCoeffs(matrix,
+            mSrcColorSpace.mRange == ColorUtils::kColorRangeLimited ? 16 : 0);
+    const ColorConverterKernels &kernels = getColorConverterKernels();
 
     uint16_t *dst_ptr = (uint16_t *)dst.mBits
         + dst.mCropTop * dst.mWidth + dst.mCropLeft;
@@ -791,44 +793,22 @@ status_t ColorConverter::convertCbYCrY(
     const uint8_t *src_ptr = (const uint8_t *)src.mBits
         + (src.mCropTop * src.mWidth + src.mCropLeft) * 2;
 
-    for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth() - 1; x += 2) {
-            signed y1 = (signed)src_ptr[2 * x + 1] - _c16;
-            signed y2 = (signed)src_ptr[2 * x + 3] - _c16;
-            signed u = (signed)src_ptr[2 * x] - 128;
-            signed v = (signed)src_ptr[2 * x + 2] - 128;
-
-            signed u_b = u * _b_u;
-            signed u_g = u * _neg_g_u;
-            signed v_g = v * _neg_g_v;
-            signed v_r = v * _r_v;
-
-            signed tmp1 = y1 * _y + 128;
-            signed b1 = (tmp1 + u_b) / 256;
-            signed g1 = (tmp1 + v_g + u_g) / 256;
-            signed r1 = (tmp1 + v_r) / 256;
-
-            signed tmp2 = y2 * _y + 128;
-            signed b2 = (tmp2 + u_b) / 256;
-            signed g2 = (tmp2 + v_g + u_g) / 256;
-            signed r2 = (tmp2 + v_r) / 256;
+    // only whole pixel pairs are converted
+    const size_t width = src.cropWidth() & ~1;
+    std::vector<uint8_t> rowY(width);
+    std::vector<uint8_t> rowU(width / 2);
+    std::vector<uint8_t> rowV(width / 2);
 
-            uint32_t rgb1 =
-                ((kAdjustedClip[r1] >> 3) << 11)
-                | ((kAdjustedClip[g1] >> 2) << 5)
-                | (kAdjustedClip[b1] >> 3);
-
-            uint32_t rgb2 =
-                ((kAdjustedClip[r2] >> 3) << 11)
-                | ((kAdjustedClip[g2] >> 2) << 5)
-                | (kAdjustedClip[b2] >> 3);
-
-            if (x + 1 < src.cropWidth()) {
-                *(uint32_t *)(&dst_ptr[x]) = (rgb2 << 16) | rgb1;
-            } else {
-                dst_ptr[x] = rgb1;
-            }
+    for (size_t y = 0; y < src.cropHeight(); ++y) {
+        // deinterleave into planes for the row kernel
+        for (size_t x = 0; x < width; x += 2) {
+            rowU[x / 2] = src_ptr[2 * x];
+            rowY[x] = src_ptr[2 * x + 1];
+            rowV[x / 2] = src_ptr[2 * x + 2];
+            rowY[x + 1] = src_ptr[2 * x + 3];
         }
+        kernels.yuv420ToRgb8Row(rowY.data(), rowU.data(), rowV.data(),
+                (uint8_t *)dst_ptr, width, coeffs, kRgbLayout565);
 
         src_ptr += src.mWidth * 2;
         dst_ptr += dst.mWidth;
@@ -1038,52 +1018,6 @@ status_t ColorConverter::convertYUV420SemiPlanarUseLibYUV(
    return OK;
 }
 
-std::function<void (void *, void *, void *, size_t,
-        signed *, signed *, signed *, signed *)>
-getReadFromChromaHorizSubsampled2Image8b(std::optional<MediaImage2> image,
-        OMX_COLOR_FORMATTYPE srcFormat) {
-    // this function is for reading src only
-    // when both chromas are horizontally subsampled by 2
-    // this returns 2 luma for one chroma.
-    if (image) {
-        uint32_t uColInc =
-                image->mPlane[MediaImage2::PlaneIndex::U].mColInc;
-        uint32_t vColInc =
-                image->mPlane[MediaImage2::PlaneIndex::V].mColInc;
-        uint32_t uHorizSubsampling =
-                image->mPlane[MediaImage2::PlaneIndex::U].mHorizSubsampling;
-         uint32_t vHorizSubsampling =
-                image->mPlane[MediaImage2::PlaneIndex::V].mHorizSubsampling;
-
-        if (!(uHorizSubsampling == 2 && vHorizSubsampling == 2)) {
-            return nullptr;
-        }
-
-        if (image->mBitDepthAllocated == 8) {
-
-            return [uColInc, vColInc, uHorizSubsampling, vHorizSubsampling]
-                    (void *src_y, void *src_u, void *src_v, size_t x,
-                    signed *y1, signed *y2, signed *u, signed *v) {
-                *y1 = ((uint8_t *)src_y)[x];
-                *y2 = ((uint8_t *)src_y)[x + 1];
-                *u  = ((uint8_t *)src_u)[(x / uHorizSubsampling) * uColInc] - 128;
-                *v  = ((uint8_t *)src_v)[(x / vHorizSubsampling) * vColInc] - 128;
-            };
-        }
-    }
-    if (srcFormat == OMX_COLOR_FormatYUV420Planar16) {
-        // OMX_COLOR_FormatYUV420Planar16
-        return [](void *src_y, void *src_u, void *src_v, size_t x,
-                signed *y1, signed *y2, signed *u, signed *v) {
-            *y1 = (uint8_t)(((uint16_t*)src_y)[x] >> 2);
-            *y2 = (uint8_t)(((uint16_t*)src_y)[x + 1] >> 2);
-            *u = (uint8_t)(((uint16_t*)src_u)[x / 2] >> 2) - 128;
-            *v = (uint8_t)(((uint16_t*)src_v)[x / 2] >> 2) - 128;
-        };
-    }
-    return nullptr;
-}
-
 std::function<void (void *, void *, void *, size_t,
         signed *, signed *, signed *)>
 getReadFromImage(std::optional<MediaImage2> image, OMX_COLOR_FORMATTYPE &srcFormat) {
@@ -1293,39 +1227,45 @@ status_t ColorConverter::convertYUVMediaImage(
 
         case ImageSamplingYUV420:
         {
-            // get read function that can read
-            // chroma sampling 2 with image
-            auto readFromSrcImage = getReadFromChromaHorizSubsampled2Image8b(
-                    mSrcImage->getMediaImage2(), mSrcFormat);
-            if (readFromSrcImage == nullptr) {
+            const MediaImage2 &image = mSrcImage->getMediaImage2();
+            if (image.mPlane[MediaImage2::PlaneIndex::U].mHorizSubsampling != 2
+                    || image.mPlane[MediaImage2::PlaneIndex::V].mHorizSubsampling != 2) {
                 ALOGE("Cannot get a read function for this MediaImage2");
                 return ERROR_UNSUPPORTED;
             }
-            for (size_t y = 0; y < src.cropHeight(); ++y) {
-                for (size_t x = 0; x < src.cropWidth(); x += 2) {
-                    signed y1, y2, u, v;
-                    readFromSrcImage(src_y, src_u, src_v, x, &y1, &y2, &u, &v);
-
-                    signed u_b = u * _b_u;
-                    signed u_g = u * _neg_g_u;
-                    signed v_g = v * _neg_g_v;
-                    signed v_r = v * _r_v;
-
-                    y1 = y1 - _c16;
-                    signed tmp1 = y1 * _y + 128;
-                    signed b1 = (tmp1 + u_b) / 256;
-                    signed g1 = (tmp1 + v_g + u_g) / 256;
-                    signed r1 = (tmp1 + v_r) / 256;
+            RgbLayout layout;
+            if (!getRgbLayout(mDstFormat, &layout)) {
+                return ERROR_UNSUPPORTED;
+            }
+            const YuvToRgbCoeffs coeffs = getKernelCoeffs(matrix, _c16);
+            const ColorConverterKernels &kernels = getColorConverterKernels();
 
-                    y2 = y2 - _c16;
-                    signed tmp2 = y2 * _y + 128;
-                    signed b2 = (tmp2 + u_b) / 256;
-                    signed g2 = (tmp2 + v_g + u_g) / 256;
-                    signed r2 = (tmp2 + v_r) / 256;
+            // chroma that is not planar (e.g. semi-planar layouts libyuv did not take)
+            // is gathered into a row first
+            const uint32_t uColInc = image.mPlane[MediaImage2::PlaneIndex::U].mColInc;
+            const uint32_t vColInc = image.mPlane[MediaImage2::PlaneIndex::V].mColInc;
+            const size_t chromaWidth = (src.cropWidth() + 1) / 2;
+            std::vector<uint8_t> rowU(uColInc == 1 ? 0 : chromaWidth);
+            std::vector<uint8_t> rowV(vColInc == 1 ? 0 : chromaWidth);
 
-                    bool uncropped = x + 1 < src.cropWidth();
-                    writeToDst(dst_ptr + x * dst.mBpp, uncropped, r1, g1, b1, r2, g2, b2);
+            for (size_t y = 0; y < src.cropHeight(); ++y) {
+                const uint8_t *row_u = src_u;
+                const uint8_t *row_v = src_v;
+                if (uColInc != 1) {
+                    for (size_t x = 0; x < chromaWidth; ++x) {
+                        rowU[x] = src_u[x * uColInc];
+                    }
+                    row_u = rowU.data();
                 }
+                if (vColInc != 1) {
+                    for (size_t x = 0; x < chromaWidth; ++x) {
+                        rowV[x] = src_v[x * vColInc];
+                    }
+                    row_v = rowV.data();
+                }
+                kernels.yuv420ToRgb8Row(src_y, row_u, row_v, dst_ptr, src.cropWidth(),
+                        coeffs, layout);
+
                 src_y += src_stride_y;
                 src_u += (((y + 1) % uVertSubsampling) == 0) ? src_stride_u : 0;
                 src_v += (((y + 1) % vVertSubsampling) == 0) ? src_stride_v : 0;
@@ -1383,17 +1323,13 @@ status_t ColorConverter::convertYUV420Planar16(
         return ERROR_UNSUPPORTED;
     }
 
-    signed _b_u = matrix->_b_u;
-    signed _neg_g_u = -matrix->_g_u;
-    signed _neg_g_v = -matrix->_g_v;
-    signed _r_v = matrix->_r_v;
-    signed _y = matrix->_y;
-    signed _c16 = mSrcColorSpace.mRange == ColorUtils::kColorRangeLimited ? 16 : 0;
-
-    uint8_t *kAdjustedClip = initClip();
-
-    auto readFromSrc = getReadFromChromaHorizSubsampled2Image8b(std::nullopt, mSrcFormat);
-    auto writeToDst = getWriteToDst(mDstFormat, (void *)kAdjustedClip);
+    RgbLayout layout;
+    if (!getRgbLayout(mDstFormat, &layout)) {
+        return ERROR_UNSUPPORTED;
+    }
+    const YuvToRgbCoeffs coeffs = getKernelCoeffs(matrix,
+            mSrcColorSpace.mRange == ColorUtils::kColorRangeLimited ? 16 : 0);
+    const ColorConverterKernels &kernels = getColorConverterKernels();
 
     uint8_t *dst_ptr = (uint8_t *)dst.mBits
             + dst.mCropTop * dst.mStride + dst.mCropLeft * dst.mBpp;
@@ -1406,29 +1342,23 @@ status_t ColorConverter::convertYUV420Planar16(
 
     uint8_t *src_v = src_u + (src.mStride / 2) * (src.mHeight / 2);
 
+    // the samples are reduced to 8 bits and converted with the 8-bit row kernel
+    const size_t width = src.cropWidth();
+    const size_t chromaWidth = (width + 1) / 2;
+    std::vector<uint8_t> rowY(width);
+    std::vector<uint8_t> rowU(chromaWidth);
+    std::vector<uint8_t> rowV(chromaWidth);
+
     for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
-            signed y1, y2, u, v;
-            readFromSrc(src_y, src_u, src_v, x, &y1, &y2, &u, &v);
-
-            signed u_b = u * _b_u;
-            signed u_g = u * _neg_g_u;
-            signed v_g = v * _neg_g_v;
-            signed v_r = v * _r_v;
-
-            signed tmp1 = (y1 - _c16) * _y + 128;
-            signed b1 = (tmp1 + u_b) / 256;
-            signed g1 = (tmp1 + v_g + u_g) / 256;
-            signed r1 = (tmp1 + v_r) / 256;
-
-            signed tmp2 = (y2 - _c16) * _y + 128;
-            signed b2 = (tmp2 + u_b) / 256;
-            signed g2 = (tmp2 + v_g + u_g) / 256;
-            signed r2 = (tmp2 + v_r) / 256;
-
-            bool uncropped = x + 1 < src.cropWidth();
-            writeToDst(dst_ptr + x * dst.mBpp, uncropped, r1, g1, b1, r2, g2, b2);
+        for (size_t x = 0; x < width; ++x) {
+            rowY[x] = (uint8_t)(((uint16_t *)src_y)[x] >> 2);
         }
+        for (size_t x = 0; x < chromaWidth; ++x) {
+            rowU[x] = (uint8_t)(((uint16_t *)src_u)[x] >> 2);
+            rowV[x] = (uint8_t)(((uint16_t *)src_v)[x] >> 2);
+        }
+        kernels.yuv420ToRgb8Row(rowY.data(), rowU.data(), rowV.data(), dst_ptr, width,
+                coeffs, layout);
 
         src_y += src.mStride;
 
@@ -1458,17 +1388,9 @@ status_t ColorConverter::convertYUVP010ToRGBA1010102(
         return ERROR_UNSUPPORTED;
     }
 
-    signed _b_u = matrix->_b_u;
-    signed _neg_g_u = -matrix->_g_u;
-    signed _neg_g_v = -matrix->_g_v;
-    signed _r_v = matrix->_r_v;
-    signed _y = matrix->_y;
-    signed _c16 = mSrcColorSpace.mRange == ColorUtils::kColorRangeLimited ? 64 : 0;
-
-    uint16_t *kAdjustedClip10bit = initClip10Bit();
-
-//    auto readFromSrc = getReadFromSrc(mSrcFormat);
-    auto writeToDst = getWriteToDst(mDstFormat, (void *)kAdjustedClip10bit);
+    const YuvToRgbCoeffs coeffs = getKernelCoeffs(matrix,
+            mSrcColorSpace.mRange == ColorUtils::kColorRangeLimited ? 64 : 0);
+    const ColorConverterKernels &kernels = getColorConverterKernels();
 
     uint8_t *dst_ptr = (uint8_t *)dst.mBits
             + dst.mCropTop * dst.mStride + dst.mCropLeft * dst.mBpp;
@@ -1481,32 +1403,7 @@ status_t ColorConverter::convertYUVP010ToRGBA1010102(
             + (src.mCropTop / 2) * src.mStride + src.mCropLeft * src.mBpp);
 
     for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
-            signed y1, y2, u, v;
-            y1 = (src_y[x] >> 6) - _c16;
-            y2 = (src_y[x + 1] >> 6) - _c16;
-            u = int(src_uv[x] >> 6) - 512;
-            v = int(src_uv[x + 1] >> 6) - 512;
-
-            signed u_b = u * _b_u;
-            signed u_g = u * _neg_g_u;
-            signed v_g = v * _neg_g_v;
-            signed v_r = v * _r_v;
-
-            signed tmp1 = y1 * _y + 128;
-            signed b1 = (tmp1 + u_b) / 256;
-            signed g1 = (tmp1 + v_g + u_g) / 256;
-            signed r1 = (tmp1 + v_r) / 256;
-
-            signed tmp2 = y2 * _y + 128;
-            signed b2 = (tmp2 + u_b) / 256;
-            signed g2 = (tmp2 + v_g + u_g) / 256;
-            signed r2 = (tmp2 + v_r) / 256;
-
-            bool uncropped = x + 1 < src.cropWidth();
-
-            writeToDst(dst_ptr + x * dst.mBpp, uncropped, r1, g1, b1, r2, g2, b2);
-        }
+        kernels.p010ToRgba1010102Row(src_y, src_uv, (uint32_t *)dst_ptr, src.cropWidth(), coeffs);
 
         src_y += src.mStride / 2;
 
@@ -1520,86 +1417,11 @@ status_t ColorConverter::convertYUVP010ToRGBA1010102(
     return OK;
 }
 
-
-#if !USE_NEON_Y410
-
 status_t ColorConverter::convertYUV420Planar16ToY410(
         const BitmapParams &src, const BitmapParams &dst) {
-    uint8_t *dst_ptr = (uint8_t *)dst.mBits
-        + dst.mCropTop * dst.mStride + dst.mCropLeft * dst.mBpp;
-
-    const uint8_t *src_y =
-        (const uint8_t *)src.mBits + src.mCropTop * src.mStride + src.mCropLeft * src.mBpp;
-
-    const uint8_t *src_u =
-        (const uint8_t *)src.mBits + src.mStride * src.mHeight
-        + (src.mCropTop / 2) * (src.mStride / 2) + (src.mCropLeft / 2) * src.mBpp;
-
-    const uint8_t *src_v =
-        src_u + (src.mStride / 2) * (src.mHeight / 2);
-
-    // Converting two lines at a time, slightly faster
-    for (size_t y = 0; y < src.cropHeight(); y += 2) {
-        uint32_t *dst_top = (uint32_t *) dst_ptr;
-        uint32_t *dst_bot = (uint32_t *) (dst_ptr + dst.mStride);
-        uint16_t *ptr_ytop = (uint16_t*) src_y;
-        uint16_t *ptr_ybot = (uint16_t*) (src_y + src.mStride);
-        uint16_t *ptr_u = (uint16_t*) src_u;
-        uint16_t *ptr_v = (uint16_t*) src_v;
-
-        uint32_t u01, v01, y01, y23, y45, y67, uv0, uv1;
-        size_t x = 0;
-        for (; x < src.cropWidth() - 3; x += 4) {
-            u01 = *((uint32_t*)ptr_u); ptr_u += 2;
-            v01 = *((uint32_t*)ptr_v); ptr_v += 2;
-
-            y01 = *((uint32_t*)ptr_ytop); ptr_ytop += 2;
-            y23 = *((uint32_t*)ptr_ytop); ptr_ytop += 2;
-            y45 = *((uint32_t*)ptr_ybot); ptr_ybot += 2;
-            y67 = *((uint32_t*)ptr_ybot); ptr_ybot += 2;
-
-            uv0 = (u01 & 0x3FF) | ((v01 & 0x3FF) << 20);
-            uv1 = (u01 >> 16) | ((v01 >> 16) << 20);
-
-            *dst_top++ = ((y01 & 0x3FF) << 10) | uv0;
-            *dst_top++ = ((y01 >> 16) << 10) | uv0;
-            *dst_top++ = ((y23 & 0x3FF) << 10) | uv1;
-            *dst_top++ = ((y23 >> 16) << 10) | uv1;
-
-            *dst_bot++ = ((y45 & 0x3FF) << 10) | uv0;
-            *dst_bot++ = ((y45 >> 16) << 10) | uv0;
-            *dst_bot++ = ((y67 & 0x3FF) << 10) | uv1;
-            *dst_bot++ = ((y67 >> 16) << 10) | uv1;
-        }
-
-        // There should be at most 2 more pixels to process. Note that we don't
-        // need to consider odd case as the buffer is always aligned to even.
-        if (x < src.cropWidth()) {
-            u01 = *ptr_u;
-            v01 = *ptr_v;
-            y01 = *((uint32_t*)ptr_ytop);
-            y45 = *((uint32_t*)ptr_ybot);
-            uv0 = (u01 & 0x3FF) | ((v01 & 0x3FF) << 20);
-            *dst_top++ = ((y01 & 0x3FF) << 10) | uv0;
-            *dst_top++ = ((y01 >> 16) << 10) | uv0;
-            *dst_bot++ = ((y45 & 0x3FF) << 10) | uv0;
-            *dst_bot++ = ((y45 >> 16) << 10) | uv0;
-        }
+    const ColorConverterKernels &kernels = getColorConverterKernels();
 
-        src_y += src.mStride * 2;
-        src_u += src.mStride / 2;
-        src_v += src.mStride / 2;
-        dst_ptr += dst.mStride * 2;
-    }
-
-    return OK;
-}
-
-#else
-
-status_t ColorConverter::convertYUV420Planar16ToY410(
-        const BitmapParams &src, const BitmapParams &dst) {
-    uint8_t *out = (uint8_t *)dst.mBits
+    uint8_t *dst_ptr = (uint8_t *)dst.mBits
         + dst.mCropTop * dst.mStride + dst.mCropLeft * dst.mBpp;
 
     const uint8_t *src_y =
@@ -1612,114 +1434,21 @@ status_t ColorConverter::convertYUV420Planar16ToY410(
     const uint8_t *src_v =
         src_u + (src.mStride / 2) * (src.mHeight / 2);
 
-    for (size_t y = 0; y < src.cropHeight(); y++) {
-        uint16_t *ptr_y = (uint16_t*) src_y;
-        uint16_t *ptr_u = (uint16_t*) src_u;
-        uint16_t *ptr_v = (uint16_t*) src_v;
-        uint32_t *ptr_out = (uint32_t *) out;
-
-        // Process 16-pixel at a time.
-        uint32_t *ptr_limit = ptr_out + (src.cropWidth() & ~15);
-        while (ptr_out < ptr_limit) {
-            uint16x4_t u0123 = vld1_u16(ptr_u); ptr_u += 4;
-            uint16x4_t u4567 = vld1_u16(ptr_u); ptr_u += 4;
-            uint16x4_t v0123 = vld1_u16(ptr_v); ptr_v += 4;
-            uint16x4_t v4567 = vld1_u16(ptr_v); ptr_v += 4;
-            uint16x4_t y0123 = vld1_u16(ptr_y); ptr_y += 4;
-            uint16x4_t y4567 = vld1_u16(ptr_y); ptr_y += 4;
-            uint16x4_t y89ab = vld1_u16(ptr_y); ptr_y += 4;
-            uint16x4_t ycdef = vld1_u16(ptr_y); ptr_y += 4;
-
-            uint32x2_t uvtempl;
-            uint32x4_t uvtempq;
-
-            uvtempq = vaddw_u16(vshll_n_u16(v0123, 20), u0123);
-
-            uvtempl = vget_low_u32(uvtempq);
-            uint32x4_t uv0011 = vreinterpretq_u32_u64(
-                    vaddw_u32(vshll_n_u32(uvtempl, 32), uvtempl));
-
-            uvtempl = vget_high_u32(uvtempq);
-            uint32x4_t uv2233 = vreinterpretq_u32_u64(
-                    vaddw_u32(vshll_n_u32(uvtempl, 32), uvtempl));
-
-            uvtempq = vaddw_u16(vshll_n_u16(v4567, 20), u4567);
-
-            uvtempl = vget_low_u32(uvtempq);
-            uint32x4_t uv4455 = vreinterpretq_u32_u64(
-                    vaddw_u32(vshll_n_u32(uvtempl, 32), uvtempl));
-
-            uvtempl = vget_high_u32(uvtempq);
-            uint32x4_t uv6677 = vreinterpretq_u32_u64(
-                    vaddw_u32(vshll_n_u32(uvtempl, 32), uvtempl));
-
-            uint32x4_t dsttemp;
-
-            dsttemp = vorrq_u32(uv0011, vshll_n_u16(y0123, 10));
-            vst1q_u32(ptr_out, dsttemp); ptr_out += 4;
-
-            dsttemp = vorrq_u32(uv2233, vshll_n_u16(y4567, 10));
-            vst1q_u32(ptr_out, dsttemp); ptr_out += 4;
-
-            dsttemp = vorrq_u32(uv4455, vshll_n_u16(y89ab, 10));
-            vst1q_u32(ptr_out, dsttemp); ptr_out += 4;
-
-            dsttemp = vorrq_u32(uv6677, vshll_n_u16(ycdef, 10));
-            vst1q_u32(ptr_out, dsttemp); ptr_out += 4;
-        }
+    for (size_t y = 0; y < src.cropHeight(); ++y) {
+        kernels.planar16ToY410Row((const uint16_t *)src_y, (const uint16_t *)src_u,
+                (const uint16_t *)src_v, (uint32_t *)dst_ptr, src.cropWidth());
 
         src_y += src.mStride;
         if (y & 1) {
             src_u += src.mStride / 2;
             src_v += src.mStride / 2;
         }
-        out += dst.mStride;
-    }
-
-    // Process the left-overs out-of-loop, 2-pixel at a time. Note that we don't
-    // need to consider odd case as the buffer is always aligned to even.
-    if (src.cropWidth() & 15) {
-        size_t xstart = (src.cropWidth() & ~15);
-
-        uint8_t *out = (uint8_t *)dst.mBits + dst.mCropTop * dst.mStride
-                + (dst.mCropLeft + xstart) * dst.mBpp;
-
-        const uint8_t *src_y = (const uint8_t *)src.mBits + src.mCropTop * src.mStride
-                + (src.mCropLeft + xstart) * src.mBpp;
-
-        const uint8_t *src_u = (const uint8_t *)src.mBits + src.mStride * src.mHeight
-            + (src.mCropTop / 2) * (src.mStride / 2)
-            + ((src.mCropLeft + xstart) / 2) * src.mBpp;
-
-        const uint8_t *src_v = src_u + (src.mStride / 2) * (src.mHeight / 2);
-
-        for (size_t y = 0; y < src.cropHeight(); y++) {
-            uint16_t *ptr_y = (uint16_t*) src_y;
-            uint16_t *ptr_u = (uint16_t*) src_u;
-            uint16_t *ptr_v = (uint16_t*) src_v;
-            uint32_t *ptr_out = (uint32_t *) out;
-            for (size_t x = xstart; x < src.cropWidth(); x += 2) {
-                uint16_t u = *ptr_u++;
-                uint16_t v = *ptr_v++;
-                uint32_t y01 = *((uint32_t*)ptr_y); ptr_y += 2;
-                uint32_t uv = u | (((uint32_t)v) << 20);
-                *ptr_out++ = ((y01 & 0x3FF) << 10) | uv;
-                *ptr_out++ = ((y01 >> 16) << 10) | uv;
-            }
-            src_y += src.mStride;
-            if (y & 1) {
-                src_u += src.mStride / 2;
-                src_v += src.mStride / 2;
-            }
-            out += dst.mStride;
-        }
+        dst_ptr += dst.mStride;
     }
 
     return OK;
 }
 
-#endif // USE_NEON_Y410
-
 uint8_t *ColorConverter::initClip() {
     if (mClip == NULL) {
         mClip = new uint8_t[CLIP_RANGE_MAX_8BIT - CLIP_RANGE_MIN_8BIT + 1];
@@ -1732,16 +1461,4 @@ uint8_t *ColorConverter::initClip() {
     return &mClip[-CLIP_RANGE_MIN_8BIT];
 }
 
-uint16_t *ColorConverter::initClip10Bit() {
-    if (mClip10Bit == NULL) {
-        mClip10Bit = new uint16_t[CLIP_RANGE_MAX_10BIT - CLIP_RANGE_MIN_10BIT + 1];
-
-        for (signed i = CLIP_RANGE_MIN_10BIT; i <= CLIP_RANGE_MAX_10BIT; ++i) {
-            mClip10Bit[i - CLIP_RANGE_MIN_10BIT] = (i < 0) ? 0 : (i > 1023) ? 1023 : (uint16_t)i;
-        }
-    }
-
-    return &mClip10Bit[-CLIP_RANGE_MIN_10BIT];
-}
-
 }  // namespace android
@@ -0,0 +1,665 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ColorConverterKernels"
+#include <utils/Log.h>
+
+#include "ColorConverterKernels.h"
+
+#include <string.h>
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#define USE_NEON_KERNELS 1
+#else
+#define USE_NEON_KERNELS 0
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
+#define USE_X86_KERNELS 1
+#else
+#define USE_X86_KERNELS 0
+#endif
+
+#if USE_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
+#if USE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace android {
+
+namespace {
+
+/*
+ * The scalar kernels divide by 256 (rounding towards zero) and then clamp,
+ * while the vector kernels shift right by 8 (rounding towards negative
+ * infinity) and then clamp. The two only differ for results in (-1, 0), which
+ * both clamp to 0, so the outputs are identical.
+ */
+inline int32_t clamp(int32_t value, int32_t max) {
+    return value < 0 ? 0 : value > max ? max : value;
+}
+
+inline uint32_t packRgb8(RgbLayout layout, int32_t r, int32_t g, int32_t b) {
+    switch (layout) {
+        case kRgbLayout565:
+            return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+        case kRgbLayoutRGBA8888:
+            return r | (g << 8) | (b << 16) | (0xFFu << 24);
+        case kRgbLayoutBGRA8888:
+        default:
+            return b | (g << 8) | (r << 16) | (0xFFu << 24);
+    }
+}
+
+void yuv420ToRgb8RowC(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        uint8_t *dst, size_t width, const YuvToRgbCoeffs &c, RgbLayout layout) {
+    for (size_t x = 0; x < width; ++x) {
+        signed u = (signed)srcU[x / 2] - 128;
+        signed v = (signed)srcV[x / 2] - 128;
+
+        signed tmp = ((signed)srcY[x] - c._c16) * c._y + 128;
+        signed r = clamp((tmp + v * c._r_v) / 256, 255);
+        signed g = clamp((tmp - u * c._g_u - v * c._g_v) / 256, 255);
+        signed b = clamp((tmp + u * c._b_u) / 256, 255);
+
+        uint32_t rgb = packRgb8(layout, r, g, b);
+        if (layout == kRgbLayout565) {
+            ((uint16_t *)dst)[x] = rgb;
+        } else {
+            ((uint32_t *)dst)[x] = rgb;
+        }
+    }
+}
+
+void p010ToRgba1010102RowC(
+        const uint16_t *srcY, const uint16_t *srcUV,
+        uint32_t *dst, size_t width, const YuvToRgbCoeffs &c) {
+    for (size_t x = 0; x < width; ++x) {
+        signed u = (signed)(srcUV[x & ~1] >> 6) - 512;
+        signed v = (signed)(srcUV[x | 1] >> 6) - 512;
+
+        signed tmp = ((signed)(srcY[x] >> 6) - c._c16) * c._y + 128;
+        uint32_t r = clamp((tmp + v * c._r_v) / 256, 1023);
+        uint32_t g = clamp((tmp - u * c._g_u - v * c._g_v) / 256, 1023);
+        uint32_t b = clamp((tmp + u * c._b_u) / 256, 1023);
+
+        dst[x] = r | (g << 10) | (b << 20) | (3u << 30);
+    }
+}
+
+void planar16ToY410RowC(
+        const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV,
+        uint32_t *dst, size_t width) {
+    for (size_t x = 0; x < width; ++x) {
+        dst[x] = (srcU[x / 2] & 0x3FF)
+                | ((uint32_t)(srcY[x] & 0x3FF) << 10)
+                | ((uint32_t)(srcV[x / 2] & 0x3FF) << 20);
+    }
+}
+
+const ColorConverterKernels kScalarKernels = {
+    "scalar",
+    yuv420ToRgb8RowC,
+    p010ToRgba1010102RowC,
+    planar16ToY410RowC,
+};
+
+#if USE_NEON_KERNELS
+
+// Converts 8 pixels of centered luma and (already upsampled) chroma.
+inline void yuvToRgbNeon(
+        int16x8_t y, int16x8_t u, int16x8_t v, const YuvToRgbCoeffs &c,
+        uint16x8_t *r, uint16x8_t *g, uint16x8_t *b) {
+    const int32x4_t k128 = vdupq_n_s32(128);
+    int32x4_t tmpLo = vmlal_n_s16(k128, vget_low_s16(y), c._y);
+    int32x4_t tmpHi = vmlal_n_s16(k128, vget_high_s16(y), c._y);
+
+    int32x4_t rLo = vmlal_n_s16(tmpLo, vget_low_s16(v), c._r_v);
+    int32x4_t rHi = vmlal_n_s16(tmpHi, vget_high_s16(v), c._r_v);
+    int32x4_t gLo = vmlsl_n_s16(vmlsl_n_s16(tmpLo, vget_low_s16(u), c._g_u),
+            vget_low_s16(v), c._g_v);
+    int32x4_t gHi = vmlsl_n_s16(vmlsl_n_s16(tmpHi, vget_high_s16(u), c._g_u),
+            vget_high_s16(v), c._g_v);
+    int32x4_t bLo = vmlal_n_s16(tmpLo, vget_low_s16(u), c._b_u);
+    int32x4_t bHi = vmlal_n_s16(tmpHi, vget_high_s16(u), c._b_u);
+
+    // saturating narrow clamps negative values to 0
+    *r = vcombine_u16(vqmovun_s32(vshrq_n_s32(rLo, 8)), vqmovun_s32(vshrq_n_s32(rHi, 8)));
+    *g = vcombine_u16(vqmovun_s32(vshrq_n_s32(gLo, 8)), vqmovun_s32(vshrq_n_s32(gHi, 8)));
+    *b = vcombine_u16(vqmovun_s32(vshrq_n_s32(bLo, 8)), vqmovun_s32(vshrq_n_s32(bHi, 8)));
+}
+
+void yuv420ToRgb8RowNeon(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        uint8_t *dst, size_t width, const YuvToRgbCoeffs &c, RgbLayout layout) {
+    const int16x8_t c16 = vdupq_n_s16(c._c16);
+    const int16x8_t c128 = vdupq_n_s16(128);
+    const uint8x8_t alpha = vdup_n_u8(0xFF);
+
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint32_t u4, v4;
+        memcpy(&u4, srcU + x / 2, sizeof(u4));
+        memcpy(&v4, srcV + x / 2, sizeof(v4));
+        uint8x8_t u8 = vreinterpret_u8_u32(vdup_n_u32(u4));
+        uint8x8_t v8 = vreinterpret_u8_u32(vdup_n_u32(v4));
+
+        int16x8_t y = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(srcY + x))), c16);
+        int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vzip_u8(u8, u8).val[0])), c128);
+        int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vzip_u8(v8, v8).val[0])), c128);
+
+        uint16x8_t r16, g16, b16;
+        yuvToRgbNeon(y, u, v, c, &r16, &g16, &b16);
+        uint8x8_t r = vqmovn_u16(r16);
+        uint8x8_t g = vqmovn_u16(g16);
+        uint8x8_t b = vqmovn_u16(b16);
+
+        switch (layout) {
+            case kRgbLayout565:
+            {
+                uint16x8_t rgb = vorrq_u16(
+                        vorrq_u16(vshlq_n_u16(vshrq_n_u16(vmovl_u8(r), 3), 11),
+                                  vshlq_n_u16(vshrq_n_u16(vmovl_u8(g), 2), 5)),
+                        vshrq_n_u16(vmovl_u8(b), 3));
+                vst1q_u16((uint16_t *)dst + x, rgb);
+                break;
+            }
+            case kRgbLayoutRGBA8888:
+            {
+                uint8x8x4_t rgba = {{ r, g, b, alpha }};
+                vst4_u8(dst + x * 4, rgba);
+                break;
+            }
+            case kRgbLayoutBGRA8888:
+            {
+                uint8x8x4_t bgra = {{ b, g, r, alpha }};
+                vst4_u8(dst + x * 4, bgra);
+                break;
+            }
+        }
+    }
+
+    if (x < width) {
+        size_t bpp = layout == kRgbLayout565 ? 2 : 4;
+        yuv420ToRgb8RowC(srcY + x, srcU + x / 2, srcV + x / 2,
+                dst + x * bpp, width - x, c, layout);
+    }
+}
+
+void p010ToRgba1010102RowNeon(
+        const uint16_t *srcY, const uint16_t *srcUV,
+        uint32_t *dst, size_t width, const YuvToRgbCoeffs &c) {
+    const int16x8_t c16 = vdupq_n_s16(c._c16);
+    const int16x4_t c512 = vdup_n_s16(512);
+    const uint16x8_t max10 = vdupq_n_u16(1023);
+    const uint32x4_t alpha = vdupq_n_u32(3u << 30);
+
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        int16x8_t y = vsubq_s16(
+                vreinterpretq_s16_u16(vshrq_n_u16(vld1q_u16(srcY + x), 6)), c16);
+
+        uint16x4x2_t uv = vld2_u16(srcUV + x);
+        int16x4_t u4 = vsub_s16(vreinterpret_s16_u16(vshr_n_u16(uv.val[0], 6)), c512);
+        int16x4_t v4 = vsub_s16(vreinterpret_s16_u16(vshr_n_u16(uv.val[1], 6)), c512);
+        int16x4x2_t uu = vzip_s16(u4, u4);
+        int16x4x2_t vv = vzip_s16(v4, v4);
+
+        uint16x8_t r, g, b;
+        yuvToRgbNeon(y, vcombine_s16(uu.val[0], uu.val[1]),
+                vcombine_s16(vv.val[0], vv.val[1]), c, &r, &g, &b);
+        r = vminq_u16(r, max10);
+        g = vminq_u16(g, max10);
+        b = vminq_u16(b, max10);
+
+        uint32x4_t lo = vorrq_u32(
+                vorrq_u32(vmovl_u16(vget_low_u16(r)), vshll_n_u16(vget_low_u16(g), 10)),
+                vorrq_u32(vshlq_n_u32(vmovl_u16(vget_low_u16(b)), 20), alpha));
+        uint32x4_t hi = vorrq_u32(
+                vorrq_u32(vmovl_u16(vget_high_u16(r)), vshll_n_u16(vget_high_u16(g), 10)),
+                vorrq_u32(vshlq_n_u32(vmovl_u16(vget_high_u16(b)), 20), alpha));
+        vst1q_u32(dst + x, lo);
+        vst1q_u32(dst + x + 4, hi);
+    }
+
+    if (x < width) {
+        p010ToRgba1010102RowC(srcY + x, srcUV + x, dst + x, width - x, c);
+    }
+}
+
+void planar16ToY410RowNeon(
+        const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV,
+        uint32_t *dst, size_t width) {
+    const uint16x8_t mask = vdupq_n_u16(0x3FF);
+
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint16x8_t y = vandq_u16(vld1q_u16(srcY + x), mask);
+        uint16x4_t u = vand_u16(vld1_u16(srcU + x / 2), vget_low_u16(mask));
+        uint16x4_t v = vand_u16(vld1_u16(srcV + x / 2), vget_low_u16(mask));
+
+        uint32x4_t uv = vorrq_u32(vmovl_u16(u), vshlq_n_u32(vmovl_u16(v), 20));
+        uint32x4x2_t uvuv = vzipq_u32(uv, uv);
+
+        vst1q_u32(dst + x, vorrq_u32(uvuv.val[0], vshll_n_u16(vget_low_u16(y), 10)));
+        vst1q_u32(dst + x + 4, vorrq_u32(uvuv.val[1], vshll_n_u16(vget_high_u16(y), 10)));
+    }
+
+    if (x < width) {
+        planar16ToY410RowC(srcY + x, srcU + x / 2, srcV + x / 2, dst + x, width - x);
+    }
+}
+
+const ColorConverterKernels kNeonKernels = {
+    "neon",
+    yuv420ToRgb8RowNeon,
+    p010ToRgba1010102RowNeon,
+    planar16ToY410RowNeon,
+};
+
+#endif  // USE_NEON_KERNELS
+
+#if USE_X86_KERNELS
+
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+struct CoeffsSse41 {
+    __m128i y, r_v, g_u, g_v, b_u, c16, k128;
+
+    TARGET_SSE41 explicit CoeffsSse41(const YuvToRgbCoeffs &c)
+        : y(_mm_set1_epi32(c._y)),
+          r_v(_mm_set1_epi32(c._r_v)),
+          g_u(_mm_set1_epi32(c._g_u)),
+          g_v(_mm_set1_epi32(c._g_v)),
+          b_u(_mm_set1_epi32(c._b_u)),
+          c16(_mm_set1_epi32(c._c16)),
+          k128(_mm_set1_epi32(128)) {
+    }
+};
+
+// Converts 4 pixels of centered luma and (already upsampled) chroma, clamped to [0, max].
+TARGET_SSE41 inline void yuvToRgbSse41(
+        __m128i y, __m128i u, __m128i v, const CoeffsSse41 &c, __m128i max,
+        __m128i *r, __m128i *g, __m128i *b) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i tmp = _mm_add_epi32(_mm_mullo_epi32(y, c.y), c.k128);
+    __m128i rr = _mm_add_epi32(tmp, _mm_mullo_epi32(v, c.r_v));
+    __m128i gg = _mm_sub_epi32(_mm_sub_epi32(tmp, _mm_mullo_epi32(u, c.g_u)),
+            _mm_mullo_epi32(v, c.g_v));
+    __m128i bb = _mm_add_epi32(tmp, _mm_mullo_epi32(u, c.b_u));
+    *r = _mm_min_epi32(_mm_max_epi32(_mm_srai_epi32(rr, 8), zero), max);
+    *g = _mm_min_epi32(_mm_max_epi32(_mm_srai_epi32(gg, 8), zero), max);
+    *b = _mm_min_epi32(_mm_max_epi32(_mm_srai_epi32(bb, 8), zero), max);
+}
+
+TARGET_SSE41 inline __m128i packRgb8Sse41(RgbLayout layout, __m128i r, __m128i g, __m128i b) {
+    switch (layout) {
+        case kRgbLayout565:
+            return _mm_or_si128(
+                    _mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(r, 3), 11),
+                                 _mm_slli_epi32(_mm_srli_epi32(g, 2), 5)),
+                    _mm_srli_epi32(b, 3));
+        case kRgbLayoutRGBA8888:
+            return _mm_or_si128(
+                    _mm_or_si128(r, _mm_slli_epi32(g, 8)),
+                    _mm_or_si128(_mm_slli_epi32(b, 16), _mm_set1_epi32(0xFF000000)));
+        case kRgbLayoutBGRA8888:
+        default:
+            return _mm_or_si128(
+                    _mm_or_si128(b, _mm_slli_epi32(g, 8)),
+                    _mm_or_si128(_mm_slli_epi32(r, 16), _mm_set1_epi32(0xFF000000)));
+    }
+}
+
+TARGET_SSE41 void yuv420ToRgb8RowSse41(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        uint8_t *dst, size_t width, const YuvToRgbCoeffs &coeffs, RgbLayout layout) {
+    const CoeffsSse41 c(coeffs);
+    const __m128i max = _mm_set1_epi32(255);
+
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        int32_t u4, v4;
+        memcpy(&u4, srcU + x / 2, sizeof(u4));
+        memcpy(&v4, srcV + x / 2, sizeof(v4));
+        __m128i u = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(u4)), c.k128);
+        __m128i v = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v4)), c.k128);
+
+        __m128i y8 = _mm_loadl_epi64((const __m128i *)(srcY + x));
+        __m128i y0 = _mm_sub_epi32(_mm_cvtepu8_epi32(y8), c.c16);
+        __m128i y1 = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_srli_si128(y8, 4)), c.c16);
+
+        __m128i r0, g0, b0, r1, g1, b1;
+        yuvToRgbSse41(y0, _mm_unpacklo_epi32(u, u), _mm_unpacklo_epi32(v, v), c, max,
+                &r0, &g0, &b0);
+        yuvToRgbSse41(y1, _mm_unpackhi_epi32(u, u), _mm_unpackhi_epi32(v, v), c, max,
+                &r1, &g1, &b1);
+
+        __m128i rgb0 = packRgb8Sse41(layout, r0, g0, b0);
+        __m128i rgb1 = packRgb8Sse41(layout, r1, g1, b1);
+        if (layout == kRgbLayout565) {
+            _mm_storeu_si128((__m128i *)(dst + x * 2), _mm_packus_epi32(rgb0, rgb1));
+        } else {
+            _mm_storeu_si128((__m128i *)(dst + x * 4), rgb0);
+            _mm_storeu_si128((__m128i *)(dst + x * 4 + 16), rgb1);
+        }
+    }
+
+    if (x < width) {
+        size_t bpp = layout == kRgbLayout565 ? 2 : 4;
+        yuv420ToRgb8RowC(srcY + x, srcU + x / 2, srcV + x / 2,
+                dst + x * bpp, width - x, coeffs, layout);
+    }
+}
+
+TARGET_SSE41 inline __m128i packRgba1010102Sse41(__m128i r, __m128i g, __m128i b) {
+    return _mm_or_si128(
+            _mm_or_si128(r, _mm_slli_epi32(g, 10)),
+            _mm_or_si128(_mm_slli_epi32(b, 20), _mm_set1_epi32(0xC0000000)));
+}
+
+TARGET_SSE41 void p010ToRgba1010102RowSse41(
+        const uint16_t *srcY, const uint16_t *srcUV,
+        uint32_t *dst, size_t width, const YuvToRgbCoeffs &coeffs) {
+    const CoeffsSse41 c(coeffs);
+    const __m128i max = _mm_set1_epi32(1023);
+    const __m128i c512 = _mm_set1_epi32(512);
+
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i y16 = _mm_loadu_si128((const __m128i *)(srcY + x));
+        __m128i y0 = _mm_sub_epi32(_mm_srli_epi32(_mm_cvtepu16_epi32(y16), 6), c.c16);
+        __m128i y1 = _mm_sub_epi32(
+                _mm_srli_epi32(_mm_cvtepu16_epi32(_mm_srli_si128(y16, 8)), 6), c.c16);
+
+        // u0 v0 u1 v1 | u2 v2 u3 v3
+        __m128i uv16 = _mm_loadu_si128((const __m128i *)(srcUV + x));
+        __m128i uv0 = _mm_sub_epi32(_mm_srli_epi32(_mm_cvtepu16_epi32(uv16), 6), c512);
+        __m128i uv1 = _mm_sub_epi32(
+                _mm_srli_epi32(_mm_cvtepu16_epi32(_mm_srli_si128(uv16, 8)), 6), c512);
+
+        __m128i r, g, b;
+        yuvToRgbSse41(y0, _mm_shuffle_epi32(uv0, _MM_SHUFFLE(2, 2, 0, 0)),
+                _mm_shuffle_epi32(uv0, _MM_SHUFFLE(3, 3, 1, 1)), c, max, &r, &g, &b);
+        _mm_storeu_si128((__m128i *)(dst + x), packRgba1010102Sse41(r, g, b));
+
+        yuvToRgbSse41(y1, _mm_shuffle_epi32(uv1, _MM_SHUFFLE(2, 2, 0, 0)),
+                _mm_shuffle_epi32(uv1, _MM_SHUFFLE(3, 3, 1, 1)), c, max, &r, &g, &b);
+        _mm_storeu_si128((__m128i *)(dst + x + 4), packRgba1010102Sse41(r, g, b));
+    }
+
+    if (x < width) {
+        p010ToRgba1010102RowC(srcY + x, srcUV + x, dst + x, width - x, coeffs);
+    }
+}
+
+TARGET_SSE41 void planar16ToY410RowSse41(
+        const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV,
+        uint32_t *dst, size_t width) {
+    const __m128i mask = _mm_set1_epi16(0x3FF);
+
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i y = _mm_and_si128(_mm_loadu_si128((const __m128i *)(srcY + x)), mask);
+        __m128i u = _mm_and_si128(_mm_loadl_epi64((const __m128i *)(srcU + x / 2)), mask);
+        __m128i v = _mm_and_si128(_mm_loadl_epi64((const __m128i *)(srcV + x / 2)), mask);
+
+        __m128i uv = _mm_or_si128(_mm_cvtepu16_epi32(u),
+                _mm_slli_epi32(_mm_cvtepu16_epi32(v), 20));
+        __m128i y0 = _mm_slli_epi32(_mm_cvtepu16_epi32(y), 10);
+        __m128i y1 = _mm_slli_epi32(_mm_cvtepu16_epi32(_mm_srli_si128(y, 8)), 10);
+
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_or_si128(y0, _mm_unpacklo_epi32(uv, uv)));
+        _mm_storeu_si128((__m128i *)(dst + x + 4), _mm_or_si128(y1, _mm_unpackhi_epi32(uv, uv)));
+    }
+
+    if (x < width) {
+        planar16ToY410RowC(srcY + x, srcU + x / 2, srcV + x / 2, dst + x, width - x);
+    }
+}
+
+const ColorConverterKernels kSse41Kernels = {
+    "sse4.1",
+    yuv420ToRgb8RowSse41,
+    p010ToRgba1010102RowSse41,
+    planar16ToY410RowSse41,
+};
+
+struct CoeffsAvx2 {
+    __m256i y, r_v, g_u, g_v, b_u, c16, k128;
+
+    TARGET_AVX2 explicit CoeffsAvx2(const YuvToRgbCoeffs &c)
+        : y(_mm256_set1_epi32(c._y)),
+          r_v(_mm256_set1_epi32(c._r_v)),
+          g_u(_mm256_set1_epi32(c._g_u)),
+          g_v(_mm256_set1_epi32(c._g_v)),
+          b_u(_mm256_set1_epi32(c._b_u)),
+          c16(_mm256_set1_epi32(c._c16)),
+          k128(_mm256_set1_epi32(128)) {
+    }
+};
+
+// Converts 8 pixels of centered luma and (already upsampled) chroma, clamped to [0, max].
+TARGET_AVX2 inline void yuvToRgbAvx2(
+        __m256i y, __m256i u, __m256i v, const CoeffsAvx2 &c, __m256i max,
+        __m256i *r, __m256i *g, __m256i *b) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i tmp = _mm256_add_epi32(_mm256_mullo_epi32(y, c.y), c.k128);
+    __m256i rr = _mm256_add_epi32(tmp, _mm256_mullo_epi32(v, c.r_v));
+    __m256i gg = _mm256_sub_epi32(_mm256_sub_epi32(tmp, _mm256_mullo_epi32(u, c.g_u)),
+            _mm256_mullo_epi32(v, c.g_v));
+    __m256i bb = _mm256_add_epi32(tmp, _mm256_mullo_epi32(u, c.b_u));
+    *r = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(rr, 8), zero), max);
+    *g = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(gg, 8), zero), max);
+    *b = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(bb, 8), zero), max);
+}
+
+TARGET_AVX2 inline __m256i packRgb8Avx2(RgbLayout layout, __m256i r, __m256i g, __m256i b) {
+    switch (layout) {
+        case kRgbLayout565:
+            return _mm256_or_si256(
+                    _mm256_or_si256(_mm256_slli_epi32(_mm256_srli_epi32(r, 3), 11),
+                                    _mm256_slli_epi32(_mm256_srli_epi32(g, 2), 5)),
+                    _mm256_srli_epi32(b, 3));
+        case kRgbLayoutRGBA8888:
+            return _mm256_or_si256(
+                    _mm256_or_si256(r, _mm256_slli_epi32(g, 8)),
+                    _mm256_or_si256(_mm256_slli_epi32(b, 16), _mm256_set1_epi32(0xFF000000)));
+        case kRgbLayoutBGRA8888:
+        default:
+            return _mm256_or_si256(
+                    _mm256_or_si256(b, _mm256_slli_epi32(g, 8)),
+                    _mm256_or_si256(_mm256_slli_epi32(r, 16), _mm256_set1_epi32(0xFF000000)));
+    }
+}
+
+TARGET_AVX2 void yuv420ToRgb8RowAvx2(
+        const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+        uint8_t *dst, size_t width, const YuvToRgbCoeffs &coeffs, RgbLayout layout) {
+    const CoeffsAvx2 c(coeffs);
+    const __m256i max = _mm256_set1_epi32(255);
+    const __m256i dupLo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    const __m256i dupHi = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i u = _mm256_sub_epi32(_mm256_cvtepu8_epi32(
+                _mm_loadl_epi64((const __m128i *)(srcU + x / 2))), c.k128);
+        __m256i v = _mm256_sub_epi32(_mm256_cvtepu8_epi32(
+                _mm_loadl_epi64((const __m128i *)(srcV + x / 2))), c.k128);
+
+        __m128i y8 = _mm_loadu_si128((const __m128i *)(srcY + x));
+        __m256i y0 = _mm256_sub_epi32(_mm256_cvtepu8_epi32(y8), c.c16);
+        __m256i y1 = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_srli_si128(y8, 8)), c.c16);
+
+        __m256i r0, g0, b0, r1, g1, b1;
+        yuvToRgbAvx2(y0, _mm256_permutevar8x32_epi32(u, dupLo),
+                _mm256_permutevar8x32_epi32(v, dupLo), c, max, &r0, &g0, &b0);
+        yuvToRgbAvx2(y1, _mm256_permutevar8x32_epi32(u, dupHi),
+                _mm256_permutevar8x32_epi32(v, dupHi), c, max, &r1, &g1, &b1);
+
+        __m256i rgb0 = packRgb8Avx2(layout, r0, g0, b0);
+        __m256i rgb1 = packRgb8Avx2(layout, r1, g1, b1);
+        if (layout == kRgbLayout565) {
+            // packus works within 128-bit lanes; restore pixel order afterwards
+            __m256i rgb = _mm256_permute4x64_epi64(
+                    _mm256_packus_epi32(rgb0, rgb1), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256((__m256i *)(dst + x * 2), rgb);
+        } else {
+            _mm256_storeu_si256((__m256i *)(dst + x * 4), rgb0);
+            _mm256_storeu_si256((__m256i *)(dst + x * 4 + 32), rgb1);
+        }
+    }
+
+    if (x < width) {
+        yuv420ToRgb8RowSse41(srcY + x, srcU + x / 2, srcV + x / 2,
+                dst + x * (layout == kRgbLayout565 ? 2 : 4), width - x, coeffs, layout);
+    }
+}
+
+TARGET_AVX2 void p010ToRgba1010102RowAvx2(
+        const uint16_t *srcY, const uint16_t *srcUV,
+        uint32_t *dst, size_t width, const YuvToRgbCoeffs &coeffs) {
+    const CoeffsAvx2 c(coeffs);
+    const __m256i max = _mm256_set1_epi32(1023);
+    const __m256i c512 = _mm256_set1_epi32(512);
+    const __m256i alpha = _mm256_set1_epi32(0xC0000000);
+
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i y = _mm256_sub_epi32(_mm256_srli_epi32(_mm256_cvtepu16_epi32(
+                _mm_loadu_si128((const __m128i *)(srcY + x))), 6), c.c16);
+
+        // u0 v0 u1 v1 | u2 v2 u3 v3
+        __m256i uv = _mm256_sub_epi32(_mm256_srli_epi32(_mm256_cvtepu16_epi32(
+                _mm_loadu_si128((const __m128i *)(srcUV + x))), 6), c512);
+
+        __m256i r, g, b;
+        yuvToRgbAvx2(y, _mm256_shuffle_epi32(uv, _MM_SHUFFLE(2, 2, 0, 0)),
+                _mm256_shuffle_epi32(uv, _MM_SHUFFLE(3, 3, 1, 1)), c, max, &r, &g, &b);
+        __m256i rgba = _mm256_or_si256(
+                _mm256_or_si256(r, _mm256_slli_epi32(g, 10)),
+                _mm256_or_si256(_mm256_slli_epi32(b, 20), alpha));
+        _mm256_storeu_si256((__m256i *)(dst + x), rgba);
+    }
+
+    if (x < width) {
+        p010ToRgba1010102RowC(srcY + x, srcUV + x, dst + x, width - x, coeffs);
+    }
+}
+
+TARGET_AVX2 void planar16ToY410RowAvx2(
+        const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV,
+        uint32_t *dst, size_t width) {
+    const __m256i mask = _mm256_set1_epi32(0x3FF);
+    const __m256i dupLo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    const __m256i dupHi = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i u = _mm256_and_si256(_mm256_cvtepu16_epi32(
+                _mm_loadu_si128((const __m128i *)(srcU + x / 2))), mask);
+        __m256i v = _mm256_and_si256(_mm256_cvtepu16_epi32(
+                _mm_loadu_si128((const __m128i *)(srcV + x / 2))), mask);
+        __m256i uv = _mm256_or_si256(u, _mm256_slli_epi32(v, 20));
+
+        __m256i y0 = _mm256_and_si256(_mm256_cvtepu16_epi32(
+                _mm_loadu_si128((const __m128i *)(srcY + x))), mask);
+        __m256i y1 = _mm256_and_si256(_mm256_cvtepu16_epi32(
+                _mm_loadu_si128((const __m128i *)(srcY + x + 8))), mask);
+
+        _mm256_storeu_si256((__m256i *)(dst + x), _mm256_or_si256(
+                _mm256_slli_epi32(y0, 10), _mm256_permutevar8x32_epi32(uv, dupLo)));
+        _mm256_storeu_si256((__m256i *)(dst + x + 8), _mm256_or_si256(
+                _mm256_slli_epi32(y1, 10), _mm256_permutevar8x32_epi32(uv, dupHi)));
+    }
+
+    if (x < width) {
+        planar16ToY410RowSse41(srcY + x, srcU + x / 2, srcV + x / 2, dst + x, width - x);
+    }
+}
+
+const ColorConverterKernels kAvx2Kernels = {
+    "avx2",
+    yuv420ToRgb8RowAvx2,
+    p010ToRgba1010102RowAvx2,
+    planar16ToY410RowAvx2,
+};
+
+bool cpuSupportsSse41() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1");
+}
+
+bool cpuSupportsAvx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif  // USE_X86_KERNELS
+
+const ColorConverterKernels *selectKernels() {
+#if USE_NEON_KERNELS
+    return &kNeonKernels;
+#elif USE_X86_KERNELS
+    if (cpuSupportsAvx2()) {
+        return &kAvx2Kernels;
+    }
+    if (cpuSupportsSse41()) {
+        return &kSse41Kernels;
+    }
+#endif
+    return &kScalarKernels;
+}
+
+}  // namespace
+
+const ColorConverterKernels &getColorConverterKernels() {
+    static const ColorConverterKernels *sKernels = [] {
+        const ColorConverterKernels *kernels = selectKernels();
+        ALOGV("using %s color conversion kernels", kernels->mName);
+        return kernels;
+    }();
+    return *sKernels;
+}
+
+const ColorConverterKernels &getScalarColorConverterKernels() {
+    return kScalarKernels;
+}
+
+std::vector<const ColorConverterKernels *> getAvailableColorConverterKernels() {
+    std::vector<const ColorConverterKernels *> kernels = { &kScalarKernels };
+#if USE_NEON_KERNELS
+    kernels.push_back(&kNeonKernels);
+#endif
+#if USE_X86_KERNELS
+    if (cpuSupportsSse41()) {
+        kernels.push_back(&kSse41Kernels);
+    }
+    if (cpuSupportsAvx2()) {
+        kernels.push_back(&kAvx2Kernels);
+    }
+#endif
+    return kernels;
+}
+
+}  // namespace android
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COLOR_CONVERTER_KERNELS_H_
+
+#define COLOR_CONVERTER_KERNELS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace android {
+
+/*
+ * Row kernels used by ColorConverter for the paths that libyuv does not cover.
+ *
+ * Every kernel converts a single row of |width| pixels. Chroma is always
+ * horizontally subsampled by 2, so pixel x uses chroma sample x / 2. The math
+ * is the integer math of ColorConverter (see the comment above
+ * ColorConverter::Coeffs); all variants produce bit-exact output with the
+ * scalar variant.
+ */
+struct YuvToRgbCoeffs {
+    int32_t _y;
+    int32_t _r_v;
+    int32_t _g_u;
+    int32_t _g_v;
+    int32_t _b_u;
+    int32_t _c16;     // luma offset (16 or 64 for limited range, 0 for full range)
+};
+
+enum RgbLayout {
+    kRgbLayout565,          // OMX_COLOR_Format16bitRGB565
+    kRgbLayoutRGBA8888,     // OMX_COLOR_Format32BitRGBA8888
+    kRgbLayoutBGRA8888,     // OMX_COLOR_Format32bitBGRA8888
+};
+
+struct ColorConverterKernels {
+    const char *mName;
+
+    // 8-bit planar Y, U and V to 8-bit RGB in |layout|.
+    void (*yuv420ToRgb8Row)(
+            const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
+            uint8_t *dst, size_t width, const YuvToRgbCoeffs &coeffs, RgbLayout layout);
+
+    // P010 (MSB aligned 10-bit) Y and interleaved UV to RGBA_1010102.
+    void (*p010ToRgba1010102Row)(
+            const uint16_t *srcY, const uint16_t *srcUV,
+            uint32_t *dst, size_t width, const YuvToRgbCoeffs &coeffs);
+
+    // LSB aligned 10-bit planar Y, U and V to Y410.
+    void (*planar16ToY410Row)(
+            const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV,
+            uint32_t *dst, size_t width);
+};
+
+// Returns the fastest kernels supported by the running CPU.
+const ColorConverterKernels &getColorConverterKernels();
+
+// Returns the portable reference kernels.
+const ColorConverterKernels &getScalarColorConverterKernels();
+
+// Returns all kernels supported by the running CPU, scalar first. For tests and benchmarks.
+std::vector<const ColorConverterKernels *> getAvailableColorConverterKernels();
+
+}  // namespace android
+
+#endif  // COLOR_CONVERTER_KERNELS_H_
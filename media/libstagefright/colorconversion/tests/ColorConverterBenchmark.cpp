@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "ColorConverterKernels.h"
+
+using namespace android;
+
+namespace {
+
+// One 1080p frame per iteration.
+constexpr size_t kWidth = 1920;
+constexpr size_t kHeight = 1080;
+
+const YuvToRgbCoeffs kBt601Limited = { 298, 409, 100, 208, 516, 16 };
+const YuvToRgbCoeffs kBt2020Ltd10Bit = { 299, 431, 48, 167, 550, 64 };
+
+template <typename T>
+std::vector<T> randomPlane(size_t count, uint32_t mask) {
+    std::mt19937 rng(42);
+    std::vector<T> plane(count);
+    for (T &value : plane) {
+        value = rng() & mask;
+    }
+    return plane;
+}
+
+void BM_Yuv420ToRgb8(benchmark::State &state, const ColorConverterKernels *kernels,
+        RgbLayout layout) {
+    size_t bpp = layout == kRgbLayout565 ? 2 : 4;
+    std::vector<uint8_t> y = randomPlane<uint8_t>(kWidth * kHeight, 0xFF);
+    std::vector<uint8_t> u = randomPlane<uint8_t>(kWidth * kHeight / 4, 0xFF);
+    std::vector<uint8_t> v = randomPlane<uint8_t>(kWidth * kHeight / 4, 0xFF);
+    std::vector<uint8_t> dst(kWidth * kHeight * bpp);
+
+    for (auto _ : state) {
+        for (size_t row = 0; row < kHeight; ++row) {
+            kernels->yuv420ToRgb8Row(
+                    y.data() + row * kWidth,
+                    u.data() + (row / 2) * (kWidth / 2),
+                    v.data() + (row / 2) * (kWidth / 2),
+                    dst.data() + row * kWidth * bpp, kWidth, kBt601Limited, layout);
+        }
+        benchmark::DoNotOptimize(dst.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+}
+
+void BM_P010ToRgba1010102(benchmark::State &state, const ColorConverterKernels *kernels) {
+    std::vector<uint16_t> y = randomPlane<uint16_t>(kWidth * kHeight, 0xFFC0);
+    std::vector<uint16_t> uv = randomPlane<uint16_t>(kWidth * kHeight / 2, 0xFFC0);
+    std::vector<uint32_t> dst(kWidth * kHeight);
+
+    for (auto _ : state) {
+        for (size_t row = 0; row < kHeight; ++row) {
+            kernels->p010ToRgba1010102Row(
+                    y.data() + row * kWidth, uv.data() + (row / 2) * kWidth,
+                    dst.data() + row * kWidth, kWidth, kBt2020Ltd10Bit);
+        }
+        benchmark::DoNotOptimize(dst.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+}
+
+void BM_Planar16ToY410(benchmark::State &state, const ColorConverterKernels *kernels) {
+    std::vector<uint16_t> y = randomPlane<uint16_t>(kWidth * kHeight, 0x3FF);
+    std::vector<uint16_t> u = randomPlane<uint16_t>(kWidth * kHeight / 4, 0x3FF);
+    std::vector<uint16_t> v = randomPlane<uint16_t>(kWidth * kHeight / 4, 0x3FF);
+    std::vector<uint32_t> dst(kWidth * kHeight);
+
+    for (auto _ : state) {
+        for (size_t row = 0; row < kHeight; ++row) {
+            kernels->planar16ToY410Row(
+                    y.data() + row * kWidth,
+                    u.data() + (row / 2) * (kWidth / 2),
+                    v.data() + (row / 2) * (kWidth / 2),
+                    dst.data() + row * kWidth, kWidth);
+        }
+        benchmark::DoNotOptimize(dst.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+}
+
+void registerBenchmarks() {
+    for (const ColorConverterKernels *kernels : getAvailableColorConverterKernels()) {
+        std::string suffix = std::string("/") + kernels->mName;
+        benchmark::RegisterBenchmark(("BM_Yuv420ToRgb565" + suffix).c_str(),
+                BM_Yuv420ToRgb8, kernels, kRgbLayout565);
+        benchmark::RegisterBenchmark(("BM_Yuv420ToRgba8888" + suffix).c_str(),
+                BM_Yuv420ToRgb8, kernels, kRgbLayoutRGBA8888);
+        benchmark::RegisterBenchmark(("BM_P010ToRgba1010102" + suffix).c_str(),
+                BM_P010ToRgba1010102, kernels);
+        benchmark::RegisterBenchmark(("BM_Planar16ToY410" + suffix).c_str(),
+                BM_Planar16ToY410, kernels);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    registerBenchmarks();
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
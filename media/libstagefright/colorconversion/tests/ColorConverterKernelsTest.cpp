@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ColorConverterKernelsTest"
+#include <utils/Log.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ColorConverterKernels.h"
+
+namespace android {
+
+namespace {
+
+// Coefficients from ColorConverter.cpp, with the matching luma offset.
+const YuvToRgbCoeffs kCoeffs8Bit[] = {
+    { 256, 359,  88, 183, 454,  0 },    // BT601_FULL
+    { 298, 409, 100, 208, 516, 16 },    // BT601_LIMITED
+    { 256, 403,  48, 120, 475,  0 },    // BT709_FULL
+    { 298, 430,  48, 167, 548, 16 },    // BT2020_LIMITED
+};
+
+const YuvToRgbCoeffs kCoeffs10Bit[] = {
+    { 256, 377,  42, 146, 482,  0 },    // BT2020_FULL
+    { 299, 431,  48, 167, 550, 64 },    // BT2020_LTD_10BIT
+    { 290, 460,  55, 137, 542, 64 },    // BT709_LTD_10BIT
+};
+
+const size_t kWidths[] = { 1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 65, 130, 1921 };
+
+const RgbLayout kLayouts[] = { kRgbLayout565, kRgbLayoutRGBA8888, kRgbLayoutBGRA8888 };
+
+// Guard bytes after each destination row to catch overruns.
+constexpr size_t kGuard = 64;
+constexpr uint8_t kGuardValue = 0xA5;
+
+template <typename T>
+std::vector<T> randomRow(std::mt19937 &rng, size_t count, uint32_t mask) {
+    std::vector<T> row(count);
+    for (T &value : row) {
+        value = rng() & mask;
+    }
+    return row;
+}
+
+}  // namespace
+
+class ColorConverterKernelsTest
+    : public ::testing::TestWithParam<const ColorConverterKernels *> {
+  protected:
+    ColorConverterKernelsTest()
+        : mKernels(*GetParam()),
+          mScalar(getScalarColorConverterKernels()),
+          mRng(0x5eed) {
+    }
+
+    const ColorConverterKernels &mKernels;
+    const ColorConverterKernels &mScalar;
+    std::mt19937 mRng;
+};
+
+TEST_P(ColorConverterKernelsTest, Yuv420ToRgb8MatchesScalar) {
+    for (const YuvToRgbCoeffs &coeffs : kCoeffs8Bit) {
+        for (RgbLayout layout : kLayouts) {
+            size_t bpp = layout == kRgbLayout565 ? 2 : 4;
+            for (size_t width : kWidths) {
+                std::vector<uint8_t> y = randomRow<uint8_t>(mRng, width, 0xFF);
+                std::vector<uint8_t> u = randomRow<uint8_t>(mRng, (width + 1) / 2, 0xFF);
+                std::vector<uint8_t> v = randomRow<uint8_t>(mRng, (width + 1) / 2, 0xFF);
+                // exercise the clamping at both ends
+                y[0] = 0;
+                y[width - 1] = 255;
+
+                std::vector<uint8_t> expected(width * bpp + kGuard, kGuardValue);
+                std::vector<uint8_t> actual(width * bpp + kGuard, kGuardValue);
+                mScalar.yuv420ToRgb8Row(y.data(), u.data(), v.data(),
+                        expected.data(), width, coeffs, layout);
+                mKernels.yuv420ToRgb8Row(y.data(), u.data(), v.data(),
+                        actual.data(), width, coeffs, layout);
+                ASSERT_EQ(expected, actual) << "width " << width << " layout " << layout;
+            }
+        }
+    }
+}
+
+TEST_P(ColorConverterKernelsTest, P010ToRgba1010102MatchesScalar) {
+    for (const YuvToRgbCoeffs &coeffs : kCoeffs10Bit) {
+        for (size_t width : kWidths) {
+            std::vector<uint16_t> y = randomRow<uint16_t>(mRng, width, 0xFFFF);
+            std::vector<uint16_t> uv = randomRow<uint16_t>(mRng, (width + 1) & ~1, 0xFFFF);
+            y[0] = 0;
+            y[width - 1] = 0xFFC0;
+
+            std::vector<uint32_t> expected(width + kGuard, kGuardValue);
+            std::vector<uint32_t> actual(width + kGuard, kGuardValue);
+            mScalar.p010ToRgba1010102Row(y.data(), uv.data(), expected.data(), width, coeffs);
+            mKernels.p010ToRgba1010102Row(y.data(), uv.data(), actual.data(), width, coeffs);
+            ASSERT_EQ(expected, actual) << "width " << width;
+        }
+    }
+}
+
+TEST_P(ColorConverterKernelsTest, Planar16ToY410MatchesScalar) {
+    for (size_t width : kWidths) {
+        // include out-of-range bits, which must be ignored
+        std::vector<uint16_t> y = randomRow<uint16_t>(mRng, width, 0xFFFF);
+        std::vector<uint16_t> u = randomRow<uint16_t>(mRng, (width + 1) / 2, 0xFFFF);
+        std::vector<uint16_t> v = randomRow<uint16_t>(mRng, (width + 1) / 2, 0xFFFF);
+
+        std::vector<uint32_t> expected(width + kGuard, kGuardValue);
+        std::vector<uint32_t> actual(width + kGuard, kGuardValue);
+        mScalar.planar16ToY410Row(y.data(), u.data(), v.data(), expected.data(), width);
+        mKernels.planar16ToY410Row(y.data(), u.data(), v.data(), actual.data(), width);
+        ASSERT_EQ(expected, actual) << "width " << width;
+    }
+}
+
+TEST(ColorConverterKernelsScalarTest, Yuv420ToRgb8KnownValues) {
+    const ColorConverterKernels &scalar = getScalarColorConverterKernels();
+    const YuvToRgbCoeffs &bt601Limited = kCoeffs8Bit[1];
+
+    // black, white and neutral grey in limited range
+    const uint8_t y[] = { 16, 235, 126, 126 };
+    const uint8_t u[] = { 128, 128 };
+    const uint8_t v[] = { 128, 128 };
+    uint32_t rgba[4];
+    scalar.yuv420ToRgb8Row(y, u, v, (uint8_t *)rgba, 4, bt601Limited, kRgbLayoutRGBA8888);
+    EXPECT_EQ(0xFF000000u, rgba[0]);
+    EXPECT_EQ(0xFFFFFFFFu, rgba[1]);
+    EXPECT_EQ(0xFF808080u, rgba[2]);
+    EXPECT_EQ(0xFF808080u, rgba[3]);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        ColorConverterKernels, ColorConverterKernelsTest,
+        ::testing::ValuesIn(getAvailableColorConverterKernels()),
+        [](const ::testing::TestParamInfo<const ColorConverterKernels *> &info) {
+            std::string name = info.param->mName;
+            for (char &c : name) {
+                if (!isalnum(c)) {
+                    c = '_';
+                }
+            }
+            return name;
+        });
+
+}  // namespace android
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAME_CONVERSION_POOL_H_
+#define FRAME_CONVERSION_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <media/hardware/VideoAPI.h>
+#include <media/openmax/OMX_Video.h>
+#include <utils/Errors.h>
+
+namespace android {
+
+/*
+ * Runs ColorConverter work on a small pool of worker threads.
+ *
+ * A submitted conversion is split into bands of rows that are converted in
+ * parallel, each with its own ColorConverter. Submission does not wait for the
+ * conversion, so the caller can keep decoding while the previous frame or tile
+ * is converted.
+ *
+ * The process-wide pool has media.stagefright.frame-conversion-threads workers
+ * (default: number of CPUs, at most 4). With 0 workers conversions run on the
+ * submitting thread.
+ */
+struct FrameConversionPool {
+    // Arguments of ColorConverter::convert() plus the converter configuration.
+    struct Params {
+        OMX_COLOR_FORMATTYPE mSrcFormat;
+        OMX_COLOR_FORMATTYPE mDstFormat;
+        std::optional<MediaImage2> mSrcImage;
+        uint32_t mStandard;
+        uint32_t mRange;
+        uint32_t mTransfer;
+
+        const void *mSrcBits;
+        size_t mSrcWidth, mSrcHeight, mSrcStride;
+        size_t mSrcCropLeft, mSrcCropTop, mSrcCropRight, mSrcCropBottom;
+
+        void *mDstBits;
+        size_t mDstWidth, mDstHeight, mDstStride;
+        size_t mDstCropLeft, mDstCropTop, mDstCropRight, mDstCropBottom;
+    };
+
+    // A submitted conversion.
+    class Job {
+    public:
+        // Blocks until all bands are converted. Returns the first error, if any.
+        status_t wait();
+
+    private:
+        friend struct FrameConversionPool;
+
+        std::mutex mLock;
+        std::condition_variable mCondition;
+        size_t mPendingBands = 0;
+        status_t mStatus = OK;
+
+        void onBandDone(status_t err);
+    };
+
+    static FrameConversionPool &getInstance();
+
+    explicit FrameConversionPool(size_t numThreads);
+    ~FrameConversionPool();
+
+    size_t numThreads() const { return mThreads.size(); }
+
+    std::shared_ptr<Job> submit(const Params &params);
+
+private:
+    struct Band {
+        std::shared_ptr<Job> mJob;
+        Params mParams;
+    };
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::deque<Band> mQueue;
+    bool mQuit;
+    std::vector<std::thread> mThreads;
+
+    void threadLoop();
+
+    static status_t convert(const Params &params);
+
+    FrameConversionPool(const FrameConversionPool &) = delete;
+    FrameConversionPool &operator=(const FrameConversionPool &) = delete;
+};
+
+}  // namespace android
+
+#endif  // FRAME_CONVERSION_POOL_H_
@@ -18,6 +18,7 @@
 #define FRAME_DECODER_H_
 
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include <media/stagefright/foundation/AString.h>
@@ -26,6 +27,8 @@
 #include <media/openmax/OMX_Video.h>
 #include <ui/GraphicTypes.h>
 
+#include "FrameConversionPool.h"
+
 namespace android {
 
 struct AMessage;
@@ -82,7 +85,19 @@ protected:
     int32_t dstBpp()             const      { return mDstBpp; }
     void setFrame(const sp<IMemory> &frameMem) { mFrameMemory = frameMem; }
 
+    // Starts converting the output buffer passed to onOutputReceived() on the
+    // conversion pool. The buffer is held until the conversion completes, which
+    // overlaps with decoding the next buffer; extractFrame() returns only after
+    // all conversions have completed.
+    void convertOutputAsync(const FrameConversionPool::Params &params);
+
 private:
+    struct PendingConversion {
+        std::shared_ptr<FrameConversionPool::Job> mJob;
+        size_t mIndex;
+        sp<MediaCodecBuffer> mBuffer;
+    };
+
     AString mComponentName;
     sp<MetaData> mTrackMeta;
     sp<IMediaSource> mSource;
@@ -96,8 +111,11 @@ private:
     bool mHaveMoreInputs;
     bool mFirstSample;
     sp<Surface> mSurface;
+    std::shared_ptr<FrameConversionPool::Job> mStartedConversion;
+    std::optional<PendingConversion> mPendingConversion;
 
     status_t extractInternal();
+    void finishPendingConversion();
 
     DISALLOW_EVIL_CONSTRUCTORS(FrameDecoder);
 };
@@ -165,10 +165,8 @@ private:
     std::optional<Image> mSrcImage;
     ColorSpace mSrcColorSpace;
     uint8_t *mClip;
-    uint16_t *mClip10Bit;
 
     uint8_t *initClip();
-    uint16_t *initClip10Bit();
 
     // resolve YUVFormat from YUV420Flexible
     bool isValidForMediaImage2() const;
@@ -28,6 +28,7 @@
 #include <media/stagefright/foundation/ALooper.h>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 namespace android {
 
@@ -117,6 +118,10 @@ private:
     bool mStreamableFile;
     off64_t mMoovExtraSize;
     uint32_t mInterleaveDurationUs;
+    int64_t mFragmentDurationUs;  // > 0 for fragmented output
+    bool mWriteSegmentIndex;  // Write a sidx box ahead of each fragment
+    bool mInitSegmentWritten;  // moov has been written in fragmented mode
+    uint32_t mFragmentSequenceNumber;
     int32_t mTimeScale;
     int64_t mStartTimestampUs;
     int32_t mStartTimeOffsetBFramesUs;  // Longest offset needed for reordering tracks with B Frames
@@ -161,16 +166,30 @@ private:
     void writeCachedBoxToFile(const char *type);
     void printWriteDurations();
 
+    // Per-sample information needed to describe a fragment in its 'trun' box.
+    struct FragmentSample {
+        uint32_t mSize;
+        uint32_t mDurationTicks;            // In track time scale
+        int32_t  mCompositionOffsetTicks;   // Presentation - decoding time
+        bool     mIsSync;
+    };
+
     struct Chunk {
         Track               *mTrack;        // Owner
         int64_t             mTimeStampUs;   // Timestamp of the 1st sample
         List<MediaBuffer *> mSamples;       // Sample data
 
+        // Fragmented mode only: one entry per sample in mSamples, and the
+        // track relative decoding time of the first sample.
+        std::vector<FragmentSample> mFragmentSamples;
+        int64_t             mBaseDecodeTimeTicks;
+
         // Convenient constructor
-        Chunk(): mTrack(NULL), mTimeStampUs(0) {}
+        Chunk(): mTrack(NULL), mTimeStampUs(0), mBaseDecodeTimeTicks(0) {}
 
         Chunk(Track *track, int64_t timeUs, List<MediaBuffer *> samples)
-            : mTrack(track), mTimeStampUs(timeUs), mSamples(samples) {
+            : mTrack(track), mTimeStampUs(timeUs), mSamples(samples),
+              mBaseDecodeTimeTicks(0) {
         }
 
     };
@@ -262,6 +281,15 @@ private:
     // Actually write the given chunk to the file.
     void writeChunkToFile(Chunk* chunk);
 
+    // Fragmented mode: the moov box can only be written once every track has
+    // its codec specific data, i.e. once every track has buffered its first
+    // fragment or has reached EOS.
+    bool isReadyForInitSegment_l();
+
+    // Fragmented mode: write the given chunk as an optional sidx followed by
+    // a moof/mdat pair, writing the init segment first if needed.
+    void writeFragmentToFile(Chunk* chunk);
+
     // Adjust other track media clock (presumably wall clock)
     // based on audio track media clock with the drift time.
     int64_t mDriftTimeUs;
@@ -283,6 +311,9 @@ private:
     // transcoding.
     bool isBackgroundMode() const;
 
+    // Return whether samples are written as moof/mdat fragments.
+    bool isFragmented() const;
+
     void lock();
     void unlock();
 
@@ -311,6 +342,7 @@ private:
     void writeCompositionMatrix(int32_t degrees);
     void writeMvhdBox(int64_t durationUs);
     void writeMoovBox(int64_t durationUs);
+    void writeMvexBox();
     void writeFtypBox(MetaData *param);
     void writeUdtaBox();
     void writeGeoDataBox();
@@ -90,6 +90,17 @@ public:
      */
     status_t setLocation(int latitude, int longitude);
 
+    /**
+     * Write a fragmented mp4 file: an init segment followed by moof/mdat
+     * fragments, so that the output stays playable while it is written.
+     * Only supported for .mp4 and .3gp output.
+     * @param durationUs The target duration of a fragment, or 0 to write a
+     * regular mp4 file.
+     * @param writeSegmentIndex Whether each fragment is preceded by a sidx box.
+     * @return OK if no error.
+     */
+    status_t setFragmentDuration(int64_t durationUs, bool writeSegmentIndex);
+
     /**
      * Stop muxing.
      * This method is a blocking call. Depending on how
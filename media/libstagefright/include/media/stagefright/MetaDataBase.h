@@ -135,6 +135,12 @@ enum {
     kKeyTrackTimeStatus   = 'tktm',  // int64_t
 
     kKeyRealTimeRecording = 'rtrc',  // bool (int32_t)
+
+    // Fragmented MP4 authoring: when set to a positive duration, samples are
+    // written as moof/mdat pairs of roughly this duration instead of a single
+    // moov at the end. kKeyFragmentSegmentIndex adds a sidx before each moof.
+    kKeyFragmentDurationUs = 'frdu',  // int64_t
+    kKeyFragmentSegmentIndex = 'frsx',  // bool (int32_t)
     kKeyBackgroundMode = 'bkmd',  // bool (int32_t)
 
     kKeyNumBuffers        = 'nbbf',  // int32_t
@@ -380,7 +386,9 @@ private:
     struct typed_data;
     struct Rect;
     struct MetaDataInternal;
-    MetaDataInternal *mInternalData;
+    MetaDataInternal *mInternalData;  // shared between copies until modified
+    // Returns mInternalData, first giving this object its own copy if it is shared.
+    MetaDataInternal *editInternalData();
 #ifndef __ANDROID_VNDK__
     status_t writeToParcel(Parcel &parcel);
     status_t updateFromParcel(const Parcel &parcel);
@@ -18,6 +18,7 @@
 #define NU_MEDIA_EXTRACTOR_H_
 
 #include <list>
+#include <memory>
 #include <media/mediaplayer.h>
 #include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/foundation/AudioPresentationInfo.h>
@@ -102,6 +103,11 @@ struct NuMediaExtractor : public RefBase {
 
     status_t setLogSessionId(const String8& logSessionId);
 
+    // When enabled, the samples of each selected track are read ahead of the client on a
+    // thread of their own, up to a bounded number of samples and bytes per track. Disabled
+    // by default.
+    status_t setPrefetchEnabled(bool enabled);
+
     const char* getName() const;
 
 protected:
@@ -123,6 +129,8 @@ private:
         int64_t mSampleTimeUs;
     };
 
+    struct TrackPrefetcher;
+
     struct TrackInfo {
         sp<IMediaSource> mSource;
         size_t mTrackIndex;
@@ -130,6 +138,7 @@ private:
         size_t mMaxFetchCount;
         status_t mFinalResult;
         std::list<Sample> mSamples;
+        std::shared_ptr<TrackPrefetcher> mPrefetcher;
 
         uint32_t mTrackFlags;  // bitmask of "TrackFlags"
     };
@@ -147,6 +156,7 @@ private:
     int64_t mTotalBitrate;  // in bits/sec
     int64_t mDurationUs;
     String8 mName;
+    bool mPrefetchEnabled;
 
     void setEntryPointToRemoteMediaExtractor();
 
@@ -160,6 +170,16 @@ private:
             MediaSource::ReadOptions::SeekMode mode =
                 MediaSource::ReadOptions::SEEK_CLOSEST_SYNC);
 
+    // Reads up to maxCount samples from source and appends them to samples. If copy is
+    // set, the samples are copied to buffers of their own and the source gets its
+    // buffers back at once.
+    static status_t readSamples(
+            const sp<IMediaSource> &source, size_t maxCount,
+            MediaSource::ReadOptions *options, bool copy, std::list<Sample> *samples);
+
+    void startPrefetching(TrackInfo *info);
+    void stopPrefetching(TrackInfo *info);
+
     void releaseTrackSamples(TrackInfo *info);
     void releaseAllTrackSamples();
 
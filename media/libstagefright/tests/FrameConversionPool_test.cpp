@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FrameConversionPool_test"
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/stagefright/foundation/ColorUtils.h>
+
+#include "FrameConversionPool.h"
+
+namespace android {
+
+namespace {
+
+struct FrameConversionPoolTest : public ::testing::TestWithParam<OMX_COLOR_FORMATTYPE> {
+    // Converts a random frame with |numThreads| workers, cropping an odd-sized
+    // rectangle that starts on an odd row.
+    std::vector<uint8_t> convert(size_t numThreads) {
+        const size_t width = 640;
+        const size_t height = 481;
+        const size_t bpp = GetParam() == OMX_COLOR_FormatCbYCrY ? 2 : 1;
+        const size_t srcSize = GetParam() == OMX_COLOR_FormatCbYCrY
+                ? width * height * 2 : width * height * 3 / 2;
+
+        std::mt19937 rng(1);
+        std::vector<uint8_t> src(srcSize);
+        for (uint8_t &value : src) {
+            value = rng();
+        }
+
+        const size_t cropLeft = 2, cropTop = 3, cropRight = 601, cropBottom = 470;
+        const size_t cropWidth = cropRight - cropLeft + 1;
+        const size_t cropHeight = cropBottom - cropTop + 1;
+        std::vector<uint8_t> dst(cropWidth * cropHeight * 2);
+
+        FrameConversionPool pool(numThreads);
+        FrameConversionPool::Params params = {
+                GetParam(), OMX_COLOR_Format16bitRGB565, std::nullopt,
+                ColorUtils::kColorStandardBT601_625, ColorUtils::kColorRangeLimited,
+                ColorUtils::kColorTransferSMPTE_170M,
+                src.data(), width, height, width * bpp,
+                cropLeft, cropTop, cropRight, cropBottom,
+                dst.data(), cropWidth, cropHeight, cropWidth * 2,
+                0, 0, cropWidth - 1, cropHeight - 1 };
+        EXPECT_EQ(OK, pool.submit(params)->wait());
+        return dst;
+    }
+};
+
+}  // namespace
+
+TEST_P(FrameConversionPoolTest, BandsMatchSingleConversion) {
+    std::vector<uint8_t> expected = convert(0);
+    for (size_t numThreads : { 1, 2, 3, 4, 7 }) {
+        EXPECT_EQ(expected, convert(numThreads)) << numThreads << " threads";
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        FrameConversionPool, FrameConversionPoolTest,
+        ::testing::Values(
+                OMX_COLOR_FormatYUV420Planar,
+                OMX_COLOR_FormatYUV420SemiPlanar,
+                OMX_COLOR_FormatCbYCrY));
+
+}  // namespace android
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * BM_ConvertFrame times the conversion pool on a synthetic 8K frame for a range
+ * of thread counts.
+ *
+ * BM_RetrieveHeif times MediaMetadataRetriever::getImageAtIndex() on every
+ * .heic/.heif/.avif file in /data/local/tmp/FrameDecoderBenchmark (or the
+ * directory in $FRAME_DECODER_BENCHMARK_DIR). Retrieval runs in the media
+ * server, so set media.stagefright.frame-conversion-threads and restart it to
+ * compare thread counts.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <binder/ProcessState.h>
+#include <media/mediametadataretriever.h>
+#include <media/stagefright/foundation/ColorUtils.h>
+#include <system/graphics.h>
+
+#include "FrameConversionPool.h"
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kWidth = 7680;
+constexpr size_t kHeight = 4320;
+
+void BM_ConvertFrame(benchmark::State &state) {
+    FrameConversionPool pool(state.range(0));
+
+    std::vector<uint8_t> src(kWidth * kHeight * 3 / 2, 0x80);
+    std::vector<uint8_t> dst(kWidth * kHeight * 4);
+    FrameConversionPool::Params params = {
+            OMX_COLOR_FormatYUV420SemiPlanar, OMX_COLOR_Format32BitRGBA8888, std::nullopt,
+            ColorUtils::kColorStandardBT709, ColorUtils::kColorRangeLimited,
+            ColorUtils::kColorTransferSMPTE_170M,
+            src.data(), kWidth, kHeight, kWidth, 0, 0, kWidth - 1, kHeight - 1,
+            dst.data(), kWidth, kHeight, kWidth * 4, 0, 0, kWidth - 1, kHeight - 1 };
+
+    for (auto _ : state) {
+        if (pool.submit(params)->wait() != OK) {
+            state.SkipWithError("conversion failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+}
+
+BENCHMARK(BM_ConvertFrame)->Arg(0)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+void BM_RetrieveHeif(benchmark::State &state, const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        state.SkipWithError("cannot open file");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+
+    for (auto _ : state) {
+        sp<MediaMetadataRetriever> retriever = new MediaMetadataRetriever();
+        if (retriever->setDataSource(fd, 0, st.st_size) != OK) {
+            state.SkipWithError("setDataSource failed");
+            break;
+        }
+        sp<IMemory> frame = retriever->getImageAtIndex(-1 /* primary */, HAL_PIXEL_FORMAT_RGBA_8888);
+        if (frame == nullptr) {
+            state.SkipWithError("getImageAtIndex failed");
+            break;
+        }
+        retriever->disconnect();
+    }
+    close(fd);
+}
+
+void registerHeifBenchmarks() {
+    const char *dirName = getenv("FRAME_DECODER_BENCHMARK_DIR");
+    std::string dirPath = dirName != nullptr ? dirName : "/data/local/tmp/FrameDecoderBenchmark";
+    DIR *dir = opendir(dirPath.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    while (struct dirent *entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        size_t dot = name.rfind('.');
+        std::string ext = dot == std::string::npos ? "" : name.substr(dot);
+        if (ext == ".heic" || ext == ".heif" || ext == ".avif") {
+            benchmark::RegisterBenchmark(("BM_RetrieveHeif/" + name).c_str(),
+                    BM_RetrieveHeif, dirPath + "/" + name)->UseRealTime();
+        }
+    }
+    closedir(dir);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ProcessState::self()->startThreadPool();
+    registerHeifBenchmarks();
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
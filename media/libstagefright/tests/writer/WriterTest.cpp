@@ -21,12 +21,14 @@
 #include <binder/ProcessState.h>
 
 #include <inttypes.h>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
 #include <media/NdkMediaExtractor.h>
 #include <media/stagefright/MediaDefs.h>
 #include <media/stagefright/MetaData.h>
+#include <media/stagefright/foundation/ByteUtils.h>
 #include <media/stagefright/Utils.h>
 
 #include <media/mediarecorder.h>
@@ -896,6 +898,191 @@ TEST_P(WriteFunctionalityTest, Mpeg4WriterTest) {
     close(fd);
 }
 
+// Returns the payloads of the child boxes of the given type found in data.
+static vector<pair<const uint8_t *, size_t>> findBoxes(const uint8_t *data, size_t size,
+                                                       const char *type) {
+    vector<pair<const uint8_t *, size_t>> boxes;
+    size_t offset = 0;
+    while (offset + 8 <= size) {
+        uint32_t boxSize = U32_AT(data + offset);
+        if (boxSize < 8 || boxSize > size - offset) break;
+        if (!memcmp(data + offset + 4, type, 4)) {
+            boxes.push_back({data + offset + 8, boxSize - 8});
+        }
+        offset += boxSize;
+    }
+    return boxes;
+}
+
+// Fragmented MPEG4 output: ftyp, then the init segment (moov with mvex),
+// then sidx/moof/mdat triplets, and no mdat before the moov. The trun
+// boxes must describe every input frame and the file must extract back.
+TEST_P(WriteFunctionalityTest, Mpeg4FragmentedWriterTest) {
+    if (mDisableTest) return;
+    if (mWriterName != standardWriters::MPEG4) return;
+    ALOGV("Test fragmented MPEG4 writer");
+
+    inputId inpId = get<1>(GetParam());
+    ASSERT_NE(inpId, UNUSED_ID) << "Test expects first inputId to be a valid id";
+    if (inpId == HEIC_1) return;  // Image tracks can not be fragmented
+
+    int32_t fd =
+            open(OUTPUT_FILE_NAME, O_CREAT | O_LARGEFILE | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR);
+    ASSERT_GE(fd, 0) << "Failed to open output file to dump writer's data";
+
+    int32_t status = createWriter(fd);
+    ASSERT_EQ(status, (status_t)OK) << "Failed to create writer for mpeg4 output format";
+
+    string inputFile = gEnv->getRes();
+    string inputInfo = gEnv->getRes();
+    configFormat param;
+    bool isAudio;
+    getFileDetails(inputFile, inputInfo, param, isAudio, inpId);
+    ASSERT_NE(inputFile.compare(gEnv->getRes()), 0) << "No input file specified";
+
+    ASSERT_NO_FATAL_FAILURE(getInputBufferInfo(inputFile, inputInfo));
+    status = addWriterSource(isAudio, param);
+    ASSERT_EQ((status_t)OK, status) << "Failed to add source for mpeg4 Writer";
+
+    mFileMeta->setInt64(kKeyFragmentDurationUs, 500000);
+    mFileMeta->setInt32(kKeyFragmentSegmentIndex, true);
+    status = mWriter->start(mFileMeta.get());
+    ASSERT_EQ((status_t)OK, status) << "Could not start the writer";
+
+    status = sendBuffersToWriter(mInputStream[0], mBufferInfo[0], mInputFrameId[0],
+                                 mCurrentTrack[0], 0, mBufferInfo[0].size());
+    ASSERT_EQ((status_t)OK, status) << "mpeg4 writer failed";
+
+    status = mCurrentTrack[0]->stop();
+    ASSERT_EQ((status_t)OK, status) << "Failed to stop the track";
+
+    status = mWriter->stop();
+    ASSERT_EQ((status_t)OK, status) << "Failed to stop the writer";
+
+    off64_t fileSize = lseek64(fd, 0, SEEK_END);
+    ASSERT_GT(fileSize, 0) << "Writer produced an empty file";
+    vector<uint8_t> file(fileSize);
+    ASSERT_EQ(fileSize, pread64(fd, file.data(), fileSize, 0)) << "Failed to read output file";
+    close(fd);
+
+    // Walk the top level boxes.
+    off64_t offset = 0;
+    vector<string> boxes;
+    while (offset + 8 <= fileSize) {
+        uint32_t size = U32_AT(file.data() + offset);
+        ASSERT_GE(size, 8u) << "Invalid box size at offset " << offset;
+        boxes.push_back(string((const char *)file.data() + offset + 4, 4));
+        offset += size;
+    }
+    ASSERT_EQ(offset, fileSize) << "Trailing data after the last box";
+
+    ASSERT_GE(boxes.size(), 5u) << "Too few boxes for a fragmented file";
+    ASSERT_EQ(boxes[0], "ftyp");
+    ASSERT_EQ(boxes[1], "moov");
+    ASSERT_EQ((boxes.size() - 2) % 3, 0u) << "Incomplete fragment";
+    size_t numFragments = 0;
+    for (size_t i = 2; i < boxes.size(); i += 3) {
+        ASSERT_EQ(boxes[i], "sidx");
+        ASSERT_EQ(boxes[i + 1], "moof");
+        ASSERT_EQ(boxes[i + 2], "mdat");
+        ++numFragments;
+    }
+    ASSERT_GT(numFragments, 0u) << "No fragment was written";
+
+    // Track timescale from moov/trak/mdia/mdhd.
+    auto moov = findBoxes(file.data(), file.size(), "moov");
+    ASSERT_EQ(moov.size(), 1u);
+    auto trak = findBoxes(moov[0].first, moov[0].second, "trak");
+    ASSERT_EQ(trak.size(), 1u);
+    auto mdia = findBoxes(trak[0].first, trak[0].second, "mdia");
+    ASSERT_EQ(mdia.size(), 1u);
+    auto mdhd = findBoxes(mdia[0].first, mdia[0].second, "mdhd");
+    ASSERT_EQ(mdhd.size(), 1u);
+    size_t timeScaleOffset = mdhd[0].first[0] == 1 ? 20 : 12;
+    ASSERT_GE(mdhd[0].second, timeScaleOffset + 4);
+    uint32_t timeScale = U32_AT(mdhd[0].first + timeScaleOffset);
+    ASSERT_GT(timeScale, 0u);
+
+    // Collect the samples described by every trun, checking that each
+    // fragment starts where the previous one ended.
+    vector<uint32_t> durations;
+    vector<bool> syncFlags;
+    uint64_t expectedDecodeTime = 0;
+    for (const auto &moof : findBoxes(file.data(), file.size(), "moof")) {
+        auto traf = findBoxes(moof.first, moof.second, "traf");
+        ASSERT_EQ(traf.size(), 1u);
+        auto tfdt = findBoxes(traf[0].first, traf[0].second, "tfdt");
+        ASSERT_EQ(tfdt.size(), 1u);
+        ASSERT_EQ(tfdt[0].second, 12u) << "Expected a version 1 tfdt";
+        uint64_t decodeTime = U64_AT(tfdt[0].first + 4);
+        if (!durations.empty()) {
+            ASSERT_EQ(decodeTime, expectedDecodeTime) << "Gap or overlap between fragments";
+        }
+        expectedDecodeTime = decodeTime;
+
+        auto trun = findBoxes(traf[0].first, traf[0].second, "trun");
+        ASSERT_EQ(trun.size(), 1u);
+        uint32_t flags = U32_AT(trun[0].first) & 0xffffff;
+        ASSERT_EQ(flags & 0x700, 0x700u) << "trun lacks per sample duration, size or flags";
+        uint32_t sampleCount = U32_AT(trun[0].first + 4);
+        size_t entryOffset = 8 + ((flags & 0x1) ? 4 : 0) + ((flags & 0x4) ? 4 : 0);
+        size_t entrySize = (flags & 0x800) ? 16 : 12;
+        ASSERT_EQ(trun[0].second, entryOffset + sampleCount * entrySize);
+        ASSERT_GT(sampleCount, 0u) << "Empty fragment";
+        for (uint32_t i = 0; i < sampleCount; ++i) {
+            const uint8_t *entry = trun[0].first + entryOffset + i * entrySize;
+            durations.push_back(U32_AT(entry));
+            uint32_t sampleFlags = U32_AT(entry + 8);
+            syncFlags.push_back(!(sampleFlags & 0x00010000));
+            expectedDecodeTime += U32_AT(entry);
+        }
+    }
+
+    // Every input frame is described once, with the sync flag it came with.
+    vector<int64_t> inputTimesUs;
+    vector<bool> inputSyncFlags;
+    for (const BufferInfo &info : mBufferInfo[0]) {
+        if (info.flags == CODEC_CONFIG_FLAG) continue;
+        inputTimesUs.push_back(info.timeUs);
+        inputSyncFlags.push_back(isAudio || info.flags == 1);
+    }
+    ASSERT_EQ(durations.size(), inputTimesUs.size())
+            << "trun sample count does not match the number of input frames";
+    ASSERT_EQ(syncFlags, inputSyncFlags) << "trun sync flags do not match the input key frames";
+
+    // All but the last sample span the input time stamps; allow one tick of
+    // rounding per sample plus the writer's sub 0.1 ms duration fudging.
+    uint64_t spanTicks = 0;
+    for (size_t i = 0; i + 1 < durations.size(); ++i) spanTicks += durations[i];
+    int64_t spanUs = spanTicks * 1000000LL / timeScale;
+    int64_t inputSpanUs = inputTimesUs.back() - inputTimesUs.front();
+    int64_t toleranceUs = 100 + (int64_t)durations.size() * 1000000LL / timeScale;
+    ASSERT_LE(llabs(spanUs - inputSpanUs), toleranceUs)
+            << "trun durations do not add up to the input duration";
+
+    // The file must extract back with the same number of samples.
+    AMediaExtractor *extractor = AMediaExtractor_new();
+    ASSERT_NE(extractor, nullptr) << "Failed to create extractor";
+    int32_t trackCount = -1;
+    ASSERT_NO_FATAL_FAILURE(setupExtractor(extractor, OUTPUT_FILE_NAME, trackCount));
+    ASSERT_EQ(trackCount, 1) << "Tracks reported by extractor does not match";
+    ASSERT_EQ(AMediaExtractor_selectTrack(extractor, 0), AMEDIA_OK);
+    size_t extractedSamples = 0;
+    size_t extractedSyncSamples = 0;
+    while (AMediaExtractor_getSampleSize(extractor) >= 0) {
+        ++extractedSamples;
+        if (AMediaExtractor_getSampleFlags(extractor) & AMEDIAEXTRACTOR_SAMPLE_FLAG_SYNC) {
+            ++extractedSyncSamples;
+        }
+        AMediaExtractor_advance(extractor);
+    }
+    AMediaExtractor_delete(extractor);
+    ASSERT_EQ(extractedSamples, inputTimesUs.size())
+            << "Extracted sample count does not match the number of input frames";
+    ASSERT_EQ(extractedSyncSamples,
+              (size_t)count(inputSyncFlags.begin(), inputSyncFlags.end(), true));
+}
+
 class ListenerTest
     : public WriterTest,
       public ::testing::TestWithParam<tuple<
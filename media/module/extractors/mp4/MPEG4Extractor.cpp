@@ -35,6 +35,7 @@
 #include "ItemTable.h"
 
 #include <media/esds/ESDS.h>
+#include <media/indexcache/IndexCache.h>
 #include <ID3.h>
 #include <media/stagefright/DataSourceBase.h>
 #include <media/ExtractorUtils.h>
@@ -441,6 +442,10 @@ MPEG4Extractor::MPEG4Extractor(DataSourceHelper *source, const char *mime)
       mHasMoovBox(false),
       mPreferHeif(mime != NULL && !strcasecmp(mime, MEDIA_MIMETYPE_CONTAINER_HEIF)),
       mIsAvif(false),
+      mIndexCache(IndexCache::Get()),
+      mSampleTableFromIndexCache(false),
+      mMoovOffset(0),
+      mMoovSize(0),
       mFirstTrack(NULL),
       mLastTrack(NULL) {
     ALOGV("mime=%s, mPreferHeif=%d", mime, mPreferHeif);
@@ -991,6 +996,11 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
                 return ERROR_MALFORMED;
             }
 
+            if (chunk_type == FOURCC("moov")) {
+                mMoovOffset = *offset;
+                mMoovSize = chunk_size;
+            }
+
             if (chunk_type == FOURCC("moof") && !mMoofFound) {
                 // store the offset of the first segment
                 mMoofFound = true;
@@ -1020,6 +1030,7 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
                 }
 
                 mLastTrack->sampleTable = new SampleTable(mDataSource);
+                mSampleTableFromIndexCache = restoreSampleTable(*offset, chunk_size);
             }
 
             bool isTrack = false;
@@ -2151,6 +2162,13 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
             if (*offset != stop_offset) {
                 return ERROR_MALFORMED;
             }
+
+            if (chunk_type == FOURCC("stbl")) {
+                if (!mSampleTableFromIndexCache) {
+                    saveSampleTable(stop_offset - chunk_size, chunk_size);
+                }
+                mSampleTableFromIndexCache = false;
+            }
             break;
         }
 
@@ -2161,9 +2179,11 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
                 return ERROR_MALFORMED;
             }
 
-            status_t err =
-                mLastTrack->sampleTable->setChunkOffsetParams(
+            status_t err = OK;
+            if (!mSampleTableFromIndexCache) {
+                err = mLastTrack->sampleTable->setChunkOffsetParams(
                         chunk_type, data_offset, chunk_data_size);
+            }
 
             *offset += chunk_size;
 
@@ -2179,9 +2199,11 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
             if ((mLastTrack == NULL) || (mLastTrack->sampleTable == NULL))
                 return ERROR_MALFORMED;
 
-            status_t err =
-                mLastTrack->sampleTable->setSampleToChunkParams(
+            status_t err = OK;
+            if (!mSampleTableFromIndexCache) {
+                err = mLastTrack->sampleTable->setSampleToChunkParams(
                         data_offset, chunk_data_size);
+            }
 
             *offset += chunk_size;
 
@@ -2199,9 +2221,11 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
                 return ERROR_MALFORMED;
             }
 
-            status_t err =
-                mLastTrack->sampleTable->setSampleSizeParams(
+            status_t err = OK;
+            if (!mSampleTableFromIndexCache) {
+                err = mLastTrack->sampleTable->setSampleSizeParams(
                         chunk_type, data_offset, chunk_data_size);
+            }
 
             *offset += chunk_size;
 
@@ -2329,9 +2353,11 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
                 break;
             }
 
-            status_t err =
-                mLastTrack->sampleTable->setTimeToSampleParams(
+            status_t err = OK;
+            if (!mSampleTableFromIndexCache) {
+                err = mLastTrack->sampleTable->setTimeToSampleParams(
                         data_offset, chunk_data_size);
+            }
 
             if (err != OK) {
                 return err;
@@ -2347,9 +2373,11 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
 
             *offset += chunk_size;
 
-            status_t err =
-                mLastTrack->sampleTable->setCompositionTimeToSampleParams(
+            status_t err = OK;
+            if (!mSampleTableFromIndexCache) {
+                err = mLastTrack->sampleTable->setCompositionTimeToSampleParams(
                         data_offset, chunk_data_size);
+            }
 
             if (err != OK) {
                 return err;
@@ -2365,9 +2393,11 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
 
             *offset += chunk_size;
 
-            status_t err =
-                mLastTrack->sampleTable->setSyncSampleParams(
+            status_t err = OK;
+            if (!mSampleTableFromIndexCache) {
+                err = mLastTrack->sampleTable->setSyncSampleParams(
                         data_offset, chunk_data_size);
+            }
 
             if (err != OK) {
                 return err;
@@ -5073,6 +5103,49 @@ void MPEG4Extractor::adjustRawDefaultFrameSize() {
     }
 }
 
+std::string MPEG4Extractor::getSampleTableIndexKey(off64_t offset, uint64_t size) {
+    if (mIndexCacheFileKey.empty()
+            && !IndexCache::GetFileKey(mDataSource, mMoovOffset, mMoovSize,
+                    &mIndexCacheFileKey)) {
+        // Do not try again for the other tracks.
+        mIndexCache = NULL;
+        return std::string();
+    }
+    return mIndexCacheFileKey + " mp4 stbl=" + std::to_string(offset) + "+"
+            + std::to_string(size);
+}
+
+// Replaces the sample table of mLastTrack with the one saved for the stbl box at offset,
+// if any. The boxes of the sample table then only need to be parsed for the track metadata.
+bool MPEG4Extractor::restoreSampleTable(off64_t offset, uint64_t size) {
+    if (mIndexCache == NULL) {
+        return false;
+    }
+    std::string key = getSampleTableIndexKey(offset, size);
+    std::string data;
+    if (key.empty() || !mIndexCache->get(key, &data)) {
+        return false;
+    }
+    sp<SampleTable> sampleTable = new SampleTable(mDataSource);
+    if (sampleTable->readIndex(data.data(), data.size()) != OK) {
+        ALOGW("ignoring saved sample table of stbl box at %lld", (long long)offset);
+        return false;
+    }
+    mLastTrack->sampleTable = sampleTable;
+    return true;
+}
+
+void MPEG4Extractor::saveSampleTable(off64_t offset, uint64_t size) {
+    if (mIndexCache == NULL || !mLastTrack->sampleTable->isValid()) {
+        return;
+    }
+    std::string key = getSampleTableIndexKey(offset, size);
+    std::string data;
+    if (!key.empty() && mLastTrack->sampleTable->writeIndex(&data) == OK) {
+        mIndexCache->put(key, data);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 MPEG4Source::MPEG4Source(
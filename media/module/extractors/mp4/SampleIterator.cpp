@@ -22,6 +22,8 @@
 
 #include <arpa/inet.h>
 
+#include <algorithm>
+
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/ByteUtils.h>
 
@@ -50,6 +52,24 @@ void SampleIterator::reset() {
     mChunkDesc = 0;
 }
 
+void SampleIterator::restartChunkRange(uint32_t sampleIndex) {
+    reset();
+
+    const uint32_t *firstSamples = mTable->mSampleToChunkFirstSamples;
+    if (firstSamples == NULL || mTable->mNumSampleToChunkFirstSamples == 0) {
+        return;
+    }
+
+    // Skip the sample-to-chunk entries before the one of sampleIndex,
+    // firstSamples[0] is 0.
+    const uint32_t *entry = std::upper_bound(
+            firstSamples, firstSamples + mTable->mNumSampleToChunkFirstSamples,
+            sampleIndex) - 1;
+    mSampleToChunkIndex = entry - firstSamples;
+    mFirstChunkSampleIndex = *entry;
+    mStopChunkSampleIndex = *entry;
+}
+
 status_t SampleIterator::seekTo(uint32_t sampleIndex) {
     ALOGV("seekTo(%d)", sampleIndex);
 
@@ -69,8 +89,9 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
         return OK;
     }
 
-    if (!mInitialized || sampleIndex < mFirstChunkSampleIndex) {
-        reset();
+    if (!mInitialized || sampleIndex < mFirstChunkSampleIndex
+            || sampleIndex >= mStopChunkSampleIndex) {
+        restartChunkRange(sampleIndex);
     }
 
     if (sampleIndex >= mStopChunkSampleIndex) {
@@ -99,29 +120,25 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
             return err;
         }
 
-        mCurrentChunkSampleSizes.clear();
-
         uint32_t firstChunkSampleIndex =
             mFirstChunkSampleIndex
                 + mSamplesPerChunk * (chunk - mFirstChunk);
 
-        for (uint32_t i = 0; i < mSamplesPerChunk; ++i) {
-            size_t sampleSize;
-            if ((err = getSampleSizeDirect(
-                            firstChunkSampleIndex + i, &sampleSize)) != OK) {
-                ALOGE("getSampleSizeDirect return error");
-                // stsc sample count is not sync with stsz sample count
-                if (err == ERROR_OUT_OF_RANGE) {
-                    ALOGW("stsc samples(%d) not sync with stsz samples(%d)", mSamplesPerChunk, i);
-                    mSamplesPerChunk = i;
-                    break;
-                } else{
-                    mCurrentChunkSampleSizes.clear();
-                    return err;
-                }
-            }
+        // stsc sample count is not sync with stsz sample count, only the
+        // last chunk is short, the chunks before it still have mSamplesPerChunk.
+        uint32_t numSamples = mTable->mNumSampleSizes - firstChunkSampleIndex;
+        if (mSamplesPerChunk > numSamples) {
+            ALOGW("stsc samples(%d) not sync with stsz samples(%d)",
+                    mSamplesPerChunk, numSamples);
+        } else {
+            numSamples = mSamplesPerChunk;
+        }
 
-            mCurrentChunkSampleSizes.push(sampleSize);
+        if ((err = getSampleSizesDirect(
+                        firstChunkSampleIndex, numSamples,
+                        &mCurrentChunkSampleSizes)) != OK) {
+            ALOGE("getSampleSizesDirect return error");
+            return err;
         }
 
         mCurrentChunkIndex = chunk;
@@ -136,7 +153,22 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
     }
 
     mCurrentSampleSize = mCurrentChunkSampleSizes[chunkRelativeSampleIndex];
-    if (sampleIndex < mTTSSampleIndex) {
+
+    // Once the sample time index is built, restart from the time-to-sample entry
+    // of the block of sampleIndex instead of walking the entries.
+    const SampleTable::SampleTimeBlock *block = mTable->getSampleTimeBlock_l(sampleIndex);
+    if (block != NULL && (block->mTimeToSampleIndex >= mTable->mTimeToSampleCount
+            || block->mTimeToSampleTime == UINT64_MAX)) {
+        block = NULL;
+    }
+    if (block != NULL && (sampleIndex < mTTSSampleIndex
+            || block->mTimeToSampleIndex >= mTimeToSampleIndex)) {
+        mTimeToSampleIndex = block->mTimeToSampleIndex + 1;
+        mTTSSampleIndex = block->mTimeToSampleSampleIndex;
+        mTTSSampleTime = block->mTimeToSampleTime;
+        mTTSCount = mTable->mTimeToSample[2 * block->mTimeToSampleIndex];
+        mTTSDuration = mTable->mTimeToSample[2 * block->mTimeToSampleIndex + 1];
+    } else if (sampleIndex < mTTSSampleIndex) {
         mTimeToSampleIndex = 0;
         mTTSSampleIndex = 0;
         mTTSSampleTime = 0;
@@ -306,6 +338,70 @@ status_t SampleIterator::getSampleSizeDirect(
     return OK;
 }
 
+status_t SampleIterator::getSampleSizesDirect(
+        uint32_t sampleIndex, uint32_t count, Vector<size_t> *sizes) {
+    sizes->clear();
+
+    if (sampleIndex > mTable->mNumSampleSizes
+            || count > mTable->mNumSampleSizes - sampleIndex) {
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    if (mTable->mDefaultSampleSize > 0) {
+        sizes->insertAt((size_t)mTable->mDefaultSampleSize, 0, count);
+        return OK;
+    }
+
+    const uint32_t fieldSize = mTable->mSampleSizeFieldSize;
+    CHECK(fieldSize == 32 || fieldSize == 16 || fieldSize == 8 || fieldSize == 4);
+
+    // A 4 bit field may start in the middle of a byte, keep one byte for it.
+    uint8_t buffer[1024];
+    const uint32_t maxSamplesPerRead = (sizeof(buffer) - 1) * 8 / fieldSize;
+
+    sizes->setCapacity(count);
+    while (count > 0) {
+        uint32_t numSamples = std::min(count, maxSamplesPerRead);
+        uint64_t begin = (uint64_t)sampleIndex * fieldSize / 8;
+        uint64_t end = ((uint64_t)(sampleIndex + numSamples) * fieldSize + 7) / 8;
+        if (mTable->mDataSource->readAt(
+                    mTable->mSampleSizeOffset + 12 + begin,
+                    buffer, end - begin) < (ssize_t)(end - begin)) {
+            sizes->clear();
+            return ERROR_IO;
+        }
+
+        for (uint32_t i = 0; i < numSamples; ++i) {
+            switch (fieldSize) {
+                case 32:
+                    sizes->push(U32_AT(&buffer[4 * i]));
+                    break;
+
+                case 16:
+                    sizes->push(U16_AT(&buffer[2 * i]));
+                    break;
+
+                case 8:
+                    sizes->push(buffer[i]);
+                    break;
+
+                default:
+                {
+                    uint32_t index = sampleIndex + i;
+                    uint8_t x = buffer[index / 2 - begin];
+                    sizes->push((index & 1) ? x & 0x0f : x >> 4);
+                    break;
+                }
+            }
+        }
+
+        sampleIndex += numSamples;
+        count -= numSamples;
+    }
+
+    return OK;
+}
+
 status_t SampleIterator::findSampleTimeAndDuration(
         uint32_t sampleIndex, uint64_t *time, uint64_t *duration) {
     if (sampleIndex >= mTable->mNumSampleSizes) {
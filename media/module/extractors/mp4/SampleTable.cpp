@@ -18,12 +18,15 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <limits>
+#include <memory>
 
 #include "SampleTable.h"
 #include "SampleIterator.h"
 
 #include <arpa/inet.h>
+#include <string.h>
 
 #include <media/MediaExtractorPluginApi.h>
 #include <media/stagefright/foundation/ADebug.h>
@@ -55,7 +58,8 @@ struct SampleTable::CompositionDeltaLookup {
     void setEntries(
             const int32_t *deltaEntries, size_t numDeltaEntries);
 
-    int32_t getCompositionTimeOffset(uint32_t sampleIndex);
+    // block is the SampleTimeBlock of sampleIndex, if any, to restart the search from.
+    int32_t getCompositionTimeOffset(uint32_t sampleIndex, const SampleTimeBlock *block);
 
 private:
     Mutex mLock;
@@ -87,14 +91,18 @@ void SampleTable::CompositionDeltaLookup::setEntries(
 }
 
 int32_t SampleTable::CompositionDeltaLookup::getCompositionTimeOffset(
-        uint32_t sampleIndex) {
+        uint32_t sampleIndex, const SampleTimeBlock *block) {
     Mutex::Autolock autolock(mLock);
 
     if (mDeltaEntries == NULL) {
         return 0;
     }
 
-    if (sampleIndex < mCurrentEntrySampleIndex) {
+    if (block != NULL && (sampleIndex < mCurrentEntrySampleIndex
+            || block->mCompositionDeltaIndex > mCurrentDeltaEntry)) {
+        mCurrentDeltaEntry = block->mCompositionDeltaIndex;
+        mCurrentEntrySampleIndex = block->mCompositionDeltaSampleIndex;
+    } else if (sampleIndex < mCurrentEntrySampleIndex) {
         mCurrentDeltaEntry = 0;
         mCurrentEntrySampleIndex = 0;
     }
@@ -114,6 +122,152 @@ int32_t SampleTable::CompositionDeltaLookup::getCompositionTimeOffset(
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Walks the time-to-sample and composition-time-to-sample tables in decode order.
+struct SampleTable::SampleTimeCursor {
+    explicit SampleTimeCursor(const SampleTable *table);
+
+    // Continues from the first sample of a block saved by getBlock().
+    void seek(uint32_t sampleIndex, const SampleTimeBlock &block);
+
+    // Saves the state at the next sample.
+    void getBlock(SampleTimeBlock *block);
+
+    // Returns the composition time of the next sample and moves past it.
+    uint64_t next();
+
+private:
+    const SampleTable *mTable;
+
+    uint64_t mSampleIndex;
+    uint64_t mSampleTime;
+
+    uint32_t mTimeToSampleIndex;
+    uint64_t mTimeToSampleSampleIndex;
+    uint64_t mTimeToSampleTime;
+
+    uint32_t mCompositionDeltaIndex;
+    uint64_t mCompositionDeltaSampleIndex;
+
+    void findEntries();
+
+    DISALLOW_EVIL_CONSTRUCTORS(SampleTimeCursor);
+};
+
+SampleTable::SampleTimeCursor::SampleTimeCursor(const SampleTable *table)
+    : mTable(table),
+      mSampleIndex(0),
+      mSampleTime(0),
+      mTimeToSampleIndex(0),
+      mTimeToSampleSampleIndex(0),
+      mTimeToSampleTime(0),
+      mCompositionDeltaIndex(0),
+      mCompositionDeltaSampleIndex(0) {
+}
+
+void SampleTable::SampleTimeCursor::seek(
+        uint32_t sampleIndex, const SampleTimeBlock &block) {
+    mSampleIndex = sampleIndex;
+    mSampleTime = block.mSampleTime;
+    mTimeToSampleIndex = block.mTimeToSampleIndex;
+    mTimeToSampleSampleIndex = block.mTimeToSampleSampleIndex;
+    mTimeToSampleTime = block.mTimeToSampleTime;
+    mCompositionDeltaIndex = block.mCompositionDeltaIndex;
+    mCompositionDeltaSampleIndex = block.mCompositionDeltaSampleIndex;
+}
+
+void SampleTable::SampleTimeCursor::findEntries() {
+    const uint32_t *timeToSample = mTable->mTimeToSample;
+    while (mTimeToSampleIndex < mTable->mTimeToSampleCount
+            && mSampleIndex - mTimeToSampleSampleIndex
+                    >= timeToSample[2 * mTimeToSampleIndex]) {
+        uint64_t count = timeToSample[2 * mTimeToSampleIndex];
+        uint64_t duration = count * timeToSample[2 * mTimeToSampleIndex + 1];
+        if (mTimeToSampleTime == UINT64_MAX
+                || __builtin_add_overflow(mTimeToSampleTime, duration, &mTimeToSampleTime)) {
+            mTimeToSampleTime = UINT64_MAX;
+        }
+        mTimeToSampleSampleIndex += count;
+        ++mTimeToSampleIndex;
+    }
+
+    const int32_t *deltaEntries = mTable->mCompositionTimeDeltaEntries;
+    if (deltaEntries == NULL) {
+        return;
+    }
+    while (mCompositionDeltaIndex < mTable->mNumCompositionTimeDeltaEntries
+            && mSampleIndex - mCompositionDeltaSampleIndex
+                    >= (uint32_t)deltaEntries[2 * mCompositionDeltaIndex]) {
+        mCompositionDeltaSampleIndex += (uint32_t)deltaEntries[2 * mCompositionDeltaIndex];
+        ++mCompositionDeltaIndex;
+    }
+}
+
+void SampleTable::SampleTimeCursor::getBlock(SampleTimeBlock *block) {
+    findEntries();
+
+    block->mSampleTime = mSampleTime;
+    block->mTimeToSampleIndex = mTimeToSampleIndex;
+    block->mTimeToSampleSampleIndex = mTimeToSampleSampleIndex;
+    block->mTimeToSampleTime = mTimeToSampleTime;
+    if (mTimeToSampleIndex < mTable->mTimeToSampleCount
+            && mTimeToSampleSampleIndex + mTable->mTimeToSample[2 * mTimeToSampleIndex]
+                    > UINT32_MAX) {
+        // SampleIterator fails on this entry.
+        block->mTimeToSampleTime = UINT64_MAX;
+    }
+    block->mCompositionDeltaIndex = mCompositionDeltaIndex;
+    block->mCompositionDeltaSampleIndex = mCompositionDeltaSampleIndex;
+}
+
+uint64_t SampleTable::SampleTimeCursor::next() {
+    findEntries();
+
+    uint64_t compositionTime = 0;
+    if (mTimeToSampleIndex < mTable->mTimeToSampleCount) {
+        // Technically all samples should have a time if the file
+        // is well-formed, but you know... there's (gasp) malformed
+        // content out there.
+
+        int32_t compTimeDelta = 0;
+        if (mTable->mCompositionTimeDeltaEntries != NULL
+                && mCompositionDeltaIndex < mTable->mNumCompositionTimeDeltaEntries) {
+            compTimeDelta = mTable->mCompositionTimeDeltaEntries[2 * mCompositionDeltaIndex + 1];
+        }
+
+        if ((compTimeDelta < 0 && mSampleTime <
+                (compTimeDelta == INT32_MIN ?
+                        INT32_MAX : uint32_t(-compTimeDelta)))
+                || (compTimeDelta > 0 &&
+                        mSampleTime > UINT64_MAX - compTimeDelta)) {
+            ALOGE("%llu + %d would overflow, clamping",
+                    (unsigned long long) mSampleTime, compTimeDelta);
+            if (compTimeDelta < 0) {
+                mSampleTime = 0;
+            } else {
+                mSampleTime = UINT64_MAX;
+            }
+            compTimeDelta = 0;
+        }
+
+        compositionTime = compTimeDelta > 0 ? mSampleTime + compTimeDelta :
+                mSampleTime - (-compTimeDelta);
+
+        uint32_t delta = mTable->mTimeToSample[2 * mTimeToSampleIndex + 1];
+        if (mSampleTime > UINT64_MAX - delta) {
+            ALOGE("%llu + %u would overflow, clamping",
+                (unsigned long long) mSampleTime, delta);
+            mSampleTime = UINT64_MAX;
+        } else {
+            mSampleTime += delta;
+        }
+    }
+
+    ++mSampleIndex;
+    return compositionTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 SampleTable::SampleTable(DataSourceHelper *source)
     : mDataSource(source),
       mChunkOffsetOffset(-1),
@@ -128,7 +282,10 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mHasTimeToSample(false),
       mTimeToSampleCount(0),
       mTimeToSample(NULL),
-      mSampleTimeEntries(NULL),
+      mSampleTimeBlocks(NULL),
+      mNumSampleTimeBlocks(0),
+      mSampleTimeWindows(NULL),
+      mNumSampleTimeWindows(0),
       mCompositionTimeDeltaEntries(NULL),
       mNumCompositionTimeDeltaEntries(0),
       mCompositionDeltaLookup(new CompositionDeltaLookup),
@@ -137,7 +294,15 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mSyncSamples(NULL),
       mLastSyncSampleIndex(0),
       mSampleToChunkEntries(NULL),
+      mSampleToChunkFirstSamples(NULL),
+      mNumSampleToChunkFirstSamples(0),
+      mMaxSampleSize(0),
       mTotalSize(0) {
+    for (size_t i = 0; i < kNumSortedSampleTimeWindows; ++i) {
+        mSortedSampleTimeWindows[i].mWindow = 0;
+        mSortedSampleTimeWindows[i].mNumEntries = 0;
+        mSortedSampleTimeWindows[i].mEntries = NULL;
+    }
     mSampleIterator = new SampleIterator(this);
 }
 
@@ -145,6 +310,9 @@ SampleTable::~SampleTable() {
     delete[] mSampleToChunkEntries;
     mSampleToChunkEntries = NULL;
 
+    delete[] mSampleToChunkFirstSamples;
+    mSampleToChunkFirstSamples = NULL;
+
     delete[] mSyncSamples;
     mSyncSamples = NULL;
 
@@ -157,8 +325,16 @@ SampleTable::~SampleTable() {
     delete[] mCompositionTimeDeltaEntries;
     mCompositionTimeDeltaEntries = NULL;
 
-    delete[] mSampleTimeEntries;
-    mSampleTimeEntries = NULL;
+    delete[] mSampleTimeBlocks;
+    mSampleTimeBlocks = NULL;
+
+    delete[] mSampleTimeWindows;
+    mSampleTimeWindows = NULL;
+
+    for (size_t i = 0; i < kNumSortedSampleTimeWindows; ++i) {
+        delete[] mSortedSampleTimeWindows[i].mEntries;
+        mSortedSampleTimeWindows[i].mEntries = NULL;
+    }
 
     delete mSampleIterator;
     mSampleIterator = NULL;
@@ -306,9 +482,48 @@ status_t SampleTable::setSampleToChunkParams(
         mSampleToChunkEntries[i].chunkDesc = U32_AT(&buffer[8]);
     }
 
+    buildSampleToChunkFirstSamples();
+
     return OK;
 }
 
+void SampleTable::buildSampleToChunkFirstSamples() {
+    // Optional: without it, SampleIterator walks the sample-to-chunk table from the start.
+    uint64_t allocSize = (uint64_t)mNumSampleToChunkOffsets * sizeof(uint32_t);
+    if (mTotalSize + allocSize > kMaxTotalSize) {
+        return;
+    }
+
+    mSampleToChunkFirstSamples = new (std::nothrow) uint32_t[mNumSampleToChunkOffsets];
+    if (!mSampleToChunkFirstSamples) {
+        return;
+    }
+    mTotalSize += allocSize;
+
+    // Stop after the first entry that SampleIterator::findChunkRange() rejects,
+    // so that seeking past it fails in the same way.
+    uint32_t firstSample = 0;
+    while (mNumSampleToChunkFirstSamples < mNumSampleToChunkOffsets) {
+        const SampleToChunkEntry *entry =
+            &mSampleToChunkEntries[mNumSampleToChunkFirstSamples];
+        mSampleToChunkFirstSamples[mNumSampleToChunkFirstSamples++] = firstSample;
+
+        if (mNumSampleToChunkFirstSamples == mNumSampleToChunkOffsets) {
+            break;
+        }
+
+        uint32_t firstChunk = entry->startChunk;
+        uint32_t stopChunk = entry[1].startChunk;
+        uint32_t samplesPerChunk = entry->samplesPerChunk;
+        if (samplesPerChunk == 0 || stopChunk < firstChunk ||
+            (stopChunk - firstChunk) > UINT32_MAX / samplesPerChunk ||
+            ((stopChunk - firstChunk) * samplesPerChunk > UINT32_MAX - firstSample)) {
+            break;
+        }
+        firstSample += (stopChunk - firstChunk) * samplesPerChunk;
+    }
+}
+
 status_t SampleTable::setSampleSizeParams(
         uint32_t type, off64_t data_offset, size_t data_size) {
     if (mSampleSizeOffset >= 0) {
@@ -336,6 +551,7 @@ status_t SampleTable::setSampleSizeParams(
 
     mDefaultSampleSize = U32_AT(&header[4]);
     mNumSampleSizes = U32_AT(&header[8]);
+    mMaxSampleSize = 0;
     if (mNumSampleSizes > (UINT32_MAX - 12) / 16) {
         ALOGE("b/23247055, mNumSampleSizes(%u)", mNumSampleSizes);
         return ERROR_MALFORMED;
@@ -593,21 +809,39 @@ uint32_t SampleTable::countSamples() const {
 status_t SampleTable::getMaxSampleSize(size_t *max_size) {
     Mutex::Autolock autoLock(mLock);
 
+    // The result is shared by all the sources of the track.
+    if (mMaxSampleSize > 0) {
+        *max_size = mMaxSampleSize;
+        return OK;
+    }
+
     *max_size = 0;
 
-    for (uint32_t i = 0; i < mNumSampleSizes; ++i) {
-        size_t sample_size;
-        status_t err = getSampleSize_l(i, &sample_size);
+    if (mDefaultSampleSize > 0) {
+        if (mNumSampleSizes > 0) {
+            *max_size = mDefaultSampleSize;
+        }
+        return OK;
+    }
+
+    static const uint32_t kNumSamplesPerRead = 4096;
+    Vector<size_t> sampleSizes;
+    for (uint32_t i = 0; i < mNumSampleSizes; i += sampleSizes.size()) {
+        status_t err = mSampleIterator->getSampleSizesDirect(
+                i, std::min(kNumSamplesPerRead, mNumSampleSizes - i), &sampleSizes);
 
         if (err != OK) {
             return err;
         }
 
-        if (sample_size > *max_size) {
-            *max_size = sample_size;
+        for (size_t j = 0; j < sampleSizes.size(); ++j) {
+            if (sampleSizes[j] > *max_size) {
+                *max_size = sampleSizes[j];
+            }
         }
     }
 
+    mMaxSampleSize = *max_size;
     return OK;
 }
 
@@ -615,140 +849,226 @@ uint32_t abs_difference(uint64_t time1, uint64_t time2) {
     return time1 > time2 ? time1 - time2 : time2 - time1;
 }
 
-// static
-int SampleTable::CompareIncreasingTime(const void *_a, const void *_b) {
-    const SampleTimeEntry *a = (const SampleTimeEntry *)_a;
-    const SampleTimeEntry *b = (const SampleTimeEntry *)_b;
+status_t SampleTable::buildSampleTimeIndex_l() {
+    if (mSampleTimeWindows != NULL) {
+        return OK;
+    }
 
-    if (a->mCompositionTime < b->mCompositionTime) {
-        return -1;
-    } else if (a->mCompositionTime > b->mCompositionTime) {
-        return 1;
+    if (mNumSampleSizes == 0) {
+        ALOGE("b/23247055, mNumSampleSizes(%u)", mNumSampleSizes);
+        return ERROR_MALFORMED;
     }
 
-    return 0;
-}
+    uint32_t numBlocks = (mNumSampleSizes - 1) / kSampleTimeBlockSize + 1;
+    uint64_t allocSize =
+            (uint64_t)numBlocks * (sizeof(SampleTimeBlock) + sizeof(SampleTimeWindow));
+    if (mTotalSize + allocSize > kMaxTotalSize) {
+        ALOGE("Sample time index size would make sample table too large.\n"
+              "    Requested sample time index size = %llu\n"
+              "    Eventual sample table size >= %llu\n"
+              "    Allowed sample table size = %llu\n",
+              (unsigned long long)allocSize,
+              (unsigned long long)(mTotalSize + allocSize),
+              (unsigned long long)kMaxTotalSize);
+        return ERROR_OUT_OF_RANGE;
+    }
 
-void SampleTable::buildSampleEntriesTable() {
-    Mutex::Autolock autoLock(mLock);
+    std::unique_ptr<SampleTimeBlock[]> blocks(new (std::nothrow) SampleTimeBlock[numBlocks]);
+    std::unique_ptr<SampleTimeWindow[]> windows(new (std::nothrow) SampleTimeWindow[numBlocks]);
+    // Smallest composition time of each block and of all the blocks after it,
+    // and largest composition time of each block.
+    std::unique_ptr<uint64_t[]> minTimes(new (std::nothrow) uint64_t[numBlocks]);
+    std::unique_ptr<uint64_t[]> maxTimes(new (std::nothrow) uint64_t[numBlocks]);
+    if (!blocks || !windows || !minTimes || !maxTimes) {
+        ALOGE("Cannot allocate sample time index with %u blocks.", numBlocks);
+        return ERROR_OUT_OF_RANGE;
+    }
 
-    if (mSampleTimeEntries != NULL || mNumSampleSizes == 0) {
-        if (mNumSampleSizes == 0) {
-            ALOGE("b/23247055, mNumSampleSizes(%u)", mNumSampleSizes);
+    SampleTimeCursor cursor(this);
+    for (uint32_t i = 0; i < numBlocks; ++i) {
+        cursor.getBlock(&blocks[i]);
+
+        uint32_t numSamples =
+            std::min(kSampleTimeBlockSize, mNumSampleSizes - i * kSampleTimeBlockSize);
+        minTimes[i] = UINT64_MAX;
+        maxTimes[i] = 0;
+        for (uint32_t j = 0; j < numSamples; ++j) {
+            uint64_t compositionTime = cursor.next();
+            minTimes[i] = std::min(minTimes[i], compositionTime);
+            maxTimes[i] = std::max(maxTimes[i], compositionTime);
         }
-        return;
     }
 
-    mTotalSize += (uint64_t)mNumSampleSizes * sizeof(SampleTimeEntry);
-    if (mTotalSize > kMaxTotalSize) {
+    for (uint32_t i = numBlocks - 1; i > 0; --i) {
+        minTimes[i - 1] = std::min(minTimes[i - 1], minTimes[i]);
+    }
+
+    // A new window starts at each block whose samples are all presented after those of
+    // the previous blocks, which is almost every block unless the content is malformed.
+    uint32_t numWindows = 0;
+    uint64_t maxTime = 0;
+    for (uint32_t i = 0; i < numBlocks; ++i) {
+        if (i == 0 || maxTime <= minTimes[i]) {
+            windows[numWindows].mFirstBlock = i;
+            windows[numWindows].mCompositionTime = minTimes[i];
+            ++numWindows;
+        }
+        maxTime = std::max(maxTime, maxTimes[i]);
+    }
+
+    ALOGV("sample time index: %u samples, %u blocks, %u windows",
+            mNumSampleSizes, numBlocks, numWindows);
+
+    mTotalSize += allocSize;
+    mSampleTimeBlocks = blocks.release();
+    mNumSampleTimeBlocks = numBlocks;
+    mSampleTimeWindows = windows.release();
+    mNumSampleTimeWindows = numWindows;
+    return OK;
+}
+
+status_t SampleTable::sortSampleTimeWindow_l(
+        uint32_t window, const SortedSampleTimeWindow **sorted) {
+    for (size_t i = 0; i < kNumSortedSampleTimeWindows; ++i) {
+        if (mSortedSampleTimeWindows[i].mEntries != NULL
+                && mSortedSampleTimeWindows[i].mWindow == window) {
+            std::rotate(&mSortedSampleTimeWindows[0], &mSortedSampleTimeWindows[i],
+                    &mSortedSampleTimeWindows[i + 1]);
+            *sorted = &mSortedSampleTimeWindows[0];
+            return OK;
+        }
+    }
+
+    uint32_t firstBlock = mSampleTimeWindows[window].mFirstBlock;
+    uint32_t firstSample = firstBlock * kSampleTimeBlockSize;
+    uint32_t stopSample = window + 1 < mNumSampleTimeWindows
+            ? mSampleTimeWindows[window + 1].mFirstBlock * kSampleTimeBlockSize
+            : mNumSampleSizes;
+    uint32_t numEntries = stopSample - firstSample;
+
+    // Replace the least recently used window.
+    SortedSampleTimeWindow *last = &mSortedSampleTimeWindows[kNumSortedSampleTimeWindows - 1];
+    if (last->mEntries != NULL) {
+        mTotalSize -= (uint64_t)last->mNumEntries * sizeof(SampleTimeEntry);
+        delete[] last->mEntries;
+        last->mEntries = NULL;
+    }
+
+    uint64_t allocSize = (uint64_t)numEntries * sizeof(SampleTimeEntry);
+    if (mTotalSize + allocSize > kMaxTotalSize) {
         ALOGE("Sample entry table size would make sample table too large.\n"
               "    Requested sample entry table size = %llu\n"
               "    Eventual sample table size >= %llu\n"
               "    Allowed sample table size = %llu\n",
-              (unsigned long long)mNumSampleSizes * sizeof(SampleTimeEntry),
-              (unsigned long long)mTotalSize,
+              (unsigned long long)allocSize,
+              (unsigned long long)(mTotalSize + allocSize),
               (unsigned long long)kMaxTotalSize);
-        return;
+        return ERROR_OUT_OF_RANGE;
     }
 
-    mSampleTimeEntries = new (std::nothrow) SampleTimeEntry[mNumSampleSizes];
-
-    if (!mSampleTimeEntries) {
+    SampleTimeEntry *entries = new (std::nothrow) SampleTimeEntry[numEntries];
+    if (!entries) {
         ALOGE("Cannot allocate sample entry table with %llu entries.",
-                (unsigned long long)mNumSampleSizes);
-        return;
+                (unsigned long long)numEntries);
+        return ERROR_OUT_OF_RANGE;
     }
-    memset(mSampleTimeEntries, 0, sizeof(SampleTimeEntry) * mNumSampleSizes);
-
-    uint32_t sampleIndex = 0;
-    uint64_t sampleTime = 0;
-
-    for (uint32_t i = 0; i < mTimeToSampleCount; ++i) {
-        uint32_t n = mTimeToSample[2 * i];
-        uint32_t delta = mTimeToSample[2 * i + 1];
-
-        for (uint32_t j = 0; j < n; ++j) {
-            if (sampleIndex < mNumSampleSizes) {
-                // Technically this should always be the case if the file
-                // is well-formed, but you know... there's (gasp) malformed
-                // content out there.
-
-                mSampleTimeEntries[sampleIndex].mSampleIndex = sampleIndex;
-
-                int32_t compTimeDelta =
-                    mCompositionDeltaLookup->getCompositionTimeOffset(
-                            sampleIndex);
-
-                if ((compTimeDelta < 0 && sampleTime <
-                        (compTimeDelta == INT32_MIN ?
-                                INT32_MAX : uint32_t(-compTimeDelta)))
-                        || (compTimeDelta > 0 &&
-                                sampleTime > UINT64_MAX - compTimeDelta)) {
-                    ALOGE("%llu + %d would overflow, clamping",
-                            (unsigned long long) sampleTime, compTimeDelta);
-                    if (compTimeDelta < 0) {
-                        sampleTime = 0;
-                    } else {
-                        sampleTime = UINT64_MAX;
-                    }
-                    compTimeDelta = 0;
-                }
-
-                mSampleTimeEntries[sampleIndex].mCompositionTime =
-                        compTimeDelta > 0 ? sampleTime + compTimeDelta:
-                                sampleTime - (-compTimeDelta);
-            }
+    mTotalSize += allocSize;
 
-            ++sampleIndex;
-            if (sampleTime > UINT64_MAX - delta) {
-                ALOGE("%llu + %u would overflow, clamping",
-                    (unsigned long long) sampleTime, delta);
-                sampleTime = UINT64_MAX;
-            } else {
-                sampleTime += delta;
-            }
-        }
+    SampleTimeCursor cursor(this);
+    cursor.seek(firstSample, mSampleTimeBlocks[firstBlock]);
+    for (uint32_t i = 0; i < numEntries; ++i) {
+        entries[i].mSampleIndex = firstSample + i;
+        entries[i].mCompositionTime = cursor.next();
+    }
+
+    std::sort(entries, entries + numEntries,
+            [](const SampleTimeEntry &a, const SampleTimeEntry &b) {
+                return a.mCompositionTime < b.mCompositionTime
+                        || (a.mCompositionTime == b.mCompositionTime
+                                && a.mSampleIndex < b.mSampleIndex);
+            });
+
+    last->mWindow = window;
+    last->mNumEntries = numEntries;
+    last->mEntries = entries;
+    std::rotate(&mSortedSampleTimeWindows[0], last, last + 1);
+    *sorted = &mSortedSampleTimeWindows[0];
+    return OK;
+}
+
+status_t SampleTable::getSampleTimeEntry_l(uint32_t position, SampleTimeEntry *entry) {
+    // The last window starting at or before position.
+    const SampleTimeWindow *window = std::upper_bound(
+            mSampleTimeWindows, mSampleTimeWindows + mNumSampleTimeWindows, position,
+            [](uint32_t position, const SampleTimeWindow &window) {
+                return position < (uint64_t)window.mFirstBlock * kSampleTimeBlockSize;
+            }) - 1;
+
+    const SortedSampleTimeWindow *sorted;
+    status_t err = sortSampleTimeWindow_l(window - mSampleTimeWindows, &sorted);
+    if (err != OK) {
+        return err;
     }
 
-    qsort(mSampleTimeEntries, mNumSampleSizes, sizeof(SampleTimeEntry),
-          CompareIncreasingTime);
+    *entry = sorted->mEntries[position - window->mFirstBlock * kSampleTimeBlockSize];
+    return OK;
 }
 
 status_t SampleTable::findSampleAtTime(
         uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
         uint32_t *sample_index, uint32_t flags) {
-    buildSampleEntriesTable();
+    Mutex::Autolock autoLock(mLock);
 
-    if (mSampleTimeEntries == NULL) {
+    if (buildSampleTimeIndex_l() != OK) {
         return ERROR_OUT_OF_RANGE;
     }
 
+    SampleTimeEntry entry;
+    status_t err;
+
     if (flags == kFlagFrameIndex) {
         if (req_time >= mNumSampleSizes) {
             return ERROR_OUT_OF_RANGE;
         }
-        *sample_index = mSampleTimeEntries[req_time].mSampleIndex;
+        if ((err = getSampleTimeEntry_l(req_time, &entry)) != OK) {
+            return err;
+        }
+        *sample_index = entry.mSampleIndex;
         return OK;
     }
 
-    uint32_t left = 0;
-    uint32_t right_plus_one = mNumSampleSizes;
-    while (left < right_plus_one) {
-        uint32_t center = left + (right_plus_one - left) / 2;
-        uint64_t centerTime =
-            getSampleTime(center, scale_num, scale_den);
+    // All the samples of the windows from the first one presented after req_time are
+    // presented after req_time, and all the samples of the windows before the previous
+    // one are presented before or at the first sample of the previous one.
+    uint32_t window = std::upper_bound(
+            mSampleTimeWindows, mSampleTimeWindows + mNumSampleTimeWindows, req_time,
+            [scale_num, scale_den](uint64_t time, const SampleTimeWindow &window) {
+                return time < scaleTime(window.mCompositionTime, scale_num, scale_den);
+            }) - mSampleTimeWindows;
+
+    uint32_t closestIndex = 0;
+    if (window > 0) {
+        --window;
+        const SortedSampleTimeWindow *sorted;
+        if ((err = sortSampleTimeWindow_l(window, &sorted)) != OK) {
+            return err;
+        }
 
-        if (req_time < centerTime) {
-            right_plus_one = center;
-        } else if (req_time > centerTime) {
-            left = center + 1;
-        } else {
-            *sample_index = mSampleTimeEntries[center].mSampleIndex;
+        const SampleTimeEntry *first = sorted->mEntries;
+        const SampleTimeEntry *last = first + sorted->mNumEntries;
+        const SampleTimeEntry *closest = std::lower_bound(first, last, req_time,
+                [scale_num, scale_den](const SampleTimeEntry &entry, uint64_t time) {
+                    return scaleTime(entry.mCompositionTime, scale_num, scale_den) < time;
+                });
+        if (closest != last
+                && scaleTime(closest->mCompositionTime, scale_num, scale_den) == req_time) {
+            *sample_index = closest->mSampleIndex;
             return OK;
         }
-    }
 
-    uint32_t closestIndex = left;
+        closestIndex = mSampleTimeWindows[window].mFirstBlock * kSampleTimeBlockSize
+                + (closest - first);
+    }
 
     if (closestIndex == mNumSampleSizes) {
         if (flags == kFlagAfter) {
@@ -782,17 +1102,25 @@ status_t SampleTable::findSampleAtTime(
         {
             CHECK(flags == kFlagClosest);
             // pick closest based on timestamp. use abs_difference for safety
+            SampleTimeEntry before;
+            if ((err = getSampleTimeEntry_l(closestIndex, &entry)) != OK
+                    || (err = getSampleTimeEntry_l(closestIndex - 1, &before)) != OK) {
+                return err;
+            }
             if (abs_difference(
-                    getSampleTime(closestIndex, scale_num, scale_den), req_time) >
+                    scaleTime(entry.mCompositionTime, scale_num, scale_den), req_time) >
                 abs_difference(
-                    req_time, getSampleTime(closestIndex - 1, scale_num, scale_den))) {
+                    req_time, scaleTime(before.mCompositionTime, scale_num, scale_den))) {
                 --closestIndex;
             }
             break;
         }
     }
 
-    *sample_index = mSampleTimeEntries[closestIndex].mSampleIndex;
+    if ((err = getSampleTimeEntry_l(closestIndex, &entry)) != OK) {
+        return err;
+    }
+    *sample_index = entry.mSampleIndex;
     return OK;
 }
 
@@ -986,9 +1314,8 @@ status_t SampleTable::getMetaDataForSample(
                     && (mSyncSamples[mLastSyncSampleIndex] <= sampleIndex)
                 ? mLastSyncSampleIndex : 0;
 
-            while (i < mNumSyncSamples && mSyncSamples[i] < sampleIndex) {
-                ++i;
-            }
+            i = std::lower_bound(mSyncSamples + i, mSyncSamples + mNumSyncSamples,
+                    sampleIndex) - mSyncSamples;
 
             if (i < mNumSyncSamples && mSyncSamples[i] == sampleIndex) {
                 *isSyncSample = true;
@@ -1006,7 +1333,316 @@ status_t SampleTable::getMetaDataForSample(
 }
 
 int32_t SampleTable::getCompositionTimeOffset(uint32_t sampleIndex) {
-    return mCompositionDeltaLookup->getCompositionTimeOffset(sampleIndex);
+    return mCompositionDeltaLookup->getCompositionTimeOffset(
+            sampleIndex, getSampleTimeBlock_l(sampleIndex));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Layout of the data written by SampleTable::writeIndex(). The data is only read back
+// on the same device, so values are written in native byte order.
+const uint32_t kIndexVersion = 1;
+
+struct IndexWriter {
+    explicit IndexWriter(std::string *data) : mData(data) {}
+
+    template <typename T>
+    void write(T value) {
+        mData->append((const char *)&value, sizeof(value));
+    }
+
+    template <typename T>
+    void writeArray(const T *values, size_t count) {
+        if (count > 0) {
+            mData->append((const char *)values, count * sizeof(T));
+        }
+    }
+
+private:
+    std::string *mData;
+};
+
+struct IndexReader {
+    IndexReader(const void *data, size_t size)
+        : mData((const uint8_t *)data), mSize(size) {}
+
+    template <typename T>
+    bool read(T *value) {
+        return readArray(value, 1);
+    }
+
+    template <typename T>
+    bool readArray(T *values, size_t count) {
+        if (count > mSize / sizeof(T)) {
+            return false;
+        }
+        memcpy(values, mData, count * sizeof(T));
+        mData += count * sizeof(T);
+        mSize -= count * sizeof(T);
+        return true;
+    }
+
+    // Allocates a table of count values and reads them, adding its size to *totalSize.
+    template <typename T>
+    bool readTable(T **table, size_t count, uint64_t *totalSize, uint64_t maxTotalSize) {
+        if (count > mSize / sizeof(T)) {
+            return false;
+        }
+        *totalSize += (uint64_t)count * sizeof(T);
+        if (*totalSize > maxTotalSize) {
+            return false;
+        }
+        *table = new (std::nothrow) T[count];
+        return *table != NULL && readArray(*table, count);
+    }
+
+    bool atEnd() const {
+        return mSize == 0;
+    }
+
+private:
+    const uint8_t *mData;
+    size_t mSize;
+};
+
+}  // namespace
+
+status_t SampleTable::writeIndex(std::string *data) {
+    if (!isValid()) {
+        return ERROR_MALFORMED;
+    }
+
+    size_t maxSampleSize;
+    status_t err = getMaxSampleSize(&maxSampleSize);
+    if (err != OK) {
+        return err;
+    }
+
+    Mutex::Autolock autoLock(mLock);
+
+    // The index is built on the first seek otherwise, save it too.
+    err = buildSampleTimeIndex_l();
+    if (err != OK) {
+        return err;
+    }
+
+    IndexWriter writer(data);
+    writer.write(kIndexVersion);
+
+    writer.write((int64_t)mChunkOffsetOffset);
+    writer.write(mChunkOffsetType);
+    writer.write(mNumChunkOffsets);
+
+    writer.write((int64_t)mSampleToChunkOffset);
+    writer.write(mNumSampleToChunkOffsets);
+    for (uint32_t i = 0; i < mNumSampleToChunkOffsets; ++i) {
+        writer.write(mSampleToChunkEntries[i].startChunk);
+        writer.write(mSampleToChunkEntries[i].samplesPerChunk);
+        writer.write(mSampleToChunkEntries[i].chunkDesc);
+    }
+
+    writer.write((int64_t)mSampleSizeOffset);
+    writer.write(mSampleSizeFieldSize);
+    writer.write(mDefaultSampleSize);
+    writer.write(mNumSampleSizes);
+    writer.write((uint64_t)maxSampleSize);
+
+    writer.write(mTimeToSampleCount);
+    writer.writeArray(mTimeToSample, 2 * (size_t)mTimeToSampleCount);
+
+    uint8_t hasCompositionTimeDeltas = mCompositionTimeDeltaEntries != NULL;
+    writer.write(hasCompositionTimeDeltas);
+    if (hasCompositionTimeDeltas) {
+        writer.write((uint64_t)mNumCompositionTimeDeltaEntries);
+        writer.writeArray(mCompositionTimeDeltaEntries, 2 * mNumCompositionTimeDeltaEntries);
+    }
+
+    writer.write((int64_t)mSyncSampleOffset);
+    writer.write(mNumSyncSamples);
+    writer.writeArray(mSyncSamples, mNumSyncSamples);
+
+    writer.write(mNumSampleTimeBlocks);
+    for (uint32_t i = 0; i < mNumSampleTimeBlocks; ++i) {
+        const SampleTimeBlock &block = mSampleTimeBlocks[i];
+        writer.write(block.mSampleTime);
+        writer.write(block.mTimeToSampleIndex);
+        writer.write(block.mTimeToSampleSampleIndex);
+        writer.write(block.mTimeToSampleTime);
+        writer.write(block.mCompositionDeltaIndex);
+        writer.write(block.mCompositionDeltaSampleIndex);
+    }
+    writer.write(mNumSampleTimeWindows);
+    for (uint32_t i = 0; i < mNumSampleTimeWindows; ++i) {
+        writer.write(mSampleTimeWindows[i].mFirstBlock);
+        writer.write(mSampleTimeWindows[i].mCompositionTime);
+    }
+
+    return OK;
+}
+
+status_t SampleTable::readIndex(const void *data, size_t size) {
+    if (mChunkOffsetOffset >= 0 || mSampleToChunkOffset >= 0 || mSampleSizeOffset >= 0
+            || mHasTimeToSample || mCompositionTimeDeltaEntries != NULL
+            || mSyncSampleOffset >= 0) {
+        return ERROR_MALFORMED;
+    }
+
+    Mutex::Autolock autoLock(mLock);
+
+    // The data was written by writeIndex() for a table that was parsed successfully,
+    // the checks below only make sure that it cannot be used to read out of bounds.
+    IndexReader reader(data, size);
+    uint32_t version;
+    int64_t chunkOffsetOffset;
+    if (!reader.read(&version) || version != kIndexVersion
+            || !reader.read(&chunkOffsetOffset) || chunkOffsetOffset < 0
+            || !reader.read(&mChunkOffsetType)
+            || (mChunkOffsetType != kChunkOffsetType32
+                    && mChunkOffsetType != kChunkOffsetType64)
+            || !reader.read(&mNumChunkOffsets)) {
+        return ERROR_MALFORMED;
+    }
+    mChunkOffsetOffset = chunkOffsetOffset;
+
+    int64_t sampleToChunkOffset;
+    if (!reader.read(&sampleToChunkOffset) || sampleToChunkOffset < 0
+            || !reader.read(&mNumSampleToChunkOffsets)
+            || (uint64_t)mNumSampleToChunkOffsets * sizeof(SampleToChunkEntry)
+                    > kMaxTotalSize) {
+        return ERROR_MALFORMED;
+    }
+    mSampleToChunkOffset = sampleToChunkOffset;
+    mTotalSize += (uint64_t)mNumSampleToChunkOffsets * sizeof(SampleToChunkEntry);
+    mSampleToChunkEntries =
+        new (std::nothrow) SampleToChunkEntry[mNumSampleToChunkOffsets];
+    if (!mSampleToChunkEntries) {
+        return ERROR_OUT_OF_RANGE;
+    }
+    for (uint32_t i = 0; i < mNumSampleToChunkOffsets; ++i) {
+        SampleToChunkEntry *entry = &mSampleToChunkEntries[i];
+        if (!reader.read(&entry->startChunk) || entry->startChunk == UINT32_MAX
+                || !reader.read(&entry->samplesPerChunk)
+                || !reader.read(&entry->chunkDesc)) {
+            return ERROR_MALFORMED;
+        }
+    }
+    buildSampleToChunkFirstSamples();
+
+    int64_t sampleSizeOffset;
+    uint64_t maxSampleSize;
+    if (!reader.read(&sampleSizeOffset) || sampleSizeOffset < 0
+            || !reader.read(&mSampleSizeFieldSize)
+            || !reader.read(&mDefaultSampleSize)
+            || !reader.read(&mNumSampleSizes)
+            || !reader.read(&maxSampleSize) || maxSampleSize > SIZE_MAX) {
+        return ERROR_MALFORMED;
+    }
+    if (mSampleSizeFieldSize != 32 && (mDefaultSampleSize != 0
+            || (mSampleSizeFieldSize != 4 && mSampleSizeFieldSize != 8
+                    && mSampleSizeFieldSize != 16))) {
+        return ERROR_MALFORMED;
+    }
+    mSampleSizeOffset = sampleSizeOffset;
+    mMaxSampleSize = maxSampleSize;
+
+    if (!reader.read(&mTimeToSampleCount)
+            || !reader.readTable(&mTimeToSample, 2 * (size_t)mTimeToSampleCount,
+                    &mTotalSize, kMaxTotalSize)) {
+        return ERROR_MALFORMED;
+    }
+    mHasTimeToSample = true;
+
+    uint8_t hasCompositionTimeDeltas;
+    if (!reader.read(&hasCompositionTimeDeltas)) {
+        return ERROR_MALFORMED;
+    }
+    if (hasCompositionTimeDeltas) {
+        uint64_t numEntries;
+        if (!reader.read(&numEntries) || numEntries > SIZE_MAX / 8
+                || !reader.readTable(&mCompositionTimeDeltaEntries, 2 * numEntries,
+                        &mTotalSize, kMaxTotalSize)) {
+            return ERROR_MALFORMED;
+        }
+        mNumCompositionTimeDeltaEntries = numEntries;
+        mCompositionDeltaLookup->setEntries(
+                mCompositionTimeDeltaEntries, mNumCompositionTimeDeltaEntries);
+    }
+
+    int64_t syncSampleOffset;
+    if (!reader.read(&syncSampleOffset) || !reader.read(&mNumSyncSamples)
+            || (syncSampleOffset < 0 && mNumSyncSamples != 0)
+            || !reader.readTable(&mSyncSamples, mNumSyncSamples,
+                    &mTotalSize, kMaxTotalSize)) {
+        return ERROR_MALFORMED;
+    }
+    mSyncSampleOffset = syncSampleOffset < 0 ? -1 : syncSampleOffset;
+
+    uint32_t numBlocks;
+    if (!reader.read(&numBlocks) || (numBlocks != 0 && (mNumSampleSizes == 0
+            || numBlocks != (mNumSampleSizes - 1) / kSampleTimeBlockSize + 1))) {
+        return ERROR_MALFORMED;
+    }
+    uint64_t allocSize =
+            (uint64_t)numBlocks * (sizeof(SampleTimeBlock) + sizeof(SampleTimeWindow));
+    mTotalSize += allocSize;
+    if (mTotalSize > kMaxTotalSize) {
+        return ERROR_OUT_OF_RANGE;
+    }
+    std::unique_ptr<SampleTimeBlock[]> blocks(new (std::nothrow) SampleTimeBlock[numBlocks]);
+    std::unique_ptr<SampleTimeWindow[]> windows(new (std::nothrow) SampleTimeWindow[numBlocks]);
+    if (!blocks || !windows) {
+        return ERROR_OUT_OF_RANGE;
+    }
+    for (uint32_t i = 0; i < numBlocks; ++i) {
+        SampleTimeBlock &block = blocks[i];
+        if (!reader.read(&block.mSampleTime)
+                || !reader.read(&block.mTimeToSampleIndex)
+                || block.mTimeToSampleIndex > mTimeToSampleCount
+                || !reader.read(&block.mTimeToSampleSampleIndex)
+                || !reader.read(&block.mTimeToSampleTime)
+                || !reader.read(&block.mCompositionDeltaIndex)
+                || block.mCompositionDeltaIndex > mNumCompositionTimeDeltaEntries
+                || !reader.read(&block.mCompositionDeltaSampleIndex)) {
+            return ERROR_MALFORMED;
+        }
+    }
+    uint32_t numWindows;
+    if (!reader.read(&numWindows) || numWindows > numBlocks
+            || (numBlocks > 0 && numWindows == 0)) {
+        return ERROR_MALFORMED;
+    }
+    for (uint32_t i = 0; i < numWindows; ++i) {
+        SampleTimeWindow &window = windows[i];
+        if (!reader.read(&window.mFirstBlock)
+                || !reader.read(&window.mCompositionTime)
+                || window.mFirstBlock >= numBlocks
+                || (i == 0 ? window.mFirstBlock != 0
+                        : window.mFirstBlock <= windows[i - 1].mFirstBlock)) {
+            return ERROR_MALFORMED;
+        }
+    }
+    if (!reader.atEnd()) {
+        return ERROR_MALFORMED;
+    }
+    if (numBlocks > 0) {
+        mSampleTimeBlocks = blocks.release();
+        mNumSampleTimeBlocks = numBlocks;
+        mSampleTimeWindows = windows.release();
+        mNumSampleTimeWindows = numWindows;
+    }
+
+    // Catch files modified in place: the number of chunks and samples must still match.
+    uint8_t header[12];
+    if (mDataSource->readAt(mChunkOffsetOffset, header, 8) < 8
+            || U32_AT(&header[4]) != mNumChunkOffsets
+            || mDataSource->readAt(mSampleSizeOffset, header, 12) < 12
+            || U32_AT(&header[8]) != mNumSampleSizes) {
+        return ERROR_MALFORMED;
+    }
+
+    return OK;
 }
 
 }  // namespace android
@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/indexcache/IndexCache.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+#include "SampleTable.h"
+
+using namespace android;
+
+// Sample tables of a synthetic 30 fps video track with B-frames: one sync sample
+// every second, 15 samples per chunk. Only the tables are generated, not the media data.
+static constexpr uint32_t kFramesPerSecond = 30;
+static constexpr uint32_t kTimescale = 90000;
+static constexpr uint32_t kSampleDuration = kTimescale / kFramesPerSecond;
+static constexpr uint32_t kSamplesPerChunk = 15;
+
+struct SyntheticTrack {
+    std::vector<uint8_t> data;
+    off64_t stszOffset, stszSize;
+    off64_t stscOffset, stscSize;
+    off64_t stcoOffset, stcoSize;
+    off64_t sttsOffset, sttsSize;
+    off64_t cttsOffset, cttsSize;
+    off64_t stssOffset, stssSize;
+    uint32_t numSamples;
+    size_t numReads;
+};
+
+static void put32(std::vector<uint8_t> *data, uint32_t x) {
+    data->push_back(x >> 24);
+    data->push_back(x >> 16);
+    data->push_back(x >> 8);
+    data->push_back(x);
+}
+
+// Appends a full box payload (version and flags, then the entries) and returns its offset.
+static off64_t beginBox(SyntheticTrack *track, uint32_t numEntries) {
+    off64_t offset = track->data.size();
+    put32(&track->data, 0);
+    put32(&track->data, numEntries);
+    return offset;
+}
+
+static void createTrack(SyntheticTrack *track, uint32_t seconds) {
+    const uint32_t numSamples = seconds * kFramesPerSecond;
+    const uint32_t numChunks = numSamples / kSamplesPerChunk;
+    std::mt19937 random(numSamples);
+    track->numSamples = numSamples;
+    track->numReads = 0;
+
+    // stsz has the default sample size before the count.
+    track->stszOffset = beginBox(track, 0);
+    put32(&track->data, numSamples);
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        put32(&track->data, (i % kFramesPerSecond == 0 ? 60000 : 4000) + random() % 2000);
+    }
+    track->stszSize = track->data.size() - track->stszOffset;
+
+    track->stscOffset = beginBox(track, 1);
+    put32(&track->data, 1);
+    put32(&track->data, kSamplesPerChunk);
+    put32(&track->data, 1);
+    track->stscSize = track->data.size() - track->stscOffset;
+
+    track->stcoOffset = beginBox(track, numChunks);
+    for (uint32_t i = 0; i < numChunks; ++i) {
+        put32(&track->data, i * 100000);
+    }
+    track->stcoSize = track->data.size() - track->stcoOffset;
+
+    track->sttsOffset = beginBox(track, 1);
+    put32(&track->data, numSamples);
+    put32(&track->data, kSampleDuration);
+    track->sttsSize = track->data.size() - track->sttsOffset;
+
+    // I B B P B B P ... in decode order: each I or P frame is presented after
+    // the 2 B frames that follow it.
+    track->cttsOffset = beginBox(track, numSamples);
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        put32(&track->data, 1);
+        put32(&track->data, (i % 3 == 0 ? 3 : 0) * kSampleDuration);
+    }
+    track->cttsSize = track->data.size() - track->cttsOffset;
+
+    track->stssOffset = beginBox(track, seconds);
+    for (uint32_t i = 0; i < seconds; ++i) {
+        put32(&track->data, i * kFramesPerSecond + 1);
+    }
+    track->stssSize = track->data.size() - track->stssOffset;
+}
+
+static ssize_t readAt(void *handle, off64_t offset, void *data, size_t size) {
+    SyntheticTrack *track = (SyntheticTrack *)handle;
+    ++track->numReads;
+    if (offset < 0 || (size_t)offset >= track->data.size()) {
+        return 0;
+    }
+    size = std::min(size, track->data.size() - (size_t)offset);
+    memcpy(data, &track->data[offset], size);
+    return size;
+}
+
+static status_t getSize(void *handle, off64_t *size) {
+    *size = ((SyntheticTrack *)handle)->data.size();
+    return OK;
+}
+
+static uint32_t flags(void *) {
+    return 0;
+}
+
+static bool getUri(void *, char *, size_t) {
+    return false;
+}
+
+// Does what MPEG4Extractor does for the track when parsing its stbl box.
+static sp<SampleTable> openTrack(DataSourceHelper *source, SyntheticTrack *track) {
+    sp<SampleTable> table = new SampleTable(source);
+    size_t maxSampleSize;
+    if (table->setSampleSizeParams(FOURCC("stsz"), track->stszOffset, track->stszSize) != OK
+            || table->getMaxSampleSize(&maxSampleSize) != OK
+            || table->setSampleToChunkParams(track->stscOffset, track->stscSize) != OK
+            || table->setChunkOffsetParams(
+                    FOURCC("stco"), track->stcoOffset, track->stcoSize) != OK
+            || table->setTimeToSampleParams(track->sttsOffset, track->sttsSize) != OK
+            || table->setCompositionTimeToSampleParams(
+                    track->cttsOffset, track->cttsSize) != OK
+            || table->setSyncSampleParams(track->stssOffset, track->stssSize) != OK) {
+        return nullptr;
+    }
+    return table;
+}
+
+// Seeks as MPEG4Source::read() does for a SEEK_PREVIOUS_SYNC seek.
+static bool seekTrack(const sp<SampleTable> &table, uint64_t timeUs) {
+    uint32_t sampleIndex;
+    uint32_t syncSampleIndex;
+    off64_t offset;
+    size_t size;
+    uint64_t compositionTime;
+    return table->findSampleAtTime(timeUs, kTimescale, 1000000, &sampleIndex,
+                    SampleTable::kFlagBefore) == OK
+            && table->findSyncSampleNear(sampleIndex, &syncSampleIndex,
+                    SampleTable::kFlagBefore) == OK
+            && table->getMetaDataForSample(syncSampleIndex, &offset, &size,
+                    &compositionTime) == OK;
+}
+
+// Time to parse the sample tables of the track and to do the first seek,
+// which builds the sample time index.
+static void BM_SampleTableOpen(benchmark::State& state) {
+    SyntheticTrack track;
+    createTrack(&track, state.range(0));
+    CDataSource csource = {readAt, getSize, flags, getUri, &track};
+    DataSourceHelper source(&csource);
+
+    for (auto _ : state) {
+        sp<SampleTable> table = openTrack(&source, &track);
+        if (table == nullptr || !seekTrack(table, 0)) {
+            state.SkipWithError("cannot open track");
+            return;
+        }
+    }
+
+    state.counters["samples"] = track.numSamples;
+    state.counters["reads"] = benchmark::Counter(
+            track.numReads, benchmark::Counter::kAvgIterations);
+}
+
+// Same as BM_SampleTableOpen, when the track was opened before: the sample tables
+// and the sample time index are restored from an IndexCache.
+static void BM_SampleTableReopen(benchmark::State& state) {
+    SyntheticTrack track;
+    createTrack(&track, state.range(0));
+    CDataSource csource = {readAt, getSize, flags, getUri, &track};
+    DataSourceHelper source(&csource);
+
+#ifdef __ANDROID__
+    std::string dir = "/data/local/tmp/indexcacheXXXXXX";
+#else
+    const char *tmpDir = getenv("TMPDIR");
+    std::string dir = std::string(tmpDir != nullptr ? tmpDir : "/tmp") + "/indexcacheXXXXXX";
+#endif
+    if (mkdtemp(&dir[0]) == nullptr) {
+        state.SkipWithError("cannot create cache directory");
+        return;
+    }
+    IndexCache cache(dir.c_str(), IndexCache::kDefaultMaxSize * 4);
+
+    // The first open parses the track and saves it, as MPEG4Extractor does. The source
+    // has no uri, as for a file descriptor, so the key hashes the tables as it would the
+    // moov box.
+    const off64_t moovSize = track.data.size();
+    std::string key;
+    std::string data;
+    sp<SampleTable> table = openTrack(&source, &track);
+    if (!IndexCache::GetFileKey(&source, 0, moovSize, &key) || table == nullptr
+            || table->writeIndex(&data) != OK) {
+        state.SkipWithError("cannot save track");
+        std::filesystem::remove_all(dir);
+        return;
+    }
+    cache.put(key, data);
+
+    track.numReads = 0;
+    for (auto _ : state) {
+        key.clear();
+        data.clear();
+        sp<SampleTable> table = new SampleTable(&source);
+        if (!IndexCache::GetFileKey(&source, 0, moovSize, &key) || !cache.get(key, &data)
+                || table->readIndex(data.data(), data.size()) != OK
+                || !seekTrack(table, 0)) {
+            state.SkipWithError("cannot restore track");
+            break;
+        }
+    }
+
+    state.counters["samples"] = track.numSamples;
+    state.counters["reads"] = benchmark::Counter(
+            track.numReads, benchmark::Counter::kAvgIterations);
+    state.counters["index_bytes"] = data.size();
+    std::filesystem::remove_all(dir);
+}
+
+// Time to seek to a random position, once the track is open.
+static void BM_SampleTableSeek(benchmark::State& state) {
+    SyntheticTrack track;
+    const uint32_t seconds = state.range(0);
+    createTrack(&track, seconds);
+    CDataSource csource = {readAt, getSize, flags, getUri, &track};
+    DataSourceHelper source(&csource);
+    sp<SampleTable> table = openTrack(&source, &track);
+    if (table == nullptr || !seekTrack(table, 0)) {
+        state.SkipWithError("cannot open track");
+        return;
+    }
+
+    std::mt19937 random(seconds);
+    track.numReads = 0;
+    for (auto _ : state) {
+        if (!seekTrack(table, (uint64_t)(random() % seconds) * 1000000 + random() % 1000000)) {
+            state.SkipWithError("cannot seek");
+            return;
+        }
+    }
+
+    state.counters["reads"] = benchmark::Counter(
+            track.numReads, benchmark::Counter::kAvgIterations);
+}
+
+// 1 minute, 1 hour and 4 hours.
+BENCHMARK(BM_SampleTableOpen)->Arg(60)->Arg(60 * 60)->Arg(4 * 60 * 60)
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SampleTableReopen)->Arg(60)->Arg(60 * 60)->Arg(4 * 60 * 60)
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SampleTableSeek)->Arg(60)->Arg(60 * 60)->Arg(4 * 60 * 60);
+
+BENCHMARK_MAIN();
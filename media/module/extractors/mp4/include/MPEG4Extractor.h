@@ -20,6 +20,8 @@
 
 #include <arpa/inet.h>
 
+#include <string>
+
 #include <media/MediaExtractorPluginApi.h>
 #include <media/MediaExtractorPluginHelper.h>
 #include <media/NdkMediaFormat.h>
@@ -33,6 +35,7 @@ namespace android {
 struct AMessage;
 struct CDataSource;
 class DataSourceHelper;
+class IndexCache;
 class SampleTable;
 class String8;
 namespace heif {
@@ -146,6 +149,15 @@ private:
     bool mPreferHeif;
     bool mIsAvif;
 
+    // Sample tables are saved to mIndexCache, if enabled, when the file can be identified.
+    IndexCache *mIndexCache;
+    std::string mIndexCacheFileKey;
+    // True while parsing a stbl box whose sample table was restored from mIndexCache.
+    bool mSampleTableFromIndexCache;
+    // The moov box, which identifies files that cannot be stat()ed in the index cache.
+    off64_t mMoovOffset;
+    uint64_t mMoovSize;
+
     Track *mFirstTrack, *mLastTrack;
 
     AMediaFormat *mFileMetaData;
@@ -188,6 +200,10 @@ private:
     status_t parseALACSampleEntry(off64_t *offset);
     void adjustRawDefaultFrameSize();
 
+    std::string getSampleTableIndexKey(off64_t offset, uint64_t size);
+    bool restoreSampleTable(off64_t offset, uint64_t size);
+    void saveSampleTable(off64_t offset, uint64_t size);
+
     MPEG4Extractor(const MPEG4Extractor &);
     MPEG4Extractor &operator=(const MPEG4Extractor &);
 };
@@ -44,6 +44,11 @@ struct SampleIterator {
     status_t getSampleSizeDirect(
             uint32_t sampleIndex, size_t *size);
 
+    // Reads the sizes of count samples starting at sampleIndex with as few reads as possible.
+    // Fails with ERROR_OUT_OF_RANGE if the samples are not all in the table.
+    status_t getSampleSizesDirect(
+            uint32_t sampleIndex, uint32_t count, Vector<size_t> *sizes);
+
 private:
     SampleTable *mTable;
 
@@ -74,6 +79,7 @@ private:
     uint64_t mCurrentSampleDuration;
 
     void reset();
+    void restartChunkRange(uint32_t sampleIndex);
     status_t findChunkRange(uint32_t sampleIndex);
     status_t getChunkOffset(uint32_t chunk, off64_t *offset);
     status_t findSampleTimeAndDuration(uint32_t sampleIndex, uint64_t *time, uint64_t *duration);
@@ -21,6 +21,8 @@
 #include <sys/types.h>
 #include <stdint.h>
 
+#include <string>
+
 #include <media/MediaExtractorPluginHelper.h>
 #include <media/stagefright/MediaErrors.h>
 #include <utils/RefBase.h>
@@ -89,8 +91,18 @@ public:
 
     status_t findThumbnailSample(uint32_t *sample_index);
 
+    // Appends the tables read from the file and the sample time index to data, so that
+    // another SampleTable for the same stbl box can be restored with readIndex().
+    status_t writeIndex(std::string *data);
+
+    // Restores the tables saved by writeIndex(), instead of calling the set*Params()
+    // methods. The sizes of the tables are checked against the file. If this fails,
+    // the table must be discarded.
+    status_t readIndex(const void *data, size_t size);
+
     void setPredictSampleSize(uint32_t sampleSize) {
         mDefaultSampleSize = sampleSize;
+        mMaxSampleSize = 0;
     }
 
 protected:
@@ -98,6 +110,7 @@ protected:
 
 private:
     struct CompositionDeltaLookup;
+    struct SampleTimeCursor;
 
     static const uint32_t kChunkOffsetType32;
     static const uint32_t kChunkOffsetType64;
@@ -126,11 +139,51 @@ private:
     uint32_t mTimeToSampleCount;
     uint32_t* mTimeToSample;
 
+    // The samples sorted by composition time are not materialized. Instead, the state of the
+    // time tables is saved at the start of every kSampleTimeBlockSize samples in decode order,
+    // and the blocks are grouped into windows: all the samples of a window have a composition
+    // time between those of the previous and of the next window. Only the windows that are
+    // searched are sorted, see buildSampleTimeIndex_l() and getSampleTimeEntry_l().
+    // The table is shared by all MPEG4Sources of the track, and so is the index.
+    static constexpr uint32_t kSampleTimeBlockSize = 1024;
+
     struct SampleTimeEntry {
         uint32_t mSampleIndex;
         uint64_t mCompositionTime;
     };
-    SampleTimeEntry *mSampleTimeEntries;
+
+    struct SampleTimeBlock {
+        // Running decode time, clamped on overflow.
+        uint64_t mSampleTime;
+        // Time-to-sample entry of the first sample of the block, its first sample and its
+        // decode time. mTimeToSampleTime is UINT64_MAX if a SampleIterator cannot restart
+        // from the entry.
+        uint32_t mTimeToSampleIndex;
+        uint32_t mTimeToSampleSampleIndex;
+        uint64_t mTimeToSampleTime;
+        // Composition-time-to-sample entry of the first sample of the block and its first sample.
+        uint32_t mCompositionDeltaIndex;
+        uint32_t mCompositionDeltaSampleIndex;
+    };
+    SampleTimeBlock *mSampleTimeBlocks;
+    uint32_t mNumSampleTimeBlocks;
+
+    struct SampleTimeWindow {
+        uint32_t mFirstBlock;
+        // Smallest composition time of the window.
+        uint64_t mCompositionTime;
+    };
+    SampleTimeWindow *mSampleTimeWindows;
+    uint32_t mNumSampleTimeWindows;
+
+    // The last sorted windows, most recently used first.
+    struct SortedSampleTimeWindow {
+        uint32_t mWindow;
+        uint32_t mNumEntries;
+        SampleTimeEntry *mEntries;
+    };
+    static constexpr size_t kNumSortedSampleTimeWindows = 2;
+    SortedSampleTimeWindow mSortedSampleTimeWindows[kNumSortedSampleTimeWindows];
 
     int32_t *mCompositionTimeDeltaEntries;
     size_t mNumCompositionTimeDeltaEntries;
@@ -150,25 +203,41 @@ private:
     };
     SampleToChunkEntry *mSampleToChunkEntries;
 
+    // First sample of each sample-to-chunk entry, for the first
+    // mNumSampleToChunkFirstSamples entries which are consistent.
+    uint32_t *mSampleToChunkFirstSamples;
+    uint32_t mNumSampleToChunkFirstSamples;
+
+    // Cached result of getMaxSampleSize(), 0 if not computed yet.
+    size_t mMaxSampleSize;
+
     // Approximate size of all tables combined.
     uint64_t mTotalSize;
 
     friend struct SampleIterator;
 
     // normally we don't round
-    inline uint64_t getSampleTime(
-            size_t sample_index, uint64_t scale_num, uint64_t scale_den) const {
-        return (sample_index < (size_t)mNumSampleSizes && mSampleTimeEntries != NULL
-                && scale_den != 0)
-                ? (mSampleTimeEntries[sample_index].mCompositionTime * scale_num) / scale_den : 0;
+    static inline uint64_t scaleTime(uint64_t time, uint64_t scale_num, uint64_t scale_den) {
+        return scale_den != 0 ? (time * scale_num) / scale_den : 0;
     }
 
     status_t getSampleSize_l(uint32_t sample_index, size_t *sample_size);
     int32_t getCompositionTimeOffset(uint32_t sampleIndex);
 
-    static int CompareIncreasingTime(const void *, const void *);
+    void buildSampleToChunkFirstSamples();
 
-    void buildSampleEntriesTable();
+    status_t buildSampleTimeIndex_l();
+
+    // Returns the entry at position in composition time order.
+    status_t getSampleTimeEntry_l(uint32_t position, SampleTimeEntry *entry);
+
+    status_t sortSampleTimeWindow_l(uint32_t window, const SortedSampleTimeWindow **sorted);
+
+    // Returns the block of sampleIndex, or NULL if the time index is not built.
+    const SampleTimeBlock *getSampleTimeBlock_l(uint32_t sampleIndex) const {
+        uint32_t block = sampleIndex / kSampleTimeBlockSize;
+        return block < mNumSampleTimeBlocks ? &mSampleTimeBlocks[block] : NULL;
+    }
 
     SampleTable(const SampleTable &);
     SampleTable &operator=(const SampleTable &);
@@ -0,0 +1,706 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SampleTableTest"
+#include <utils/Log.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+#include "SampleTable.h"
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kTimescale = 90000;
+constexpr uint32_t kSampleDuration = 3000;
+
+// The boxes of a sample table, as the payloads that follow their box headers.
+struct SyntheticFile {
+    std::vector<uint8_t> data;
+    uint32_t stszType = FOURCC("stsz");
+    off64_t stszOffset = -1, stszSize = 0;
+    off64_t stscOffset = -1, stscSize = 0;
+    off64_t stcoOffset = -1, stcoSize = 0;
+    off64_t sttsOffset = -1, sttsSize = 0;
+    off64_t cttsOffset = -1, cttsSize = 0;
+    off64_t stssOffset = -1, stssSize = 0;
+};
+
+void put32(std::vector<uint8_t> *data, uint32_t x) {
+    data->push_back(x >> 24);
+    data->push_back(x >> 16);
+    data->push_back(x >> 8);
+    data->push_back(x);
+}
+
+// Appends a box payload of 32-bit values and returns its offset and size.
+void addBox(SyntheticFile *file, const std::vector<uint32_t> &values, off64_t *offset,
+            off64_t *size) {
+    *offset = file->data.size();
+    for (uint32_t value : values) {
+        put32(&file->data, value);
+    }
+    *size = file->data.size() - *offset;
+}
+
+ssize_t readAt(void *handle, off64_t offset, void *data, size_t size) {
+    SyntheticFile *file = (SyntheticFile *)handle;
+    if (offset < 0 || (size_t)offset >= file->data.size()) {
+        return 0;
+    }
+    size = std::min(size, file->data.size() - (size_t)offset);
+    memcpy(data, &file->data[offset], size);
+    return size;
+}
+
+status_t getSize(void *handle, off64_t *size) {
+    *size = ((SyntheticFile *)handle)->data.size();
+    return OK;
+}
+
+uint32_t flags(void *) {
+    return 0;
+}
+
+bool getUri(void *, char *, size_t) {
+    return false;
+}
+
+// The tables of a track, with the values of each sample.
+struct Track {
+    std::vector<uint32_t> sampleSizes;
+    // 0 for an stsz box with a size per sample, or the field size of an stz2 box.
+    uint32_t compactFieldSize = 0;
+    // Whether all the samples have the size of the first one, written in the stsz header.
+    bool constantSize = false;
+    // The first chunk, from 1, and the samples per chunk of the sample-to-chunk entries.
+    std::vector<std::pair<uint32_t, uint32_t>> sampleToChunk = {{1, 10}};
+    // The durations of the samples covered by the time-to-sample table.
+    std::vector<uint32_t> durations;
+    // The composition time offsets, without a ctts box if empty.
+    std::vector<int32_t> compositionOffsets;
+    // The sync samples, from 0, without an stss box if empty.
+    std::vector<uint32_t> syncSamples;
+};
+
+// Appends (count, value) entries for the runs of equal values.
+template <typename T>
+void addRuns(std::vector<uint32_t> *values, const std::vector<T> &samples) {
+    size_t countIndex = values->size();
+    values->push_back(0);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        if (i == 0 || samples[i] != samples[i - 1]) {
+            values->push_back(1);
+            values->push_back(samples[i]);
+            ++(*values)[countIndex];
+        } else {
+            ++(*values)[values->size() - 2];
+        }
+    }
+}
+
+// The first sample of each chunk, and the number of samples after the last chunk.
+std::vector<uint32_t> getChunkFirstSamples(const Track &track) {
+    const uint32_t numSamples = track.sampleSizes.size();
+    std::vector<uint32_t> firstSamples;
+    uint32_t sample = 0;
+    while (sample < numSamples) {
+        uint32_t chunk = firstSamples.size() + 1;
+        size_t entry = 0;
+        while (entry + 1 < track.sampleToChunk.size()
+                && track.sampleToChunk[entry + 1].first <= chunk) {
+            ++entry;
+        }
+        firstSamples.push_back(sample);
+        sample += track.sampleToChunk[entry].second;
+    }
+    firstSamples.push_back(numSamples);
+    return firstSamples;
+}
+
+void writeTrack(SyntheticFile *file, const Track &track) {
+    const uint32_t numSamples = track.sampleSizes.size();
+    std::vector<uint32_t> values;
+    if (track.compactFieldSize != 0) {
+        file->stszType = FOURCC("stz2");
+        addBox(file, {0, track.compactFieldSize, numSamples}, &file->stszOffset,
+               &file->stszSize);
+        uint32_t bits = 0, numBits = 0;
+        for (uint32_t size : track.sampleSizes) {
+            bits = (bits << track.compactFieldSize) | size;
+            numBits += track.compactFieldSize;
+            for (; numBits >= 8; numBits -= 8) {
+                file->data.push_back(bits >> (numBits - 8));
+            }
+        }
+        if (numBits > 0) {
+            file->data.push_back(bits << (8 - numBits));
+        }
+        file->stszSize = file->data.size() - file->stszOffset;
+    } else if (track.constantSize) {
+        addBox(file, {0, track.sampleSizes[0], numSamples}, &file->stszOffset,
+               &file->stszSize);
+    } else {
+        values = {0, 0, numSamples};
+        values.insert(values.end(), track.sampleSizes.begin(), track.sampleSizes.end());
+        addBox(file, values, &file->stszOffset, &file->stszSize);
+    }
+
+    values = {0, (uint32_t)track.sampleToChunk.size()};
+    for (const auto &[firstChunk, samplesPerChunk] : track.sampleToChunk) {
+        values.insert(values.end(), {firstChunk, samplesPerChunk, 1});
+    }
+    addBox(file, values, &file->stscOffset, &file->stscSize);
+
+    const uint32_t numChunks = getChunkFirstSamples(track).size() - 1;
+    values = {0, numChunks};
+    for (uint32_t i = 0; i < numChunks; ++i) {
+        values.push_back(i * 100000);
+    }
+    addBox(file, values, &file->stcoOffset, &file->stcoSize);
+
+    values = {0};
+    addRuns(&values, track.durations);
+    addBox(file, values, &file->sttsOffset, &file->sttsSize);
+
+    if (!track.compositionOffsets.empty()) {
+        bool negative = std::any_of(track.compositionOffsets.begin(),
+                                    track.compositionOffsets.end(),
+                                    [](int32_t offset) { return offset < 0; });
+        values = {negative ? 1u << 24 : 0u};
+        addRuns(&values, track.compositionOffsets);
+        addBox(file, values, &file->cttsOffset, &file->cttsSize);
+    }
+
+    if (!track.syncSamples.empty()) {
+        values = {0, (uint32_t)track.syncSamples.size()};
+        for (uint32_t sample : track.syncSamples) {
+            values.push_back(sample + 1);
+        }
+        addBox(file, values, &file->stssOffset, &file->stssSize);
+    }
+}
+
+// A video track of numSamples samples with B-frames, 10 samples per chunk and a sync
+// sample every 30 samples.
+Track videoTrack(uint32_t numSamples) {
+    std::mt19937 random(numSamples);
+    Track track;
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        track.sampleSizes.push_back(1000 + random() % 5000);
+        track.durations.push_back(kSampleDuration);
+        track.compositionOffsets.push_back((i % 3 == 0 ? 3 : 0) * kSampleDuration);
+        if (i % 30 == 0) {
+            track.syncSamples.push_back(i);
+        }
+    }
+    return track;
+}
+
+void createTrack(SyntheticFile *file, uint32_t numSamples) {
+    writeTrack(file, videoTrack(numSamples));
+}
+
+// Does what MPEG4Extractor does when parsing the stbl box.
+sp<SampleTable> openTrack(DataSourceHelper *source, const SyntheticFile &file) {
+    sp<SampleTable> table = new SampleTable(source);
+    size_t maxSampleSize;
+    if (table->setSampleSizeParams(file.stszType, file.stszOffset, file.stszSize) != OK
+            || table->getMaxSampleSize(&maxSampleSize) != OK
+            || table->setSampleToChunkParams(file.stscOffset, file.stscSize) != OK
+            || table->setChunkOffsetParams(FOURCC("stco"), file.stcoOffset, file.stcoSize) != OK
+            || (file.sttsOffset >= 0
+                    && table->setTimeToSampleParams(file.sttsOffset, file.sttsSize) != OK)
+            || (file.cttsOffset >= 0
+                    && table->setCompositionTimeToSampleParams(file.cttsOffset, file.cttsSize)
+                            != OK)
+            || (file.stssOffset >= 0
+                    && table->setSyncSampleParams(file.stssOffset, file.stssSize) != OK)) {
+        return nullptr;
+    }
+    return table;
+}
+
+// A track written to memory and opened.
+struct OpenedTrack {
+    explicit OpenedTrack(const Track &track)
+        : csource({readAt, getSize, flags, getUri, &file}), source(&csource) {
+        writeTrack(&file, track);
+        table = openTrack(&source, file);
+    }
+
+    SyntheticFile file;
+    CDataSource csource;
+    DataSourceHelper source;
+    sp<SampleTable> table;
+};
+
+// A video track with B-frames, as in videoTrack(), but with negative composition time
+// offsets, and durations of 3000 and 3003 that change every few hundred samples.
+Track bFrameTrack(uint32_t numSamples) {
+    std::mt19937 random(numSamples);
+    Track track;
+    uint32_t duration = kSampleDuration;
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        if (random() % 200 == 0) {
+            duration = duration == kSampleDuration ? kSampleDuration + 3 : kSampleDuration;
+        }
+        track.sampleSizes.push_back(100 + random() % 5000);
+        track.durations.push_back(duration);
+        // I P B B P B B ... presented as I B B P B B P ...
+        track.compositionOffsets.push_back(
+                i == 0 ? 0 : (i - 1) % 3 == 0 ? 2 * kSampleDuration : -(int32_t)kSampleDuration);
+        if (i % 30 == 0) {
+            track.syncSamples.push_back(i);
+        }
+    }
+    return track;
+}
+
+// A track with chunks of 7, 3001, 1 and 13 samples, and sample sizes that fit in
+// fieldSize bits.
+Track chunkedTrack(uint32_t fieldSize) {
+    std::mt19937 random(fieldSize);
+    Track track = bFrameTrack(3 * 7 + 3001 + 3 * 1 + 52 * 13);
+    for (uint32_t &size : track.sampleSizes) {
+        size = random() % (fieldSize < 32 ? 1u << fieldSize : 100000u);
+    }
+    track.compactFieldSize = fieldSize < 32 ? fieldSize : 0;
+    track.sampleToChunk = {{1, 7}, {4, 3001}, {5, 1}, {8, 13}};
+    return track;
+}
+
+struct SampleInfo {
+    status_t status;
+    off64_t offset;
+    size_t size;
+    uint64_t compositionTime;
+    bool isSync;
+    uint64_t duration;
+
+    bool operator==(const SampleInfo &other) const {
+        return status == other.status
+                && (status != OK
+                        || (offset == other.offset && size == other.size
+                                && compositionTime == other.compositionTime
+                                && isSync == other.isSync && duration == other.duration));
+    }
+};
+
+SampleInfo getSample(const sp<SampleTable> &table, uint32_t sampleIndex) {
+    SampleInfo info = {};
+    info.status = table->getMetaDataForSample(sampleIndex, &info.offset, &info.size,
+                                              &info.compositionTime, &info.isSync,
+                                              &info.duration);
+    return info;
+}
+
+// What SampleTable returned before the sample time index, when it sorted all the samples
+// by composition time. Samples without a time are presented at 0 as they were, but keep
+// their own index instead of 0, and samples presented at the same time stay in decode
+// order, which the qsort() did not guarantee.
+class ReferenceTable {
+  public:
+    explicit ReferenceTable(const Track &track)
+        : mTrack(track), mChunkFirstSamples(getChunkFirstSamples(track)) {
+        const uint32_t numSamples = track.sampleSizes.size();
+        uint64_t time = 0;
+        for (uint32_t i = 0; i < numSamples; ++i) {
+            uint64_t compositionTime = 0;
+            if (i < track.durations.size()) {
+                compositionTime = time + getCompositionOffset(i);
+                time += track.durations[i];
+            }
+            mCompositionTimes.push_back(compositionTime);
+            mSortedSamples.push_back(i);
+        }
+        std::stable_sort(mSortedSamples.begin(), mSortedSamples.end(),
+                         [this](uint32_t a, uint32_t b) {
+                             return mCompositionTimes[a] < mCompositionTimes[b];
+                         });
+        for (uint32_t sample : mSortedSamples) {
+            mSortedTimes.push_back(mCompositionTimes[sample]);
+        }
+    }
+
+    status_t findSampleAtTime(uint64_t reqTime, uint64_t scaleNum, uint64_t scaleDen,
+                              uint32_t *sampleIndex, uint32_t flags) const {
+        const uint32_t numSamples = mSortedSamples.size();
+        if (flags == SampleTable::kFlagFrameIndex) {
+            if (reqTime >= numSamples) {
+                return ERROR_OUT_OF_RANGE;
+            }
+            *sampleIndex = mSortedSamples[reqTime];
+            return OK;
+        }
+
+        auto scaledTime = [&](uint32_t position) {
+            return mSortedTimes[position] * scaleNum / scaleDen;
+        };
+        uint32_t closest = std::lower_bound(mSortedTimes.begin(), mSortedTimes.end(), reqTime,
+                                            [&](uint64_t time, uint64_t reqTime) {
+                                                return time * scaleNum / scaleDen < reqTime;
+                                            }) - mSortedTimes.begin();
+        if (closest < numSamples && scaledTime(closest) == reqTime) {
+            *sampleIndex = mSortedSamples[closest];
+            return OK;
+        }
+
+        if (closest == numSamples) {
+            if (flags == SampleTable::kFlagAfter) {
+                return ERROR_OUT_OF_RANGE;
+            }
+            flags = SampleTable::kFlagBefore;
+        } else if (closest == 0) {
+            flags = SampleTable::kFlagAfter;
+        }
+        if (flags == SampleTable::kFlagBefore) {
+            --closest;
+        } else if (flags == SampleTable::kFlagClosest
+                && scaledTime(closest) - reqTime > reqTime - scaledTime(closest - 1)) {
+            --closest;
+        }
+        *sampleIndex = mSortedSamples[closest];
+        return OK;
+    }
+
+    SampleInfo getSample(uint32_t sampleIndex) const {
+        SampleInfo info = {};
+        if (sampleIndex >= mTrack.sampleSizes.size()) {
+            info.status = ERROR_END_OF_STREAM;
+            return info;
+        }
+        if (sampleIndex >= mTrack.durations.size()) {
+            info.status = ERROR_OUT_OF_RANGE;
+            return info;
+        }
+        size_t chunk = std::upper_bound(mChunkFirstSamples.begin(), mChunkFirstSamples.end(),
+                                        sampleIndex) - mChunkFirstSamples.begin() - 1;
+        info.status = OK;
+        info.offset = chunk * 100000;
+        for (uint32_t i = mChunkFirstSamples[chunk]; i < sampleIndex; ++i) {
+            info.offset += mTrack.sampleSizes[i];
+        }
+        info.size = mTrack.sampleSizes[sampleIndex];
+        info.compositionTime = mCompositionTimes[sampleIndex];
+        info.isSync = mTrack.syncSamples.empty()
+                || std::binary_search(mTrack.syncSamples.begin(), mTrack.syncSamples.end(),
+                                      sampleIndex);
+        info.duration = mTrack.durations[sampleIndex];
+        return info;
+    }
+
+    // The composition times of the samples in presentation order.
+    const std::vector<uint64_t> &getSortedTimes() const { return mSortedTimes; }
+
+  private:
+    int32_t getCompositionOffset(uint32_t sampleIndex) const {
+        return sampleIndex < mTrack.compositionOffsets.size()
+                ? mTrack.compositionOffsets[sampleIndex] : 0;
+    }
+
+    const Track mTrack;
+    const std::vector<uint32_t> mChunkFirstSamples;
+    std::vector<uint64_t> mCompositionTimes;
+    std::vector<uint32_t> mSortedSamples;
+    std::vector<uint64_t> mSortedTimes;
+};
+
+}  // namespace
+
+class SampleTableTest : public ::testing::Test {
+  public:
+    SampleTableTest() : mCSource({readAt, getSize, flags, getUri, &mFile}), mSource(&mCSource) {}
+
+    // Restores a table from index data.
+    status_t restore(const std::string &data, sp<SampleTable> *table = nullptr) {
+        sp<SampleTable> restored = new SampleTable(&mSource);
+        status_t err = restored->readIndex(data.data(), data.size());
+        if (table != nullptr) *table = restored;
+        return err;
+    }
+
+    SyntheticFile mFile;
+    CDataSource mCSource;
+    DataSourceHelper mSource;
+};
+
+TEST_F(SampleTableTest, IndexRoundTripTest) {
+    // More than one block of the sample time index.
+    createTrack(&mFile, 2500);
+    sp<SampleTable> table = openTrack(&mSource, mFile);
+    ASSERT_NE(table, nullptr);
+    std::string data;
+    ASSERT_EQ(table->writeIndex(&data), OK);
+
+    sp<SampleTable> restored;
+    ASSERT_EQ(restore(data, &restored), OK);
+    ASSERT_TRUE(restored->isValid());
+    EXPECT_EQ(restored->countSamples(), table->countSamples());
+    EXPECT_EQ(restored->countChunkOffsets(), table->countChunkOffsets());
+    size_t maxSize, restoredMaxSize;
+    ASSERT_EQ(table->getMaxSampleSize(&maxSize), OK);
+    ASSERT_EQ(restored->getMaxSampleSize(&restoredMaxSize), OK);
+    EXPECT_EQ(restoredMaxSize, maxSize);
+
+    for (uint32_t i = 0; i <= table->countSamples(); ++i) {
+        ASSERT_EQ(getSample(restored, i), getSample(table, i)) << "sample " << i;
+    }
+    for (uint64_t timeUs = 0; timeUs < 2600 * 1000000ull / 30; timeUs += 12345) {
+        for (uint32_t flags : {SampleTable::kFlagBefore, SampleTable::kFlagAfter,
+                               SampleTable::kFlagClosest}) {
+            uint32_t sample = UINT32_MAX, restoredSample = UINT32_MAX;
+            status_t err = table->findSampleAtTime(timeUs, kTimescale, 1000000, &sample, flags);
+            ASSERT_EQ(restored->findSampleAtTime(timeUs, kTimescale, 1000000, &restoredSample,
+                                                 flags),
+                      err);
+            ASSERT_EQ(restoredSample, sample) << "time " << timeUs << " flags " << flags;
+            if (err == OK) {
+                uint32_t sync = UINT32_MAX, restoredSync = UINT32_MAX;
+                err = table->findSyncSampleNear(sample, &sync, flags);
+                ASSERT_EQ(restored->findSyncSampleNear(sample, &restoredSync, flags), err);
+                ASSERT_EQ(restoredSync, sync);
+            }
+        }
+    }
+
+    // The index can be saved again from the restored table.
+    std::string restoredData;
+    ASSERT_EQ(restored->writeIndex(&restoredData), OK);
+    EXPECT_EQ(restoredData, data);
+
+    // A table that is already set up cannot be restored.
+    EXPECT_NE(table->readIndex(data.data(), data.size()), OK);
+}
+
+TEST_F(SampleTableTest, TruncatedIndexTest) {
+    createTrack(&mFile, 1500);
+    sp<SampleTable> table = openTrack(&mSource, mFile);
+    ASSERT_NE(table, nullptr);
+    std::string data;
+    ASSERT_EQ(table->writeIndex(&data), OK);
+    for (size_t size = 0; size < data.size(); ++size) {
+        ASSERT_NE(restore(data.substr(0, size)), OK) << "index truncated to " << size;
+    }
+    ASSERT_NE(restore(data + '\0'), OK) << "index with trailing data";
+    ASSERT_EQ(restore(data), OK);
+}
+
+TEST_F(SampleTableTest, CorruptedIndexTest) {
+    createTrack(&mFile, 1500);
+    sp<SampleTable> table = openTrack(&mSource, mFile);
+    ASSERT_NE(table, nullptr);
+    std::string data;
+    ASSERT_EQ(table->writeIndex(&data), OK);
+
+    // Fields that are checked: the version, the chunk offset type and the sample size
+    // field size, which follows the single sample-to-chunk entry.
+    const size_t kVersionOffset = 0;
+    const size_t kChunkOffsetTypeOffset = 12;
+    const size_t kSampleSizeFieldSizeOffset = 32 + 12 + 8;
+    for (size_t offset : {kVersionOffset, kChunkOffsetTypeOffset, kSampleSizeFieldSizeOffset}) {
+        std::string corrupted = data;
+        corrupted[offset] ^= 1;
+        EXPECT_NE(restore(corrupted), OK) << "corrupted at " << offset;
+    }
+
+    // The index of another file, with other chunk or sample counts.
+    SyntheticFile other;
+    createTrack(&other, 1490);
+    CDataSource otherCSource = {readAt, getSize, flags, getUri, &other};
+    DataSourceHelper otherSource(&otherCSource);
+    sp<SampleTable> otherTable = new SampleTable(&otherSource);
+    EXPECT_NE(otherTable->readIndex(data.data(), data.size()), OK);
+
+    // The file modified in place.
+    mFile.data[mFile.stszOffset + 11] ^= 1;
+    EXPECT_NE(restore(data), OK) << "sample count changed";
+    mFile.data[mFile.stszOffset + 11] ^= 1;
+    mFile.data[mFile.stcoOffset + 7] ^= 1;
+    EXPECT_NE(restore(data), OK) << "chunk count changed";
+    mFile.data[mFile.stcoOffset + 7] ^= 1;
+    ASSERT_EQ(restore(data), OK);
+
+    // Other values are not checked, IndexCache has a checksum for them, but they must
+    // not make the table read out of bounds.
+    std::mt19937 random(1);
+    for (int i = 0; i < 2000; ++i) {
+        std::string corrupted = data;
+        size_t offset = random() % corrupted.size();
+        corrupted[offset] ^= 1 << (random() % 8);
+        sp<SampleTable> restored;
+        if (restore(corrupted, &restored) != OK) {
+            continue;
+        }
+        for (uint32_t sample = 0; sample <= restored->countSamples(); sample += 7) {
+            getSample(restored, sample);
+        }
+        for (uint64_t timeUs = 0; timeUs < 60000000; timeUs += 1000000) {
+            uint32_t sample;
+            if (restored->findSampleAtTime(timeUs, kTimescale, 1000000, &sample,
+                                           SampleTable::kFlagClosest) == OK) {
+                uint32_t sync;
+                restored->findSyncSampleNear(sample, &sync, SampleTable::kFlagBefore);
+            }
+        }
+    }
+}
+
+TEST_F(SampleTableTest, FindSampleAtTimeTest) {
+    std::vector<std::pair<std::string, Track>> tracks;
+    tracks.emplace_back("B-frames", bFrameTrack(3500));
+
+    // Samples presented out of their block: a window starts at every block that is
+    // presented after the previous ones, so blocks 0 to 2 are one window here.
+    Track track = bFrameTrack(3500);
+    track.compositionOffsets[1023] += 1500 * kSampleDuration;
+    track.compositionOffsets[2048] -= 2040 * kSampleDuration;
+    track.compositionOffsets[3100] += 500 * kSampleDuration;
+    tracks.emplace_back("reordered across blocks", track);
+
+    // Samples presented at the same time, across a block boundary.
+    track = bFrameTrack(3500);
+    for (uint32_t i = 1000; i < 1050; ++i) {
+        track.durations[i] = 0;
+        track.compositionOffsets[i] = 0;
+    }
+    tracks.emplace_back("equal times", track);
+
+    // Samples without a time are presented at 0, so there is a single window.
+    track = bFrameTrack(3500);
+    track.durations.resize(3200);
+    tracks.emplace_back("partial stts", track);
+
+    // Exactly two blocks.
+    track = bFrameTrack(2048);
+    track.compositionOffsets.clear();
+    tracks.emplace_back("no ctts", track);
+
+    std::mt19937 random(1);
+    for (const auto &[name, track] : tracks) {
+        SCOPED_TRACE(name);
+        OpenedTrack opened(track);
+        ASSERT_NE(opened.table, nullptr);
+        ReferenceTable reference(track);
+
+        // Times at, around and between those of the samples, in the time scale of the
+        // track and in microseconds.
+        std::vector<std::pair<uint64_t, uint64_t>> scales = {{1, 1}, {1000000, kTimescale}};
+        std::vector<std::pair<uint64_t, size_t>> queries;
+        for (size_t scale = 0; scale < scales.size(); ++scale) {
+            const auto [scaleNum, scaleDen] = scales[scale];
+            const std::vector<uint64_t> &times = reference.getSortedTimes();
+            for (size_t i = 0; i < times.size(); ++i) {
+                uint64_t time = times[i] * scaleNum / scaleDen;
+                uint64_t nextTime = i + 1 < times.size()
+                        ? times[i + 1] * scaleNum / scaleDen : time + 1000000;
+                for (uint64_t queryTime : {time, time + 1, (time + nextTime) / 2, nextTime - 1}) {
+                    queries.emplace_back(queryTime, scale);
+                }
+            }
+        }
+
+        auto check = [&](uint64_t time, size_t scale, uint32_t flags) {
+            const auto [scaleNum, scaleDen] = scales[scale];
+            uint32_t sample = UINT32_MAX, expectedSample = UINT32_MAX;
+            status_t expected = reference.findSampleAtTime(time, scaleNum, scaleDen,
+                                                           &expectedSample, flags);
+            ASSERT_EQ(opened.table->findSampleAtTime(time, scaleNum, scaleDen, &sample, flags),
+                      expected) << "time " << time << "*" << scaleNum << "/" << scaleDen
+                                << " flags " << flags;
+            if (expected == OK) {
+                ASSERT_EQ(sample, expectedSample) << "time " << time << "*" << scaleNum << "/"
+                                                  << scaleDen << " flags " << flags;
+            }
+        };
+
+        // In order, as when playing, then in any order, as when seeking.
+        for (int pass = 0; pass < 2; ++pass) {
+            for (const auto &[time, scale] : queries) {
+                for (uint32_t flags : {SampleTable::kFlagBefore, SampleTable::kFlagAfter,
+                                       SampleTable::kFlagClosest}) {
+                    check(time, scale, flags);
+                }
+            }
+            std::shuffle(queries.begin(), queries.end(), random);
+            queries.resize(3000);
+        }
+
+        const uint32_t numSamples = track.sampleSizes.size();
+        std::vector<uint32_t> frames;
+        for (uint32_t i = 0; i <= numSamples; ++i) {
+            frames.push_back(i);
+        }
+        std::shuffle(frames.begin(), frames.end(), random);
+        for (uint32_t frame : frames) {
+            check(frame, 0, SampleTable::kFlagFrameIndex);
+        }
+
+        for (uint32_t i = 0; i <= numSamples; ++i) {
+            ASSERT_EQ(getSample(opened.table, i), reference.getSample(i)) << "sample " << i;
+        }
+    }
+}
+
+TEST_F(SampleTableTest, SampleMetaDataTest) {
+    std::vector<std::pair<std::string, Track>> tracks;
+    for (uint32_t fieldSize : {4, 8, 16, 32}) {
+        tracks.emplace_back("field size " + std::to_string(fieldSize), chunkedTrack(fieldSize));
+    }
+    Track track = chunkedTrack(32);
+    track.constantSize = true;
+    std::fill(track.sampleSizes.begin(), track.sampleSizes.end(), 1234);
+    tracks.emplace_back("constant size", track);
+
+    std::mt19937 random(1);
+    for (const auto &[name, track] : tracks) {
+        SCOPED_TRACE(name);
+        OpenedTrack opened(track);
+        ASSERT_NE(opened.table, nullptr);
+        ReferenceTable reference(track);
+        const uint32_t numSamples = track.sampleSizes.size();
+
+        // Without the sample time index, then with it, once findSampleAtTime() built it.
+        for (int pass = 0; pass < 2; ++pass) {
+            for (uint32_t i = 0; i <= numSamples; ++i) {
+                ASSERT_EQ(getSample(opened.table, i), reference.getSample(i)) << "sample " << i;
+            }
+            for (uint32_t i = numSamples + 1; i-- > 0;) {
+                ASSERT_EQ(getSample(opened.table, i), reference.getSample(i)) << "sample " << i;
+            }
+            for (int i = 0; i < 5000; ++i) {
+                uint32_t sample = random() % (numSamples + 1);
+                ASSERT_EQ(getSample(opened.table, sample), reference.getSample(sample))
+                        << "sample " << sample;
+            }
+
+            uint32_t sample;
+            ASSERT_EQ(opened.table->findSampleAtTime(0, 1, 1, &sample, SampleTable::kFlagClosest),
+                      OK);
+        }
+    }
+}
@@ -17,6 +17,7 @@
 #include "ABuffer.h"
 
 #include "ADebug.h"
+#include "AObjectPool.h"
 #include "ALooper.h"
 #include "AMessage.h"
 
@@ -26,7 +27,7 @@ ABuffer::ABuffer(size_t capacity)
     : mRangeOffset(0),
       mInt32Data(0),
       mOwnsData(true) {
-    mData = malloc(capacity);
+    mData = AObjectPool::Allocate(capacity);
     if (mData == NULL) {
         mCapacity = 0;
         mRangeLength = 0;
@@ -59,7 +60,7 @@ sp<ABuffer> ABuffer::CreateAsCopy(const void *data, size_t capacity)
 ABuffer::~ABuffer() {
     if (mOwnsData) {
         if (mData != NULL) {
-            free(mData);
+            AObjectPool::Free(mData, mCapacity);
             mData = NULL;
         }
     }
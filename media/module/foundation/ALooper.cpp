@@ -23,6 +23,8 @@
 
 #include <sys/time.h>
 
+#include <algorithm>
+
 #include "ALooper.h"
 
 #include "AHandler.h"
@@ -74,7 +76,8 @@ int64_t ALooper::getNowUs() {
 }
 
 ALooper::ALooper()
-    : mRunningLocally(false) {
+    : mNextEventSeq(0),
+      mRunningLocally(false) {
     // clean up stale AHandlers. Doing it here instead of in the destructor avoids
     // the side effect of objects being deleted from the unregister function recursively.
     gLooperRoster.unregisterStaleHandlers();
@@ -169,6 +172,11 @@ status_t ALooper::stop() {
     return OK;
 }
 
+// static
+bool ALooper::EventLater(const Event &a, const Event &b) {
+    return a.mWhenUs > b.mWhenUs || (a.mWhenUs == b.mWhenUs && a.mSeq > b.mSeq);
+}
+
 void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
     Mutex::Autolock autoLock(mLock);
 
@@ -181,21 +189,12 @@ void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
         whenUs = getNowUs();
     }
 
-    List<Event>::iterator it = mEventQueue.begin();
-    while (it != mEventQueue.end() && (*it).mWhenUs <= whenUs) {
-        ++it;
-    }
-
-    Event event;
-    event.mWhenUs = whenUs;
-    event.mMessage = msg;
-    event.mToken = nullptr;
-
-    if (it == mEventQueue.begin()) {
+    if (mEventQueue.empty() || whenUs < mEventQueue.front().mWhenUs) {
         mQueueChangedCondition.signal();
     }
 
-    mEventQueue.insert(it, event);
+    mEventQueue.push_back(Event{whenUs, mNextEventSeq++, msg, nullptr});
+    std::push_heap(mEventQueue.begin(), mEventQueue.end(), EventLater);
 }
 
 status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token, int64_t delayUs) {
@@ -215,28 +214,20 @@ status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token,
     // We only need to wake the loop up if we're rescheduling to the earliest event in the queue.
     // This needs to be checked now, before we reschedule the message, in case this message is
     // already at the beginning of the queue.
-    bool shouldAwakeLoop = mEventQueue.empty() || whenUs < mEventQueue.begin()->mWhenUs;
-
-    // Erase any previously-posted event with this token.
-    for (auto i = mEventQueue.begin(); i != mEventQueue.end();) {
-        if (i->mToken == token) {
-            i = mEventQueue.erase(i);
-        } else {
-            ++i;
-        }
-    }
-
-    // Find the insertion point for the rescheduled message.
-    List<Event>::iterator i = mEventQueue.begin();
-    while (i != mEventQueue.end() && i->mWhenUs <= whenUs) {
-        ++i;
+    bool shouldAwakeLoop = mEventQueue.empty() || whenUs < mEventQueue.front().mWhenUs;
+
+    // Erase any previously-posted event with this token, including one that is already due.
+    auto hasToken = [&token](const Event &event) { return event.mToken == token; };
+    mDueEvents.erase(
+            std::remove_if(mDueEvents.begin(), mDueEvents.end(), hasToken), mDueEvents.end());
+    auto removed = std::remove_if(mEventQueue.begin(), mEventQueue.end(), hasToken);
+    if (removed != mEventQueue.end()) {
+        mEventQueue.erase(removed, mEventQueue.end());
+        std::make_heap(mEventQueue.begin(), mEventQueue.end(), EventLater);
     }
 
-    Event event;
-    event.mWhenUs = whenUs;
-    event.mMessage = msg;
-    event.mToken = token;
-    mEventQueue.insert(i, event);
+    mEventQueue.push_back(Event{whenUs, mNextEventSeq++, msg, token});
+    std::push_heap(mEventQueue.begin(), mEventQueue.end(), EventLater);
 
     // If we rescheduled the event to be earlier than the first event, then we need to wake up the
     // looper earlier than it was previously scheduled to be woken up. Otherwise, it can sleep until
@@ -256,25 +247,35 @@ bool ALooper::loop() {
         if (mThread == NULL && !mRunningLocally) {
             return false;
         }
-        if (mEventQueue.empty()) {
-            mQueueChangedCondition.wait(mLock);
-            return true;
-        }
-        int64_t whenUs = (*mEventQueue.begin()).mWhenUs;
-        int64_t nowUs = getNowUs();
+        if (mDueEvents.empty()) {
+            if (mEventQueue.empty()) {
+                mQueueChangedCondition.wait(mLock);
+                return true;
+            }
+            int64_t whenUs = mEventQueue.front().mWhenUs;
+            int64_t nowUs = getNowUs();
+
+            if (whenUs > nowUs) {
+                int64_t delayUs = whenUs - nowUs;
+                if (delayUs > INT64_MAX / 1000) {
+                    delayUs = INT64_MAX / 1000;
+                }
+                mQueueChangedCondition.waitRelative(mLock, delayUs * 1000ll);
 
-        if (whenUs > nowUs) {
-            int64_t delayUs = whenUs - nowUs;
-            if (delayUs > INT64_MAX / 1000) {
-                delayUs = INT64_MAX / 1000;
+                return true;
             }
-            mQueueChangedCondition.waitRelative(mLock, delayUs * 1000ll);
 
-            return true;
+            // Take every event that is due now; anything posted from here on is
+            // due no earlier than nowUs, so delivery order is unchanged.
+            do {
+                std::pop_heap(mEventQueue.begin(), mEventQueue.end(), EventLater);
+                mDueEvents.push_back(std::move(mEventQueue.back()));
+                mEventQueue.pop_back();
+            } while (!mEventQueue.empty() && mEventQueue.front().mWhenUs <= nowUs);
         }
 
-        event = *mEventQueue.begin();
-        mEventQueue.erase(mEventQueue.begin());
+        event = std::move(mDueEvents.front());
+        mDueEvents.pop_front();
     }
 
     event.mMessage->deliver();
@@ -26,6 +26,7 @@
 #include "ADebug.h"
 #include "AHandler.h"
 #include "AMessage.h"
+#include "AObjectPool.h"
 
 namespace android {
 
@@ -180,6 +181,7 @@ void ALooperRoster::dump(int fd, const Vector<String16>& args) {
         }
         s.append("\n");
     }
+    s.append(AObjectPool::DumpStats().c_str());
     (void)write(fd, s.string(), s.size());
 }
 
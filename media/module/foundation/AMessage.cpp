@@ -89,11 +89,11 @@ void AMessage::setTarget(const sp<const AHandler> &handler) {
 void AMessage::clear() {
     // Item needs to be handled delicately
     for (Item &item : mItems) {
-        delete[] item.mName;
-        item.mName = NULL;
+        item.freeName();
         freeItemValue(&item);
     }
     mItems.clear();
+    mIndex.clear();
 }
 
 void AMessage::freeItemValue(Item *item) {
@@ -150,20 +150,51 @@ static void reportStats() {
 }
 #endif
 
+// static
+__attribute__((no_sanitize("integer")))
+inline uint32_t AMessage::HashName(const char *name, size_t len) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
 inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
 #ifdef DUMP_STATS
     size_t memchecks = 0;
 #endif
-    size_t i = 0;
-    for (; i < mItems.size(); i++) {
-        if (len != mItems[i].mNameLength) {
-            continue;
+    // Comparing the cached hash first means memcmp only runs on the matching
+    // entry (barring collisions).
+    const uint32_t hash = HashName(name, len);
+    size_t i = mItems.size();
+    if (!mIndex.empty()) {
+        const size_t mask = mIndex.size() - 1;
+        for (size_t slot = hash & mask; mIndex[slot] != 0; slot = (slot + 1) & mask) {
+            const Item &item = mItems[mIndex[slot] - 1];
+            if (hash != item.mNameHash || len != item.mNameLength) {
+                continue;
+            }
+#ifdef DUMP_STATS
+            ++memchecks;
+#endif
+            if (!memcmp(item.name(), name, len)) {
+                i = mIndex[slot] - 1;
+                break;
+            }
         }
+    } else {
+        for (i = 0; i < mItems.size(); i++) {
+            if (hash != mItems[i].mNameHash || len != mItems[i].mNameLength) {
+                continue;
+            }
 #ifdef DUMP_STATS
-        ++memchecks;
+            ++memchecks;
 #endif
-        if (!memcmp(mItems[i].mName, name, len)) {
-            break;
+            if (!memcmp(mItems[i].name(), name, len)) {
+                break;
+            }
         }
     }
 #ifdef DUMP_STATS
@@ -172,23 +203,72 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
         ++gFindItemCalls;
         gAverageNumItems += mItems.size();
         gAverageNumMemChecks += memchecks;
-        gAverageNumChecks += i;
+        gAverageNumChecks += mIndex.empty() ? i : memchecks;
         reportStats();
     }
 #endif
     return i;
 }
 
-// assumes item's name was uninitialized or NULL
+void AMessage::insertIntoIndex(size_t i) {
+    static_assert(kMaxNumItems < UINT16_MAX, "mIndex holds item index + 1 as uint16_t");
+    // Linear probing keeps items of the same name in insertion order, so the first one
+    // is found first, as with the scan.
+    const size_t mask = mIndex.size() - 1;
+    size_t slot = mItems[i].mNameHash & mask;
+    while (mIndex[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    mIndex[slot] = i + 1;
+}
+
+void AMessage::rebuildIndex() {
+    mIndex.clear();
+    if (mItems.size() <= kMaxUnindexedItems) {
+        return;
+    }
+    size_t slots = 4 * kMaxUnindexedItems;
+    while (slots < 2 * mItems.size()) {
+        slots *= 2;
+    }
+    mIndex.resize(slots);
+    for (size_t i = 0; i < mItems.size(); ++i) {
+        insertIntoIndex(i);
+    }
+}
+
+void AMessage::indexLastItem() {
+    if (mIndex.size() < 2 * mItems.size()) {
+        rebuildIndex();  // also builds the index once there are enough items
+    } else {
+        insertIntoIndex(mItems.size() - 1);
+    }
+}
+
+// assumes item's name was uninitialized or freed
 void AMessage::Item::setName(const char *name, size_t len) {
     mNameLength = len;
-    mName = new char[len + 1];
-    memcpy((void*)mName, name, len + 1);
+    mNameHash = HashName(name, len);
+    char *dst = mInlineName;
+    if (len > kMaxInlineNameLength) {
+        dst = mHeapName = new char[len + 1];
+    }
+    memcpy(dst, name, len);
+    dst[len] = '\0';
+}
+
+void AMessage::Item::freeName() {
+    if (mNameLength > kMaxInlineNameLength) {
+        delete[] mHeapName;
+    }
+    mNameLength = 0;
+    mNameHash = 0;
+    mInlineName[0] = '\0';
 }
 
 AMessage::Item::Item(const char *name, size_t len)
     : mType(kTypeInt32) {
-    // mName and mNameLength are initialized by setName
+    // the name fields are initialized by setName
     setName(name, len);
 }
 
@@ -203,8 +283,18 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
     } else {
         CHECK(mItems.size() < kMaxNumItems);
         i = mItems.size();
+        // |name| may be the inline name of one of our own items (e.g. from extend()) which
+        // would move if the vector grows.
+        char nameCopy[kMaxInlineNameLength + 1];
+        if (mItems.size() == mItems.capacity() && len <= kMaxInlineNameLength
+                && !mItems.empty() && (const void *)name >= (const void *)mItems.data()
+                && (const void *)name < (const void *)(mItems.data() + mItems.size())) {
+            memcpy(nameCopy, name, len + 1);
+            name = nameCopy;
+        }
         // place a 'blank' item at the end - this is of type kTypeInt32
         mItems.emplace_back(name, len);
+        indexLastItem();
         item = &mItems[i];
     }
 
@@ -491,6 +581,7 @@ bool AMessage::senderAwaitsResponse(sp<AReplyToken> *replyToken) {
 sp<AMessage> AMessage::dup() const {
     sp<AMessage> msg = new AMessage(mWhat, mHandler.promote());
     msg->mItems = mItems;
+    msg->mIndex = mIndex;
 
 #ifdef DUMP_STATS
     {
@@ -505,7 +596,7 @@ sp<AMessage> AMessage::dup() const {
         const Item *from = &mItems[i];
         Item *to = &msg->mItems[i];
 
-        to->setName(from->mName, from->mNameLength);
+        to->setName(from->name(), from->mNameLength);
         to->mType = from->mType;
 
         switch (from->mType) {
@@ -590,65 +681,65 @@ AString AMessage::debugString(int32_t indent) const {
         switch (item.mType) {
             case kTypeInt32:
                 tmp = AStringPrintf(
-                        "int32_t %s = %d", item.mName, item.u.int32Value);
+                        "int32_t %s = %d", item.name(), item.u.int32Value);
                 break;
             case kTypeInt64:
                 tmp = AStringPrintf(
-                        "int64_t %s = %lld", item.mName, item.u.int64Value);
+                        "int64_t %s = %lld", item.name(), item.u.int64Value);
                 break;
             case kTypeSize:
                 tmp = AStringPrintf(
-                        "size_t %s = %d", item.mName, item.u.sizeValue);
+                        "size_t %s = %d", item.name(), item.u.sizeValue);
                 break;
             case kTypeFloat:
                 tmp = AStringPrintf(
-                        "float %s = %f", item.mName, item.u.floatValue);
+                        "float %s = %f", item.name(), item.u.floatValue);
                 break;
             case kTypeDouble:
                 tmp = AStringPrintf(
-                        "double %s = %f", item.mName, item.u.doubleValue);
+                        "double %s = %f", item.name(), item.u.doubleValue);
                 break;
             case kTypePointer:
                 tmp = AStringPrintf(
-                        "void *%s = %p", item.mName, item.u.ptrValue);
+                        "void *%s = %p", item.name(), item.u.ptrValue);
                 break;
             case kTypeString:
                 tmp = AStringPrintf(
                         "string %s = \"%s\"",
-                        item.mName,
+                        item.name(),
                         item.u.stringValue->c_str());
                 break;
             case kTypeObject:
                 tmp = AStringPrintf(
-                        "RefBase *%s = %p", item.mName, item.u.refValue);
+                        "RefBase *%s = %p", item.name(), item.u.refValue);
                 break;
             case kTypeBuffer:
             {
                 sp<ABuffer> buffer = static_cast<ABuffer *>(item.u.refValue);
 
                 if (buffer != NULL && buffer->data() != NULL && buffer->size() <= 64) {
-                    tmp = AStringPrintf("Buffer %s = {\n", item.mName);
+                    tmp = AStringPrintf("Buffer %s = {\n", item.name());
                     hexdump(buffer->data(), buffer->size(), indent + 4, &tmp);
                     appendIndent(&tmp, indent + 2);
                     tmp.append("}");
                 } else {
                     tmp = AStringPrintf(
-                            "Buffer *%s = %p", item.mName, buffer.get());
+                            "Buffer *%s = %p", item.name(), buffer.get());
                 }
                 break;
             }
             case kTypeMessage:
                 tmp = AStringPrintf(
                         "AMessage %s = %s",
-                        item.mName,
+                        item.name(),
                         static_cast<AMessage *>(
                             item.u.refValue)->debugString(
-                                indent + strlen(item.mName) + 14).c_str());
+                                indent + strlen(item.name()) + 14).c_str());
                 break;
             case kTypeRect:
                 tmp = AStringPrintf(
                         "Rect %s(%d, %d, %d, %d)",
-                        item.mName,
+                        item.name(),
                         item.u.rectValue.mLeft,
                         item.u.rectValue.mTop,
                         item.u.rectValue.mRight,
@@ -773,6 +864,7 @@ sp<AMessage> AMessage::FromParcel(const Parcel &parcel, size_t maxNestingLevel)
 
         item->setName(name, strlen(name));
     }
+    msg->rebuildIndex();
 
     return msg;
 }
@@ -782,7 +874,7 @@ void AMessage::writeToParcel(Parcel *parcel) const {
     parcel->writeInt32(static_cast<int32_t>(mItems.size()));
 
     for (const Item &item : mItems) {
-        parcel->writeCString(item.mName);
+        parcel->writeCString(item.name());
         parcel->writeInt32(static_cast<int32_t>(item.mType));
 
         switch (item.mType) {
@@ -852,55 +944,55 @@ sp<AMessage> AMessage::changesFrom(const sp<const AMessage> &other, bool deep) c
     }
 
     for (const Item &item : mItems) {
-        const Item *oitem = other->findItem(item.mName, item.mType);
+        const Item *oitem = other->findItem(item.name(), item.mType);
         switch (item.mType) {
             case kTypeInt32:
                 if (oitem == NULL || item.u.int32Value != oitem->u.int32Value) {
-                    diff->setInt32(item.mName, item.u.int32Value);
+                    diff->setInt32(item.name(), item.u.int32Value);
                 }
                 break;
 
             case kTypeInt64:
                 if (oitem == NULL || item.u.int64Value != oitem->u.int64Value) {
-                    diff->setInt64(item.mName, item.u.int64Value);
+                    diff->setInt64(item.name(), item.u.int64Value);
                 }
                 break;
 
             case kTypeSize:
                 if (oitem == NULL || item.u.sizeValue != oitem->u.sizeValue) {
-                    diff->setSize(item.mName, item.u.sizeValue);
+                    diff->setSize(item.name(), item.u.sizeValue);
                 }
                 break;
 
             case kTypeFloat:
                 if (oitem == NULL || item.u.floatValue != oitem->u.floatValue) {
-                    diff->setFloat(item.mName, item.u.sizeValue);
+                    diff->setFloat(item.name(), item.u.sizeValue);
                 }
                 break;
 
             case kTypeDouble:
                 if (oitem == NULL || item.u.doubleValue != oitem->u.doubleValue) {
-                    diff->setDouble(item.mName, item.u.sizeValue);
+                    diff->setDouble(item.name(), item.u.sizeValue);
                 }
                 break;
 
             case kTypeString:
                 if (oitem == NULL || *item.u.stringValue != *oitem->u.stringValue) {
-                    diff->setString(item.mName, *item.u.stringValue);
+                    diff->setString(item.name(), *item.u.stringValue);
                 }
                 break;
 
             case kTypeRect:
                 if (oitem == NULL || memcmp(&item.u.rectValue, &oitem->u.rectValue, sizeof(Rect))) {
                     diff->setRect(
-                            item.mName, item.u.rectValue.mLeft, item.u.rectValue.mTop,
+                            item.name(), item.u.rectValue.mLeft, item.u.rectValue.mTop,
                             item.u.rectValue.mRight, item.u.rectValue.mBottom);
                 }
                 break;
 
             case kTypePointer:
                 if (oitem == NULL || item.u.ptrValue != oitem->u.ptrValue) {
-                    diff->setPointer(item.mName, item.u.ptrValue);
+                    diff->setPointer(item.name(), item.u.ptrValue);
                 }
                 break;
 
@@ -909,7 +1001,7 @@ sp<AMessage> AMessage::changesFrom(const sp<const AMessage> &other, bool deep) c
                 sp<ABuffer> myBuf = static_cast<ABuffer *>(item.u.refValue);
                 if (myBuf == NULL) {
                     if (oitem == NULL || oitem->u.refValue != NULL) {
-                        diff->setBuffer(item.mName, NULL);
+                        diff->setBuffer(item.name(), NULL);
                     }
                     break;
                 }
@@ -918,7 +1010,7 @@ sp<AMessage> AMessage::changesFrom(const sp<const AMessage> &other, bool deep) c
                         || myBuf->size() != oBuf->size()
                         || (!myBuf->data() ^ !oBuf->data()) // data nullness differs
                         || (myBuf->data() && memcmp(myBuf->data(), oBuf->data(), myBuf->size()))) {
-                    diff->setBuffer(item.mName, myBuf);
+                    diff->setBuffer(item.name(), myBuf);
                 }
                 break;
             }
@@ -928,7 +1020,7 @@ sp<AMessage> AMessage::changesFrom(const sp<const AMessage> &other, bool deep) c
                 sp<AMessage> myMsg = static_cast<AMessage *>(item.u.refValue);
                 if (myMsg == NULL) {
                     if (oitem == NULL || oitem->u.refValue != NULL) {
-                        diff->setMessage(item.mName, NULL);
+                        diff->setMessage(item.name(), NULL);
                     }
                     break;
                 }
@@ -936,14 +1028,14 @@ sp<AMessage> AMessage::changesFrom(const sp<const AMessage> &other, bool deep) c
                     oitem == NULL ? NULL : static_cast<AMessage *>(oitem->u.refValue);
                 sp<AMessage> changes = myMsg->changesFrom(oMsg, deep);
                 if (changes->countEntries()) {
-                    diff->setMessage(item.mName, deep ? changes : myMsg);
+                    diff->setMessage(item.name(), deep ? changes : myMsg);
                 }
                 break;
             }
 
             case kTypeObject:
                 if (oitem == NULL || item.u.refValue != oitem->u.refValue) {
-                    diff->setObject(item.mName, item.u.refValue);
+                    diff->setObject(item.name(), item.u.refValue);
                 }
                 break;
 
@@ -975,7 +1067,7 @@ const char *AMessage::getEntryNameAt(size_t index, Type *type) const {
 
     *type = mItems[index].mType;
 
-    return mItems[index].mName;
+    return mItems[index].name();
 }
 
 AMessage::ItemData AMessage::getEntryAt(size_t index) const {
@@ -1019,16 +1111,16 @@ status_t AMessage::setEntryNameAt(size_t index, const char *name) {
     if (name == nullptr) {
         return BAD_VALUE;
     }
-    if (!strcmp(name, mItems[index].mName)) {
+    if (!strcmp(name, mItems[index].name())) {
         return OK; // name has not changed
     }
     size_t len = strlen(name);
     if (findItemIndex(name, len) < mItems.size()) {
         return ALREADY_EXISTS;
     }
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    mItems[index].freeName();
     mItems[index].setName(name, len);
+    rebuildIndex();
     return OK;
 }
 
@@ -1091,18 +1183,19 @@ status_t AMessage::removeEntryAt(size_t index) {
         return BAD_INDEX;
     }
     // delete entry data and objects
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    mItems[index].freeName();
     freeItemValue(&mItems[index]);
 
     // swap entry with last entry and clear last entry's data
     size_t lastIndex = mItems.size() - 1;
     if (index < lastIndex) {
         mItems[index] = mItems[lastIndex];
-        mItems[lastIndex].mName = nullptr;
+        // the name and value are now owned by mItems[index]
+        mItems[lastIndex].mNameLength = 0;
         mItems[lastIndex].mType = kTypeInt32;
     }
     mItems.pop_back();
+    rebuildIndex();
     return OK;
 }
 
@@ -1137,7 +1230,7 @@ void AMessage::extend(const sp<AMessage> &other) {
     }
 
     for (size_t ix = 0; ix < other->mItems.size(); ++ix) {
-        Item *it = allocateItem(other->mItems[ix].mName);
+        Item *it = allocateItem(other->mItems[ix].name());
         if (it != nullptr) {
             ItemData data = other->getEntryAt(ix);
             setEntryAt(it - &mItems[0], data);
@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "AObjectPool"
+#include <utils/Log.h>
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "AObjectPool.h"
+
+#include "AString.h"
+
+// Pooling hides use-after-free and overflows of pooled objects from the
+// sanitizers, so let them see every allocation.
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(hwaddress_sanitizer)
+#define A_OBJECT_POOL_DISABLED 1
+#endif
+#endif
+
+namespace android {
+
+#ifndef A_OBJECT_POOL_DISABLED
+namespace {
+
+constexpr size_t kMinBlockShift = 6;  // 64 bytes
+constexpr size_t kMinBlockSize = 1 << kMinBlockShift;
+constexpr size_t kNumSizeClasses = 7;  // 64 .. 4096 bytes
+static_assert((kMinBlockSize << (kNumSizeClasses - 1)) == AObjectPool::kMaxBlockSize,
+        "size classes must end at kMaxBlockSize");
+
+// Number of blocks moved between a thread cache and the depot at once. Keeps
+// at most 4KiB per batch, so large classes are not hoarded by idle threads.
+// A thread caches up to two batches per size class, at most 46KiB in all.
+constexpr size_t kMaxBatchBlocks = 16;
+constexpr size_t kBatchBytes = 4096;
+// Batches kept in the depot per size class before blocks go back to malloc,
+// at most 92KiB in all.
+constexpr size_t kMaxDepotBatches = 4;
+
+inline size_t sizeClassOf(size_t size) {
+    if (size <= kMinBlockSize) {
+        return 0;
+    }
+    return (sizeof(unsigned long) * 8 - __builtin_clzl(size - 1)) - kMinBlockShift;
+}
+
+inline size_t blockSizeOf(size_t sizeClass) {
+    return kMinBlockSize << sizeClass;
+}
+
+inline size_t batchBlocksOf(size_t sizeClass) {
+    size_t blocks = kBatchBytes / blockSizeOf(sizeClass);
+    return blocks > kMaxBatchBlocks ? kMaxBatchBlocks : blocks;
+}
+
+struct FreeBlock {
+    FreeBlock *mNext;
+};
+
+struct Stats {
+    std::atomic<uint64_t> mAllocations{0};
+    std::atomic<uint64_t> mSystemAllocations{0};
+    std::atomic<uint64_t> mSystemFrees{0};
+    std::atomic<uint64_t> mDepotRefills{0};
+    std::atomic<uint64_t> mDepotFlushes{0};
+};
+
+// Shared between all threads. Intentionally leaked so that threads exiting
+// during process teardown can still return their blocks.
+struct Depot {
+    std::mutex mLock;
+    std::vector<FreeBlock *> mBatches[kNumSizeClasses];  // each a list of batchBlocksOf() blocks
+    Stats mStats[kNumSizeClasses];
+    std::atomic<uint64_t> mOversizedAllocations{0};
+};
+
+Depot &depot() {
+    static Depot *sDepot = new Depot;
+    return *sDepot;
+}
+
+struct ThreadCache {
+    FreeBlock *mHead[kNumSizeClasses] = {};
+    size_t mCount[kNumSizeClasses] = {};
+    // allocations served since the counters were last published to the depot
+    uint64_t mPendingAllocations[kNumSizeClasses] = {};
+
+    ~ThreadCache();
+
+    void *allocate(size_t sizeClass);
+    void free(void *ptr, size_t sizeClass);
+
+private:
+    void refill(size_t sizeClass);
+    void flush(size_t sizeClass, size_t blocks);
+};
+
+thread_local ThreadCache tCache;
+// Set once tCache is destroyed; blocks freed afterwards on this thread bypass the cache.
+thread_local bool tCacheDestroyed = false;
+
+ThreadCache::~ThreadCache() {
+    for (size_t i = 0; i < kNumSizeClasses; ++i) {
+        flush(i, mCount[i]);
+    }
+    tCacheDestroyed = true;
+}
+
+void *ThreadCache::allocate(size_t sizeClass) {
+    ++mPendingAllocations[sizeClass];
+    if (mHead[sizeClass] == nullptr) {
+        refill(sizeClass);
+        if (mHead[sizeClass] == nullptr) {
+            depot().mStats[sizeClass].mSystemAllocations.fetch_add(1, std::memory_order_relaxed);
+            return malloc(blockSizeOf(sizeClass));
+        }
+    }
+    FreeBlock *block = mHead[sizeClass];
+    mHead[sizeClass] = block->mNext;
+    --mCount[sizeClass];
+    return block;
+}
+
+void ThreadCache::free(void *ptr, size_t sizeClass) {
+    FreeBlock *block = static_cast<FreeBlock *>(ptr);
+    block->mNext = mHead[sizeClass];
+    mHead[sizeClass] = block;
+    const size_t batch = batchBlocksOf(sizeClass);
+    if (++mCount[sizeClass] > 2 * batch) {
+        flush(sizeClass, batch);
+    }
+}
+
+void ThreadCache::refill(size_t sizeClass) {
+    Depot &d = depot();
+    Stats &stats = d.mStats[sizeClass];
+    stats.mAllocations.fetch_add(mPendingAllocations[sizeClass], std::memory_order_relaxed);
+    mPendingAllocations[sizeClass] = 0;
+
+    std::lock_guard<std::mutex> lock(d.mLock);
+    std::vector<FreeBlock *> &batches = d.mBatches[sizeClass];
+    if (batches.empty()) {
+        return;
+    }
+    mHead[sizeClass] = batches.back();
+    mCount[sizeClass] = batchBlocksOf(sizeClass);
+    batches.pop_back();
+    stats.mDepotRefills.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ThreadCache::flush(size_t sizeClass, size_t blocks) {
+    Depot &d = depot();
+    Stats &stats = d.mStats[sizeClass];
+    stats.mAllocations.fetch_add(mPendingAllocations[sizeClass], std::memory_order_relaxed);
+    mPendingAllocations[sizeClass] = 0;
+    if (blocks == 0) {
+        return;
+    }
+
+    // detach |blocks| blocks from the front of the list
+    FreeBlock *head = mHead[sizeClass];
+    FreeBlock *tail = head;
+    for (size_t i = 1; i < blocks; ++i) {
+        tail = tail->mNext;
+    }
+    mHead[sizeClass] = tail->mNext;
+    mCount[sizeClass] -= blocks;
+    tail->mNext = nullptr;
+
+    if (blocks == batchBlocksOf(sizeClass)) {
+        std::lock_guard<std::mutex> lock(d.mLock);
+        std::vector<FreeBlock *> &batches = d.mBatches[sizeClass];
+        if (batches.size() < kMaxDepotBatches) {
+            batches.push_back(head);
+            stats.mDepotFlushes.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    // depot is full, or this is a partial batch from an exiting thread
+    while (head != nullptr) {
+        FreeBlock *next = head->mNext;
+        ::free(head);
+        head = next;
+        stats.mSystemFrees.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace
+#endif  // A_OBJECT_POOL_DISABLED
+
+// static
+void *AObjectPool::Allocate(size_t size) {
+#ifndef A_OBJECT_POOL_DISABLED
+    if (size <= kMaxBlockSize) {
+        if (tCacheDestroyed) {
+            return malloc(blockSizeOf(sizeClassOf(size)));
+        }
+        return tCache.allocate(sizeClassOf(size));
+    }
+    depot().mOversizedAllocations.fetch_add(1, std::memory_order_relaxed);
+#endif
+    return malloc(size);
+}
+
+// static
+void AObjectPool::Free(void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return;
+    }
+#ifndef A_OBJECT_POOL_DISABLED
+    if (size <= kMaxBlockSize && !tCacheDestroyed) {
+        tCache.free(ptr, sizeClassOf(size));
+        return;
+    }
+#else
+    (void)size;
+#endif
+    ::free(ptr);
+}
+
+// static
+AString AObjectPool::DumpStats() {
+#ifdef A_OBJECT_POOL_DISABLED
+    return AString(" AObjectPool: disabled\n");
+#else
+    Depot &d = depot();
+    AString s(" AObjectPool (allocations counted lazily per thread):\n");
+    std::lock_guard<std::mutex> lock(d.mLock);
+    for (size_t i = 0; i < kNumSizeClasses; ++i) {
+        const Stats &stats = d.mStats[i];
+        s.append(AStringPrintf(
+                "  %5zu bytes: %" PRIu64 " allocs, %" PRIu64 " mallocs, %" PRIu64 " frees, "
+                "%" PRIu64 " refills, %" PRIu64 " flushes, %zu/%zu batches in depot\n",
+                blockSizeOf(i),
+                stats.mAllocations.load(std::memory_order_relaxed),
+                stats.mSystemAllocations.load(std::memory_order_relaxed),
+                stats.mSystemFrees.load(std::memory_order_relaxed),
+                stats.mDepotRefills.load(std::memory_order_relaxed),
+                stats.mDepotFlushes.load(std::memory_order_relaxed),
+                d.mBatches[i].size(), kMaxDepotBatches));
+    }
+    s.append(AStringPrintf("  oversized: %" PRIu64 " allocs\n",
+            d.mOversizedAllocations.load(std::memory_order_relaxed)));
+    return s;
+#endif
+}
+
+}  // namespace android
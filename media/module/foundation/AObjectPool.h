@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef A_OBJECT_POOL_H_
+
+#define A_OBJECT_POOL_H_
+
+#include <sys/types.h>
+
+#include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/AString.h>
+
+namespace android {
+
+// Size-classed block allocator backing the payloads of small ABuffers. Every
+// thread keeps a short free list per size class, so the buffer traffic of a
+// looper thread is mostly served without going to malloc. Surplus blocks move in
+// batches through a shared depot, which lets blocks freed on a looper thread be
+// reused by the threads posting to it.
+//
+// This is private to libstagefright_foundation: blocks are only allocated and
+// freed by code inside the library, never by code built against its headers.
+struct AObjectPool {
+    // Requests larger than this are passed straight to malloc()/free().
+    static constexpr size_t kMaxBlockSize = 4096;
+
+    // Returns NULL if the system allocator fails.
+    static void *Allocate(size_t size);
+
+    // |size| must be the size that was passed to Allocate().
+    static void Free(void *ptr, size_t size);
+
+    // Returns a human readable summary of the pool counters for dumpsys.
+    static AString DumpStats();
+
+private:
+    DISALLOW_EVIL_CONSTRUCTORS(AObjectPool);
+};
+
+}  // namespace android
+
+#endif  // A_OBJECT_POOL_H_
@@ -17,12 +17,18 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "MetaDataBase"
 #include <inttypes.h>
-#include <utils/KeyedVector.h>
 #include <utils/Log.h>
 
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AString.h>
 #include <media/stagefright/foundation/hexdump.h>
@@ -40,6 +46,8 @@ struct MetaDataBase::typed_data {
 
     typed_data(const MetaDataBase::typed_data &);
     typed_data &operator=(const MetaDataBase::typed_data &);
+    typed_data(MetaDataBase::typed_data &&) noexcept;
+    typed_data &operator=(MetaDataBase::typed_data &&) noexcept;
 
     void clear();
     void setData(uint32_t type, const void *data, size_t size);
@@ -51,24 +59,36 @@ private:
     uint32_t mType;
     size_t mSize;
 
+    // Strings, rects and other blobs live in a heap block shared by the copies
+    // of the item, so that the pointers returned by findData() stay valid until
+    // their key is set again or removed, whatever else is set and however the
+    // item array is moved or copied.
+    struct alignas(std::max_align_t) Payload {
+        std::atomic<int32_t> mRefCount;
+
+        void *data() { return this + 1; }
+    };
+
+    // Scalars are kept inline.
     union {
-        void *ext_data;
-        float reservoir;
+        Payload *payload;
+        int64_t reservoir;
     } u;
 
     bool usesReservoir() const {
-        return mSize <= sizeof(u.reservoir);
+        return (mType == TYPE_INT32 || mType == TYPE_INT64 || mType == TYPE_FLOAT
+                || mType == TYPE_POINTER) && mSize <= sizeof(u.reservoir);
     }
 
     void *allocateStorage(size_t size);
     void freeStorage();
 
     void *storage() {
-        return usesReservoir() ? &u.reservoir : u.ext_data;
+        return usesReservoir() ? &u.reservoir : (u.payload ? u.payload->data() : NULL);
     }
 
     const void *storage() const {
-        return usesReservoir() ? &u.reservoir : u.ext_data;
+        return usesReservoir() ? &u.reservoir : (u.payload ? u.payload->data() : NULL);
     }
 };
 
@@ -77,8 +97,43 @@ struct MetaDataBase::Rect {
 };
 
 
+// Items are kept in a flat array sorted by key. The array is shared between
+// copies of a MetaDataBase and only duplicated when one of them is modified,
+// so copying track formats around is cheap.
 struct MetaDataBase::MetaDataInternal {
-    KeyedVector<uint32_t, MetaDataBase::typed_data> mItems;
+    typedef std::pair<uint32_t, MetaDataBase::typed_data> Item;
+    std::vector<Item> mItems;
+    std::atomic<int32_t> mRefCount{1};
+
+    MetaDataInternal() {}
+    MetaDataInternal(const MetaDataInternal &from) : mItems(from.mItems) {}
+
+    ssize_t indexOfKey(uint32_t key) const {
+        auto it = lowerBound(key);
+        if (it == mItems.end() || it->first != key) {
+            return -1;
+        }
+        return it - mItems.begin();
+    }
+
+    std::vector<Item>::const_iterator lowerBound(uint32_t key) const {
+        return std::lower_bound(mItems.begin(), mItems.end(), key,
+                [](const Item &item, uint32_t k) { return item.first < k; });
+    }
+
+    void acquire() {
+        mRefCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() {
+        if (mRefCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    bool isShared() const {
+        return mRefCount.load(std::memory_order_acquire) > 1;
+    }
 };
 
 
@@ -87,32 +142,51 @@ MetaDataBase::MetaDataBase()
 }
 
 MetaDataBase::MetaDataBase(const MetaDataBase &from)
-    : mInternalData(new MetaDataInternal()) {
-    mInternalData->mItems = from.mInternalData->mItems;
+    : mInternalData(from.mInternalData) {
+    mInternalData->acquire();
 }
 
 MetaDataBase& MetaDataBase::operator = (const MetaDataBase &rhs) {
-    this->mInternalData->mItems = rhs.mInternalData->mItems;
+    if (mInternalData != rhs.mInternalData) {
+        rhs.mInternalData->acquire();
+        mInternalData->release();
+        mInternalData = rhs.mInternalData;
+    }
     return *this;
 }
 
 MetaDataBase::~MetaDataBase() {
-    clear();
-    delete mInternalData;
+    mInternalData->release();
+}
+
+MetaDataBase::MetaDataInternal *MetaDataBase::editInternalData() {
+    if (mInternalData->isShared()) {
+        MetaDataInternal *copy = new MetaDataInternal(*mInternalData);
+        mInternalData->release();
+        mInternalData = copy;
+    }
+    return mInternalData;
 }
 
 void MetaDataBase::clear() {
-    mInternalData->mItems.clear();
+    if (mInternalData->isShared()) {
+        mInternalData->release();
+        mInternalData = new MetaDataInternal();
+    } else {
+        // keeps the capacity, as the same buffer meta data is refilled for every sample
+        mInternalData->mItems.clear();
+    }
 }
 
 bool MetaDataBase::remove(uint32_t key) {
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
+    ssize_t i = mInternalData->indexOfKey(key);
 
     if (i < 0) {
         return false;
     }
 
-    mInternalData->mItems.removeItemsAt(i);
+    MetaDataInternal *internal = editInternalData();
+    internal->mItems.erase(internal->mItems.begin() + i);
 
     return true;
 }
@@ -151,7 +225,8 @@ bool MetaDataBase::setRect(
 }
 
 /**
- * Note that the returned pointer becomes invalid when additional metadata is set.
+ * Note that the returned pointer becomes invalid when |key| is set again or removed,
+ * or when the metadata is cleared or destroyed.
  */
 bool MetaDataBase::findCString(uint32_t key, const char **value) const {
     uint32_t type;
@@ -250,32 +325,34 @@ bool MetaDataBase::findRect(
 
 bool MetaDataBase::setData(
         uint32_t key, uint32_t type, const void *data, size_t size) {
-    bool overwrote_existing = true;
+    // Copy the value first: |data| may point into this meta data, which the
+    // update below may free.
+    typed_data item;
+    item.setData(type, data, size);
 
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
-    if (i < 0) {
-        typed_data item;
-        i = mInternalData->mItems.add(key, item);
+    MetaDataInternal *internal = editInternalData();
+    std::vector<MetaDataInternal::Item> &items = internal->mItems;
 
-        overwrote_existing = false;
+    auto it = items.begin() + (internal->lowerBound(key) - items.cbegin());
+    bool overwrote_existing = it != items.end() && it->first == key;
+    if (overwrote_existing) {
+        it->second = std::move(item);
+    } else {
+        items.emplace(it, key, std::move(item));
     }
 
-    typed_data &item = mInternalData->mItems.editValueAt(i);
-
-    item.setData(type, data, size);
-
     return overwrote_existing;
 }
 
 bool MetaDataBase::findData(uint32_t key, uint32_t *type,
                         const void **data, size_t *size) const {
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
+    ssize_t i = mInternalData->indexOfKey(key);
 
     if (i < 0) {
         return false;
     }
 
-    const typed_data &item = mInternalData->mItems.valueAt(i);
+    const typed_data &item = mInternalData->mItems[i].second;
 
     item.getData(type, data, size);
 
@@ -283,7 +360,7 @@ bool MetaDataBase::findData(uint32_t key, uint32_t *type,
 }
 
 bool MetaDataBase::hasData(uint32_t key) const {
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
+    ssize_t i = mInternalData->indexOfKey(key);
 
     if (i < 0) {
         return false;
@@ -295,6 +372,7 @@ bool MetaDataBase::hasData(uint32_t key) const {
 MetaDataBase::typed_data::typed_data()
     : mType(0),
       mSize(0) {
+    u.payload = NULL;
 }
 
 MetaDataBase::typed_data::~typed_data() {
@@ -303,23 +381,43 @@ MetaDataBase::typed_data::~typed_data() {
 
 MetaDataBase::typed_data::typed_data(const typed_data &from)
     : mType(from.mType),
-      mSize(0) {
-
-    void *dst = allocateStorage(from.mSize);
-    if (dst) {
-        memcpy(dst, from.storage(), mSize);
+      mSize(from.mSize),
+      u(from.u) {
+    if (!usesReservoir() && u.payload != NULL) {
+        u.payload->mRefCount.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
+MetaDataBase::typed_data::typed_data(typed_data &&from) noexcept
+    : mType(from.mType),
+      mSize(from.mSize),
+      u(from.u) {
+    // |from| no longer owns the payload
+    from.mType = 0;
+    from.mSize = 0;
+    from.u.payload = NULL;
+}
+
 MetaDataBase::typed_data &MetaDataBase::typed_data::operator=(
-        const MetaDataBase::typed_data &from) {
+        MetaDataBase::typed_data &&from) noexcept {
     if (this != &from) {
         clear();
         mType = from.mType;
-        void *dst = allocateStorage(from.mSize);
-        if (dst) {
-            memcpy(dst, from.storage(), mSize);
-        }
+        mSize = from.mSize;
+        u = from.u;
+        from.mType = 0;
+        from.mSize = 0;
+        from.u.payload = NULL;
+    }
+
+    return *this;
+}
+
+MetaDataBase::typed_data &MetaDataBase::typed_data::operator=(
+        const MetaDataBase::typed_data &from) {
+    if (this != &from) {
+        typed_data copy(from);
+        *this = std::move(copy);
     }
 
     return *this;
@@ -357,20 +455,23 @@ void *MetaDataBase::typed_data::allocateStorage(size_t size) {
         return &u.reservoir;
     }
 
-    u.ext_data = malloc(mSize);
-    if (u.ext_data == NULL) {
+    u.payload = (Payload *)malloc(sizeof(Payload) + mSize);
+    if (u.payload == NULL) {
         ALOGE("Couldn't allocate %zu bytes for item", size);
         mSize = 0;
+        return NULL;
     }
-    return u.ext_data;
+    new (&u.payload->mRefCount) std::atomic<int32_t>(1);
+    return u.payload->data();
 }
 
 void MetaDataBase::typed_data::freeStorage() {
     if (!usesReservoir()) {
-        if (u.ext_data) {
-            free(u.ext_data);
-            u.ext_data = NULL;
+        if (u.payload != NULL
+                && u.payload->mRefCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            free(u.payload);
         }
+        u.payload = NULL;
     }
 
     mSize = 0;
@@ -430,10 +531,10 @@ static void MakeFourCCString(uint32_t x, char *s) {
 String8 MetaDataBase::toString() const {
     String8 s;
     for (int i = mInternalData->mItems.size(); --i >= 0;) {
-        int32_t key = mInternalData->mItems.keyAt(i);
+        int32_t key = mInternalData->mItems[i].first;
         char cc[5];
         MakeFourCCString(key, cc);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
+        const typed_data &item = mInternalData->mItems[i].second;
         s.appendFormat("%s: %s", cc, item.asString(false).string());
         if (i != 0) {
             s.append(", ");
@@ -444,10 +545,10 @@ String8 MetaDataBase::toString() const {
 
 void MetaDataBase::dumpToLog() const {
     for (int i = mInternalData->mItems.size(); --i >= 0;) {
-        int32_t key = mInternalData->mItems.keyAt(i);
+        int32_t key = mInternalData->mItems[i].first;
         char cc[5];
         MakeFourCCString(key, cc);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
+        const typed_data &item = mInternalData->mItems[i].second;
         ALOGI("%s: %s", cc, item.asString(true /* verbose */).string());
     }
 }
@@ -461,8 +562,8 @@ status_t MetaDataBase::writeToParcel(Parcel &parcel) {
         return ret;
     }
     for (size_t i = 0; i < numItems; i++) {
-        int32_t key = mInternalData->mItems.keyAt(i);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
+        int32_t key = mInternalData->mItems[i].first;
+        const typed_data &item = mInternalData->mItems[i].second;
         uint32_t type;
         const void *data;
         size_t size;
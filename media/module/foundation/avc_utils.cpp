@@ -18,6 +18,7 @@
 #define LOG_TAG "avc_utils"
 #include <utils/Log.h>
 
+#include <string.h>
 
 #include <media/stagefright/foundation/ABitReader.h>
 #include <media/stagefright/foundation/ADebug.h>
@@ -288,6 +289,27 @@ void FindAVCDimensions(
     }
 }
 
+const uint8_t *findNextStartCode(const uint8_t *data, size_t size) {
+    if (size < 3) {
+        return NULL;
+    }
+    // Look for the 0x01 byte, then check the two bytes before it.
+    const uint8_t *end = data + size;
+    const uint8_t *ptr = data + 2;
+    while (ptr < end) {
+        ptr = (const uint8_t *)memchr(ptr, 0x01, end - ptr);
+        if (ptr == NULL) {
+            return NULL;
+        }
+        if (ptr[-1] == 0x00 && ptr[-2] == 0x00) {
+            return ptr - 2;
+        }
+        // The 0x01 byte cannot be one of the two 0x00 bytes of the next start code.
+        ptr += 3;
+    }
+    return NULL;
+}
+
 status_t getNextNALUnit(
         const uint8_t **_data, size_t *_size,
         const uint8_t **nalStart, size_t *nalSize,
@@ -302,43 +324,25 @@ status_t getNextNALUnit(
         return -EAGAIN;
     }
 
-    size_t offset = 0;
-
     // A valid startcode consists of at least two 0x00 bytes followed by 0x01.
-    for (; offset + 2 < size; ++offset) {
-        if (data[offset + 2] == 0x01 && data[offset] == 0x00
-                && data[offset + 1] == 0x00) {
-            break;
-        }
-    }
-    if (offset + 2 >= size) {
-        *_data = &data[offset];
+    const uint8_t *startCode = findNextStartCode(data, size);
+    if (startCode == NULL) {
+        *_data = &data[size - 2];
         *_size = 2;
         return -EAGAIN;
     }
-    offset += 3;
+    size_t offset = startCode - data + 3;
 
     size_t startOffset = offset;
 
-    for (;;) {
-        while (offset < size && data[offset] != 0x01) {
-            ++offset;
-        }
-
-        if (offset == size) {
-            if (startCodeFollows) {
-                offset = size + 2;
-                break;
-            }
-
-            return -EAGAIN;
-        }
-
-        if (data[offset - 1] == 0x00 && data[offset - 2] == 0x00) {
-            break;
-        }
-
-        ++offset;
+    // |offset| is that of the 0x01 byte of the next start code.
+    startCode = findNextStartCode(&data[startOffset], size - startOffset);
+    if (startCode != NULL) {
+        offset = startCode - data + 2;
+    } else if (startCodeFollows) {
+        offset = size + 2;
+    } else {
+        return -EAGAIN;
     }
 
     size_t endOffset = offset - 2;
@@ -26,6 +26,9 @@
 #include <utils/RefBase.h>
 #include <utils/threads.h>
 
+#include <deque>
+#include <vector>
+
 namespace android {
 
 struct AHandler;
@@ -69,16 +72,25 @@ private:
 
     struct Event {
         int64_t mWhenUs;
+        uint64_t mSeq;  // keeps events posted for the same time in FIFO order
         sp<AMessage> mMessage;
         sp<RefBase> mToken;
     };
 
+    // Heap comparator that puts the earliest event at the front of mEventQueue.
+    static bool EventLater(const Event &a, const Event &b);
+
     Mutex mLock;
     Condition mQueueChangedCondition;
 
     AString mName;
 
-    List<Event> mEventQueue;
+    // Pending events, kept as a binary min-heap on (mWhenUs, mSeq).
+    std::vector<Event> mEventQueue;
+    // Events that are due, in delivery order. All events that have expired are
+    // moved here together, so a burst of them costs one clock read.
+    std::deque<Event> mDueEvents;
+    uint64_t mNextEventSeq;
 
     struct LooperThread;
     sp<LooperThread> mThread;
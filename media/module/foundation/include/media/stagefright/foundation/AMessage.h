@@ -200,6 +200,9 @@ struct AMessage : public RefBase {
 
     size_t countEntries() const;
     static size_t maxAllowedEntries();
+    // The returned name points into this message. Short names are stored inside the
+    // entries, so any call adding, removing or renaming an entry, or clear(), invalidates
+    // the names returned before. Copy the name if the message may change meanwhile.
     const char *getEntryNameAt(size_t index, Type *type) const;
 
     /**
@@ -295,6 +298,12 @@ private:
     wp<AHandler> mHandler;
     wp<ALooper> mLooper;
 
+    enum {
+        // Names up to this length are stored inside the Item itself, which covers
+        // nearly all keys used by the media framework.
+        kMaxInlineNameLength = 23,
+    };
+
     struct Item {
         union {
             int32_t int32Value;
@@ -307,11 +316,20 @@ private:
             AString *stringValue;
             Rect rectValue;
         } u;
-        const char *mName;
+        union {
+            char *mHeapName;    // used if mNameLength > kMaxInlineNameLength
+            char mInlineName[kMaxInlineNameLength + 1];
+        };
         size_t      mNameLength;
+        uint32_t    mNameHash;
         Type mType;
+        const char *name() const {
+            return mNameLength > kMaxInlineNameLength ? mHeapName : mInlineName;
+        }
         void setName(const char *name, size_t len);
-        Item() : mName(nullptr), mNameLength(0), mType(kTypeInt32) { }
+        // frees a heap allocated name and resets the name to empty
+        void freeName();
+        Item() : mNameLength(0), mNameHash(0), mType(kTypeInt32) { mInlineName[0] = '\0'; }
         Item(const char *name, size_t length);
     };
 
@@ -320,6 +338,16 @@ private:
     };
     std::vector<Item> mItems;
 
+    enum {
+        // Up to this many items, scanning the name hashes of the items is faster than
+        // going through mIndex.
+        kMaxUnindexedItems = 8,
+    };
+    // Open addressing hash table of the items by name hash, holding item index + 1 and 0
+    // for empty slots. It is empty while there are at most kMaxUnindexedItems items,
+    // and has at least twice as many slots as items otherwise.
+    std::vector<uint16_t> mIndex;
+
     /**
      * Allocates an item with the given key |name|. If the key already exists, the corresponding
      * item value is freed. Otherwise a new item is added.
@@ -351,6 +379,14 @@ private:
 
     size_t findItemIndex(const char *name, size_t len) const;
 
+    // Adds the last item to mIndex, growing it if needed.
+    void indexLastItem();
+    // Rebuilds mIndex after items were removed, renamed or moved.
+    void rebuildIndex();
+    void insertIntoIndex(size_t i);
+
+    static uint32_t HashName(const char *name, size_t len);
+
     void deliver();
 
     DISALLOW_EVIL_CONSTRUCTORS(AMessage);
@@ -75,6 +75,10 @@ inline void skipSE(ABitReader *br) {
     (void)parseSEWithFallback(br, 0);
 }
 
+// Returns a pointer to the first "0x00 0x00 0x01" start code in |data|, or NULL
+// if there is none. Scanning uses memchr(), which is vectorized by libc.
+const uint8_t *findNextStartCode(const uint8_t *data, size_t size);
+
 status_t getNextNALUnit(
         const uint8_t **_data, size_t *_size,
         const uint8_t **nalStart, size_t *nalSize,
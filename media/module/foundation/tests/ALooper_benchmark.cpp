@@ -0,0 +1,158 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+using namespace android;
+
+namespace {
+
+// Records how late each message is delivered relative to the time it was due.
+struct LatencyHandler : public AHandler {
+    void expect(size_t count) {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExpected = count;
+        mLatenciesUs.clear();
+    }
+
+    std::vector<int64_t> wait() {
+        std::unique_lock<std::mutex> lock(mLock);
+        mCondition.wait(lock, [this] { return mLatenciesUs.size() >= mExpected; });
+        return mLatenciesUs;
+    }
+
+protected:
+    void onMessageReceived(const sp<AMessage> &msg) override {
+        int64_t dueUs;
+        if (!msg->findInt64("dueUs", &dueUs)) {
+            return;  // background traffic
+        }
+        int64_t latencyUs = ALooper::GetNowUs() - dueUs;
+        std::lock_guard<std::mutex> lock(mLock);
+        mLatenciesUs.push_back(latencyUs);
+        if (mLatenciesUs.size() >= mExpected) {
+            mCondition.notify_one();
+        }
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::vector<int64_t> mLatenciesUs;
+    size_t mExpected = 0;
+};
+
+struct LooperFixture {
+    LooperFixture() : mLooper(new ALooper), mHandler(new LatencyHandler) {
+        mLooper->setName("ALooper_benchmark");
+        mLooper->registerHandler(mHandler);
+        mLooper->start();
+    }
+
+    ~LooperFixture() {
+        mLooper->unregisterHandler(mHandler->id());
+        mLooper->stop();
+    }
+
+    sp<ALooper> mLooper;
+    sp<LatencyHandler> mHandler;
+};
+
+}  // namespace
+
+// Cost of posting a delayed message into a queue that already holds
+// |state.range(0)| pending timeouts, as with NuPlayerRenderer and ACodec.
+static void BM_ALooperPostDelayed(benchmark::State& state) {
+    const size_t pending = state.range(0);
+    LooperFixture fixture;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int64_t> delayUs(60000000LL, 120000000LL);
+
+    for (size_t i = 0; i < pending; ++i) {
+        (new AMessage('pend', fixture.mHandler))->post(delayUs(rng));
+    }
+    sp<AMessage> msg = new AMessage('time', fixture.mHandler);
+    for (auto _ : state) {
+        msg->post(delayUs(rng));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ALooperPostDelayed)->Arg(0)->Arg(16)->Arg(256)->Arg(4096);
+
+// Cost of rescheduling a unique timeout, as done for repeated timeouts.
+static void BM_ALooperPostUnique(benchmark::State& state) {
+    const size_t pending = state.range(0);
+    LooperFixture fixture;
+    for (size_t i = 0; i < pending; ++i) {
+        (new AMessage('pend', fixture.mHandler))->post(60000000LL + i);
+    }
+    sp<RefBase> token = new RefBase;
+    sp<AMessage> msg = new AMessage('uniq', fixture.mHandler);
+    int64_t delayUs = 30000000LL;
+    for (auto _ : state) {
+        msg->postUnique(token, delayUs++);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ALooperPostUnique)->Arg(0)->Arg(256)->Arg(4096);
+
+// Delivery latency and jitter of delayed messages that fall due together,
+// while the queue also holds |state.range(0)| unrelated timeouts.
+static void BM_ALooperDelayedDeliveryJitter(benchmark::State& state) {
+    constexpr size_t kBurst = 32;
+    constexpr int64_t kDelayUs = 2000;
+    const size_t pending = state.range(0);
+    LooperFixture fixture;
+    for (size_t i = 0; i < pending; ++i) {
+        (new AMessage('pend', fixture.mHandler))->post(60000000LL + i);
+    }
+
+    std::vector<int64_t> latenciesUs;
+    for (auto _ : state) {
+        fixture.mHandler->expect(kBurst);
+        int64_t dueUs = ALooper::GetNowUs() + kDelayUs;
+        for (size_t i = 0; i < kBurst; ++i) {
+            sp<AMessage> msg = new AMessage('late', fixture.mHandler);
+            msg->setInt64("dueUs", dueUs);
+            msg->post(dueUs - ALooper::GetNowUs());
+        }
+        std::vector<int64_t> burst = fixture.mHandler->wait();
+        latenciesUs.insert(latenciesUs.end(), burst.begin(), burst.end());
+    }
+
+    if (!latenciesUs.empty()) {
+        std::sort(latenciesUs.begin(), latenciesUs.end());
+        int64_t sumUs = 0;
+        for (int64_t latencyUs : latenciesUs) {
+            sumUs += latencyUs;
+        }
+        state.counters["meanUs"] = (double)sumUs / latenciesUs.size();
+        state.counters["p50Us"] = latenciesUs[latenciesUs.size() / 2];
+        state.counters["p99Us"] = latenciesUs[latenciesUs.size() * 99 / 100];
+        state.counters["maxUs"] = latenciesUs.back();
+    }
+}
+BENCHMARK(BM_ALooperDelayedDeliveryJitter)->Arg(0)->Arg(4096)->UseRealTime();
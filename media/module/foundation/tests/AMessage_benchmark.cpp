@@ -0,0 +1,195 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <condition_variable>
+#include <mutex>
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+using namespace android;
+
+// Message shapes modeled after the traffic between MediaCodec, ACodec and NuPlayer.
+
+// MediaCodec kWhatDrainThisBuffer / ACodec buffer callbacks: a handful of small keys.
+static sp<AMessage> makeBufferMessage() {
+    sp<AMessage> msg = new AMessage;
+    msg->setSize("index", 3);
+    msg->setSize("offset", 0);
+    msg->setSize("size", 4096);
+    msg->setInt64("timeUs", 33366);
+    msg->setInt32("flags", 1);
+    msg->setBuffer("buffer", new ABuffer(16));
+    return msg;
+}
+
+// An output format of a video decoder, including a few long vendor keys.
+static sp<AMessage> makeVideoFormat() {
+    sp<AMessage> msg = new AMessage;
+    msg->setString("mime", "video/avc");
+    msg->setInt32("width", 3840);
+    msg->setInt32("height", 2160);
+    msg->setInt32("stride", 3840);
+    msg->setInt32("slice-height", 2160);
+    msg->setInt32("color-format", 0x7f420888);
+    msg->setRect("crop", 0, 0, 3839, 2159);
+    msg->setInt32("color-range", 2);
+    msg->setInt32("color-standard", 1);
+    msg->setInt32("color-transfer", 3);
+    msg->setInt32("android._dataspace", 0x10c10000);
+    msg->setInt32("android._video-scaling", 1);
+    msg->setInt32("max-input-size", 6291456);
+    msg->setInt32("priority", 0);
+    msg->setFloat("frame-rate", 60.0f);
+    msg->setInt32("vendor.qti-ext-dec-picture-order.enable", 1);
+    msg->setInt32("vendor.qti-ext-dec-low-latency.enable", 0);
+    msg->setInt64("durationUs", 7200000000LL);
+    msg->setString("language", "und");
+    msg->setInt32("rotation-degrees", 0);
+    return msg;
+}
+
+static void BM_AMessageBuildBufferMessage(benchmark::State& state) {
+    for (auto _ : state) {
+        sp<AMessage> msg = makeBufferMessage();
+        benchmark::DoNotOptimize(msg.get());
+    }
+}
+BENCHMARK(BM_AMessageBuildBufferMessage);
+
+static void BM_AMessageFindBufferMessage(benchmark::State& state) {
+    sp<AMessage> msg = makeBufferMessage();
+    size_t index, offset, size;
+    int64_t timeUs;
+    int32_t flags;
+    sp<ABuffer> buffer;
+    for (auto _ : state) {
+        msg->findSize("index", &index);
+        msg->findSize("offset", &offset);
+        msg->findSize("size", &size);
+        msg->findInt64("timeUs", &timeUs);
+        msg->findInt32("flags", &flags);
+        msg->findBuffer("buffer", &buffer);
+        benchmark::DoNotOptimize(timeUs);
+    }
+}
+BENCHMARK(BM_AMessageFindBufferMessage);
+
+static void BM_AMessageFindVideoFormat(benchmark::State& state) {
+    sp<AMessage> msg = makeVideoFormat();
+    int32_t value;
+    for (auto _ : state) {
+        msg->findInt32("width", &value);
+        msg->findInt32("height", &value);
+        msg->findInt32("color-format", &value);
+        msg->findInt32("android._dataspace", &value);
+        msg->findInt32("vendor.qti-ext-dec-low-latency.enable", &value);
+        msg->findInt32("rotation-degrees", &value);
+        // misses are common, e.g. probing optional keys
+        msg->findInt32("hdr-static-info", &value);
+        msg->findInt32("low-latency", &value);
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK(BM_AMessageFindVideoFormat);
+
+static void BM_AMessageDupVideoFormat(benchmark::State& state) {
+    sp<AMessage> msg = makeVideoFormat();
+    for (auto _ : state) {
+        sp<AMessage> copy = msg->dup();
+        benchmark::DoNotOptimize(copy.get());
+    }
+}
+BENCHMARK(BM_AMessageDupVideoFormat);
+
+static void BM_AMessageChangesFromVideoFormat(benchmark::State& state) {
+    sp<AMessage> format = makeVideoFormat();
+    sp<AMessage> newFormat = format->dup();
+    newFormat->setInt32("width", 1920);
+    newFormat->setInt32("height", 1080);
+    for (auto _ : state) {
+        sp<AMessage> diff = newFormat->changesFrom(format);
+        benchmark::DoNotOptimize(diff.get());
+    }
+}
+BENCHMARK(BM_AMessageChangesFromVideoFormat);
+
+// Allocation churn of access-unit sized buffers, as in ATSParser and the RTSP assemblers.
+static void BM_ABufferSmallAllocation(benchmark::State& state) {
+    const size_t size = state.range(0);
+    for (auto _ : state) {
+        sp<ABuffer> buffer = new ABuffer(size);
+        buffer->meta()->setInt64("timeUs", 0);
+        benchmark::DoNotOptimize(buffer->data());
+    }
+}
+BENCHMARK(BM_ABufferSmallAllocation)->Arg(188)->Arg(1500)->Arg(4096)->Arg(65536);
+
+// Posts from the benchmark thread and frees on the looper thread, which is the
+// pattern the per-thread caches of AObjectPool need to handle.
+struct CountingHandler : public AHandler {
+    void waitFor(size_t count) {
+        std::unique_lock<std::mutex> lock(mLock);
+        mCondition.wait(lock, [this, count] { return mReceived >= count; });
+        mReceived = 0;
+    }
+
+protected:
+    void onMessageReceived(const sp<AMessage> &msg) override {
+        sp<ABuffer> buffer;
+        msg->findBuffer("buffer", &buffer);
+        std::lock_guard<std::mutex> lock(mLock);
+        ++mReceived;
+        mCondition.notify_one();
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    size_t mReceived = 0;
+};
+
+static void BM_AMessagePostToLooper(benchmark::State& state) {
+    constexpr size_t kBurst = 64;
+    sp<ALooper> looper = new ALooper;
+    sp<CountingHandler> handler = new CountingHandler;
+    looper->setName("AMessage_benchmark");
+    looper->registerHandler(handler);
+    looper->start();
+
+    sp<AMessage> proto = new AMessage('drai', handler);
+    for (auto _ : state) {
+        for (size_t i = 0; i < kBurst; ++i) {
+            sp<AMessage> msg = proto->dup();
+            msg->setSize("index", i);
+            msg->setInt64("timeUs", i * 16666);
+            msg->setBuffer("buffer", new ABuffer(188));
+            msg->post();
+        }
+        handler->waitFor(kBurst);
+    }
+    state.SetItemsProcessed(state.iterations() * kBurst);
+
+    looper->unregisterHandler(handler->id());
+    looper->stop();
+}
+BENCHMARK(BM_AMessagePostToLooper)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -24,6 +24,7 @@
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AHandler.h>
 #include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AString.h>
 
 using namespace android;
 
@@ -169,6 +170,99 @@ TEST(AMessage_tests, settersAndGetters) {
   EXPECT_NE(OK, m1->removeEntryByName("notpresent"));
 }
 
+TEST(AMessage_tests, shortAndLongNames) {
+  sp<AMessage> m1 = new AMessage();
+
+  // names on either side of the inline storage limit
+  const char *kShort = "width";
+  const char *kLong = "vendor.qti-ext-enc-custom-profile-level.value";
+  m1->setInt32(kShort, 1);
+  m1->setInt32(kLong, 2);
+  m1->setString("android._encoding-statistics-level", "none");
+
+  int32_t i32;
+  EXPECT_TRUE(m1->findInt32(kShort, &i32));
+  EXPECT_EQ(1, i32);
+  EXPECT_TRUE(m1->findInt32(kLong, &i32));
+  EXPECT_EQ(2, i32);
+  EXPECT_FALSE(m1->findInt32("widt", &i32));
+
+  // names survive dup() and renaming
+  sp<AMessage> m2 = m1->dup();
+  EXPECT_TRUE(m2->findInt32(kLong, &i32));
+  EXPECT_EQ(2, i32);
+  EXPECT_EQ(OK, m2->setEntryNameAt(m2->findEntryByName(kShort), "a-much-longer-name-for-width"));
+  EXPECT_TRUE(m2->findInt32("a-much-longer-name-for-width", &i32));
+  EXPECT_EQ(1, i32);
+  EXPECT_FALSE(m2->findInt32(kShort, &i32));
+  EXPECT_TRUE(m1->findInt32(kShort, &i32));
+
+  // removal moves the last entry into the freed slot
+  EXPECT_EQ(OK, m2->removeEntryByName("a-much-longer-name-for-width"));
+  AString str;
+  EXPECT_TRUE(m2->findString("android._encoding-statistics-level", &str));
+  EXPECT_EQ(AString("none"), str);
+
+  // extending a message with itself must not read moved names
+  m2->extend(m2);
+  EXPECT_EQ(2, m2->countEntries());
+}
+
+TEST(AMessage_tests, manyEntries) {
+  sp<AMessage> m1 = new AMessage();
+  const auto name = [](int i) { return AStringPrintf("key-%d", i); };
+
+  // past the size where entries are looked up through the index
+  for (int i = 0; i < 100; ++i) {
+    m1->setInt32(name(i).c_str(), i);
+  }
+  EXPECT_EQ(100u, m1->countEntries());
+  int32_t i32;
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(m1->findInt32(name(i).c_str(), &i32));
+    EXPECT_EQ(i, i32);
+  }
+  EXPECT_FALSE(m1->contains("key-100"));
+  // setting an existing entry does not add one
+  m1->setInt32("key-50", 500);
+  EXPECT_EQ(100u, m1->countEntries());
+  EXPECT_TRUE(m1->findInt32("key-50", &i32));
+  EXPECT_EQ(500, i32);
+
+  sp<AMessage> m2 = m1->dup();
+  EXPECT_EQ(OK, m2->setEntryNameAt(m2->findEntryByName("key-7"), "renamed"));
+  EXPECT_FALSE(m2->contains("key-7"));
+  EXPECT_TRUE(m2->findInt32("renamed", &i32));
+  EXPECT_EQ(7, i32);
+  EXPECT_TRUE(m1->contains("key-7"));
+
+  // removals move entries around, down to where the entries are scanned again
+  for (int i = 0; i < 97; ++i) {
+    if (i != 7) {
+      EXPECT_EQ(OK, m2->removeEntryByName(name(i).c_str()));
+    }
+  }
+  EXPECT_EQ(4u, m2->countEntries());
+  for (int i = 97; i < 100; ++i) {
+    EXPECT_TRUE(m2->findInt32(name(i).c_str(), &i32));
+    EXPECT_EQ(i, i32);
+  }
+  EXPECT_TRUE(m2->contains("renamed"));
+  EXPECT_FALSE(m2->contains("key-0"));
+
+  m2->extend(m1);
+  EXPECT_EQ(101u, m2->countEntries());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(m2->contains(name(i).c_str()));
+  }
+
+  m2->clear();
+  EXPECT_EQ(0u, m2->countEntries());
+  EXPECT_FALSE(m2->contains("key-99"));
+  m2->setInt32("key-99", 1);
+  EXPECT_TRUE(m2->contains("key-99"));
+}
+
 TEST(AMessage_tests, deliversMultipleMessagesInOrderImmediately) {
   sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
   sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
@@ -349,6 +349,53 @@ TEST_P(AVCFrameTest, FrameTest) {
     }
 }
 
+TEST(StartCodeTest, FindNextStartCodeTest) {
+    // Mostly 0x00 and 0x01 bytes, so that there are many partial start codes.
+    uint8_t data[256];
+    uint32_t seed = 1;
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (seed >> 16) % 5 < 3 ? 0x00 : (seed >> 16) % 5 == 3 ? 0x01 : seed >> 24;
+    }
+
+    for (size_t start = 0; start < sizeof(data); ++start) {
+        for (size_t size = 0; start + size <= sizeof(data); size += 7) {
+            const uint8_t *expected = nullptr;
+            for (size_t i = start; i + 2 < start + size; ++i) {
+                if (data[i] == 0x00 && data[i + 1] == 0x00 && data[i + 2] == 0x01) {
+                    expected = &data[i];
+                    break;
+                }
+            }
+            ASSERT_EQ(findNextStartCode(&data[start], size), expected)
+                    << "Wrong start code in " << size << " bytes at offset " << start;
+        }
+    }
+}
+
+TEST(StartCodeTest, GetNextNALUnitTest) {
+    const uint8_t data[] = {0x00, 0x00, 0x00, 0x01, 0x09, 0xf0, 0x00, 0x00, 0x01,
+                            0x67, 0x42, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x68, 0xce};
+    const uint8_t *ptr = data;
+    size_t size = sizeof(data);
+    const uint8_t *nalStart;
+    size_t nalSize;
+
+    ASSERT_EQ(getNextNALUnit(&ptr, &size, &nalStart, &nalSize, true), OK);
+    ASSERT_EQ(nalStart, &data[4]);
+    ASSERT_EQ(nalSize, 2);
+
+    ASSERT_EQ(getNextNALUnit(&ptr, &size, &nalStart, &nalSize, true), OK);
+    ASSERT_EQ(nalStart, &data[9]);
+    ASSERT_EQ(nalSize, 4) << "Trailing zero bytes must not be part of the NAL unit";
+
+    ASSERT_EQ(getNextNALUnit(&ptr, &size, &nalStart, &nalSize, true), OK);
+    ASSERT_EQ(nalStart, &data[17]);
+    ASSERT_EQ(nalSize, 2);
+
+    ASSERT_EQ(getNextNALUnit(&ptr, &size, &nalStart, &nalSize, true), -EAGAIN);
+}
+
 INSTANTIATE_TEST_SUITE_P(AVCUtilsTestAll, MpegAudioUnitTest,
                          ::testing::Values(make_tuple(0xFFFB9204, 418, 44100, 2, 128, 1152),
                                            make_tuple(0xFFFB7604, 289, 48000, 2, 96, 1152),
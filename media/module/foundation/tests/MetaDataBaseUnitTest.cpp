@@ -276,4 +276,71 @@ TEST_F(MetaDataBaseUnitTest, ConvertToStringTest) {
                                 << info.length();
 }
 
+TEST_F(MetaDataBaseUnitTest, PointerStabilityTest) {
+    std::unique_ptr<MetaDataBase> metaData(new MetaDataBase());
+    ASSERT_NE(metaData, nullptr) << "Failed to create meta data";
+
+    // Short values used to be stored inside the item array, which moves when
+    // other keys are inserted.
+    metaData->setCString(kKeyMIMEType, MEDIA_MIMETYPE_VIDEO_AVC);
+    metaData->setRect(kKeyCropRect, kLeft, kTop, kRight, kBottom);
+
+    const char *mime = nullptr;
+    ASSERT_TRUE(metaData->findCString(kKeyMIMEType, &mime)) << "MetaData doesn't contain mime";
+    uint32_t type;
+    const void *rect = nullptr;
+    size_t size;
+    ASSERT_TRUE(metaData->findData(kKeyCropRect, &type, &rect, &size))
+            << "MetaData doesn't contain crop rect";
+
+    for (uint32_t key = 1; key <= 256; key++) {
+        metaData->setInt64(key, key);
+    }
+    metaData->setCString(kKeyTitle, "title");
+    metaData->remove(kKeyTitle);
+
+    ASSERT_STREQ(mime, MEDIA_MIMETYPE_VIDEO_AVC) << "Mime pointer changed after inserts";
+    const int32_t *margins = static_cast<const int32_t *>(rect);
+    ASSERT_EQ(size, 4 * sizeof(int32_t)) << "Unexpected crop rect size";
+    ASSERT_EQ(margins[0], kLeft) << "Crop rect pointer changed after inserts";
+    ASSERT_EQ(margins[3], kBottom) << "Crop rect pointer changed after inserts";
+
+    // Copies share the value until one of them sets it again.
+    MetaDataBase copy(*metaData);
+    metaData->setCString(kKeyMIMEType, MEDIA_MIMETYPE_VIDEO_HEVC);
+    ASSERT_STREQ(mime, MEDIA_MIMETYPE_VIDEO_AVC) << "Copy lost the previous mime";
+    const char *copyMime = nullptr;
+    ASSERT_TRUE(copy.findCString(kKeyMIMEType, &copyMime)) << "Copy doesn't contain mime";
+    ASSERT_STREQ(copyMime, MEDIA_MIMETYPE_VIDEO_AVC) << "Copy changed with the original";
+    ASSERT_TRUE(metaData->findCString(kKeyMIMEType, &mime)) << "MetaData doesn't contain mime";
+    ASSERT_STREQ(mime, MEDIA_MIMETYPE_VIDEO_HEVC) << "Mime wasn't updated";
+}
+
+TEST_F(MetaDataBaseUnitTest, SetFromOwnDataTest) {
+    std::unique_ptr<MetaDataBase> metaData(new MetaDataBase());
+    ASSERT_NE(metaData, nullptr) << "Failed to create meta data";
+
+    const char *mime = nullptr;
+    metaData->setCString(kKeyMIMEType, MEDIA_MIMETYPE_AUDIO_AAC);
+    ASSERT_TRUE(metaData->findCString(kKeyMIMEType, &mime)) << "MetaData doesn't contain mime";
+
+    // Setting a new key from a value of the same meta data must copy it before
+    // the items are touched.
+    for (uint32_t key = 1; key <= 64; key++) {
+        metaData->setCString(key, mime);
+        ASSERT_TRUE(metaData->findCString(kKeyMIMEType, &mime))
+                << "MetaData doesn't contain mime";
+    }
+    for (uint32_t key = 1; key <= 64; key++) {
+        const char *value = nullptr;
+        ASSERT_TRUE(metaData->findCString(key, &value)) << "MetaData doesn't contain key " << key;
+        ASSERT_STREQ(value, MEDIA_MIMETYPE_AUDIO_AAC) << "Wrong value for key " << key;
+    }
+
+    // Setting a key from its own value.
+    metaData->setCString(kKeyMIMEType, mime);
+    ASSERT_TRUE(metaData->findCString(kKeyMIMEType, &mime)) << "MetaData doesn't contain mime";
+    ASSERT_STREQ(mime, MEDIA_MIMETYPE_AUDIO_AAC) << "Mime changed when set to itself";
+}
+
 }  // namespace android
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/MediaBuffer.h>
+#include <media/stagefright/MetaDataBase.h>
+
+using namespace android;
+
+// Replays the per-sample work MediaTrackCUnwrapper::read() does after every
+// MediaTrack::read(): copying the extractor's sample keys into the MetaDataBase
+// of a MediaBuffer that is reused from a MediaBufferGroup.
+static void BM_MediaTrackReadSampleMeta(benchmark::State& state) {
+    const bool encrypted = state.range(0);
+    MediaBuffer *buffer = new MediaBuffer(4096);
+    sp<ABuffer> iv = new ABuffer(16);
+    memset(iv->data(), 0x5a, iv->size());
+    sp<ABuffer> sizes = new ABuffer(8);
+    memset(sizes->data(), 0, sizes->size());
+
+    int64_t timeUs = 0;
+    for (auto _ : state) {
+        sp<AMessage> format = new AMessage;
+        format->setInt64("timeUs", timeUs);
+        format->setInt64("durationUs", 33366);
+        format->setInt32("is-sync-frame", (timeUs % 1000000) == 0);
+        if (encrypted) {
+            format->setBuffer("crypto-iv", iv);
+            format->setBuffer("crypto-plain-sizes", sizes);
+            format->setBuffer("crypto-encrypted-sizes", sizes);
+            format->setInt32("crypto-mode", 1);
+        }
+
+        MetaDataBase &meta = buffer->meta_data();
+        int64_t val64;
+        int32_t val32;
+        sp<ABuffer> valbuf;
+        if (format->findInt64("timeUs", &val64)) {
+            meta.setInt64(kKeyTime, val64);
+        }
+        if (format->findInt64("durationUs", &val64)) {
+            meta.setInt64(kKeyDuration, val64);
+        }
+        if (format->findInt32("is-sync-frame", &val32)) {
+            meta.setInt32(kKeyIsSyncFrame, val32);
+        }
+        if (format->findInt32("crypto-mode", &val32)) {
+            meta.setInt32(kKeyCryptoMode, val32);
+        }
+        if (format->findBuffer("crypto-iv", &valbuf)) {
+            meta.setData(kKeyCryptoIV, MetaDataBase::Type::TYPE_NONE, valbuf->data(),
+                    valbuf->size());
+        }
+        if (format->findBuffer("crypto-plain-sizes", &valbuf)) {
+            meta.setData(kKeyPlainSizes, MetaDataBase::Type::TYPE_NONE, valbuf->data(),
+                    valbuf->size());
+        }
+        if (format->findBuffer("crypto-encrypted-sizes", &valbuf)) {
+            meta.setData(kKeyEncryptedSizes, MetaDataBase::Type::TYPE_NONE, valbuf->data(),
+                    valbuf->size());
+        }
+
+        // what a decoder wrapper reads back
+        meta.findInt64(kKeyTime, &val64);
+        benchmark::DoNotOptimize(val64);
+        timeUs += 33366;
+    }
+    state.SetItemsProcessed(state.iterations());
+    buffer->release();
+}
+BENCHMARK(BM_MediaTrackReadSampleMeta)->Arg(0)->Arg(1);
+
+static MetaDataBase makeTrackFormat() {
+    MetaDataBase meta;
+    meta.setCString(kKeyMIMEType, "video/avc");
+    meta.setInt32(kKeyWidth, 3840);
+    meta.setInt32(kKeyHeight, 2160);
+    meta.setInt64(kKeyDuration, 7200000000LL);
+    meta.setInt32(kKeyMaxInputSize, 6291456);
+    meta.setInt32(kKeyFrameRate, 60);
+    meta.setInt32(kKeyTrackID, 1);
+    meta.setCString(kKeyMediaLanguage, "und");
+    uint8_t avcc[64] = {};
+    meta.setData(kKeyAVCC, MetaDataBase::Type::TYPE_NONE, avcc, sizeof(avcc));
+    return meta;
+}
+
+// Track formats are copied around on every getFormat() and rarely modified.
+static void BM_MetaDataBaseCopyTrackFormat(benchmark::State& state) {
+    MetaDataBase format = makeTrackFormat();
+    for (auto _ : state) {
+        MetaDataBase copy(format);
+        int32_t width;
+        copy.findInt32(kKeyWidth, &width);
+        benchmark::DoNotOptimize(width);
+    }
+}
+BENCHMARK(BM_MetaDataBaseCopyTrackFormat);
+
+static void BM_MetaDataBaseCopyAndModifyTrackFormat(benchmark::State& state) {
+    MetaDataBase format = makeTrackFormat();
+    for (auto _ : state) {
+        MetaDataBase copy(format);
+        copy.setInt32(kKeyRotation, 90);
+        benchmark::DoNotOptimize(&copy);
+    }
+}
+BENCHMARK(BM_MetaDataBaseCopyAndModifyTrackFormat);
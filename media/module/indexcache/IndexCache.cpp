@@ -0,0 +1,345 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "IndexCache"
+#include <log/log.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/indexcache/IndexCache.h>
+
+namespace android {
+
+namespace {
+
+const uint32_t kEntryMagic = 0x49445843;  // 'IDXC'
+const char kEntrySuffix[] = ".idx";
+
+struct EntryHeader {
+    uint32_t magic;
+    uint32_t keySize;
+    uint64_t dataSize;
+    uint64_t checksum;  // of the key and the data
+};
+
+const uint64_t kHashMultiplier = 0x9e3779b97f4a7c15ull;
+
+inline uint64_t mix(uint64_t x) {
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ull;
+    x ^= x >> 32;
+    return x;
+}
+
+bool readFully(int fd, void *data, size_t size) {
+    uint8_t *p = (uint8_t *)data;
+    while (size > 0) {
+        ssize_t n = TEMP_FAILURE_RETRY(read(fd, p, size));
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool writeFully(int fd, const void *data, size_t size) {
+    const uint8_t *p = (const uint8_t *)data;
+    while (size > 0) {
+        ssize_t n = TEMP_FAILURE_RETRY(write(fd, p, size));
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool hasEntrySuffix(const char *name) {
+    size_t length = strlen(name);
+    size_t suffixLength = sizeof(kEntrySuffix) - 1;
+    return length > suffixLength
+            && strcmp(name + length - suffixLength, kEntrySuffix) == 0;
+}
+
+}  // namespace
+
+// static
+IndexCache *IndexCache::Get() {
+#ifdef __ANDROID__
+    // The properties are read once per process.
+    static IndexCache *sCache = []() -> IndexCache * {
+        char dir[PROP_VALUE_MAX];
+        if (__system_property_get("media.extractor.index_cache.dir", dir) <= 0) {
+            return NULL;
+        }
+        uint64_t maxSize = kDefaultMaxSize;
+        char value[PROP_VALUE_MAX];
+        if (__system_property_get("media.extractor.index_cache.max_kb", value) > 0) {
+            char *end;
+            unsigned long long maxKb = strtoull(value, &end, 10);
+            if (end == value || *end != '\0' || maxKb > UINT64_MAX / 1024) {
+                ALOGW("ignoring invalid media.extractor.index_cache.max_kb %s", value);
+            } else {
+                maxSize = maxKb * 1024;
+            }
+        }
+        if (maxSize == 0) {
+            return NULL;
+        }
+        ALOGV("index cache in %s, up to %" PRIu64 " bytes", dir, maxSize);
+        return new IndexCache(dir, maxSize);
+    }();
+    return sCache;
+#else
+    return NULL;
+#endif
+}
+
+IndexCache::IndexCache(const char *dir, uint64_t maxSize)
+    : mDir(dir),
+      mMaxSize(maxSize) {
+}
+
+// static
+uint64_t IndexCache::Hash(const void *data, size_t size, uint64_t hash) {
+    const uint8_t *p = (const uint8_t *)data;
+    hash = (hash ^ size) * kHashMultiplier;
+    while (size >= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        hash = (hash ^ mix(word * kHashMultiplier)) * kHashMultiplier;
+        p += 8;
+        size -= 8;
+    }
+    if (size > 0) {
+        uint64_t word = 0;
+        memcpy(&word, p, size);
+        hash = (hash ^ mix(word * kHashMultiplier)) * kHashMultiplier;
+    }
+    return mix(hash);
+}
+
+// static
+bool IndexCache::GetFileKey(DataSourceHelper *source, off64_t offset, off64_t size,
+        std::string *key) {
+    off64_t fileSize;
+    if (source->getSize(&fileSize) != OK || fileSize <= 0) {
+        return false;
+    }
+    uint8_t header[kHeaderSize];
+    size_t headerSize = std::min((off64_t)kHeaderSize, fileSize);
+    if (source->readAt(0, header, headerSize) != (ssize_t)headerSize) {
+        return false;
+    }
+
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "size=%lld header=%016" PRIx64,
+            (long long)fileSize, Hash(header, headerSize));
+    *key = buffer;
+
+    // Extractors do not get a file descriptor, only the uri if the source has one.
+    char uri[PATH_MAX];
+    const char *path = NULL;
+    if (source->getUri(uri, sizeof(uri))) {
+        path = uri;
+        if (!strncasecmp(path, "file://", 7)) {
+            path += 7;
+        }
+    }
+    struct stat st;
+    if (path != NULL && path[0] == '/' && stat(path, &st) == 0 && S_ISREG(st.st_mode)
+            && st.st_size == fileSize) {
+        snprintf(buffer, sizeof(buffer), " dev=%llu ino=%llu mtime=%lld.%09ld",
+                (unsigned long long)st.st_dev, (unsigned long long)st.st_ino,
+                (long long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec);
+        key->append(" path=").append(path).append(buffer);
+        return true;
+    }
+
+    // The file cannot be told apart from an edited copy of the same size, as happens
+    // for file descriptors: hash the range that holds the index instead.
+    if (offset < 0 || size <= 0 || offset > fileSize || size > fileSize - offset) {
+        return false;
+    }
+    std::vector<uint8_t> data(std::min((off64_t)kRangeReadSize, size));
+    uint64_t hash = 0;
+    for (off64_t pos = offset; pos < offset + size;) {
+        size_t n = std::min((off64_t)data.size(), offset + size - pos);
+        if (source->readAt(pos, data.data(), n) != (ssize_t)n) {
+            return false;
+        }
+        hash = Hash(data.data(), n, hash);
+        pos += n;
+    }
+    snprintf(buffer, sizeof(buffer), " range=%lld+%lld hash=%016" PRIx64,
+            (long long)offset, (long long)size, hash);
+    key->append(buffer);
+    return true;
+}
+
+std::string IndexCache::getPath(const std::string &key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "/%016" PRIx64 "%s", Hash(key.data(), key.size()),
+            kEntrySuffix);
+    return mDir + name;
+}
+
+bool IndexCache::get(const std::string &key, std::string *data) {
+    std::lock_guard<std::mutex> lock(mLock);
+    const std::string path = getPath(key);
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool corrupt = true;
+    bool found = false;
+    struct stat st;
+    EntryHeader header;
+    if (fstat(fd, &st) == 0 && readFully(fd, &header, sizeof(header))
+            && header.magic == kEntryMagic
+            && header.keySize <= (uint64_t)st.st_size
+            && header.dataSize <= (uint64_t)st.st_size
+            && sizeof(header) + header.keySize + header.dataSize == (uint64_t)st.st_size) {
+        std::string entry(header.keySize + header.dataSize, '\0');
+        if (readFully(fd, &entry[0], entry.size())
+                && Hash(entry.data(), entry.size()) == header.checksum) {
+            corrupt = false;
+            // Another key with the same hash is a miss, not an error.
+            if (entry.compare(0, header.keySize, key) == 0) {
+                data->assign(entry, header.keySize, header.dataSize);
+                found = true;
+                // The modification time of the entries orders them for eviction.
+                futimens(fd, NULL);
+            }
+        }
+    }
+    close(fd);
+
+    if (corrupt) {
+        ALOGW("removing invalid entry %s", path.c_str());
+        unlink(path.c_str());
+    }
+    ALOGV("%s %s", found ? "hit" : "miss", key.c_str());
+    return found;
+}
+
+void IndexCache::put(const std::string &key, const std::string &data) {
+    if (key.size() > UINT32_MAX
+            || sizeof(EntryHeader) + key.size() + data.size() > mMaxSize) {
+        return;
+    }
+    EntryHeader header;
+    header.magic = kEntryMagic;
+    header.keySize = key.size();
+    header.dataSize = data.size();
+    header.checksum = Hash((key + data).data(), key.size() + data.size());
+
+    std::lock_guard<std::mutex> lock(mLock);
+    const std::string path = getPath(key);
+    // Other processes may write the same entry, and readers must never see a
+    // partial one: write to a file of our own and rename it.
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%d.tmp", getpid());
+    const std::string tmpPath = path + suffix;
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        ALOGW("cannot create %s: %s", tmpPath.c_str(), strerror(errno));
+        return;
+    }
+    bool written = writeFully(fd, &header, sizeof(header))
+            && writeFully(fd, key.data(), key.size())
+            && writeFully(fd, data.data(), data.size());
+    if (close(fd) != 0 || !written || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        ALOGW("cannot write %s: %s", path.c_str(), strerror(errno));
+        unlink(tmpPath.c_str());
+        return;
+    }
+    trim_l(mMaxSize);
+}
+
+uint64_t IndexCache::size() {
+    std::lock_guard<std::mutex> lock(mLock);
+    return trim_l(UINT64_MAX);
+}
+
+uint64_t IndexCache::trim_l(uint64_t maxSize) {
+    DIR *dir = opendir(mDir.c_str());
+    if (dir == NULL) {
+        return 0;
+    }
+    struct Entry {
+        struct timespec mtime;
+        uint64_t size;
+        std::string path;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    while (struct dirent *dirent = readdir(dir)) {
+        if (!hasEntrySuffix(dirent->d_name)) {
+            continue;
+        }
+        std::string path = mDir + "/" + dirent->d_name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        entries.push_back({st.st_mtim, (uint64_t)st.st_size, std::move(path)});
+        total += st.st_size;
+    }
+    closedir(dir);
+
+    if (total <= maxSize) {
+        return total;
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.mtime.tv_sec < b.mtime.tv_sec
+                || (a.mtime.tv_sec == b.mtime.tv_sec && a.mtime.tv_nsec < b.mtime.tv_nsec);
+    });
+    for (const Entry &entry : entries) {
+        if (total <= maxSize) {
+            break;
+        }
+        if (unlink(entry.path.c_str()) == 0) {
+            ALOGV("evicted %s", entry.path.c_str());
+            total -= entry.size;
+        }
+    }
+    return total;
+}
+
+}  // namespace android
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INDEX_CACHE_H_
+#define INDEX_CACHE_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <mutex>
+#include <string>
+
+namespace android {
+
+class DataSourceHelper;
+
+// IndexCache is an opt-in on-disk cache for the indexes that extractors build when
+// parsing a file, such as the sample tables of an MPEG4 track. Opening the same file
+// again can then skip reading and parsing them.
+//
+// It is enabled by setting the media.extractor.index_cache.dir property to a directory
+// that the process running the extractors can write to. The entries are kept under
+// media.extractor.index_cache.max_kb in total, 16 MiB by default. When the limit is
+// exceeded, the least recently used entries are removed.
+//
+// For now the cache is only meant for host and test use. The mediaextractor seccomp
+// policy allows the calls made here, but the device has no directory labeled for the
+// cache, and no SELinux rules letting mediaextractor read the properties or write the
+// entries. Those belong in system/sepolicy and must land before the cache can be
+// enabled in mediaextractor.
+//
+// Entries are looked up by key, see GetFileKey(). The key is stored in the entry and
+// checked by get(), along with a checksum of the data. The key cannot catch every change
+// to a file, so extractors must still check that the data is consistent with the file.
+class IndexCache {
+public:
+    static const size_t kHeaderSize = 4096;
+    static const uint64_t kDefaultMaxSize = 16 * 1024 * 1024;
+    static const size_t kRangeReadSize = 64 * 1024;
+
+    // Returns the cache configured by the properties, or NULL if it is disabled.
+    static IndexCache *Get();
+
+    // Entries are stored in dir, which must exist.
+    IndexCache(const char *dir, uint64_t maxSize);
+
+    // Identifies the file read by source by its size and a hash of its first kHeaderSize
+    // bytes. If source has a local file uri, the device, inode and modification time of
+    // the file are added. Otherwise, as for file descriptors, a hash of the size bytes at
+    // offset is added: this is the box that holds the index, such as the moov box of an
+    // MPEG4 file. Fails if source has no known size, or if the range cannot be read.
+    static bool GetFileKey(DataSourceHelper *source, off64_t offset, off64_t size,
+            std::string *key);
+
+    // Returns false if there is no valid entry for key.
+    bool get(const std::string &key, std::string *data);
+
+    // Replaces the entry for key, if any, then removes the least recently used
+    // entries over the size limit.
+    void put(const std::string &key, const std::string &data);
+
+    // Size of the entries in the cache.
+    uint64_t size();
+
+    uint64_t maxSize() const { return mMaxSize; }
+
+    static uint64_t Hash(const void *data, size_t size, uint64_t hash = 0);
+
+private:
+    const std::string mDir;
+    const uint64_t mMaxSize;
+    std::mutex mLock;
+
+    std::string getPath(const std::string &key) const;
+
+    // Returns the size of the entries, after removing the least recently used ones
+    // down to maxSize.
+    uint64_t trim_l(uint64_t maxSize);
+
+    IndexCache(const IndexCache &);
+    IndexCache &operator=(const IndexCache &);
+};
+
+}  // namespace android
+
+#endif  // INDEX_CACHE_H_
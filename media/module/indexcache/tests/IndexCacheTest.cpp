@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "IndexCacheTest"
+#include <utils/Log.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/indexcache/IndexCache.h>
+
+using namespace android;
+
+namespace {
+
+// A source in memory, with an optional uri.
+struct MemorySource {
+    std::vector<uint8_t> data;
+    std::string uri;
+};
+
+ssize_t readAt(void *handle, off64_t offset, void *data, size_t size) {
+    MemorySource *source = (MemorySource *)handle;
+    if (offset < 0 || (size_t)offset >= source->data.size()) {
+        return 0;
+    }
+    size = std::min(size, source->data.size() - (size_t)offset);
+    memcpy(data, &source->data[offset], size);
+    return size;
+}
+
+status_t getSize(void *handle, off64_t *size) {
+    *size = ((MemorySource *)handle)->data.size();
+    return OK;
+}
+
+uint32_t flags(void *) {
+    return 0;
+}
+
+bool getUri(void *handle, char *uri, size_t size) {
+    MemorySource *source = (MemorySource *)handle;
+    if (source->uri.empty() || source->uri.size() >= size) {
+        return false;
+    }
+    snprintf(uri, size, "%s", source->uri.c_str());
+    return true;
+}
+
+std::string getKey(MemorySource *memorySource, off64_t offset, off64_t size) {
+    CDataSource csource = {readAt, getSize, flags, getUri, memorySource};
+    DataSourceHelper source(&csource);
+    std::string key;
+    EXPECT_TRUE(IndexCache::GetFileKey(&source, offset, size, &key));
+    return key;
+}
+
+}  // namespace
+
+class IndexCacheTest : public ::testing::Test {
+  public:
+    void SetUp() override {
+#ifdef __ANDROID__
+        mDir = "/data/local/tmp/indexcacheXXXXXX";
+#else
+        const char *tmpDir = getenv("TMPDIR");
+        mDir = std::string(tmpDir != nullptr ? tmpDir : "/tmp") + "/indexcacheXXXXXX";
+#endif
+        ASSERT_NE(mkdtemp(&mDir[0]), nullptr) << "Cannot create " << mDir;
+    }
+
+    void TearDown() override { std::filesystem::remove_all(mDir); }
+
+    // The entry files in the cache directory.
+    std::vector<std::string> listEntries() {
+        std::vector<std::string> entries;
+        for (const auto &entry : std::filesystem::directory_iterator(mDir)) {
+            if (entry.path().extension() == ".idx") {
+                entries.push_back(entry.path());
+            }
+        }
+        return entries;
+    }
+
+    // Makes the entry look last used seconds after the epoch.
+    static void setLastUsed(const std::string &path, time_t seconds) {
+        struct timespec times[2] = {{seconds, 0}, {seconds, 0}};
+        ASSERT_EQ(utimensat(AT_FDCWD, path.c_str(), times, 0), 0);
+    }
+
+    std::string mDir;
+};
+
+TEST_F(IndexCacheTest, PutGetTest) {
+    IndexCache cache(mDir.c_str(), IndexCache::kDefaultMaxSize);
+    std::string data;
+    EXPECT_FALSE(cache.get("key", &data)) << "Empty cache has an entry";
+
+    std::string value("index data\0with a null byte", 27);
+    cache.put("key", value);
+    ASSERT_TRUE(cache.get("key", &data));
+    EXPECT_EQ(data, value);
+    EXPECT_EQ(listEntries().size(), 1u);
+    EXPECT_GT(cache.size(), value.size());
+
+    // Replacing an entry.
+    cache.put("key", "other data");
+    ASSERT_TRUE(cache.get("key", &data));
+    EXPECT_EQ(data, "other data");
+    EXPECT_EQ(listEntries().size(), 1u);
+
+    // Other keys are separate entries, and empty data is valid.
+    cache.put("empty", "");
+    ASSERT_TRUE(cache.get("empty", &data));
+    EXPECT_TRUE(data.empty());
+    ASSERT_TRUE(cache.get("key", &data));
+    EXPECT_EQ(data, "other data");
+    EXPECT_FALSE(cache.get("missing", &data));
+
+    // Entries persist across instances, and no temporary file is left behind.
+    IndexCache other(mDir.c_str(), IndexCache::kDefaultMaxSize);
+    ASSERT_TRUE(other.get("key", &data));
+    EXPECT_EQ(data, "other data");
+    size_t numFiles = std::distance(std::filesystem::directory_iterator(mDir),
+                                    std::filesystem::directory_iterator());
+    EXPECT_EQ(numFiles, 2u);
+}
+
+TEST_F(IndexCacheTest, KeyMismatchTest) {
+    IndexCache cache(mDir.c_str(), IndexCache::kDefaultMaxSize);
+    cache.put("key", "data");
+    std::vector<std::string> entries = listEntries();
+    ASSERT_EQ(entries.size(), 1u);
+
+    // An entry stored under the file name of another key, as happens on a collision of
+    // the hashes of the keys, is a miss but is not removed.
+    cache.put("other key", "other data");
+    entries = listEntries();
+    ASSERT_EQ(entries.size(), 2u);
+    std::filesystem::copy_file(entries[0], entries[1],
+                               std::filesystem::copy_options::overwrite_existing);
+    std::string data;
+    int hits = cache.get("key", &data) + cache.get("other key", &data);
+    EXPECT_EQ(hits, 1) << "Entry returned for the wrong key";
+    EXPECT_EQ(listEntries().size(), 2u) << "Valid entry of another key removed";
+}
+
+TEST_F(IndexCacheTest, InvalidEntryTest) {
+    IndexCache cache(mDir.c_str(), IndexCache::kDefaultMaxSize);
+    const std::string value(1000, 'x');
+    cache.put("key", value);
+    std::vector<std::string> entries = listEntries();
+    ASSERT_EQ(entries.size(), 1u);
+    const std::string path = entries[0];
+    const uintmax_t size = std::filesystem::file_size(path);
+
+    std::string data;
+    // Truncated entries, down to an empty file.
+    for (uintmax_t truncatedSize : {size - 1, size / 2, (uintmax_t)8, (uintmax_t)0}) {
+        cache.put("key", value);
+        std::filesystem::resize_file(path, truncatedSize);
+        EXPECT_FALSE(cache.get("key", &data)) << "Entry truncated to " << truncatedSize;
+        EXPECT_TRUE(listEntries().empty()) << "Invalid entry not removed";
+    }
+
+    // A flipped bit anywhere, in the header, key or data.
+    for (uintmax_t offset : {(uintmax_t)0, (uintmax_t)4, (uintmax_t)16, size - 500, size - 1}) {
+        cache.put("key", value);
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(offset);
+        char c = file.get();
+        file.seekp(offset);
+        file.put(c ^ 0x10);
+        file.close();
+        EXPECT_FALSE(cache.get("key", &data)) << "Entry corrupted at " << offset;
+        EXPECT_TRUE(listEntries().empty()) << "Invalid entry not removed";
+    }
+
+    // Appended data.
+    cache.put("key", value);
+    std::ofstream(path, std::ios::app | std::ios::binary) << "trailing";
+    EXPECT_FALSE(cache.get("key", &data));
+
+    cache.put("key", value);
+    ASSERT_TRUE(cache.get("key", &data));
+    EXPECT_EQ(data, value);
+}
+
+TEST_F(IndexCacheTest, EvictionTest) {
+    const std::string value(1000, 'x');
+    // Room for 8 entries, but not 9.
+    IndexCache cache(mDir.c_str(), 9 * value.size());
+    // Entries over the limit are not stored.
+    cache.put("too large", std::string(cache.maxSize(), 'x'));
+    EXPECT_TRUE(listEntries().empty());
+
+    std::vector<std::string> keys;
+    for (int i = 0; i < 8; ++i) {
+        keys.push_back("key" + std::to_string(i));
+        cache.put(keys.back(), value);
+    }
+    std::vector<std::string> entries = listEntries();
+    ASSERT_EQ(entries.size(), keys.size()) << "Entries evicted under the limit";
+    uint64_t entrySize = cache.size() / keys.size();
+
+    // Order the entries by last use, key0 first, then use key0.
+    std::string data;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_TRUE(cache.get(keys[i], &data));
+    }
+    time_t time = 1000000;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        for (const std::string &path : entries) {
+            // Entries are only told apart by their key, so find it in the file.
+            std::ifstream file(path, std::ios::binary);
+            std::string contents((std::istreambuf_iterator<char>(file)),
+                                 std::istreambuf_iterator<char>());
+            if (contents.find(keys[i] + value) != std::string::npos) {
+                setLastUsed(path, time + i);
+            }
+        }
+    }
+    ASSERT_TRUE(cache.get("key0", &data));
+
+    // Each entry added now evicts one: key1 and key2 are the least recently used.
+    cache.put("key8", value);
+    cache.put("key9", value);
+    EXPECT_LE(cache.size(), cache.maxSize());
+    EXPECT_EQ(cache.size(), keys.size() * entrySize);
+    EXPECT_FALSE(cache.get("key1", &data));
+    EXPECT_FALSE(cache.get("key2", &data));
+    for (const char *key : {"key0", "key3", "key7", "key8", "key9"}) {
+        EXPECT_TRUE(cache.get(key, &data)) << key << " evicted";
+    }
+}
+
+TEST_F(IndexCacheTest, FileKeyTest) {
+    MemorySource source;
+    for (size_t i = 0; i < 3 * IndexCache::kRangeReadSize; ++i) {
+        source.data.push_back(i * 7);
+    }
+    const off64_t fileSize = source.data.size();
+    const off64_t rangeOffset = IndexCache::kHeaderSize * 2;
+    const off64_t rangeSize = fileSize - rangeOffset;
+    const std::string key = getKey(&source, rangeOffset, rangeSize);
+    EXPECT_EQ(key, getKey(&source, rangeOffset, rangeSize)) << "Key is not stable";
+
+    // Without a uri, as for a file descriptor, the key depends on the range that holds
+    // the index: a change there, past the header, is caught.
+    source.data[fileSize - 1] ^= 1;
+    EXPECT_NE(key, getKey(&source, rangeOffset, rangeSize));
+    source.data[fileSize - 1] ^= 1;
+    source.data[rangeOffset] ^= 1;
+    EXPECT_NE(key, getKey(&source, rangeOffset, rangeSize));
+    source.data[rangeOffset] ^= 1;
+    // So is a change of the header or of the size.
+    source.data[0] ^= 1;
+    EXPECT_NE(key, getKey(&source, rangeOffset, rangeSize));
+    source.data[0] ^= 1;
+    source.data.push_back(0);
+    EXPECT_NE(key, getKey(&source, rangeOffset, rangeSize));
+    source.data.pop_back();
+    EXPECT_EQ(key, getKey(&source, rangeOffset, rangeSize));
+
+    // A range out of the file cannot identify it.
+    CDataSource csource = {readAt, getSize, flags, getUri, &source};
+    DataSourceHelper helper(&csource);
+    std::string badKey;
+    EXPECT_FALSE(IndexCache::GetFileKey(&helper, rangeOffset, fileSize, &badKey));
+    EXPECT_FALSE(IndexCache::GetFileKey(&helper, 0, 0, &badKey));
+
+    // A local file is identified by its inode and modification time instead.
+    const std::string path = mDir + "/file";
+    std::ofstream(path, std::ios::binary)
+            .write((const char *)source.data.data(), source.data.size());
+    source.uri = "file://" + path;
+    const std::string fileKey = getKey(&source, 0, 0);
+    EXPECT_NE(fileKey.find(path), std::string::npos);
+    setLastUsed(path, 1000000);
+    EXPECT_NE(fileKey, getKey(&source, 0, 0)) << "Key ignores the modification time";
+}
@@ -19,6 +19,7 @@
 
 #include <android-base/logging.h>
 #include <media/MediaSampleReaderNDK.h>
+#include <media/NdkMediaExtractorPlatform.h>
 
 #include <algorithm>
 #include <cmath>
@@ -317,6 +318,17 @@ media_status_t MediaSampleReaderNDK::setEnforceSequentialAccess(bool enforce) {
     return AMEDIA_OK;
 }
 
+media_status_t MediaSampleReaderNDK::setPrefetchEnabled(bool enabled) {
+    LOG(DEBUG) << "setPrefetchEnabled( " << enabled << " )";
+
+    std::scoped_lock lock(mExtractorMutex);
+
+    if (__builtin_available(android 35, *)) {
+        return AMediaExtractor_setPrefetchEnabled(mExtractor, enabled);
+    }
+    return AMEDIA_ERROR_UNSUPPORTED;
+}
+
 media_status_t MediaSampleReaderNDK::getEstimatedBitrateForTrack(int trackIndex, int32_t* bitrate) {
     std::scoped_lock lock(mExtractorMutex);
     media_status_t status = AMEDIA_OK;
@@ -37,12 +37,14 @@
 #include <media/MediaSampleReaderNDK.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <thread>
 
 using namespace android;
 
 static void ReadMediaSamples(benchmark::State& state, const std::string& srcFileName,
-                             bool readAudio, bool sequentialAccess = false) {
+                             bool readAudio, bool sequentialAccess = false,
+                             bool prefetch = false) {
     // Asset directory.
     static const std::string kAssetDirectory = "/data/local/tmp/TranscodingBenchmark/";
 
@@ -57,12 +59,17 @@ static void ReadMediaSamples(benchmark::State& state, const std::string& srcFile
     const size_t fileSize = lseek(srcFd, 0, SEEK_END);
     lseek(srcFd, 0, SEEK_SET);
 
+    std::atomic<int64_t> bytesRead = 0;
     for (auto _ : state) {
         auto sampleReader = MediaSampleReaderNDK::createFromFd(srcFd, 0, fileSize);
         if (sampleReader->setEnforceSequentialAccess(sequentialAccess) != AMEDIA_OK) {
             state.SkipWithError("setEnforceSequentialAccess failed");
             return;
         }
+        if (prefetch && sampleReader->setPrefetchEnabled(true) != AMEDIA_OK) {
+            state.SkipWithError("setPrefetchEnabled failed");
+            return;
+        }
 
         // Select tracks.
         std::vector<int> trackIndices;
@@ -89,7 +96,7 @@ static void ReadMediaSamples(benchmark::State& state, const std::string& srcFile
         // Start threads.
         std::vector<std::thread> trackThreads;
         for (auto trackIndex : trackIndices) {
-            trackThreads.emplace_back([trackIndex, sampleReader, &state] {
+            trackThreads.emplace_back([trackIndex, sampleReader, &state, &bytesRead] {
                 LOG(INFO) << "Track " << trackIndex << " started";
                 MediaSampleInfo info;
 
@@ -113,6 +120,7 @@ static void ReadMediaSamples(benchmark::State& state, const std::string& srcFile
                         state.SkipWithError("Error reading sample data");
                         break;
                     }
+                    bytesRead += info.size;
                 }
 
                 LOG(INFO) << "Track " << trackIndex << " finished";
@@ -125,6 +133,7 @@ static void ReadMediaSamples(benchmark::State& state, const std::string& srcFile
         }
     }
 
+    state.SetBytesProcessed(bytesRead);
     close(srcFd);
 }
 
@@ -147,8 +156,20 @@ static void BM_MediaSampleReader_Video(benchmark::State& state) {
                      false /* readAudio */);
 }
 
+static void BM_MediaSampleReader_AudioVideo_Sequential_Prefetch(benchmark::State& state) {
+    ReadMediaSamples(state, "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4",
+                     true /* readAudio */, true /* sequentialAccess */, true /* prefetch */);
+}
+
+static void BM_MediaSampleReader_Video_Prefetch(benchmark::State& state) {
+    ReadMediaSamples(state, "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4",
+                     false /* readAudio */, false /* sequentialAccess */, true /* prefetch */);
+}
+
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_Parallel);
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_Sequential);
+TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_Sequential_Prefetch);
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_Video);
+TRANSCODER_BENCHMARK(BM_MediaSampleReader_Video_Prefetch);
 
 BENCHMARK_MAIN();
@@ -84,6 +84,18 @@ public:
      */
     virtual media_status_t setEnforceSequentialAccess(bool enforce) = 0;
 
+    /**
+     * Toggles reading ahead on or off. When the reader reads ahead, the samples of the selected
+     * tracks are read in the background ahead of the sample accessors. Reading ahead works best
+     * with sequential access, since the samples read ahead are discarded when the reader has to
+     * move backwards.
+     * @param enabled True to read ahead.
+     * @return AMEDIA_OK on success, AMEDIA_ERROR_UNSUPPORTED if the reader cannot read ahead.
+     */
+    virtual media_status_t setPrefetchEnabled(bool /* enabled */) {
+        return AMEDIA_ERROR_UNSUPPORTED;
+    }
+
     /**
      * Estimates the bitrate of a source track by sampling sample sizes. The bitrate is returned in
      * megabits per second (Mbps). This method will fail if the track only contains a single sample
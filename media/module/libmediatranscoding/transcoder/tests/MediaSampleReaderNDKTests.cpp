@@ -25,10 +25,13 @@
 #include <fcntl.h>
 #include <gtest/gtest.h>
 #include <media/MediaSampleReaderNDK.h>
+#include <media/NdkMediaExtractorPlatform.h>
 #include <openssl/md5.h>
 #include <utils/Timers.h>
 
+#include <chrono>
 #include <cmath>
+#include <functional>
 #include <mutex>
 #include <thread>
 
@@ -75,6 +78,9 @@ public:
     uint8_t mChecksum[MD5_DIGEST_LENGTH];
 };
 
+/** A sample read by an extractor along with the index of its track. */
+using TrackSample = std::pair<int, Sample>;
+
 /** Constant for selecting all samples. */
 static constexpr int SAMPLE_COUNT_ALL = -1;
 
@@ -247,6 +253,55 @@ public:
         }
     }
 
+    AMediaExtractor* createExtractor(bool prefetch) {
+        AMediaExtractor* extractor = AMediaExtractor_new();
+        EXPECT_NE(extractor, nullptr);
+        EXPECT_EQ(AMediaExtractor_setDataSourceFd(extractor, mSourceFd, 0, mFileSize), AMEDIA_OK);
+        for (size_t trackIndex = 0; trackIndex < mTrackCount; trackIndex++) {
+            EXPECT_EQ(AMediaExtractor_selectTrack(extractor, trackIndex), AMEDIA_OK);
+        }
+        EXPECT_EQ(AMediaExtractor_setPrefetchEnabled(extractor, prefetch), AMEDIA_OK);
+        return extractor;
+    }
+
+    /** Reads up to |sampleCount| samples from the selected tracks, in extractor order. */
+    static void readTrackSamples(AMediaExtractor* extractor, int sampleCount,
+                                 std::vector<TrackSample>* samples) {
+        for (int samplesRead = 0; samplesRead < sampleCount || sampleCount == SAMPLE_COUNT_ALL;
+             ++samplesRead) {
+            const int trackIndex = AMediaExtractor_getSampleTrackIndex(extractor);
+            if (trackIndex < 0) break;
+
+            samples->emplace_back(trackIndex, Sample{extractor});
+            AMediaExtractor_advance(extractor);
+        }
+    }
+
+    /** Lets the prefetching threads, if any, read ahead of the extractor position. */
+    static void waitForPrefetch() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }
+
+    /**
+     * Runs |readSamples| on an extractor with prefetching and on one without, and checks that
+     * both return the same samples in the same order.
+     */
+    void comparePrefetchedSamples(
+            const std::function<void(AMediaExtractor*, std::vector<TrackSample>*)>& readSamples) {
+        std::vector<TrackSample> samples[2];
+        for (int prefetch = 0; prefetch <= 1; prefetch++) {
+            AMediaExtractor* extractor = createExtractor(prefetch);
+            ASSERT_NE(extractor, nullptr);
+            readSamples(extractor, &samples[prefetch]);
+            AMediaExtractor_delete(extractor);
+        }
+
+        LOG(DEBUG) << "Comparing " << samples[1].size() << " prefetched samples.";
+        ASSERT_EQ(samples[1].size(), samples[0].size());
+        for (size_t sampleIndex = 0; sampleIndex < samples[0].size(); sampleIndex++) {
+            EXPECT_EQ(samples[1][sampleIndex], samples[0][sampleIndex])
+                    << "Sample " << sampleIndex;
+        }
+    }
+
     void TearDown() override {
         LOG(DEBUG) << "MediaSampleReaderNDKTests tear down";
         AMediaExtractor_delete(mExtractor);
@@ -380,6 +435,107 @@ TEST_F(MediaSampleReaderNDKTests, TestMixedSampleAccess) {
     }
 }
 
+/** Reads all samples with and without prefetching. */
+TEST_F(MediaSampleReaderNDKTests, TestPrefetchSampleSequence) {
+    LOG(DEBUG) << "TestPrefetchSampleSequence Starts";
+    initExtractorSamples();
+
+    comparePrefetchedSamples([](AMediaExtractor* extractor, std::vector<TrackSample>* samples) {
+        readTrackSamples(extractor, SAMPLE_COUNT_ALL, samples);
+    });
+
+    // Prefetching turned off and on again midway keeps the samples already read ahead.
+    const int sampleCount = mExtractorSamples[0].size() / 2;
+    comparePrefetchedSamples(
+            [sampleCount](AMediaExtractor* extractor, std::vector<TrackSample>* samples) {
+                readTrackSamples(extractor, sampleCount, samples);
+                waitForPrefetch();
+                EXPECT_EQ(AMediaExtractor_setPrefetchEnabled(extractor, false), AMEDIA_OK);
+                readTrackSamples(extractor, sampleCount, samples);
+                EXPECT_EQ(AMediaExtractor_setPrefetchEnabled(extractor, true), AMEDIA_OK);
+                readTrackSamples(extractor, SAMPLE_COUNT_ALL, samples);
+            });
+}
+
+/** Seeks forward and backward while the samples are prefetched. */
+TEST_F(MediaSampleReaderNDKTests, TestPrefetchSeek) {
+    LOG(DEBUG) << "TestPrefetchSeek Starts";
+    initExtractorSamples();
+
+    int64_t durationUs;
+    AMediaFormat* trackFormat = AMediaExtractor_getTrackFormat(mExtractor, 0);
+    ASSERT_NE(trackFormat, nullptr);
+    ASSERT_TRUE(AMediaFormat_getInt64(trackFormat, AMEDIAFORMAT_KEY_DURATION, &durationUs));
+    AMediaFormat_delete(trackFormat);
+
+    const int sampleCount = mExtractorSamples[0].size() / 4;
+    for (SeekMode mode : {AMEDIAEXTRACTOR_SEEK_PREVIOUS_SYNC, AMEDIAEXTRACTOR_SEEK_NEXT_SYNC,
+                          AMEDIAEXTRACTOR_SEEK_CLOSEST_SYNC}) {
+        LOG(DEBUG) << "Testing seek mode " << mode;
+
+        comparePrefetchedSamples([durationUs, sampleCount, mode](
+                                         AMediaExtractor* extractor,
+                                         std::vector<TrackSample>* samples) {
+            readTrackSamples(extractor, sampleCount, samples);
+            waitForPrefetch();
+
+            // Forward, past the samples read ahead.
+            EXPECT_EQ(AMediaExtractor_seekTo(extractor, durationUs * 3 / 4, mode), AMEDIA_OK);
+            readTrackSamples(extractor, sampleCount, samples);
+            waitForPrefetch();
+
+            // Backward, before the samples read ahead.
+            EXPECT_EQ(AMediaExtractor_seekTo(extractor, durationUs / 4, mode), AMEDIA_OK);
+            readTrackSamples(extractor, sampleCount, samples);
+
+            // Twice in a row, before the prefetching threads read anything.
+            EXPECT_EQ(AMediaExtractor_seekTo(extractor, durationUs / 2, mode), AMEDIA_OK);
+            EXPECT_EQ(AMediaExtractor_seekTo(extractor, 0, mode), AMEDIA_OK);
+            readTrackSamples(extractor, SAMPLE_COUNT_ALL, samples);
+        });
+    }
+}
+
+/** Unselects and selects tracks while the samples are prefetched. */
+TEST_F(MediaSampleReaderNDKTests, TestPrefetchUnselectTrack) {
+    LOG(DEBUG) << "TestPrefetchUnselectTrack Starts";
+    initExtractorSamples();
+
+    for (int trackIndex = 0; trackIndex < mTrackCount; ++trackIndex) {
+        LOG(DEBUG) << "Testing unselect of track " << trackIndex;
+
+        const int sampleCount = mExtractorSamples[trackIndex].size() / 3;
+        comparePrefetchedSamples([trackIndex, sampleCount](AMediaExtractor* extractor,
+                                                           std::vector<TrackSample>* samples) {
+            readTrackSamples(extractor, sampleCount, samples);
+            waitForPrefetch();
+
+            EXPECT_EQ(AMediaExtractor_unselectTrack(extractor, trackIndex), AMEDIA_OK);
+            readTrackSamples(extractor, sampleCount, samples);
+            waitForPrefetch();
+
+            EXPECT_EQ(AMediaExtractor_selectTrack(extractor, trackIndex), AMEDIA_OK);
+            EXPECT_EQ(AMediaExtractor_seekTo(extractor, 0, AMEDIAEXTRACTOR_SEEK_PREVIOUS_SYNC),
+                      AMEDIA_OK);
+            readTrackSamples(extractor, SAMPLE_COUNT_ALL, samples);
+        });
+    }
+}
+
+/** Reads all samples through the sample reader with prefetching, in both access modes. */
+TEST_F(MediaSampleReaderNDKTests, TestPrefetchSampleAccess) {
+    LOG(DEBUG) << "TestPrefetchSampleAccess Starts";
+
+    for (int sequential = 0; sequential <= 1; sequential++) {
+        SampleAccessTester tester{mSourceFd, mFileSize};
+        EXPECT_EQ(tester.mSampleReader->setPrefetchEnabled(true), AMEDIA_OK);
+        tester.setEnforceSequentialAccess(sequential);
+        tester.readSamplesAsync(SAMPLE_COUNT_ALL);
+        tester.waitForTracks();
+        compareSamples(tester.getSamples());
+    }
+}
+
 TEST_F(MediaSampleReaderNDKTests, TestEstimatedBitrateAccuracy) {
     // Just put a somewhat reasonable upper bound on the estimated bitrate expected in our test
     // assets. This is mostly to make sure the estimation is not way off.
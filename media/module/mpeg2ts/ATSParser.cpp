@@ -45,6 +45,8 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+
 namespace android {
 using hardware::hidl_string;
 using hardware::hidl_vec;
@@ -59,6 +61,10 @@ typedef hidl::memory::V1_0::IMemory TMemory;
     do { unsigned tmp = y; ALOGV(x, tmp); } while (0)
 
 static const size_t kTSPacketSize = 188;
+static const size_t kNumPIDs = 0x2000;
+
+// Number of packets whose headers feedTSPackets() reads ahead of parsing them.
+static const size_t kTSPacketBatchSize = 32;
 
 struct ATSParser::Program : public RefBase {
     Program(ATSParser *parser, unsigned programNumber, unsigned programMapPID,
@@ -117,6 +123,10 @@ struct ATSParser::Program : public RefBase {
 
     void signalNewSampleAesKey(const sp<AMessage> &keyItem);
 
+    // Set the entries of streamsByPID for the streams of this program, unless
+    // another program already did.
+    void mapStreamsByPID(std::vector<Stream *> *streamsByPID) const;
+
 private:
 
     ATSParser *mParser;
@@ -345,6 +355,15 @@ bool ATSParser::Program::parsePID(
     return true;
 }
 
+void ATSParser::Program::mapStreamsByPID(std::vector<Stream *> *streamsByPID) const {
+    for (size_t i = 0; i < mStreams.size(); ++i) {
+        unsigned pid = mStreams.keyAt(i);
+        if (pid < streamsByPID->size() && (*streamsByPID)[pid] == NULL) {
+            (*streamsByPID)[pid] = mStreams.valueAt(i).get();
+        }
+    }
+}
+
 void ATSParser::Program::signalDiscontinuity(
         DiscontinuityType type, const sp<AMessage> &extra) {
     int64_t mediaTimeUs;
@@ -1918,8 +1937,34 @@ status_t ATSParser::feedTSPacket(const void *data, size_t size,
         return BAD_VALUE;
     }
 
-    ABitReader br((const uint8_t *)data, kTSPacketSize);
-    return parseTS(&br, event);
+    const uint8_t *packet = (const uint8_t *)data;
+    return parseTS(packet, U32_AT(packet), event);
+}
+
+status_t ATSParser::feedTSPackets(const void *data, size_t size, size_t *consumed) {
+    const uint8_t *packets = (const uint8_t *)data;
+    const size_t numPackets = size / kTSPacketSize;
+    *consumed = 0;
+
+    // The headers of a batch are loaded in a pass of their own, which has no
+    // dependency between packets, so that the loads overlap.
+    uint32_t headers[kTSPacketBatchSize];
+    for (size_t start = 0; start < numPackets; start += kTSPacketBatchSize) {
+        const uint8_t *batch = packets + start * kTSPacketSize;
+        const size_t count = std::min(numPackets - start, kTSPacketBatchSize);
+        for (size_t i = 0; i < count; ++i) {
+            headers[i] = U32_AT(batch + i * kTSPacketSize);
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            status_t err = parseTS(batch + i * kTSPacketSize, headers[i], NULL);
+            if (err != OK) {
+                return err;
+            }
+            *consumed += kTSPacketSize;
+        }
+    }
+    return OK;
 }
 
 status_t ATSParser::setMediaCas(const sp<ICas> &cas) {
@@ -2065,6 +2110,19 @@ status_t ATSParser::parsePID(
         unsigned transport_scrambling_control,
         unsigned random_access_indicator,
         SyncEvent *event) {
+    if (mStreamsByPID.empty()) {
+        updateStreamsByPID();
+    }
+    Stream *stream = mStreamsByPID[PID];
+    if (stream != NULL) {
+        return stream->parse(
+                continuity_counter,
+                payload_unit_start_indicator,
+                transport_scrambling_control,
+                random_access_indicator,
+                br, event);
+    }
+
     ssize_t sectionIndex = mPSISections.indexOfKey(PID);
 
     if (sectionIndex >= 0) {
@@ -2097,6 +2155,8 @@ status_t ATSParser::parsePID(
         if (!section->isCRCOkay()) {
             return BAD_VALUE;
         }
+        // The section may change the programs, their streams or the PSI PIDs.
+        mStreamsByPID.clear();
         ABitReader sectionBits(section->data(), section->size());
 
         if (PID == 0) {
@@ -2160,6 +2220,20 @@ status_t ATSParser::parsePID(
     return OK;
 }
 
+void ATSParser::updateStreamsByPID() {
+    mStreamsByPID.assign(kNumPIDs, NULL);
+    for (size_t i = 0; i < mPrograms.size(); ++i) {
+        mPrograms.itemAt(i)->mapStreamsByPID(&mStreamsByPID);
+    }
+    // PSI sections take precedence over the streams with the same PID.
+    for (size_t i = 0; i < mPSISections.size(); ++i) {
+        unsigned pid = mPSISections.keyAt(i);
+        if (pid < kNumPIDs) {
+            mStreamsByPID[pid] = NULL;
+        }
+    }
+}
+
 status_t ATSParser::parseAdaptationField(
         ABitReader *br, unsigned PID, unsigned *random_access_indicator) {
     *random_access_indicator = 0;
@@ -2230,48 +2304,49 @@ status_t ATSParser::parseAdaptationField(
     return OK;
 }
 
-status_t ATSParser::parseTS(ABitReader *br, SyncEvent *event) {
+status_t ATSParser::parseTS(const uint8_t *packet, uint32_t header, SyncEvent *event) {
     ALOGV("---");
 
-    unsigned sync_byte = br->getBits(8);
+    unsigned sync_byte = header >> 24;
     if (sync_byte != 0x47u) {
         ALOGE("[error] parseTS: return error as sync_byte=0x%x", sync_byte);
         return BAD_VALUE;
     }
 
-    if (br->getBits(1)) {  // transport_error_indicator
+    if ((header >> 23) & 1) {  // transport_error_indicator
         // silently ignore.
         return OK;
     }
 
-    unsigned payload_unit_start_indicator = br->getBits(1);
+    unsigned payload_unit_start_indicator = (header >> 22) & 1;
     ALOGV("payload_unit_start_indicator = %u", payload_unit_start_indicator);
 
-    MY_LOGV("transport_priority = %u", br->getBits(1));
+    MY_LOGV("transport_priority = %u", (header >> 21) & 1);
 
-    unsigned PID = br->getBits(13);
+    unsigned PID = (header >> 8) & 0x1fff;
     ALOGV("PID = 0x%04x", PID);
 
-    unsigned transport_scrambling_control = br->getBits(2);
+    unsigned transport_scrambling_control = (header >> 6) & 3;
     ALOGV("transport_scrambling_control = %u", transport_scrambling_control);
 
-    unsigned adaptation_field_control = br->getBits(2);
+    unsigned adaptation_field_control = (header >> 4) & 3;
     ALOGV("adaptation_field_control = %u", adaptation_field_control);
 
-    unsigned continuity_counter = br->getBits(4);
+    unsigned continuity_counter = header & 0x0f;
     ALOGV("PID = 0x%04x, continuity_counter = %u", PID, continuity_counter);
 
     // ALOGI("PID = 0x%04x, continuity_counter = %u", PID, continuity_counter);
 
     status_t err = OK;
 
+    ABitReader br(packet + 4, kTSPacketSize - 4);
     unsigned random_access_indicator = 0;
     if (adaptation_field_control == 2 || adaptation_field_control == 3) {
-        err = parseAdaptationField(br, PID, &random_access_indicator);
+        err = parseAdaptationField(&br, PID, &random_access_indicator);
     }
     if (err == OK) {
         if (adaptation_field_control == 1 || adaptation_field_control == 3) {
-            err = parsePID(br, PID, continuity_counter,
+            err = parsePID(&br, PID, continuity_counter,
                     payload_unit_start_indicator,
                     transport_scrambling_control,
                     random_access_indicator,
@@ -36,6 +36,9 @@
 #include <inttypes.h>
 #include <netinet/in.h>
 
+#include <algorithm>
+#include <atomic>
+
 #ifdef ENABLE_CRYPTO
 #include "HlsSampleDecryptor.h"
 #endif
@@ -69,7 +72,7 @@ sp<MetaData> ElementaryStreamQueue::getFormat() {
 
 void ElementaryStreamQueue::clear(bool clearFormat) {
     if (mBuffer != NULL) {
-        mBuffer->setRange(0, 0);
+        consumeData(mBuffer->size());
     }
 
     mRangeInfos.clear();
@@ -868,6 +871,36 @@ static bool IsSeeminglyValidMPEGAudioHeader(const uint8_t *ptr, size_t size) {
     return true;
 }
 
+// An access unit referencing data of a queue buffer without copying it. It keeps the
+// buffer alive, and is counted in the SliceCount of the buffer until it is destroyed.
+struct ElementaryStreamQueue::AccessUnitSlice : public ABuffer {
+    AccessUnitSlice(const sp<ABuffer> &buffer, size_t offset, size_t size,
+            const sp<SliceCount> &sliceCount)
+        : ABuffer(buffer->base() + offset, size),
+          mQueueBuffer(buffer),
+          mSliceCount(sliceCount) {
+        mSliceCount->mSlices.fetch_add(1, std::memory_order_relaxed);
+    }
+
+protected:
+    ~AccessUnitSlice() override {
+        // The access unit may be released on another thread: its reads of the buffer
+        // must happen before the queue writes to it again, see isBufferReferenced().
+        mSliceCount->mSlices.fetch_sub(1, std::memory_order_release);
+    }
+
+private:
+    const sp<ABuffer> mQueueBuffer;
+    const sp<SliceCount> mSliceCount;
+
+    DISALLOW_EVIL_CONSTRUCTORS(AccessUnitSlice);
+};
+
+bool ElementaryStreamQueue::isBufferReferenced() const {
+    return mSliceCount != NULL
+            && mSliceCount->mSlices.load(std::memory_order_acquire) != 0;
+}
+
 status_t ElementaryStreamQueue::appendData(
         const void *data, size_t size, int64_t timeUs,
         int32_t payloadOffset, uint32_t pesScramblingControl) {
@@ -889,17 +922,11 @@ status_t ElementaryStreamQueue::appendData(
 #else
                 uint8_t *ptr = (uint8_t *)data;
 
-                ssize_t startOffset = -1;
-                for (size_t i = 0; i + 2 < size; ++i) {
-                    if (!memcmp("\x00\x00\x01", &ptr[i], 3)) {
-                        startOffset = i;
-                        break;
-                    }
-                }
-
-                if (startOffset < 0) {
+                const uint8_t *startCode = findNextStartCode(ptr, size);
+                if (startCode == NULL) {
                     return ERROR_MALFORMED;
                 }
+                ssize_t startOffset = startCode - ptr;
 
                 if (mFormat == NULL && startOffset > 0) {
                     ALOGI("found something resembling an H.264/MPEG syncword "
@@ -922,17 +949,11 @@ status_t ElementaryStreamQueue::appendData(
 #else
                 uint8_t *ptr = (uint8_t *)data;
 
-                ssize_t startOffset = -1;
-                for (size_t i = 0; i + 2 < size; ++i) {
-                    if (!memcmp("\x00\x00\x01", &ptr[i], 3)) {
-                        startOffset = i;
-                        break;
-                    }
-                }
-
-                if (startOffset < 0) {
+                const uint8_t *startCode = findNextStartCode(ptr, size);
+                if (startCode == NULL) {
                     return ERROR_MALFORMED;
                 }
+                ssize_t startOffset = startCode - ptr;
 
                 if (startOffset > 0) {
                     ALOGI("found something resembling an H.264/MPEG syncword "
@@ -1162,24 +1183,36 @@ status_t ElementaryStreamQueue::appendData(
     }
 
     size_t neededSize = (mBuffer == NULL ? 0 : mBuffer->size()) + size;
-    if (mBuffer == NULL || neededSize > mBuffer->capacity()) {
-        neededSize = (neededSize + 65535) & ~65535;
+    if (mBuffer == NULL || mBuffer->offset() + neededSize > mBuffer->capacity()) {
+        if (mBuffer != NULL && !isBufferReferenced()
+                && neededSize <= mBuffer->capacity() / 2) {
+            // No access unit references the dequeued data any more, and there
+            // is little left to move to the front.
+            memmove(mBuffer->base(), mBuffer->data(), mBuffer->size());
+            mBuffer->setRange(0, mBuffer->size());
+        } else {
+            // Leave room for the data that follows, so that the buffer is
+            // not replaced for every PES payload.
+            neededSize = (neededSize * 2 + 65535) & ~65535;
 
-        ALOGV("resizing buffer to size %zu", neededSize);
+            ALOGV("resizing buffer to size %zu", neededSize);
 
-        sp<ABuffer> buffer = new ABuffer(neededSize);
-        if (mBuffer != NULL) {
-            memcpy(buffer->data(), mBuffer->data(), mBuffer->size());
-            buffer->setRange(0, mBuffer->size());
-        } else {
-            buffer->setRange(0, 0);
-        }
+            sp<ABuffer> buffer = new ABuffer(neededSize);
+            if (mBuffer != NULL) {
+                memcpy(buffer->data(), mBuffer->data(), mBuffer->size());
+                buffer->setRange(0, mBuffer->size());
+            } else {
+                buffer->setRange(0, 0);
+            }
 
-        mBuffer = buffer;
+            mBuffer = buffer;
+            // the slices of the previous buffer do not reference this one
+            mSliceCount.clear();
+        }
     }
 
     memcpy(mBuffer->data() + mBuffer->size(), data, size);
-    mBuffer->setRange(0, mBuffer->size() + size);
+    mBuffer->setRange(mBuffer->offset(), mBuffer->size() + size);
 
     RangeInfo info;
     info.mLength = size;
@@ -1280,11 +1313,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueScrambledAccessUnit() {
     // Retrieve the leading clear bytes info, and use it to set the clear
     // range on mBuffer. Note that the leading clear bytes includes the
     // PES header portion, while mBuffer doesn't.
+    size_t clearSize = 0;
     if ((int32_t)leadingClearBytes > pesOffset) {
-        mBuffer->setRange(0, leadingClearBytes - pesOffset);
-    } else {
-        mBuffer->setRange(0, 0);
+        clearSize = std::min(leadingClearBytes - pesOffset, mBuffer->size());
     }
+    mBuffer->setRange(mBuffer->offset(), clearSize);
 
     // Try to parse formats, and if unavailable set up a dummy format.
     // Only support the following modes for scrambled content for now.
@@ -1339,7 +1372,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueScrambledAccessUnit() {
                 0, mCasSessionId.data(), mCasSessionId.size());
     }
 
-    mBuffer->setRange(0, 0);
+    consumeData(mBuffer->size());
 
     // copy into scrambled access unit
     sp<ABuffer> scrambledAccessUnit = ABuffer::CreateAsCopy(
@@ -1384,16 +1417,9 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnit() {
         RangeInfo info = *mRangeInfos.begin();
         mRangeInfos.erase(mRangeInfos.begin());
 
-        sp<ABuffer> accessUnit = new ABuffer(info.mLength);
-        memcpy(accessUnit->data(), mBuffer->data(), info.mLength);
+        sp<ABuffer> accessUnit = takeData(info.mLength);
         accessUnit->meta()->setInt64("timeUs", info.mTimestampUs);
 
-        memmove(mBuffer->data(),
-                mBuffer->data() + info.mLength,
-                mBuffer->size() - info.mLength);
-
-        mBuffer->setRange(0, mBuffer->size() - info.mLength);
-
         if (mFormat == NULL) {
             mFormat = new MetaData;
             if (!MakeAVCCodecSpecificData(*mFormat, accessUnit->data(), accessUnit->size())) {
@@ -1473,19 +1499,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitDTSOrDTSHD() {
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
-    memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = takeData(syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-        mBuffer->data(),
-        mBuffer->data() + syncStartPos + payloadSize,
-        mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
-
     return accessUnit;
 }
 
@@ -1527,19 +1545,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitDTSUHD()
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
-    memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = takeData(syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-        mBuffer->data(),
-        mBuffer->data() + syncStartPos + payloadSize,
-        mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
-
     return accessUnit;
 }
 
@@ -1599,19 +1609,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitEAC3() {
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
-    memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = takeData(syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
-
     return accessUnit;
 }
 
@@ -1663,18 +1665,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAC4() {
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
-    memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = takeData(syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
-
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
     return accessUnit;
 }
 
@@ -1736,12 +1730,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitPCMAudio() {
         ptr[i] = ntohs(ptr[i]);
     }
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + 4 + payloadSize,
-            mBuffer->size() - 4 - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - 4 - payloadSize);
+    consumeData(4 + payloadSize);
 
     return accessUnit;
 }
@@ -1882,12 +1871,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAAC() {
 
     int64_t timeUs = fetchTimestamp(offset);
 
-    sp<ABuffer> accessUnit = new ABuffer(offset);
-    memcpy(accessUnit->data(), mBuffer->data(), offset);
-
-    memmove(mBuffer->data(), mBuffer->data() + offset,
-            mBuffer->size() - offset);
-    mBuffer->setRange(0, mBuffer->size() - offset);
+    sp<ABuffer> accessUnit = takeData(offset);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
@@ -1895,6 +1879,27 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAAC() {
     return accessUnit;
 }
 
+void ElementaryStreamQueue::consumeData(size_t size) {
+    size_t offset = mBuffer->offset() + size;
+    size_t remaining = mBuffer->size() - size;
+    if (remaining == 0 && !isBufferReferenced()) {
+        // Nothing references the dequeued data, the next append can start over
+        // at the beginning of the buffer.
+        offset = 0;
+    }
+    mBuffer->setRange(offset, remaining);
+}
+
+sp<ABuffer> ElementaryStreamQueue::takeData(size_t size) {
+    CHECK_LE(size, mBuffer->size());
+    if (mSliceCount == NULL) {
+        mSliceCount = new SliceCount;
+    }
+    sp<ABuffer> data = new AccessUnitSlice(mBuffer, mBuffer->offset(), size, mSliceCount);
+    consumeData(size);
+    return data;
+}
+
 int64_t ElementaryStreamQueue::fetchTimestamp(
         size_t size, int32_t *pesOffset, int32_t *pesScramblingControl) {
     int64_t timeUs = -1;
@@ -2072,11 +2077,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitH264() {
             const NALPosition &pos = nals.itemAt(nals.size() - 1);
             size_t nextScan = pos.nalOffset + pos.nalSize;
 
-            memmove(mBuffer->data(),
-                    mBuffer->data() + nextScan,
-                    mBuffer->size() - nextScan);
-
-            mBuffer->setRange(0, mBuffer->size() - nextScan);
+            consumeData(nextScan);
 
             int64_t timeUs = fetchTimestamp(nextScan);
             if (timeUs < 0LL) {
@@ -2145,7 +2146,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGAudio() {
                 header, &frameSize, &samplingRate, &numChannels,
                 &bitrate, &numSamples)) {
         ALOGE("Failed to get audio frame size");
-        mBuffer->setRange(0, 0);
+        consumeData(size);
         return NULL;
     }
 
@@ -2155,14 +2156,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGAudio() {
 
     unsigned layer = 4 - ((header >> 17) & 3);
 
-    sp<ABuffer> accessUnit = new ABuffer(frameSize);
-    memcpy(accessUnit->data(), data, frameSize);
-
-    memmove(mBuffer->data(),
-            mBuffer->data() + frameSize,
-            mBuffer->size() - frameSize);
-
-    mBuffer->setRange(0, mBuffer->size() - frameSize);
+    sp<ABuffer> accessUnit = takeData(frameSize);
 
     int64_t timeUs = fetchTimestamp(frameSize);
     if (timeUs < 0LL) {
@@ -2275,21 +2269,23 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
 
     size_t offset = 0;
     while (offset + 3 < size) {
-        if (memcmp(&data[offset], "\x00\x00\x01", 3)) {
-            ++offset;
-            continue;
+        // The start code must be followed by its value.
+        const uint8_t *startCode = findNextStartCode(&data[offset], size - offset - 1);
+        if (startCode == NULL) {
+            break;
         }
+        offset = startCode - data;
 
         pprevStartCode = prevStartCode;
         prevStartCode = currentStartCode;
         currentStartCode = data[offset + 3];
 
         if (currentStartCode == 0xb3 && mFormat == NULL) {
-            memmove(mBuffer->data(), mBuffer->data() + offset, size - offset);
+            consumeData(offset);
+            data = mBuffer->data();
             size -= offset;
             (void)fetchTimestamp(offset);
             offset = 0;
-            mBuffer->setRange(0, size);
         }
 
         if ((prevStartCode == 0xb3 && currentStartCode != 0xb5)
@@ -2315,14 +2311,8 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
 
                 ALOGI("found MPEG2 video codec config (%d x %d)", width, height);
 
-                sp<ABuffer> csd = new ABuffer(offset);
-                memcpy(csd->data(), data, offset);
-
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                sp<ABuffer> csd = takeData(offset);
+                data = mBuffer->data();
                 size -= offset;
                 (void)fetchTimestamp(offset);
                 offset = 0;
@@ -2358,14 +2348,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
             if (!sawPictureStart) {
                 sawPictureStart = true;
             } else {
-                sp<ABuffer> accessUnit = new ABuffer(offset);
-                memcpy(accessUnit->data(), data, offset);
-
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                sp<ABuffer> accessUnit = takeData(offset);
 
                 int64_t timeUs = fetchTimestamp(offset);
                 if (timeUs < 0LL) {
@@ -2422,16 +2405,12 @@ static ssize_t getNextChunkSize(
         return -EAGAIN;
     }
 
-    size_t offset = 4;
-    while (offset + 2 < size) {
-        if (!memcmp(&data[offset], kStartCode, 3)) {
-            return offset;
-        }
-
-        ++offset;
+    const uint8_t *startCode = findNextStartCode(&data[4], size - 4);
+    if (startCode == NULL) {
+        return -EAGAIN;
     }
 
-    return -EAGAIN;
+    return startCode - data;
 }
 
 sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
@@ -2557,12 +2536,9 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
 
                     offset += chunkSize;
 
-                    sp<ABuffer> accessUnit = new ABuffer(offset);
-                    memcpy(accessUnit->data(), data, offset);
-
-                    memmove(data, &data[offset], size - offset);
+                    sp<ABuffer> accessUnit = takeData(offset);
+                    data = mBuffer->data();
                     size -= offset;
-                    mBuffer->setRange(0, size);
 
                     int64_t timeUs = fetchTimestamp(offset);
                     if (timeUs < 0LL) {
@@ -2598,10 +2574,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
 
         if (discard) {
             (void)fetchTimestamp(offset);
-            memmove(data, &data[offset], size - offset);
+            consumeData(offset);
+            data = mBuffer->data();
             size -= offset;
             offset = 0;
-            mBuffer->setRange(0, size);
         } else {
             offset += chunkSize;
         }
@@ -2628,13 +2604,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMetadata() {
         return NULL;
     }
 
-    sp<ABuffer> accessUnit = new ABuffer(size);
+    sp<ABuffer> accessUnit = takeData(size);
     int64_t timeUs = fetchTimestamp(size);
     accessUnit->meta()->setInt64("timeUs", timeUs);
 
-    memcpy(accessUnit->data(), mBuffer->data(), size);
-    mBuffer->setRange(0, 0);
-
     if (mFormat == NULL) {
         mFormat = new MetaData;
         mFormat->setCString(kKeyMIMEType, MEDIA_MIMETYPE_DATA_TIMED_ID3);
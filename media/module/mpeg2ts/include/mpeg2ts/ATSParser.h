@@ -122,6 +122,12 @@ struct ATSParser : public RefBase {
     status_t feedTSPacket(
             const void *data, size_t size, SyncEvent *event = NULL);
 
+    // Feed consecutive TS packets into the parser, as feedTSPacket() does for
+    // each of them, and stop at the first one that fails. Trailing bytes that
+    // do not make up a whole packet are left. consumed is set to the number of
+    // bytes of the packets parsed without error.
+    status_t feedTSPackets(const void *data, size_t size, size_t *consumed);
+
     void signalDiscontinuity(
             DiscontinuityType type, const sp<AMessage> &extra);
 
@@ -223,6 +229,11 @@ private:
 
     size_t mNumTSPacketsParsed;
 
+    // The elementary streams of the programs indexed by PID, for the PIDs that
+    // are not PSI sections. Empty until rebuilt by updateStreamsByPID() after
+    // the program tables changed.
+    std::vector<Stream *> mStreamsByPID;
+
     sp<AMessage> mSampleAesKeyItem;
 
     void parseProgramAssociationTable(ABitReader *br);
@@ -248,8 +259,10 @@ private:
     status_t parseAdaptationField(
             ABitReader *br, unsigned PID, unsigned *random_access_indicator);
 
-    // see feedTSPacket().
-    status_t parseTS(ABitReader *br, SyncEvent *event);
+    void updateStreamsByPID();
+
+    // see feedTSPacket(). header is the first 4 bytes of packet, in host order.
+    status_t parseTS(const uint8_t *packet, uint32_t header, SyncEvent *event);
 
     void updatePCR(unsigned PID, uint64_t PCR, uint64_t byteOffsetFromStart);
 
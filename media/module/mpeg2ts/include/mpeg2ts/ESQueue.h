@@ -23,6 +23,7 @@
 #include <utils/Errors.h>
 #include <utils/List.h>
 #include <utils/RefBase.h>
+#include <atomic>
 #include <vector>
 
 #include "SampleDecryptor.h"
@@ -102,7 +103,20 @@ private:
     uint32_t mFlags;
     bool mEOSReached;
 
+    // Counts the access units which are slices of one queue buffer. Each slice
+    // decrements the count when it is destroyed.
+    struct SliceCount : public RefBase {
+        std::atomic<size_t> mSlices{0};
+    };
+    struct AccessUnitSlice;
+
+    // The range of mBuffer is the queued data: dequeued access units advance
+    // its offset instead of moving the data that follows them. Access units may
+    // be slices of mBuffer, in which case the data before its range must not be
+    // overwritten until they are released.
     sp<ABuffer> mBuffer;
+    // Counts the slices of mBuffer, NULL if none was made since mBuffer was allocated.
+    sp<SliceCount> mSliceCount;
     List<RangeInfo> mRangeInfos;
 
     sp<ABuffer> mScrambledBuffer;
@@ -131,6 +145,16 @@ private:
     sp<ABuffer> dequeueAccessUnitDTSOrDTSHD();
     sp<ABuffer> dequeueAccessUnitDTSUHD();
 
+    // remove the first "size" bytes of the queued data.
+    void consumeData(size_t size);
+
+    // remove the first "size" bytes of the queued data and return them,
+    // as a slice of mBuffer rather than a copy.
+    sp<ABuffer> takeData(size_t size);
+
+    // true if an access unit returned by takeData() still references mBuffer.
+    bool isBufferReferenced() const;
+
     // consume a logical (compressed) access unit of size "size",
     // returns its timestamp in us (or -1 if no time information).
     int64_t fetchTimestamp(size_t size,
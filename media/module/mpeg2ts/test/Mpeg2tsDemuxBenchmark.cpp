@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Demux throughput of ATSParser on a synthetic transport stream: one program with an H.264
+ * video stream and an AAC audio stream, at the bitrate given as argument in Mbps.
+ *
+ *      $ adb shell /data/benchmarktest64/Mpeg2tsDemuxBenchmark/Mpeg2tsDemuxBenchmark
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/MediaErrors.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <mpeg2ts/ATSParser.h>
+#include <mpeg2ts/AnotherPacketSource.h>
+
+using namespace android;
+
+static constexpr size_t kTSPacketSize = 188;
+static constexpr unsigned kPMTPID = 0x1000;
+static constexpr unsigned kVideoPID = 0x100;
+static constexpr unsigned kAudioPID = 0x101;
+static constexpr unsigned kFramesPerSecond = 30;
+static constexpr unsigned kAudioFramesPerSecond = 47;  // 1024 samples at 48 kHz
+static constexpr size_t kAudioFrameSize = 768;         // 288 kbps
+static constexpr unsigned kSeconds = 2;
+
+// SPS and PPS of 1280x720 H.264 baseline profile video, level 3.1.
+static const uint8_t kSPS[] = {0x67, 0x42, 0xc0, 0x1f, 0xda, 0x01, 0x40, 0x16, 0xe4};
+static const uint8_t kPPS[] = {0x68, 0xce, 0x3c, 0x80};
+static const uint8_t kAUD[] = {0x09, 0xf0};
+
+static uint32_t crc32(const uint8_t *data, size_t size) {
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= (uint32_t)data[i] << 24;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+class TSWriter {
+public:
+    std::vector<uint8_t> mData;
+
+    // Writes the payload in packets of the PID. The last packet is padded with
+    // adaptation field stuffing.
+    void writePayload(unsigned pid, const std::vector<uint8_t> &payload) {
+        size_t offset = 0;
+        do {
+            size_t size = std::min(payload.size() - offset, kTSPacketSize - 4);
+            size_t stuffing = kTSPacketSize - 4 - size;
+            mData.push_back(0x47);
+            mData.push_back((offset == 0 ? 0x40 : 0x00) | (pid >> 8));
+            mData.push_back(pid & 0xff);
+            mData.push_back((stuffing > 0 ? 0x30 : 0x10) | (mContinuityCounters[pid]++ & 0x0f));
+            if (stuffing > 0) {
+                mData.push_back(stuffing - 1);  // adaptation_field_length
+                if (stuffing > 1) {
+                    mData.push_back(0x00);  // no flags
+                    mData.insert(mData.end(), stuffing - 2, 0xff);
+                }
+            }
+            mData.insert(mData.end(), payload.begin() + offset, payload.begin() + offset + size);
+            offset += size;
+        } while (offset < payload.size());
+    }
+
+    void writeSection(unsigned pid, std::vector<uint8_t> section) {
+        // section_length covers what follows it, including the CRC.
+        unsigned sectionLength = section.size() - 3 + 4;
+        section[1] = 0xb0 | (sectionLength >> 8);
+        section[2] = sectionLength & 0xff;
+        uint32_t crc = crc32(section.data(), section.size());
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            section.push_back(crc >> shift);
+        }
+        section.insert(section.begin(), 0x00);  // pointer_field
+        section.resize(kTSPacketSize - 4, 0xff);
+        writePayload(pid, section);
+    }
+
+    void writeTables() {
+        writeSection(0, {
+                0x00, 0, 0,                    // table_id, section_length
+                0x00, 0x01, 0xc1, 0x00, 0x00,  // transport_stream_id, version, section numbers
+                0x00, 0x01, 0xe0 | (kPMTPID >> 8), kPMTPID & 0xff});
+        writeSection(kPMTPID, {
+                0x02, 0, 0,                    // table_id, section_length
+                0x00, 0x01, 0xc1, 0x00, 0x00,  // program_number, version, section numbers
+                0xe0 | (kVideoPID >> 8), kVideoPID & 0xff, 0xf0, 0x00,  // PCR_PID, program info
+                ATSParser::STREAMTYPE_H264, 0xe0 | (kVideoPID >> 8), kVideoPID & 0xff, 0xf0, 0x00,
+                ATSParser::STREAMTYPE_MPEG2_AUDIO_ADTS,
+                0xe0 | (kAudioPID >> 8), kAudioPID & 0xff, 0xf0, 0x00});
+    }
+
+    void writePES(unsigned pid, uint8_t streamId, uint64_t pts, const std::vector<uint8_t> &data) {
+        std::vector<uint8_t> pes = {0x00, 0x00, 0x01, streamId, 0, 0, 0x80, 0x80, 5};
+        // PES_packet_length is 0 for video, which may not fit.
+        size_t length = data.size() + 8;
+        if (pid != kVideoPID && length <= 0xffff) {
+            pes[4] = length >> 8;
+            pes[5] = length & 0xff;
+        }
+        pes.push_back(0x21 | ((pts >> 29) & 0x0e));
+        pes.push_back(pts >> 22);
+        pes.push_back(0x01 | ((pts >> 14) & 0xfe));
+        pes.push_back(pts >> 7);
+        pes.push_back(0x01 | ((pts << 1) & 0xfe));
+        pes.insert(pes.end(), data.begin(), data.end());
+        writePayload(pid, pes);
+    }
+
+private:
+    unsigned mContinuityCounters[0x2000] = {};
+};
+
+static void appendNAL(std::vector<uint8_t> *data, const uint8_t *nal, size_t size) {
+    static const uint8_t kStartCode[] = {0x00, 0x00, 0x00, 0x01};
+    data->insert(data->end(), kStartCode, kStartCode + sizeof(kStartCode));
+    data->insert(data->end(), nal, nal + size);
+}
+
+// Random payload bytes that never make up a start code.
+static void appendRandom(std::vector<uint8_t> *data, size_t size, std::mt19937 *random) {
+    for (size_t i = 0; i < size; ++i) {
+        data->push_back(1 + (*random)() % 255);
+    }
+}
+
+static std::vector<uint8_t> createStream(unsigned mbps) {
+    TSWriter writer;
+    std::mt19937 random(mbps);
+    const size_t audioBytesPerSecond = kAudioFramesPerSecond * kAudioFrameSize;
+    const size_t videoFrameSize = (mbps * 1000000 / 8 - audioBytesPerSecond) / kFramesPerSecond;
+
+    unsigned audioFrame = 0;
+    for (unsigned frame = 0; frame < kSeconds * kFramesPerSecond; ++frame) {
+        const bool idr = frame % kFramesPerSecond == 0;
+        if (idr) {
+            writer.writeTables();
+        }
+
+        std::vector<uint8_t> video;
+        appendNAL(&video, kAUD, sizeof(kAUD));
+        if (idr) {
+            appendNAL(&video, kSPS, sizeof(kSPS));
+            appendNAL(&video, kPPS, sizeof(kPPS));
+        }
+        // A single slice, first_mb_in_slice = 0.
+        const uint8_t sliceHeader[] = {(uint8_t)(idr ? 0x65 : 0x41), 0x88};
+        appendNAL(&video, sliceHeader, sizeof(sliceHeader));
+        appendRandom(&video, videoFrameSize, &random);
+        const uint64_t pts = 90000ull * frame / kFramesPerSecond;
+        writer.writePES(kVideoPID, 0xe0, pts, video);
+
+        // The audio frames up to the next video frame.
+        for (; audioFrame * kFramesPerSecond < (frame + 1) * kAudioFramesPerSecond;
+                ++audioFrame) {
+            // ADTS header of AAC LC at 48 kHz in stereo.
+            const size_t size = kAudioFrameSize;
+            std::vector<uint8_t> audio = {
+                    0xff, 0xf1, 0x4c, (uint8_t)(0x80 | (size >> 11)),
+                    (uint8_t)(size >> 3), (uint8_t)(((size & 7) << 5) | 0x1f), 0xfc};
+            appendRandom(&audio, size - audio.size(), &random);
+            writer.writePES(kAudioPID, 0xc0, 90000ull * audioFrame / kAudioFramesPerSecond, audio);
+        }
+    }
+    return writer.mData;
+}
+
+// Dequeues what the parser output, as a player would.
+static size_t drainSources(const sp<ATSParser> &parser) {
+    size_t count = 0;
+    for (ATSParser::SourceType type : {ATSParser::VIDEO, ATSParser::AUDIO}) {
+        sp<AnotherPacketSource> source = parser->getSource(type);
+        status_t finalResult;
+        sp<ABuffer> accessUnit;
+        while (source != nullptr && source->hasBufferAvailable(&finalResult)
+                && source->dequeueAccessUnit(&accessUnit) == OK) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Demuxes the stream one packet at a time with feedTSPacket().
+static void BM_ATSParser_FeedTSPacket(benchmark::State &state) {
+    const std::vector<uint8_t> stream = createStream(state.range(0));
+    size_t accessUnits = 0;
+
+    for (auto _ : state) {
+        sp<ATSParser> parser = new ATSParser();
+        for (size_t offset = 0; offset < stream.size(); offset += kTSPacketSize) {
+            if (parser->feedTSPacket(&stream[offset], kTSPacketSize) != OK) {
+                state.SkipWithError("feedTSPacket failed");
+                return;
+            }
+        }
+        parser->signalEOS(ERROR_END_OF_STREAM);
+        accessUnits = drainSources(parser);
+    }
+
+    state.SetBytesProcessed(state.iterations() * stream.size());
+    state.counters["access_units"] = accessUnits;
+}
+
+// Demuxes the stream with feedTSPackets(), in buffers of the given number of packets.
+static void BM_ATSParser_FeedTSPackets(benchmark::State &state) {
+    const std::vector<uint8_t> stream = createStream(state.range(0));
+    const size_t bufferSize = state.range(1) * kTSPacketSize;
+    size_t accessUnits = 0;
+
+    for (auto _ : state) {
+        sp<ATSParser> parser = new ATSParser();
+        for (size_t offset = 0; offset < stream.size(); offset += bufferSize) {
+            size_t size = std::min(bufferSize, stream.size() - offset);
+            size_t consumed;
+            if (parser->feedTSPackets(&stream[offset], size, &consumed) != OK
+                    || consumed != size) {
+                state.SkipWithError("feedTSPackets failed");
+                return;
+            }
+        }
+        parser->signalEOS(ERROR_END_OF_STREAM);
+        accessUnits = drainSources(parser);
+    }
+
+    state.SetBytesProcessed(state.iterations() * stream.size());
+    state.counters["access_units"] = accessUnits;
+}
+
+BENCHMARK(BM_ATSParser_FeedTSPacket)->Arg(8)->Arg(80)->Unit(benchmark::kMillisecond);
+// 7 packets is the payload of an RTP packet, 1024 packets that of a large HLS read.
+BENCHMARK(BM_ATSParser_FeedTSPackets)
+        ->Args({8, 7})->Args({8, 1024})->Args({80, 7})->Args({80, 1024})
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
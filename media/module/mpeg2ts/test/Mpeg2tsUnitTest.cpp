@@ -20,14 +20,22 @@
 #include <utils/Log.h>
 
 #include <stdint.h>
+#include <string.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include <datasource/FileSource.h>
 #include <media/stagefright/MediaDefs.h>
+#include <media/stagefright/MediaErrors.h>
 #include <media/stagefright/MetaDataBase.h>
+#include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/AUtils.h>
 #include <mpeg2ts/AnotherPacketSource.h>
 #include <mpeg2ts/ATSParser.h>
+#include <mpeg2ts/ESQueue.h>
 
 #include "Mpeg2tsUnitTestEnvironment.h"
 
@@ -216,12 +224,312 @@ TEST_P(Mpeg2tsUnitTest, MediaInfoTest) {
     }
 }
 
+TEST_P(Mpeg2tsUnitTest, FeedTSPacketsTest) {
+    // Packets with a partial one at the end, as a buffer read from the network may be.
+    constexpr size_t kPacketsPerBuffer = 7;
+    constexpr size_t kBufferSize = kPacketsPerBuffer * kTSPacketSize + kTSPacketSize / 2;
+
+    sp<ATSParser> batchParser = new ATSParser();
+    std::vector<uint8_t> buffer(kBufferSize);
+    ssize_t numBytesRead;
+    while ((numBytesRead = mSource->readAt(mOffset, buffer.data(), kBufferSize)) > 0) {
+        size_t consumed;
+        status_t err = batchParser->feedTSPackets(buffer.data(), numBytesRead, &consumed);
+        ASSERT_EQ(err, (status_t)OK) << "Unable to feed TS packets!";
+        ASSERT_EQ(consumed, (size_t)numBytesRead / kTSPacketSize * kTSPacketSize)
+                << "Wrong number of bytes consumed!";
+
+        for (size_t offset = 0; offset < consumed; offset += kTSPacketSize) {
+            err = mParser->feedTSPacket(buffer.data() + offset, kTSPacketSize);
+            ASSERT_EQ(err, (status_t)OK) << "Unable to feed TS packet!";
+        }
+        if (consumed == 0) {
+            break;
+        }
+        mOffset += consumed;
+    }
+    mParser->signalEOS(ERROR_END_OF_STREAM);
+    batchParser->signalEOS(ERROR_END_OF_STREAM);
+
+    // Both parsers output the same access units.
+    for (ATSParser::SourceType type : {ATSParser::VIDEO, ATSParser::AUDIO, ATSParser::META}) {
+        ASSERT_EQ(mParser->hasSource(type), batchParser->hasSource(type))
+                << "Sources differ for media type: " << type;
+        if (!mParser->hasSource(type)) {
+            continue;
+        }
+        sp<AnotherPacketSource> source = mParser->getSource(type);
+        sp<AnotherPacketSource> batchSource = batchParser->getSource(type);
+        ASSERT_NE(source, nullptr);
+        ASSERT_NE(batchSource, nullptr);
+
+        size_t numAccessUnits = 0;
+        status_t finalResult;
+        while (source->hasBufferAvailable(&finalResult)) {
+            sp<ABuffer> accessUnit, batchAccessUnit;
+            ASSERT_EQ(source->dequeueAccessUnit(&accessUnit), (status_t)OK);
+            ASSERT_EQ(batchSource->dequeueAccessUnit(&batchAccessUnit), (status_t)OK)
+                    << "Missing access unit " << numAccessUnits << " for media type: " << type;
+            ASSERT_EQ(accessUnit->size(), batchAccessUnit->size());
+            ASSERT_EQ(memcmp(accessUnit->data(), batchAccessUnit->data(), accessUnit->size()), 0)
+                    << "Access unit " << numAccessUnits << " differs for media type: " << type;
+            int64_t timeUs, batchTimeUs;
+            ASSERT_TRUE(accessUnit->meta()->findInt64("timeUs", &timeUs));
+            ASSERT_TRUE(batchAccessUnit->meta()->findInt64("timeUs", &batchTimeUs));
+            ASSERT_EQ(timeUs, batchTimeUs);
+            ++numAccessUnits;
+        }
+        ASSERT_FALSE(batchSource->hasBufferAvailable(&finalResult))
+                << "Extra access units for media type: " << type;
+        ASSERT_GT(numAccessUnits, 0u) << "No access units for media type: " << type;
+    }
+}
+
 INSTANTIATE_TEST_SUITE_P(
         infoTest, Mpeg2tsUnitTest,
         ::testing::Values(make_tuple("crowd_1920x1080_25fps_6700kbps_h264.ts", 0x01, 1),
                           make_tuple("segment000001.ts", 0x03, 2),
                           make_tuple("bbb_44100hz_2ch_128kbps_mp3_5mins.ts", 0x02, 1)));
 
+// ElementaryStreamQueue returns most access units as slices of its buffer. These check that
+// the data of the access units a client holds on to stays intact as more data is appended, as
+// the queue buffer is compacted or replaced, and across clear().
+struct ESQueueStream {
+    ElementaryStreamQueue::Mode mode;
+    uint32_t flags;
+    // PES payloads, appended one at a time.
+    vector<vector<uint8_t>> payloads;
+    // Access units the payloads split into, in order.
+    vector<vector<uint8_t>> accessUnits;
+};
+
+constexpr int64_t kESQueueFrameDurationUs = 10000;
+
+// Sizes vary so that the queue buffer fills at different offsets.
+static size_t getESQueueFrameSize(size_t index) {
+    return 200 + (index * 397) % 1800;
+}
+
+// Fills |size| bytes without any zero byte, so that no start code shows up by accident.
+static void appendFiller(vector<uint8_t> *data, size_t size, size_t seed) {
+    for (size_t i = 0; i < size; ++i) {
+        data->push_back((seed * 31 + i * 13) % 255 + 1);
+    }
+}
+
+static ESQueueStream makeAACStream(size_t numFrames) {
+    ESQueueStream stream = {ElementaryStreamQueue::AAC, 0, {}, {}};
+    for (size_t i = 0; i < numFrames; ++i) {
+        size_t frameLength = getESQueueFrameSize(i);
+        // AAC LC, 44.1 kHz, stereo, no CRC, one raw data block.
+        vector<uint8_t> frame = {0xff,
+                                 0xf1,
+                                 0x50,
+                                 (uint8_t)(0x80 | (frameLength >> 11)),
+                                 (uint8_t)(frameLength >> 3),
+                                 (uint8_t)(((frameLength & 7) << 5) | 0x1f),
+                                 0xfc};
+        appendFiller(&frame, frameLength - frame.size(), i);
+        stream.payloads.push_back(frame);
+        stream.accessUnits.push_back(frame);
+    }
+    return stream;
+}
+
+static ESQueueStream makeMPEGVideoStream(size_t numFrames) {
+    static const uint8_t kSequenceHeader[] = {0x00, 0x00, 0x01, 0xb3, 0x16, 0x01,
+                                              0x20, 0x13, 0xff, 0xff, 0xe0, 0x18};
+    static const uint8_t kClosedGOPHeader[] = {0x00, 0x00, 0x01, 0xb8,
+                                               0x00, 0x08, 0x00, 0x40};
+
+    ESQueueStream stream = {ElementaryStreamQueue::MPEG_VIDEO, 0, {}, {}};
+    for (size_t i = 0; i < numFrames; ++i) {
+        vector<uint8_t> picture = {0x00, 0x00, 0x01, 0x00};
+        appendFiller(&picture, getESQueueFrameSize(i), i);
+
+        // The sequence header goes to the codec config, the GOP header to the first picture.
+        vector<uint8_t> accessUnit;
+        if (i == 0) {
+            accessUnit.assign(kClosedGOPHeader, kClosedGOPHeader + sizeof(kClosedGOPHeader));
+        }
+        accessUnit.insert(accessUnit.end(), picture.begin(), picture.end());
+
+        vector<uint8_t> payload;
+        if (i == 0) {
+            payload.assign(kSequenceHeader, kSequenceHeader + sizeof(kSequenceHeader));
+        }
+        payload.insert(payload.end(), accessUnit.begin(), accessUnit.end());
+
+        stream.payloads.push_back(payload);
+        stream.accessUnits.push_back(accessUnit);
+    }
+    return stream;
+}
+
+static ESQueueStream makeAlignedH264Stream(size_t numFrames) {
+    ESQueueStream stream = {ElementaryStreamQueue::H264, ElementaryStreamQueue::kFlag_AlignedData,
+                            {}, {}};
+    for (size_t i = 0; i < numFrames; ++i) {
+        // One slice per access unit, an IDR one every 30 frames. The start codes are 3 bytes
+        // long: the queue skips the zero bytes before the first one in its buffer.
+        vector<uint8_t> accessUnit = {0x00, 0x00, 0x01, (uint8_t)(i % 30 == 0 ? 0x65 : 0x41)};
+        appendFiller(&accessUnit, getESQueueFrameSize(i), i);
+        stream.payloads.push_back(accessUnit);
+        stream.accessUnits.push_back(accessUnit);
+    }
+    return stream;
+}
+
+class ESQueueTest : public ::testing::TestWithParam<ElementaryStreamQueue::Mode> {
+  public:
+    // Enough data for the queue buffer to fill up several times.
+    static constexpr size_t kNumFrames = 400;
+
+    void SetUp() override {
+        switch (GetParam()) {
+            case ElementaryStreamQueue::AAC:
+                mStream = makeAACStream(kNumFrames);
+                break;
+            case ElementaryStreamQueue::MPEG_VIDEO:
+                mStream = makeMPEGVideoStream(kNumFrames);
+                break;
+            default:
+                mStream = makeAlignedH264Stream(kNumFrames);
+                break;
+        }
+        mQueue.reset(new ElementaryStreamQueue(mStream.mode, mStream.flags));
+        mNumAppended = 0;
+        mNumDequeued = 0;
+    }
+
+    // Appends the payloads up to |end|, dequeuing access units as long as more than
+    // |numPending| appended payloads are left in the queue. Leaving payloads in the queue keeps
+    // its buffer from being emptied, so that appending has to compact or replace it. Every
+    // |holdInterval|-th access unit is kept in mHeldAccessUnits, the others are released once
+    // checked. A zero |holdInterval| keeps none.
+    void appendAndDequeue(size_t end, size_t numPending, size_t holdInterval) {
+        for (; mNumAppended < end; ++mNumAppended) {
+            const vector<uint8_t> &payload = mStream.payloads[mNumAppended];
+            ASSERT_EQ(mQueue->appendData(payload.data(), payload.size(),
+                                         mNumAppended * kESQueueFrameDurationUs),
+                      (status_t)OK)
+                    << "Unable to append payload " << mNumAppended;
+            while (mNumAppended + 1 - mNumDequeued > numPending) {
+                sp<ABuffer> accessUnit = mQueue->dequeueAccessUnit();
+                if (accessUnit == nullptr) {
+                    break;
+                }
+                ASSERT_NO_FATAL_FAILURE(checkAccessUnit(accessUnit, mNumDequeued));
+                if (holdInterval > 0 && mNumDequeued % holdInterval == 0) {
+                    mHeldAccessUnits.emplace_back(mNumDequeued, accessUnit);
+                }
+                ++mNumDequeued;
+            }
+        }
+    }
+
+    // Dequeues the access units left at the end of the stream.
+    void drain() {
+        mQueue->signalEOS();
+        sp<ABuffer> accessUnit;
+        while ((accessUnit = mQueue->dequeueAccessUnit()) != nullptr) {
+            ASSERT_NO_FATAL_FAILURE(checkAccessUnit(accessUnit, mNumDequeued));
+            ++mNumDequeued;
+        }
+        ASSERT_EQ(mNumDequeued, mStream.accessUnits.size()) << "Missing access units";
+    }
+
+    void checkAccessUnit(const sp<ABuffer> &accessUnit, size_t index) {
+        ASSERT_LT(index, mStream.accessUnits.size()) << "Extra access unit";
+        const vector<uint8_t> &expected = mStream.accessUnits[index];
+        ASSERT_EQ(accessUnit->size(), expected.size()) << "Wrong size for access unit " << index;
+        ASSERT_EQ(memcmp(accessUnit->data(), expected.data(), expected.size()), 0)
+                << "Wrong data for access unit " << index;
+        int64_t timeUs;
+        ASSERT_TRUE(accessUnit->meta()->findInt64("timeUs", &timeUs));
+        ASSERT_EQ(timeUs, (int64_t)index * kESQueueFrameDurationUs)
+                << "Wrong timestamp for access unit " << index;
+    }
+
+    void checkHeldAccessUnits() {
+        for (const auto &[index, accessUnit] : mHeldAccessUnits) {
+            ASSERT_NO_FATAL_FAILURE(checkAccessUnit(accessUnit, index));
+        }
+    }
+
+    ESQueueStream mStream;
+    std::unique_ptr<ElementaryStreamQueue> mQueue;
+    size_t mNumAppended;
+    size_t mNumDequeued;
+    vector<pair<size_t, sp<ABuffer>>> mHeldAccessUnits;
+};
+
+// Holding every access unit keeps the queue from reusing its buffer: it has to replace it.
+TEST_P(ESQueueTest, HoldAllAccessUnitsTest) {
+    ASSERT_NO_FATAL_FAILURE(appendAndDequeue(kNumFrames, 0, 1));
+    ASSERT_NO_FATAL_FAILURE(drain());
+    ASSERT_NO_FATAL_FAILURE(checkHeldAccessUnits());
+}
+
+// With every access unit released and data left in the queue, the queue compacts its buffer.
+TEST_P(ESQueueTest, ReleaseAllAccessUnitsTest) {
+    ASSERT_NO_FATAL_FAILURE(appendAndDequeue(kNumFrames, 1, 0));
+    ASSERT_NO_FATAL_FAILURE(drain());
+}
+
+// Holding some access units mixes both: the queue replaces its buffer while they reference it,
+// and compacts the new one once they are gone.
+TEST_P(ESQueueTest, HoldSomeAccessUnitsTest) {
+    for (size_t end = kNumFrames / 4; end <= kNumFrames; end += kNumFrames / 4) {
+        ASSERT_NO_FATAL_FAILURE(appendAndDequeue(end, 1, 7));
+        ASSERT_NO_FATAL_FAILURE(checkHeldAccessUnits());
+        // Release all but the last few.
+        mHeldAccessUnits.erase(mHeldAccessUnits.begin(),
+                               mHeldAccessUnits.end() - std::min(mHeldAccessUnits.size(),
+                                                                 (size_t)3));
+    }
+    ASSERT_NO_FATAL_FAILURE(drain());
+    ASSERT_NO_FATAL_FAILURE(checkHeldAccessUnits());
+}
+
+// clear() drops the queued data, but not the data of the access units already dequeued.
+TEST_P(ESQueueTest, ClearWithHeldAccessUnitsTest) {
+    for (size_t end = kNumFrames / 4; end <= kNumFrames; end += kNumFrames / 4) {
+        ASSERT_NO_FATAL_FAILURE(appendAndDequeue(end, 1, 3));
+        mQueue->clear(false /* clearFormat */);
+        // The access units of the payloads left in the queue are gone.
+        mNumDequeued = end;
+        ASSERT_NO_FATAL_FAILURE(checkHeldAccessUnits());
+        if (end == kNumFrames / 2) {
+            // Let the queue reuse its buffer from the start.
+            mHeldAccessUnits.clear();
+        }
+    }
+    ASSERT_NO_FATAL_FAILURE(checkHeldAccessUnits());
+}
+
+// The queue does not keep anything in the meta of the access units, which clients may clear.
+TEST_P(ESQueueTest, ClearHeldMetaTest) {
+    for (size_t end = kNumFrames / 4; end <= kNumFrames; end += kNumFrames / 4) {
+        ASSERT_NO_FATAL_FAILURE(appendAndDequeue(end, 1, 2));
+        for (const auto &[index, accessUnit] : mHeldAccessUnits) {
+            accessUnit->meta()->clear();
+            accessUnit->meta()->setInt64("timeUs", index * kESQueueFrameDurationUs);
+        }
+        ASSERT_NO_FATAL_FAILURE(checkHeldAccessUnits());
+        // Release half of them, so that the queue both replaces and compacts its buffer.
+        mHeldAccessUnits.erase(mHeldAccessUnits.begin(),
+                               mHeldAccessUnits.begin() + mHeldAccessUnits.size() / 2);
+    }
+    ASSERT_NO_FATAL_FAILURE(drain());
+    ASSERT_NO_FATAL_FAILURE(checkHeldAccessUnits());
+}
+
+INSTANTIATE_TEST_SUITE_P(ESQueueTestAll, ESQueueTest,
+                         ::testing::Values(ElementaryStreamQueue::AAC,
+                                           ElementaryStreamQueue::MPEG_VIDEO,
+                                           ElementaryStreamQueue::H264));
+
 int32_t main(int argc, char **argv) {
     gEnv = new Mpeg2tsUnitTestEnvironment();
     ::testing::AddGlobalTestEnvironment(gEnv);
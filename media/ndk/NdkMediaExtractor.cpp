@@ -20,6 +20,7 @@
 
 #include <media/NdkMediaError.h>
 #include <media/NdkMediaExtractor.h>
+#include <media/NdkMediaExtractorPlatform.h>
 #include <media/NdkMediaErrorPriv.h>
 #include <media/NdkMediaFormatPriv.h>
 #include "NdkJavaVMHelperPriv.h"
@@ -153,6 +154,12 @@ media_status_t AMediaExtractor_unselectTrack(AMediaExtractor *mData, size_t idx)
     return translate_error(mData->mImpl->unselectTrack(idx));
 }
 
+EXPORT
+media_status_t AMediaExtractor_setPrefetchEnabled(AMediaExtractor *mData, bool enabled) {
+    ALOGV("setPrefetchEnabled(%d)", enabled);
+    return translate_error(mData->mImpl->setPrefetchEnabled(enabled));
+}
+
 EXPORT
 bool AMediaExtractor_advance(AMediaExtractor *mData) {
     //ALOGV("advance");
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _NDK_MEDIA_EXTRACTOR_PLATFORM_H
+#define _NDK_MEDIA_EXTRACTOR_PLATFORM_H
+
+#include <stdbool.h>
+#include <sys/cdefs.h>
+
+#include <media/NdkMediaExtractor.h>
+
+__BEGIN_DECLS
+
+/**
+ * Enable or disable reading the samples of the selected tracks ahead of the caller.
+ *
+ * When enabled, the samples of each selected track are read in the background, in large
+ * batches, up to a bounded number of samples and bytes per track. AMediaExtractor_advance(),
+ * AMediaExtractor_readSampleData() and the other sample accessors then return samples that
+ * were already read, instead of waiting for the extractor. This is meant for callers that
+ * read the whole stream as fast as they can, such as transcoders and muxers.
+ *
+ * Seeking discards the samples read ahead. Disabling keeps the samples already read and
+ * reads the next ones on demand again. Disabled by default.
+ *
+ * Available since API level 35.
+ */
+media_status_t AMediaExtractor_setPrefetchEnabled(AMediaExtractor *mData,
+                                                  bool enabled) __INTRODUCED_IN(35);
+
+__END_DECLS
+
+#endif //_NDK_MEDIA_EXTRACTOR_PLATFORM_H
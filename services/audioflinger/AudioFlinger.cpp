@@ -62,6 +62,7 @@
 #include "NBAIO_Tee.h"
 #include "PropertyUtils.h"
 
+#include <media/AudioResampler.h>
 #include <media/AudioResamplerPublic.h>
 
 #include <system/audio_effects/effect_visualizer.h>
@@ -844,6 +845,9 @@ void AudioFlinger::dumpInternals(int fd, const Vector<String16>& args __unused)
     }
     dprintf(fd, "Bluetooth latency modes are %senabled\n",
             mBluetoothLatencyModesEnabled ? "" : "not ");
+
+    const std::string filterCache = AudioResampler::dumpFilterCache();
+    write(fd, filterCache.c_str(), filterCache.size());
 }
 
 void AudioFlinger::dumpPermissionDenial(int fd, const Vector<String16>& args __unused)
@@ -87,6 +87,7 @@
 #include <audio_utils/SimpleLog.h>
 #include <audio_utils/TimestampVerifier.h>
 
+#include <effectchain/I16Handoffs.h>
 #include <sounddose/SoundDoseManager.h>
 #include <timing/MonotonicFrameCounter.h>
 
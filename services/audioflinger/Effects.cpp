@@ -669,12 +669,18 @@ bool AudioFlinger::EffectModule::updateState() {
     return started;
 }
 
-void AudioFlinger::EffectModule::process()
+bool AudioFlinger::EffectModule::process(bool i16Input, bool i16Output)
 {
     Mutex::Autolock _l(mLock);
 
+    mBufferCopies = 0;
     if (mState == DESTROYED || mEffectInterface == 0 || mInBuffer == 0 || mOutBuffer == 0) {
-        return;
+#ifdef FLOAT_EFFECT_CHAIN
+        if (i16Input && mInBuffer != 0) {
+            restoreFloatInput_l();
+        }
+#endif
+        return false;
     }
 
     const uint32_t inChannelCount =
@@ -694,6 +700,7 @@ void AudioFlinger::EffectModule::process()
                             mConfig.inputCfg.buffer.frameCount,
                             mConfig.outputCfg.buffer.frameCount);
     const auto accumulateInputToOutput = [this, safeInputOutputSampleCount]() {
+        mBufferCopies++;
 #ifdef FLOAT_EFFECT_CHAIN
         accumulate_float(
                 mConfig.outputCfg.buffer.f32,
@@ -707,6 +714,7 @@ void AudioFlinger::EffectModule::process()
 #endif
     };
     const auto copyInputToOutput = [this, safeInputOutputSampleCount]() {
+        mBufferCopies++;
 #ifdef FLOAT_EFFECT_CHAIN
         memcpy(
                 mConfig.outputCfg.buffer.f32,
@@ -721,6 +729,17 @@ void AudioFlinger::EffectModule::process()
 #endif
     };
 
+#ifdef FLOAT_EFFECT_CHAIN
+    // The chain only hands off int16 data to an enabled effect, but the state may have
+    // changed since: if we are not going to take the input as is, the chain needs it in float.
+    if (i16Input && !(isProcessEnabled() && isProcessImplemented() && canTakeI16Input_l())) {
+        restoreFloatInput_l();
+        i16Input = false;
+    }
+    i16Output = i16Output && canGiveI16Output_l();
+#endif
+    bool outputIsI16 = false;
+
     if (isProcessEnabled()) {
         int ret;
         if (isProcessImplemented()) {
@@ -738,6 +757,7 @@ void AudioFlinger::EffectModule::process()
                             mConfig.inputCfg.buffer.f32,
                             mConfig.inputCfg.buffer.s32,
                             mConfig.inputCfg.buffer.frameCount);
+                    mBufferCopies++;
 #endif // !FLOAT_AUX
                 } else
 #endif // FLOAT_EFFECT_CHAIN
@@ -753,6 +773,7 @@ void AudioFlinger::EffectModule::process()
                             mConfig.inputCfg.buffer.s32,
                             mConfig.inputCfg.buffer.frameCount);
 #endif
+                    mBufferCopies++;
                 }
             }
 #ifdef FLOAT_EFFECT_CHAIN
@@ -766,6 +787,7 @@ void AudioFlinger::EffectModule::process()
                         sizeof(float),
                         sizeof(float)
                         * mInChannelCountRequested * mConfig.inputCfg.buffer.frameCount);
+                mBufferCopies++;
                 inBuffer = mInConversionBuffer;
             }
             if (mConfig.outputCfg.accessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE
@@ -776,6 +798,7 @@ void AudioFlinger::EffectModule::process()
                         sizeof(float),
                         sizeof(float)
                         * mOutChannelCountRequested * mConfig.outputCfg.buffer.frameCount);
+                mBufferCopies++;
                 outBuffer = mOutConversionBuffer;
             }
             if (!mSupportsFloat) { // convert input to int16_t as effect doesn't support float.
@@ -784,10 +807,14 @@ void AudioFlinger::EffectModule::process()
                         ALOGW("%s: mInConversionBuffer is null, bypassing", __func__);
                         goto data_bypass;
                     }
-                    memcpy_to_i16_from_float(
-                            mInConversionBuffer->audioBuffer()->s16,
-                            inBuffer->audioBuffer()->f32,
-                            inChannelCount * mConfig.inputCfg.buffer.frameCount);
+                    // otherwise the previous effect already wrote our int16 input there
+                    if (!i16Input) {
+                        memcpy_to_i16_from_float(
+                                mInConversionBuffer->audioBuffer()->s16,
+                                inBuffer->audioBuffer()->f32,
+                                inChannelCount * mConfig.inputCfg.buffer.frameCount);
+                        mBufferCopies++;
+                    }
                     inBuffer = mInConversionBuffer;
                 }
                 if (mConfig.outputCfg.accessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE) {
@@ -799,13 +826,17 @@ void AudioFlinger::EffectModule::process()
                             mOutConversionBuffer->audioBuffer()->s16,
                             outBuffer->audioBuffer()->f32,
                             outChannelCount * mConfig.outputCfg.buffer.frameCount);
+                    mBufferCopies++;
                     outBuffer = mOutConversionBuffer;
                 }
             }
 #endif
             ret = mEffectInterface->process();
 #ifdef FLOAT_EFFECT_CHAIN
-            if (!mSupportsFloat) { // convert output int16_t back to float.
+            if (i16Output) {
+                // mOutConversionBuffer is the int16 input of the next effect, which reads it as is.
+                outputIsI16 = true;
+            } else if (!mSupportsFloat) { // convert output int16_t back to float.
                 sp<EffectBufferHalInterface> target =
                         mOutChannelCountRequested != outChannelCount
                         ? mOutConversionBuffer : mOutBuffer;
@@ -814,12 +845,14 @@ void AudioFlinger::EffectModule::process()
                         target->audioBuffer()->f32,
                         mOutConversionBuffer->audioBuffer()->s16,
                         outChannelCount * mConfig.outputCfg.buffer.frameCount);
+                mBufferCopies++;
             }
             if (mOutChannelCountRequested != outChannelCount) {
                 adjust_selected_channels(mOutConversionBuffer->audioBuffer()->f32, outChannelCount,
                         mOutBuffer->audioBuffer()->f32, mOutChannelCountRequested,
                         sizeof(float),
                         sizeof(float) * outChannelCount * mConfig.outputCfg.buffer.frameCount);
+                mBufferCopies++;
             }
 #endif
         } else {
@@ -867,6 +900,93 @@ void AudioFlinger::EffectModule::process()
             }
         }
     }
+    return outputIsI16;
+}
+
+#ifdef FLOAT_EFFECT_CHAIN
+audioflinger::I16HandoffConfig AudioFlinger::EffectModule::i16HandoffConfig_l() const
+{
+    const uint32_t type = mDescriptor.flags & EFFECT_FLAG_TYPE_MASK;
+    return {
+        .supportsFloat = mSupportsFloat,
+        .isInsert = type == EFFECT_FLAG_TYPE_INSERT,
+        .isAuxiliary = type == EFFECT_FLAG_TYPE_AUXILIARY,
+        .overwritesOutput = mConfig.outputCfg.accessMode == EFFECT_BUFFER_ACCESS_WRITE,
+        .processImplemented = isProcessImplemented(),
+        .inChannelCountMatches = mInChannelCountRequested ==
+                audio_channel_count_from_out_mask(mConfig.inputCfg.channels),
+        .outChannelCountMatches = mOutChannelCountRequested ==
+                audio_channel_count_from_out_mask(mConfig.outputCfg.channels),
+        .hasInConversionBuffer = mInConversionBuffer != nullptr,
+        .hasOutConversionBuffer = mOutConversionBuffer != nullptr,
+    };
+}
+
+void AudioFlinger::EffectModule::restoreFloatInput_l()
+{
+    if (mInConversionBuffer == nullptr) {
+        return;
+    }
+    memcpy_to_float_from_i16(
+            mInBuffer->audioBuffer()->f32,
+            mInConversionBuffer->audioBuffer()->s16,
+            audio_channel_count_from_out_mask(mConfig.inputCfg.channels)
+                    * mConfig.inputCfg.buffer.frameCount);
+    mBufferCopies++;
+}
+#endif
+
+sp<EffectBufferHalInterface> AudioFlinger::EffectModule::i16HandoffInputBuffer()
+{
+#ifdef FLOAT_EFFECT_CHAIN
+    Mutex::Autolock _l(mLock);
+    if (mStatus == NO_ERROR && isProcessImplemented() && canTakeI16Input_l()) {
+        return mInConversionBuffer;
+    }
+#endif
+    return nullptr;
+}
+
+bool AudioFlinger::EffectModule::setI16HandoffOutputBuffer(
+        const sp<EffectBufferHalInterface>& buffer)
+{
+#ifdef FLOAT_EFFECT_CHAIN
+    Mutex::Autolock _l(mLock);
+    if (mStatus != NO_ERROR || mEffectInterface == 0 || !canGiveI16Output_l()) {
+        return false;
+    }
+    if (buffer == mOutConversionBuffer) {
+        return true;
+    }
+    const size_t size = audio_channel_count_from_out_mask(mConfig.outputCfg.channels)
+            * mConfig.outputCfg.buffer.frameCount * sizeof(int16_t);
+    if (buffer == nullptr || buffer->getSize() < size) {
+        return false;
+    }
+    // Our int16 output is only read by the next effect, or converted to float by us:
+    // it can go directly to its int16 input, which we then never need to convert.
+    mOutConversionBuffer = buffer;
+    mEffectInterface->setOutBuffer(mOutConversionBuffer);
+    ALOGV("%s: sharing int16 buffer %p with next effect", __func__, buffer.get());
+    return true;
+#else
+    (void)buffer;
+    return false;
+#endif
+}
+
+void AudioFlinger::EffectModule::clearI16HandoffOutputBuffer()
+{
+#ifdef FLOAT_EFFECT_CHAIN
+    Mutex::Autolock _l(mLock);
+    if (mOutConversionBuffer == mPrivateOutConversionBuffer) {
+        return;
+    }
+    mOutConversionBuffer = mPrivateOutConversionBuffer;
+    if (mEffectInterface != 0 && mOutConversionBuffer != nullptr) {
+        mEffectInterface->setOutBuffer(mOutConversionBuffer);
+    }
+#endif
 }
 
 void AudioFlinger::EffectModule::reset_l()
@@ -880,6 +1000,7 @@ void AudioFlinger::EffectModule::reset_l()
 status_t AudioFlinger::EffectModule::configure()
 {
     ALOGVV("configure() started");
+    mBufferGeneration++;
     status_t status;
     uint32_t size;
     audio_channel_mask_t channelMask;
@@ -1338,6 +1459,7 @@ bool AudioFlinger::EffectModule::isVolumeControlEnabled() const
 
 void AudioFlinger::EffectModule::setInBuffer(const sp<EffectBufferHalInterface>& buffer) {
     ALOGVV("setInBuffer %p",(&buffer));
+    mBufferGeneration++;
 
     // mConfig.inputCfg.buffer.frameCount may be zero if configure() is not called yet.
     if (buffer != 0) {
@@ -1386,6 +1508,7 @@ void AudioFlinger::EffectModule::setInBuffer(const sp<EffectBufferHalInterface>&
 
 void AudioFlinger::EffectModule::setOutBuffer(const sp<EffectBufferHalInterface>& buffer) {
     ALOGVV("setOutBuffer %p",(&buffer));
+    mBufferGeneration++;
 
     // mConfig.outputCfg.buffer.frameCount may be zero if configure() is not called yet.
     if (buffer != 0) {
@@ -1412,12 +1535,14 @@ void AudioFlinger::EffectModule::setOutBuffer(const sp<EffectBufferHalInterface>
         ALOGV("%s: setOutBuffer updating for outChannels:%d outFrameCount:%zu total size:%zu",
                 __func__, outChannels, outFrameCount, size);
 
-        if (size > 0 && (mOutConversionBuffer == nullptr
-                || size > mOutConversionBuffer->getSize())) {
-            mOutConversionBuffer.clear();
+        // A handoff from a previous plan is dropped, the chain plans again on buffer changes.
+        if (size > 0 && (mPrivateOutConversionBuffer == nullptr
+                || size > mPrivateOutConversionBuffer->getSize())) {
+            mPrivateOutConversionBuffer.clear();
             ALOGV("%s: allocating mOutConversionBuffer %zu", __func__, size);
-            (void)getCallback()->allocateHalBuffer(size, &mOutConversionBuffer);
+            (void)getCallback()->allocateHalBuffer(size, &mPrivateOutConversionBuffer);
         }
+        mOutConversionBuffer = mPrivateOutConversionBuffer;
         if (mOutConversionBuffer != nullptr) {
             mOutConversionBuffer->setFrameCount(outFrameCount);
             mEffectInterface->setOutBuffer(mOutConversionBuffer);
@@ -1700,6 +1825,7 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
             mStatus, mEffectInterface.get());
 
     result.appendFormat("\t\t- data: %s\n", mSupportsFloat ? "float" : "int16");
+    result.appendFormat("\t\t- buffer copies in last process: %u\n", mBufferCopies);
 
     result.append("\t\t- Input configuration:\n");
     result.append("\t\t\tBuffer     Frames  Smp rate Channels Format\n");
@@ -2304,9 +2430,10 @@ void AudioFlinger::EffectChain::process_l()
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->update();
         }
-        for (size_t i = 0; i < size; i++) {
-            mEffects[i]->process();
+        if (!mI16HandoffsValid || mI16HandoffsGeneration != buffersGeneration_l()) {
+            planI16Handoffs_l();
         }
+        mBufferCopiesPerCycle = audioflinger::processWithI16Handoffs(mEffects, mI16Handoffs);
         mInBuffer->commit();
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->commit();
@@ -2321,6 +2448,26 @@ void AudioFlinger::EffectChain::process_l()
     }
 }
 
+uint32_t AudioFlinger::EffectChain::buffersGeneration_l() const
+{
+    uint32_t generation = 0;
+    for (size_t i = 0; i < mEffects.size(); i++) {
+        generation += mEffects[i]->bufferGeneration();
+    }
+    return generation;
+}
+
+// See audioflinger::planI16Handoffs() in effectchain/I16Handoffs.h.
+void AudioFlinger::EffectChain::planI16Handoffs_l()
+{
+    const size_t handoffs = audioflinger::planI16Handoffs(mEffects, &mI16Handoffs);
+    // computed last as setI16HandoffOutputBuffer() does not change the generation
+    mI16HandoffsGeneration = buffersGeneration_l();
+    mI16HandoffsValid = true;
+    ALOGV("%s: %zu int16 handoffs for %zu effects in session %d",
+            __func__, handoffs, mEffects.size(), mSessionId);
+}
+
 // createEffect_l() must be called with ThreadBase::mLock held
 status_t AudioFlinger::EffectChain::createEffect_l(sp<EffectModule>& effect,
                                                    effect_descriptor_t *desc,
@@ -2427,6 +2574,7 @@ status_t AudioFlinger::EffectChain::addEffect_ll(const sp<EffectModule>& effect)
                 __func__, effect.get(), this, idx_insert);
     }
     effect->configure();
+    mI16HandoffsValid = false;
 
     return NO_ERROR;
 }
@@ -2533,6 +2681,7 @@ size_t AudioFlinger::EffectChain::removeEffect_l(const sp<EffectModule>& effect,
                 }
             }
             mEffects.removeAt(i);
+            mI16HandoffsValid = false;
 
             // make sure the input buffer configuration for the new first effect in the chain
             // is updated if needed (can switch from HAL channel mask to mixer channel mask)
@@ -2723,6 +2872,9 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
                 (int)outBufferStr.size(), "Out buffer      ");
         result.appendFormat("\t%s   %s   %d\n",
                 inBufferStr.c_str(), outBufferStr.c_str(), mActiveTrackCnt);
+        result.appendFormat("\tBuffer copies per cycle: %u, int16 handoffs: %zu\n",
+                mBufferCopiesPerCycle,
+                (size_t)std::count(mI16Handoffs.begin(), mI16Handoffs.end(), true));
         write(fd, result.string(), result.size());
 
         for (size_t i = 0; i < numEffects; ++i) {
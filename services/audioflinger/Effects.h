@@ -227,7 +227,12 @@ public:
                     audio_port_handle_t deviceId);
     virtual ~EffectModule();
 
-    void process();
+    // i16Input: the previous effect left our input as int16 in our HAL input buffer
+    // (see EffectChain::planI16Handoffs_l()).
+    // i16Output: leave the output as int16 in the HAL input buffer of the next effect
+    // if possible, instead of converting it back to float.
+    // Returns true if the output was left as int16.
+    bool process(bool i16Input = false, bool i16Output = false);
     bool updateState();
     status_t command(int32_t cmdCode,
                      const std::vector<uint8_t>& cmdData,
@@ -255,6 +260,19 @@ public:
         return mOutBuffer != 0 ? reinterpret_cast<int16_t*>(mOutBuffer->ptr()) : NULL;
     }
 
+    // Returns the int16 HAL input buffer if the effect can take its input as int16
+    // directly from the previous effect, nullptr otherwise.
+    sp<EffectBufferHalInterface> i16HandoffInputBuffer();
+    // Makes the effect write its int16 output to the HAL input buffer of the next effect.
+    // Returns false if the effect does not process in int16 or needs a channel conversion.
+    bool        setI16HandoffOutputBuffer(const sp<EffectBufferHalInterface>& buffer);
+    // Makes the effect write its int16 output to its own conversion buffer again.
+    void        clearI16HandoffOutputBuffer();
+    // Incremented whenever the buffers or the format of the effect may have changed.
+    uint32_t    bufferGeneration() const { return mBufferGeneration; }
+    // Number of full buffer copies and conversions done by the last process() call.
+    uint32_t    bufferCopies() const { return mBufferCopies; }
+
     // Updates the access mode if it is out of date.  May issue a new effect configure.
     void        updateAccessMode() {
                     if (requiredEffectBufferAccessMode() != mConfig.outputCfg.accessMode) {
@@ -308,6 +326,17 @@ private:
 
     status_t setVolumeInternal(uint32_t *left, uint32_t *right, bool controller);
 
+#ifdef FLOAT_EFFECT_CHAIN
+    audioflinger::I16HandoffConfig i16HandoffConfig_l() const;
+    bool canTakeI16Input_l() const { return audioflinger::canTakeI16Input(i16HandoffConfig_l()); }
+    bool canGiveI16Output_l() const {
+        return audioflinger::canGiveI16Output(i16HandoffConfig_l());
+    }
+    // Converts the int16 input left by the previous effect back to float in mInBuffer,
+    // when the effect does not process it.
+    void restoreFloatInput_l();
+#endif
+
 
     effect_config_t     mConfig;    // input and output audio configuration
     sp<EffectHalInterface> mEffectInterface; // Effect module HAL
@@ -327,9 +356,13 @@ private:
     bool    mSupportsFloat;         // effect supports float processing
     sp<EffectBufferHalInterface> mInConversionBuffer;  // Buffers for HAL conversion if needed.
     sp<EffectBufferHalInterface> mOutConversionBuffer;
+    // mOutConversionBuffer when the output is not handed off to the next effect.
+    sp<EffectBufferHalInterface> mPrivateOutConversionBuffer;
     uint32_t mInChannelCountRequested;
     uint32_t mOutChannelCountRequested;
 #endif
+    std::atomic<uint32_t> mBufferGeneration{0};
+    uint32_t mBufferCopies = 0;     // full buffer copies in last process(), see bufferCopies()
 
     class AutoLockReentrant {
     public:
@@ -561,6 +594,9 @@ public:
 
     bool isFirstEffect(int id) const { return !mEffects.isEmpty() && id == mEffects[0]->id(); }
 
+    // Number of full buffer copies and conversions done by the last process_l().
+    uint32_t bufferCopiesPerCycle() const { return mBufferCopiesPerCycle; }
+
     void dump(int fd, const Vector<String16>& args);
 
 private:
@@ -679,6 +715,11 @@ private:
 
     ssize_t getInsertIndex(const effect_descriptor_t& desc);
 
+    // Finds the adjacent effects which can pass int16 data to each other without
+    // converting it to float and back, and makes them share the int16 buffer.
+    void planI16Handoffs_l();
+    uint32_t buffersGeneration_l() const;
+
     mutable  Mutex mLock;        // mutex protecting effect list
              Vector< sp<EffectModule> > mEffects; // list of effect modules
              audio_session_t mSessionId; // audio session ID
@@ -690,6 +731,11 @@ private:
     volatile int32_t mTrackCnt;          // number of tracks connected
 
              int32_t mTailBufferCount;   // current effect tail buffer count
+             // mI16Handoffs[i] is true if effect i can leave its output as int16 for effect i + 1
+             std::vector<bool> mI16Handoffs;
+             bool mI16HandoffsValid = false;     // false when effects are added or removed
+             uint32_t mI16HandoffsGeneration = 0; // buffersGeneration_l() when planned
+             uint32_t mBufferCopiesPerCycle = 0;
              int32_t mMaxTailBuffers;    // maximum effect tail buffers
              int mVolumeCtrlIdx;         // index of insert effect having control over volume
              uint32_t mLeftVolume;       // previous volume on left channel
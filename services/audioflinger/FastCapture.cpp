@@ -183,7 +183,9 @@ void FastCapture::onWork()
         ALOG_ASSERT(mReadBuffer != NULL);
         dumpState->mReadSequence++;
         ATRACE_BEGIN("read");
+        const nsecs_t readStartNs = systemTime(SYSTEM_TIME_MONOTONIC);
         ssize_t framesRead = mInputSource->read(mReadBuffer, frameCount);
+        mCycleTimes.halNs = systemTime(SYSTEM_TIME_MONOTONIC) - readStartNs;
         ATRACE_END();
         dumpState->mReadSequence++;
         if (framesRead >= 0) {
@@ -208,6 +210,7 @@ void FastCapture::onWork()
             mReadBufferState = frameCount;
         }
         if (mReadBufferState > 0) {
+            const nsecs_t deliverStartNs = systemTime(SYSTEM_TIME_MONOTONIC);
             if (current->mSilenceCapture) {
                 memset(mReadBuffer, 0, mReadBufferState * Format_frameSize(mFormat));
             }
@@ -233,6 +236,7 @@ void FastCapture::onWork()
                     (void) syscall(__NR_futex, &cblk->mFutex, FUTEX_WAKE, 1);
                 }
             }
+            mCycleTimes.workNs = systemTime(SYSTEM_TIME_MONOTONIC) - deliverStartNs;
         }
     }
 }
@@ -431,11 +431,13 @@ void FastMixer::onWork()
             FastTrackUnderruns underruns = ftDump->mUnderruns;
             if (framesReady < frameCount) {
                 if (framesReady == 0) {
+                    mCycleTimes.emptyTracks |= 1u << i;
                     underruns.mBitFields.mEmpty++;
                     underruns.mBitFields.mMostRecent = UNDERRUN_EMPTY;
                     mMixer->disable(name);
                 } else {
                     // allow mixing partial buffer
+                    mCycleTimes.partialTracks |= 1u << i;
                     underruns.mBitFields.mPartial++;
                     underruns.mBitFields.mMostRecent = UNDERRUN_PARTIAL;
                     mMixer->enable(name);
@@ -454,7 +456,9 @@ void FastMixer::onWork()
 
         if (anyEnabledTracks) {
             // process() is CPU-bound
+            const nsecs_t mixStartNs = systemTime(SYSTEM_TIME_MONOTONIC);
             mMixer->process();
+            mCycleTimes.workNs = systemTime(SYSTEM_TIME_MONOTONIC) - mixStartNs;
             mMixerBufferState = MIXED;
         } else if (mMixerBufferState != ZEROED) {
             mMixerBufferState = UNDEFINED;
@@ -501,7 +505,9 @@ void FastMixer::onWork()
         //       but this code should be modified to handle both non-blocking and blocking sinks
         dumpState->mWriteSequence++;
         ATRACE_BEGIN("write");
+        const nsecs_t writeStartNs = systemTime(SYSTEM_TIME_MONOTONIC);
         ssize_t framesWritten = mOutputSink->write(buffer, frameCount);
+        mCycleTimes.halNs = systemTime(SYSTEM_TIME_MONOTONIC) - writeStartNs;
         ATRACE_END();
         dumpState->mWriteSequence++;
         if (framesWritten >= 0) {
@@ -120,6 +120,12 @@ bool FastThread::threadLoop()
         mCommand = next->mCommand;
         if (next != mCurrent) {
 
+            // Flush the cycles of the previous state while its log writer is still current
+            if (mCycleSummary.cycles > 0) {
+                LOG_CYCLE_SUMMARY(mCycleSummary);
+                mCycleSummary = {};
+            }
+
             // As soon as possible of learning of a new dump area, start using it
             mDumpState = next->mDumpState != NULL ? next->mDumpState : mDummyDumpState;
             tlNBLogWriter = next->mNBLogWriter != NULL ?
@@ -214,6 +220,7 @@ bool FastThread::threadLoop()
 
         // do work using current state here
         mAttemptedWrite = false;
+        mCycleTimes = {};
         onWork();
 
         // To be exactly periodic, compute the next sleep time based on current time.
@@ -295,6 +302,15 @@ bool FastThread::threadLoop()
                         mIgnoreNextOverrun = false;
                     }
                 }
+                if (mIsWarm && mAttemptedWrite) {
+                    const int64_t cycleNs = sec < 2 ? sec * 1000000000LL + nsec : 2000000000LL;
+                    mCycleTimes.jitterNs = cycleNs - mPeriodNs;
+                    mCycleSummary.add(mCycleTimes);
+                    if (mCycleSummary.full()) {
+                        LOG_CYCLE_SUMMARY(mCycleSummary);
+                        mCycleSummary = {};
+                    }
+                }
 #ifdef FAST_THREAD_STATISTICS
                 if (mIsWarm) {
                     // advance the FIFO queue bounds
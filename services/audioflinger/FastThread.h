@@ -86,6 +86,8 @@ protected:
 
     FastThreadState::Command mCommand;
     bool            mAttemptedWrite;
+    NBLog::cycle_times_t mCycleTimes;  // cleared before onWork(), which fills in all but jitter
+    NBLog::cycle_summary_t mCycleSummary;  // warm cycles not logged yet
 
     char            mCycleMs[16];   // cycle_ms + suffix
     char            mLoadUs[16];    // load_us + suffix
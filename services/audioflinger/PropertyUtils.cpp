@@ -101,4 +101,16 @@ int32_t getAAudioHardwareBurstMinUsecFromSystemProperty() {
     return prop;
 }
 
+int32_t getMixerResampleThreadsFromSystemProperty() {
+    static const int32_t sDefaultThreads = 0; // resample on the mixer thread only
+    static const int32_t sMaxThreads = 8; // arbitrary
+    static const char* sPropResampleThreads = "af.mixer.resample_threads";
+    int32_t prop = property_get_int32(sPropResampleThreads, sDefaultThreads);
+    if (prop < 0 || prop > sMaxThreads) {
+        ALOGE("%s: invalid value %d, use default %d", __func__, prop, sDefaultThreads);
+        prop = sDefaultThreads;
+    }
+    return prop;
+}
+
 } // namespace android
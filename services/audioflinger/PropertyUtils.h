@@ -29,4 +29,7 @@ int32_t getAAudioMixerBurstCountFromSystemProperty();
 
 int32_t getAAudioHardwareBurstMinUsecFromSystemProperty();
 
+// Number of AudioMixer worker threads that resample tracks of a MixerThread, 0 for none.
+int32_t getMixerResampleThreadsFromSystemProperty();
+
 } // namespace android
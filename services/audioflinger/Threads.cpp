@@ -92,6 +92,7 @@
 #endif
 
 #include "AutoPark.h"
+#include "PropertyUtils.h"
 
 #include <pthread.h>
 #include "TypedLogger.h"
@@ -241,6 +242,14 @@ static int sFastTrackMultiplier = kFastTrackMultiplier;
 // and that all "fast" AudioRecord clients read from.  In either case, the size can be small.
 static const size_t kRecordThreadReadOnlyHeapSize = 0xD000;
 
+// Resampling on the AudioMixer worker threads goes back to serial when it takes
+// more than half of the mix period.
+static void setMixerResampleThreads(AudioMixer* mixer, size_t frameCount, uint32_t sampleRate)
+{
+    mixer->setResampleThreads(getMixerResampleThreadsFromSystemProperty(),
+            (int64_t)frameCount * NANOS_PER_SECOND / sampleRate / 2);
+}
+
 // ----------------------------------------------------------------------------
 
 // TODO: move all toString helpers to audio.h
@@ -4912,6 +4921,7 @@ AudioFlinger::MixerThread::MixerThread(const sp<AudioFlinger>& audioFlinger, Aud
             mSampleRate, mChannelMask, mChannelCount, mFormat, mFrameSize, mFrameCount,
             mNormalFrameCount);
     mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+    setMixerResampleThreads(mAudioMixer, mNormalFrameCount, mSampleRate);
 
     if (type == DUPLICATING) {
         // The Duplicating thread uses the AudioMixer and delivers data to OutputTracks
@@ -6256,6 +6266,7 @@ bool AudioFlinger::MixerThread::checkForNewParameter_l(const String8& keyValuePa
             readOutputParameters_l();
             delete mAudioMixer;
             mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+            setMixerResampleThreads(mAudioMixer, mNormalFrameCount, mSampleRate);
             for (const auto &track : mTracks) {
                 const int trackId = track->id();
                 const status_t createStatus = mAudioMixer->create(
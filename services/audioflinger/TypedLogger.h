@@ -127,6 +127,10 @@ constexpr uint64_t hash(const char (&file)[n], uint32_t line) {
 #define LOG_WORK_TIME(ns) do { NBLog::Writer *x = tlNBLogWriter; if (x != nullptr) \
         x->log<NBLog::EVENT_WORK_TIME>(ns); } while (0)
 
+// Record the times of fast thread cycles. Parameter summary is of type cycle_summary_t.
+#define LOG_CYCLE_SUMMARY(summary) do { NBLog::Writer *x = tlNBLogWriter; if (x != nullptr) \
+        x->log<NBLog::EVENT_CYCLE_SUMMARY>(summary); } while (0)
+
 namespace android {
 extern "C" {
 // TODO consider adding a thread_local NBLog::Writer tlStubNBLogWriter and then
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "I16Handoffs.h"
+
+namespace android::audioflinger {
+
+bool canTakeI16Input(const I16HandoffConfig& config) {
+    return !config.supportsFloat
+            && !config.isAuxiliary
+            && config.inChannelCountMatches
+            && config.hasInConversionBuffer;
+}
+
+bool canGiveI16Output(const I16HandoffConfig& config) {
+    return !config.supportsFloat
+            && config.isInsert
+            && config.overwritesOutput
+            && config.processImplemented
+            && config.outChannelCountMatches
+            && config.hasOutConversionBuffer;
+}
+
+}  // namespace android::audioflinger
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace android::audioflinger {
+
+// Effects of a FLOAT_EFFECT_CHAIN which only support int16 convert their input from float
+// and their output back to float. When two such effects follow each other on the same chain
+// buffer, the first one can write its int16 output directly to the int16 input buffer of the
+// second one, saving a conversion to float and back (which is lossless).
+// The effects process in place in the chain buffers otherwise, so this is the only copy
+// the chain can avoid.
+
+// What decides whether an effect can take or give int16 data in a handoff.
+struct I16HandoffConfig {
+    bool supportsFloat = false;
+    bool isInsert = false;              // EFFECT_FLAG_TYPE_INSERT
+    bool isAuxiliary = false;           // EFFECT_FLAG_TYPE_AUXILIARY
+    bool overwritesOutput = false;      // output access mode is EFFECT_BUFFER_ACCESS_WRITE
+    bool processImplemented = false;
+    bool inChannelCountMatches = false; // the requested input channel count is configured
+    bool outChannelCountMatches = false;
+    bool hasInConversionBuffer = false;
+    bool hasOutConversionBuffer = false;
+};
+
+// Whether the effect can read the int16 output of the previous effect as its input.
+bool canTakeI16Input(const I16HandoffConfig& config);
+
+// Whether the effect can leave its int16 output in the input buffer of the next effect.
+// Only an insert effect overwriting its output leaves nothing but its own int16 output
+// in the conversion buffer: an effect accumulating into its output reads it as well.
+bool canGiveI16Output(const I16HandoffConfig& config);
+
+// Plans the int16 handoffs between consecutive effects.
+// (*i16Handoffs)[i] is set if effect i leaves its int16 output for effect i + 1.
+// Returns the number of handoffs.
+//
+// Effects is an indexable container of pointers to effects providing
+// inBuffer(), outBuffer(), i16HandoffInputBuffer(), setI16HandoffOutputBuffer()
+// and clearI16HandoffOutputBuffer(), as AudioFlinger::EffectModule does.
+template <typename Effects>
+size_t planI16Handoffs(const Effects& effects, std::vector<bool>* i16Handoffs) {
+    const size_t size = effects.size();
+    i16Handoffs->assign(size, false);
+    // The effect a handoff of the previous plan goes to may have been removed or moved:
+    // start over from the conversion buffers of the effects.
+    for (size_t i = 0; i < size; i++) {
+        effects[i]->clearI16HandoffOutputBuffer();
+    }
+    size_t handoffs = 0;
+    for (size_t i = 0; i + 1 < size; i++) {
+        const auto& effect = effects[i];
+        const auto& next = effects[i + 1];
+        if (effect->outBuffer() == nullptr || effect->outBuffer() != next->inBuffer()) {
+            continue;
+        }
+        const auto buffer = next->i16HandoffInputBuffer();
+        if (buffer != nullptr && effect->setI16HandoffOutputBuffer(buffer)) {
+            (*i16Handoffs)[i] = true;
+            handoffs++;
+        }
+    }
+    return handoffs;
+}
+
+// Processes the effects once, with the handoffs planned by planI16Handoffs().
+// Returns the number of buffer copies and conversions.
+//
+// The effects also provide isProcessEnabled(), process(bool i16Input, bool i16Output),
+// returning whether the output was left as int16, and bufferCopies().
+template <typename Effects>
+uint32_t processWithI16Handoffs(const Effects& effects, const std::vector<bool>& i16Handoffs) {
+    uint32_t copies = 0;
+    bool i16Input = false;
+    for (size_t i = 0; i < effects.size(); i++) {
+        // Only worth skipping the float conversion if the next effect will process.
+        const bool i16Output = i16Handoffs[i] && effects[i + 1]->isProcessEnabled();
+        i16Input = effects[i]->process(i16Input, i16Output);
+        copies += effects[i]->bufferCopies();
+    }
+    return copies;
+}
+
+}  // namespace android::audioflinger
@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "i16handoffs_tests"
+
+#include "../I16Handoffs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+using namespace android::audioflinger;
+
+namespace {
+
+constexpr size_t kSampleCount = 384;
+
+using FloatBuffer = std::vector<float>;
+using I16Buffer = std::vector<int16_t>;
+
+void convertToI16(I16Buffer& dst, const FloatBuffer& src) {
+    for (size_t i = 0; i < kSampleCount; i++) {
+        dst[i] = static_cast<int16_t>(
+                std::clamp<long>(lrintf(src[i] * 32768.f), INT16_MIN, INT16_MAX));
+    }
+}
+
+void convertToFloat(FloatBuffer& dst, const I16Buffer& src) {
+    for (size_t i = 0; i < kSampleCount; i++) {
+        dst[i] = src[i] / 32768.f;
+    }
+}
+
+// An insert effect processing in place in the chain buffer, as AudioFlinger::EffectModule
+// does in a FLOAT_EFFECT_CHAIN. It applies a gain and an offset with saturation, so that
+// the order in which effects process and any lost conversion shows in the output.
+class TestEffect {
+  public:
+    TestEffect(const std::shared_ptr<FloatBuffer>& buffer, bool supportsFloat, int16_t offset)
+        : mBuffer(buffer), mSupportsFloat(supportsFloat), mOffset(offset) {
+        if (!mSupportsFloat) {
+            mInConversionBuffer = std::make_shared<I16Buffer>(kSampleCount);
+            mPrivateOutConversionBuffer = std::make_shared<I16Buffer>(kSampleCount);
+            mOutConversionBuffer = mPrivateOutConversionBuffer;
+        }
+    }
+
+    I16HandoffConfig config() const {
+        return {
+            .supportsFloat = mSupportsFloat,
+            .isInsert = true,
+            .overwritesOutput = true,
+            .processImplemented = true,
+            .inChannelCountMatches = true,
+            .outChannelCountMatches = true,
+            .hasInConversionBuffer = mInConversionBuffer != nullptr,
+            .hasOutConversionBuffer = mOutConversionBuffer != nullptr,
+        };
+    }
+
+    std::shared_ptr<FloatBuffer> inBuffer() const { return mBuffer; }
+    std::shared_ptr<FloatBuffer> outBuffer() const { return mBuffer; }
+    std::shared_ptr<I16Buffer> inConversionBuffer() const { return mInConversionBuffer; }
+    std::shared_ptr<I16Buffer> outConversionBuffer() const { return mOutConversionBuffer; }
+
+    std::shared_ptr<I16Buffer> i16HandoffInputBuffer() const {
+        return canTakeI16Input(config()) ? mInConversionBuffer : nullptr;
+    }
+    bool setI16HandoffOutputBuffer(const std::shared_ptr<I16Buffer>& buffer) {
+        if (!canGiveI16Output(config()) || buffer == nullptr || buffer->size() < kSampleCount) {
+            return false;
+        }
+        mOutConversionBuffer = buffer;
+        return true;
+    }
+    void clearI16HandoffOutputBuffer() { mOutConversionBuffer = mPrivateOutConversionBuffer; }
+
+    void setEnabled(bool enabled) { mEnabled = enabled; }
+    bool isProcessEnabled() const { return mEnabled; }
+    uint32_t bufferCopies() const { return mBufferCopies; }
+
+    bool process(bool i16Input, bool i16Output) {
+        mBufferCopies = 0;
+        if (i16Input && !(mEnabled && canTakeI16Input(config()))) {
+            convertToFloat(*mBuffer, *mInConversionBuffer);
+            mBufferCopies++;
+            i16Input = false;
+        }
+        i16Output = i16Output && canGiveI16Output(config());
+        if (!mEnabled) {
+            return false;
+        }
+        if (mSupportsFloat) {
+            for (float& value : *mBuffer) {
+                value = value * 0.75f + mOffset / 32768.f;
+            }
+            return false;
+        }
+        if (!i16Input) {
+            convertToI16(*mInConversionBuffer, *mBuffer);
+            mBufferCopies++;
+        }
+        for (size_t i = 0; i < kSampleCount; i++) {
+            (*mOutConversionBuffer)[i] = static_cast<int16_t>(std::clamp<int32_t>(
+                    (*mInConversionBuffer)[i] * 3 / 4 + mOffset, INT16_MIN, INT16_MAX));
+        }
+        if (i16Output) {
+            return true;
+        }
+        convertToFloat(*mBuffer, *mOutConversionBuffer);
+        mBufferCopies++;
+        return false;
+    }
+
+  private:
+    const std::shared_ptr<FloatBuffer> mBuffer;
+    const bool mSupportsFloat;
+    const int16_t mOffset;
+    bool mEnabled = true;
+    uint32_t mBufferCopies = 0;
+    std::shared_ptr<I16Buffer> mInConversionBuffer;
+    std::shared_ptr<I16Buffer> mPrivateOutConversionBuffer;
+    std::shared_ptr<I16Buffer> mOutConversionBuffer;
+};
+
+using Effects = std::vector<std::shared_ptr<TestEffect>>;
+
+TEST(I16HandoffsTest, CanTakeI16Input) {
+    const I16HandoffConfig config{
+        .isInsert = true,
+        .overwritesOutput = true,
+        .processImplemented = true,
+        .inChannelCountMatches = true,
+        .outChannelCountMatches = true,
+        .hasInConversionBuffer = true,
+        .hasOutConversionBuffer = true,
+    };
+    EXPECT_TRUE(canTakeI16Input(config));
+
+    I16HandoffConfig other = config;
+    other.supportsFloat = true;
+    EXPECT_FALSE(canTakeI16Input(other));
+    other = config;
+    other.isInsert = false;
+    other.isAuxiliary = true;
+    EXPECT_FALSE(canTakeI16Input(other));
+    other = config;
+    other.inChannelCountMatches = false;
+    EXPECT_FALSE(canTakeI16Input(other));
+    other = config;
+    other.hasInConversionBuffer = false;
+    EXPECT_FALSE(canTakeI16Input(other));
+
+    // The output does not matter.
+    other = config;
+    other.isInsert = false;
+    other.overwritesOutput = false;
+    other.processImplemented = false;
+    other.outChannelCountMatches = false;
+    other.hasOutConversionBuffer = false;
+    EXPECT_TRUE(canTakeI16Input(other));
+}
+
+TEST(I16HandoffsTest, CanGiveI16Output) {
+    const I16HandoffConfig config{
+        .isInsert = true,
+        .overwritesOutput = true,
+        .processImplemented = true,
+        .inChannelCountMatches = true,
+        .outChannelCountMatches = true,
+        .hasInConversionBuffer = true,
+        .hasOutConversionBuffer = true,
+    };
+    EXPECT_TRUE(canGiveI16Output(config));
+
+    I16HandoffConfig other = config;
+    other.supportsFloat = true;
+    EXPECT_FALSE(canGiveI16Output(other));
+    other = config;
+    other.isInsert = false;  // a pre or post processing effect
+    EXPECT_FALSE(canGiveI16Output(other));
+    other = config;
+    other.overwritesOutput = false;  // accumulates into its output
+    EXPECT_FALSE(canGiveI16Output(other));
+    other = config;
+    other.processImplemented = false;
+    EXPECT_FALSE(canGiveI16Output(other));
+    other = config;
+    other.outChannelCountMatches = false;
+    EXPECT_FALSE(canGiveI16Output(other));
+    other = config;
+    other.hasOutConversionBuffer = false;
+    EXPECT_FALSE(canGiveI16Output(other));
+
+    // The input does not matter.
+    other = config;
+    other.inChannelCountMatches = false;
+    other.hasInConversionBuffer = false;
+    EXPECT_TRUE(canGiveI16Output(other));
+}
+
+TEST(I16HandoffsTest, OnlyBetweenEffectsSharingABuffer) {
+    const auto buffer = std::make_shared<FloatBuffer>(kSampleCount);
+    const auto otherBuffer = std::make_shared<FloatBuffer>(kSampleCount);
+    const Effects effects{
+        std::make_shared<TestEffect>(buffer, false /*supportsFloat*/, 0),
+        std::make_shared<TestEffect>(otherBuffer, false /*supportsFloat*/, 0),
+        std::make_shared<TestEffect>(otherBuffer, false /*supportsFloat*/, 0),
+    };
+    std::vector<bool> i16Handoffs;
+    EXPECT_EQ(1u, planI16Handoffs(effects, &i16Handoffs));
+    EXPECT_EQ((std::vector<bool>{false, true, false}), i16Handoffs);
+    EXPECT_EQ(effects[2]->inConversionBuffer(), effects[1]->outConversionBuffer());
+    EXPECT_NE(effects[1]->inConversionBuffer(), effects[0]->outConversionBuffer());
+}
+
+// Two chains of the same effects on the same input, one processed with int16 handoffs
+// and one without.
+class I16HandoffsChainTest : public ::testing::Test {
+  protected:
+    struct Chain {
+        std::shared_ptr<FloatBuffer> buffer = std::make_shared<FloatBuffer>(kSampleCount);
+        Effects effects;
+        Effects removedEffects;
+        std::vector<bool> i16Handoffs;
+        bool handoffs = true;
+        bool planned = false;
+        uint32_t bufferCopies = 0;
+    };
+
+    I16HandoffsChainTest() { mWithoutHandoffs.handoffs = false; }
+
+    // Adds an effect at the end of both chains.
+    void addEffect(bool supportsFloat, int16_t offset) {
+        for (Chain *chain : {&mWithHandoffs, &mWithoutHandoffs}) {
+            chain->effects.push_back(
+                    std::make_shared<TestEffect>(chain->buffer, supportsFloat, offset));
+            chain->planned = false;
+        }
+    }
+
+    void removeEffect(size_t index) {
+        for (Chain *chain : {&mWithHandoffs, &mWithoutHandoffs}) {
+            chain->removedEffects.push_back(chain->effects[index]);
+            chain->effects.erase(chain->effects.begin() + index);
+            chain->planned = false;
+        }
+    }
+
+    void setEnabled(size_t index, bool enabled) {
+        for (Chain *chain : {&mWithHandoffs, &mWithoutHandoffs}) {
+            chain->effects[index]->setEnabled(enabled);
+        }
+    }
+
+    // Processes both chains on the same input, as EffectChain::process_l() does, and checks
+    // that their outputs are the same. Returns the number of handoffs.
+    size_t process(uint32_t cycle) {
+        for (Chain *chain : {&mWithHandoffs, &mWithoutHandoffs}) {
+            if (!chain->planned) {
+                chain->i16Handoffs.assign(chain->effects.size(), false);
+                if (chain->handoffs) {
+                    planI16Handoffs(chain->effects, &chain->i16Handoffs);
+                }
+                chain->planned = true;
+            }
+            // Values which do not convert exactly to int16, and some which saturate.
+            for (size_t i = 0; i < kSampleCount; i++) {
+                (*chain->buffer)[i] = sinf((i + cycle * kSampleCount) * 0.01f) * 1.2f + i * 1e-7f;
+            }
+            chain->bufferCopies = processWithI16Handoffs(chain->effects, chain->i16Handoffs);
+        }
+        EXPECT_EQ(0, memcmp(mWithHandoffs.buffer->data(), mWithoutHandoffs.buffer->data(),
+                kSampleCount * sizeof(float))) << "cycle " << cycle;
+        return std::count(mWithHandoffs.i16Handoffs.begin(), mWithHandoffs.i16Handoffs.end(),
+                true);
+    }
+
+    // Checks that the int16 output of each effect goes to the next effect if it is handed off,
+    // and to a buffer of its own otherwise.
+    void checkConversionBuffers() {
+        const Chain &chain = mWithHandoffs;
+        for (size_t i = 0; i < chain.effects.size(); i++) {
+            const std::shared_ptr<I16Buffer> out = chain.effects[i]->outConversionBuffer();
+            if (out == nullptr) {
+                continue;  // a float effect
+            }
+            for (size_t j = 0; j < chain.effects.size(); j++) {
+                const bool handoff = j == i + 1 && chain.i16Handoffs[i];
+                EXPECT_EQ(handoff, out == chain.effects[j]->inConversionBuffer())
+                        << "output of effect " << i << ", input of effect " << j;
+            }
+            for (const std::shared_ptr<TestEffect>& removed : chain.removedEffects) {
+                EXPECT_NE(out, removed->inConversionBuffer())
+                        << "effect " << i << " hands off to a removed effect";
+            }
+        }
+    }
+
+    Chain mWithHandoffs;
+    Chain mWithoutHandoffs;
+};
+
+TEST_F(I16HandoffsChainTest, SavesConversions) {
+    addEffect(false /*supportsFloat*/, 100);
+    addEffect(false /*supportsFloat*/, -200);
+    addEffect(false /*supportsFloat*/, 300);
+    EXPECT_EQ(2u, process(0));
+    // Only the first effect converts from float, and the last one to float.
+    EXPECT_EQ(2u, mWithHandoffs.bufferCopies);
+    EXPECT_EQ(6u, mWithoutHandoffs.bufferCopies);
+}
+
+TEST_F(I16HandoffsChainTest, BitExact) {
+    // int16 effects hand off to each other, not to or from the float effect.
+    addEffect(false /*supportsFloat*/, 100);
+    addEffect(false /*supportsFloat*/, -200);
+    addEffect(false /*supportsFloat*/, 300);
+    addEffect(true /*supportsFloat*/, -400);
+    addEffect(false /*supportsFloat*/, 500);
+    addEffect(false /*supportsFloat*/, -600);
+    uint32_t cycle = 0;
+    EXPECT_EQ(3u, process(cycle++));
+    checkConversionBuffers();
+    process(cycle++);
+
+    // Disabled effects take their input in float, and effects before them give it.
+    setEnabled(1, false);
+    setEnabled(5, false);
+    for (int i = 0; i < 3; i++) {
+        process(cycle++);
+    }
+    setEnabled(1, true);
+    setEnabled(5, true);
+    for (int i = 0; i < 3; i++) {
+        process(cycle++);
+    }
+
+    // The handoffs to removed effects are replaced.
+    removeEffect(1);
+    EXPECT_EQ(2u, process(cycle++));
+    checkConversionBuffers();
+    removeEffect(1);
+    EXPECT_EQ(1u, process(cycle++));
+    checkConversionBuffers();
+    removeEffect(3);
+    EXPECT_EQ(0u, process(cycle++));
+    checkConversionBuffers();
+    process(cycle++);
+
+    // Effects added after removals hand off again.
+    addEffect(false /*supportsFloat*/, 700);
+    EXPECT_EQ(1u, process(cycle++));
+    checkConversionBuffers();
+    process(cycle++);
+}
+
+}  // namespace
@@ -15,8 +15,13 @@
  */
 
 #include <media/MediaMetricsItem.h>
+#include <mediametricsservice/TimeMachine.h>
 #include <benchmark/benchmark.h>
 
+#include <memory>
+#include <string>
+#include <vector>
+
 class MyItem : public android::mediametrics::BaseItem {
 public:
     static bool mySubmitBuffer() {
@@ -44,4 +49,96 @@ static void BM_SubmitBuffer(benchmark::State& state)
 
 BENCHMARK(BM_SubmitBuffer)->Iterations(4000);   // Adjust magic number until test runs
 
+// The TimeMachine benchmarks run in process, one client per benchmark thread.
+// Each client reports kKeysPerClient keys with properties like an AudioTrack.
+static constexpr size_t kKeysPerClient = 24;  // 16 clients stay below the GC low water mark.
+
+static android::mediametrics::TimeMachine& getTimeMachine()
+{
+    static android::mediametrics::TimeMachine timeMachine;
+    return timeMachine;
+}
+
+static std::vector<std::shared_ptr<const android::mediametrics::Item>> makeClientItems(
+        int client)
+{
+    std::vector<std::shared_ptr<const android::mediametrics::Item>> items;
+    for (size_t i = 0; i < kKeysPerClient; ++i) {
+        auto item = std::make_shared<android::mediametrics::Item>(
+                "audio.track." + std::to_string(client * kKeysPerClient + i));
+        (*item).set("event#", "update")
+               .set("sampleRate", (int32_t)48000)
+               .set("channelMask", (int32_t)3)
+               .set("encoding", "AUDIO_FORMAT_PCM_16_BIT")
+               .set("frameCount", (int32_t)(960 + i))
+               .set("underrun", (int32_t)0)
+               .set("latencyMs", (double)20.5)
+               .set("startupMs", (double)40.0)
+               .set("state", "ACTIVE")
+               .set("streamType", "AUDIO_STREAM_MUSIC")
+               .set("usage", "AUDIO_USAGE_MEDIA")
+               .set("[audio.thread.13]underrun", (int32_t)0)
+               .setTimestamp(systemTime(SYSTEM_TIME_REALTIME));
+        items.push_back(std::move(item));
+    }
+    return items;
+}
+
+static void BM_TimeMachinePut(benchmark::State& state)
+{
+    auto& timeMachine = getTimeMachine();
+    const auto items = makeClientItems(state.thread_index());
+    size_t i = 0;
+    for (auto _ : state) {
+        if (timeMachine.put(items[i], true /* isTrusted */) != android::NO_ERROR) {
+            state.SkipWithError("put failed");
+            return;
+        }
+        if (++i == items.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_TimeMachinePut)->ThreadRange(1, 16)->UseRealTime();
+
+static void BM_TimeMachineGet(benchmark::State& state)
+{
+    auto& timeMachine = getTimeMachine();
+    const auto items = makeClientItems(state.thread_index());
+    for (const auto& item : items) {
+        (void)timeMachine.put(item, true /* isTrusted */);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        int32_t value;
+        if (timeMachine.get(items[i]->getKey(), "frameCount", &value) != android::NO_ERROR) {
+            state.SkipWithError("get failed");
+            return;
+        }
+        benchmark::DoNotOptimize(value);
+        if (++i == items.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_TimeMachineGet)->ThreadRange(1, 16)->UseRealTime();
+
+// Dumps (as dumpsys does) while the other threads keep putting.
+static void BM_TimeMachineDumpUnderLoad(benchmark::State& state)
+{
+    auto& timeMachine = getTimeMachine();
+    const auto items = makeClientItems(state.thread_index());
+    size_t i = 0;
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            benchmark::DoNotOptimize(timeMachine.dump(INT32_MAX).second);
+        } else {
+            (void)timeMachine.put(items[i], true /* isTrusted */);
+            if (++i == items.size()) i = 0;
+        }
+    }
+}
+
+BENCHMARK(BM_TimeMachineDumpUnderLoad)->ThreadRange(1, 8)->UseRealTime();
+
 BENCHMARK_MAIN();
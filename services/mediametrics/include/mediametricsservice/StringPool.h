@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace android::mediametrics {
+
+/**
+ * StringPool interns strings, so that equal strings share one copy
+ * and can be compared by pointer.
+ *
+ * The pool only grows; interned strings live as long as the process.
+ * To bound memory at most kMaxStrings strings are interned, after that
+ * intern() returns nullptr and the caller must keep its own copy.
+ *
+ * StringPool is thread safe and lock-free: it is an insert-only open
+ * addressing hash table of string pointers.
+ */
+class StringPool {
+public:
+    static inline constexpr size_t kMaxStrings = 4096;
+
+    // The process-wide pool.
+    static StringPool& getInstance() {
+        static StringPool* pool = new StringPool(); // never deleted
+        return *pool;
+    }
+
+    /**
+     * Returns the pooled copy of s, or nullptr if s is not in the pool.
+     */
+    const std::string* find(std::string_view s) const {
+        for (size_t i = slotOf(s); ; i = (i + 1) & kSlotMask) {
+            const std::string* entry = mSlots[i].load(std::memory_order_acquire);
+            if (entry == nullptr) return nullptr;
+            if (*entry == s) return entry;
+        }
+    }
+
+    /**
+     * Returns the pooled copy of s, adding it if needed.
+     * Returns nullptr if s is not in the pool and the pool is full.
+     */
+    const std::string* intern(std::string_view s) {
+        const std::string* added = nullptr;
+        for (size_t i = slotOf(s); ; i = (i + 1) & kSlotMask) {
+            const std::string* entry = mSlots[i].load(std::memory_order_acquire);
+            if (entry == nullptr) {
+                if (added == nullptr) {
+                    if (mSize.load(std::memory_order_relaxed) >= kMaxStrings) return nullptr;
+                    added = new std::string(s);
+                }
+                if (mSlots[i].compare_exchange_strong(entry, added, std::memory_order_acq_rel)) {
+                    mSize.fetch_add(1, std::memory_order_relaxed);
+                    return added;
+                }
+                // Another thread took the slot, entry is now its string.
+            }
+            if (*entry == s) {
+                delete added;
+                return entry;
+            }
+        }
+    }
+
+    size_t size() const {
+        return mSize.load(std::memory_order_relaxed);
+    }
+
+private:
+    // Twice kMaxStrings so that probe sequences are short and always end on
+    // an empty slot (concurrent inserts may overshoot kMaxStrings slightly).
+    static inline constexpr size_t kSlots = 2 * kMaxStrings;
+    static inline constexpr size_t kSlotMask = kSlots - 1;
+    static_assert((kSlots & kSlotMask) == 0, "kSlots must be a power of 2");
+
+    static size_t slotOf(std::string_view s) {
+        return std::hash<std::string_view>{}(s) & kSlotMask;
+    }
+
+    std::atomic<const std::string*> mSlots[kSlots]{};
+    std::atomic<size_t> mSize{};
+};
+
+} // namespace android::mediametrics
@@ -16,11 +16,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <any>
-#include <map>
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -28,6 +32,8 @@
 #include <media/MediaMetricsItem.h>
 #include <utils/Timers.h>
 
+#include "StringPool.h"
+
 namespace android::mediametrics {
 
 // define a way of printing the monostate
@@ -61,15 +67,88 @@ std::ostream & operator<< (std::ostream& s,
  * Any URL that ends with '#' (AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED)
  * will have a time sequence that keeps duplicates.
  *
- * The TimeMachine is NOT thread safe.
+ * The TimeMachine is thread safe, see the Locking Strategy below.
  */
 class TimeMachine final { // made final as we have copy constructor instead of dup() override.
 public:
     using Elem = Item::Prop::Elem;  // use the Item property element.
-    using PropertyHistory = std::multimap<int64_t /* time */, Elem>;
 
 private:
 
+    /**
+     * PropertyHistory is the time sequence of a property: a ring buffer
+     * holding the last kTimeSequenceMaxElements values in time order.
+     *
+     * The buffer grows as values are added, so the many properties that
+     * change only a few times stay small.
+     */
+    class PropertyHistory {
+    public:
+        using Entry = std::pair<int64_t /* time */, Elem>;
+
+        size_t size() const { return mEntries.size(); }
+        bool empty() const { return mEntries.empty(); }
+
+        // Returns the i-th oldest entry.
+        const Entry& operator[](size_t i) const { return mEntries[index(i)]; }
+        const Entry& back() const { return (*this)[size() - 1]; }
+
+        // Returns the position of the first entry later than time.
+        size_t upperBound(int64_t time) const {
+            return partitionPoint([time](int64_t t) { return t <= time; });
+        }
+
+        // Returns the position of the first entry not earlier than time.
+        size_t lowerBound(int64_t time) const {
+            return partitionPoint([time](int64_t t) { return t < time; });
+        }
+
+        // Adds a value, discarding the oldest one when full.
+        void add(int64_t time, Elem&& elem) {
+            if (mEntries.size() < kTimeSequenceMaxElements) {
+                if (mEntries.size() == mEntries.capacity()) {
+                    mEntries.reserve(std::min(
+                            std::max(mEntries.capacity() * 2, (size_t)1),
+                            kTimeSequenceMaxElements));
+                }
+                mEntries.emplace_back(time, std::move(elem));
+            } else {
+                // An entry older than all others would be discarded at once.
+                if (time < (*this)[0].first) return;
+                mEntries[mHead] = Entry(time, std::move(elem));
+                mHead = static_cast<uint32_t>(index(1));
+            }
+            // Values normally arrive in time order; move a late one into place.
+            for (size_t i = size() - 1; i > 0 && (*this)[i - 1].first > time; --i) {
+                std::swap(mEntries[index(i - 1)], mEntries[index(i)]);
+            }
+        }
+
+    private:
+        size_t index(size_t i) const {
+            i += mHead;
+            return i < mEntries.size() ? i : i - mEntries.size();
+        }
+
+        template <typename F>
+        size_t partitionPoint(F pred) const {
+            size_t low = 0;
+            size_t high = size();
+            while (low < high) {
+                const size_t mid = low + (high - low) / 2;
+                if (pred((*this)[mid].first)) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            return low;
+        }
+
+        std::vector<Entry> mEntries;
+        uint32_t mHead = 0;  // position of the oldest entry, nonzero only when full.
+    };
+
     // KeyHistory contains no lock.
     // Access is through the TimeMachine, and a hash-striped lock is used
     // before calling into KeyHistory.
@@ -108,14 +187,11 @@ private:
         status_t getValue(const std::string &property, T* value, int64_t time = 0) const
                 REQUIRES(mPseudoKeyHistoryLock) {
             if (time == 0) time = systemTime(SYSTEM_TIME_REALTIME);
-            const auto tsptr = mPropertyMap.find(property);
-            if (tsptr == mPropertyMap.end()) return BAD_VALUE;
-            const auto& timeSequence = tsptr->second;
-            auto eptr = timeSequence.upper_bound(time);
-            if (eptr == timeSequence.begin()) return BAD_VALUE;
-            --eptr;
-            if (eptr == timeSequence.end()) return BAD_VALUE;
-            const T* vptr = std::get_if<T>(&eptr->second);
+            const PropertyHistory* timeSequence = findProperty(property);
+            if (timeSequence == nullptr) return BAD_VALUE;
+            const size_t i = timeSequence->upperBound(time);
+            if (i == 0) return BAD_VALUE;
+            const T* vptr = std::get_if<T>(&(*timeSequence)[i - 1].second);
             if (vptr == nullptr) return BAD_VALUE;
             *value = *vptr;
             return NO_ERROR;
@@ -140,34 +216,40 @@ private:
                 REQUIRES(mPseudoKeyHistoryLock) {
             if (time == 0) time = systemTime(SYSTEM_TIME_REALTIME);
             mLastModificationTime = time;
-            if (mPropertyMap.size() >= kKeyMaxProperties &&
-                    !mPropertyMap.count(property)) {
-                ALOGV("%s: too many properties, rejecting %s", __func__, property.c_str());
-                mRejectedPropertiesCount++;
-                return;
+            PropertyHistory* timeSequence = findProperty(property);
+            if (timeSequence == nullptr) {
+                if (mProperties.size() >= kKeyMaxProperties) {
+                    ALOGV("%s: too many properties, rejecting %s", __func__, property.c_str());
+                    mRejectedPropertiesCount++;
+                    return;
+                }
+                timeSequence = &addProperty(property).mTimeSequence;
             }
-            auto& timeSequence = mPropertyMap[property];
             Elem el{std::forward<T>(e)};
-            if (timeSequence.empty()           // no elements
+            if (timeSequence->empty()           // no elements
                     || property.back() == AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED
-                    || timeSequence.rbegin()->second != el) { // value changed
-                timeSequence.emplace_hint(timeSequence.end(), time, std::move(el));
-
-                if (timeSequence.size() > kTimeSequenceMaxElements) {
-                    ALOGV("%s: restricting maximum elements (discarding oldest) for %s",
-                            __func__, property.c_str());
-                    timeSequence.erase(timeSequence.begin());
-                }
+                    || timeSequence->back().second != el) { // value changed
+                timeSequence->add(time, std::move(el));
             }
         }
 
         std::pair<std::string, int32_t> dump(int32_t lines, int64_t time) const
                 REQUIRES(mPseudoKeyHistoryLock) {
+            // Properties are kept in insertion order, dump them sorted.
+            std::vector<const Property*> sorted;
+            sorted.reserve(mProperties.size());
+            for (const auto& property : mProperties) {
+                sorted.push_back(&property);
+            }
+            std::sort(sorted.begin(), sorted.end(), [](const Property* a, const Property* b) {
+                return *a->mName < *b->mName;
+            });
+
             std::stringstream ss;
             int32_t ll = lines;
-            for (auto& tsPair : mPropertyMap) {
+            for (const Property* property : sorted) {
                 if (ll <= 0) break;
-                std::string s = dump(mKey, tsPair, time);
+                std::string s = dump(mKey, *property, time);
                 if (s.size() > 0) {
                     --ll;
                     ss << s;
@@ -185,28 +267,65 @@ private:
         }
 
     private:
+        struct Property {
+            // Points to the pooled name, or to mOwnedName if the pool is full.
+            const std::string* mName;
+            std::shared_ptr<const std::string> mOwnedName;
+            PropertyHistory mTimeSequence;
+        };
+
+        // Properties are matched by pooled name pointer; a key has few enough
+        // properties that a linear scan beats a map lookup.
+        // A property added when the pool was full owns its name, which another thread
+        // may still have pooled since (intern() can overshoot kMaxStrings):
+        // owned names are always compared by value, so the property is not added twice.
+        const PropertyHistory* findProperty(const std::string& name) const {
+            const std::string* pooled = StringPool::getInstance().find(name);
+            for (const auto& property : mProperties) {
+                if ((pooled != nullptr && property.mName == pooled)
+                        || (property.mOwnedName != nullptr && *property.mOwnedName == name)) {
+                    return &property.mTimeSequence;
+                }
+            }
+            return nullptr;
+        }
+
+        PropertyHistory* findProperty(const std::string& name) {
+            return const_cast<PropertyHistory*>(
+                    static_cast<const KeyHistory*>(this)->findProperty(name));
+        }
+
+        Property& addProperty(const std::string& name) {
+            Property& property = mProperties.emplace_back();
+            property.mName = StringPool::getInstance().intern(name);
+            if (property.mName == nullptr) {
+                property.mOwnedName = std::make_shared<const std::string>(name);
+                property.mName = property.mOwnedName.get();
+            }
+            return property;
+        }
+
         static std::string dump(
-                const std::string &key,
-                const std::pair<std::string /* prop */, PropertyHistory>& tsPair,
-                int64_t time) {
-            const auto timeSequence = tsPair.second;
-            auto eptr = timeSequence.lower_bound(time);
-            if (eptr == timeSequence.end()) {
-                return {}; // don't dump anything. tsPair.first + "={};\n";
+                const std::string &key, const Property& property, int64_t time) {
+            const PropertyHistory& timeSequence = property.mTimeSequence;
+            size_t i = timeSequence.lowerBound(time);
+            if (i == timeSequence.size()) {
+                return {}; // don't dump anything. property + "={};\n";
             }
             std::stringstream ss;
-            ss << key << "." << tsPair.first << "={";
+            ss << key << "." << *property.mName << "={";
 
             time_string_t last_timestring{}; // last timestring used.
             while (true) {
-                const time_string_t timestring = mediametrics::timeStringFromNs(eptr->first);
+                const auto& [elemTime, elem] = timeSequence[i];
+                const time_string_t timestring = mediametrics::timeStringFromNs(elemTime);
                 // find common prefix offset.
                 const size_t offset = commonTimePrefixPosition(timestring.time,
                         last_timestring.time);
                 last_timestring = timestring;
                 ss << "(" << (offset == 0 ? "" : "~") << &timestring.time[offset]
-                    << ") " << eptr->second;
-                if (++eptr == timeSequence.end()) {
+                    << ") " << elem;
+                if (++i == timeSequence.size()) {
                     break;
                 }
                 ss << ", ";
@@ -221,10 +340,10 @@ private:
 
         unsigned int mRejectedPropertiesCount = 0;
         int64_t mLastModificationTime;
-        std::map<std::string /* property */, PropertyHistory> mPropertyMap;
+        std::vector<Property> mProperties;
     };
 
-    using History = std::map<std::string /* key */, std::shared_ptr<KeyHistory>>;
+    using History = std::unordered_map<std::string /* key */, std::shared_ptr<KeyHistory>>;
 
     static inline constexpr size_t kTimeSequenceMaxElements = 50;
     static inline constexpr size_t kKeyMaxProperties = 128;
@@ -255,21 +374,29 @@ public:
         *this = other;
     }
     TimeMachine& operator=(const TimeMachine& other) {
-        std::lock_guard lock(mLock);
-        mHistory.clear();
-
-        {
-            std::lock_guard lock2(other.mLock);
-            mHistory = other.mHistory;
-            mGarbageCollectionCount = other.mGarbageCollectionCount.load();
+        if (this == &other) return *this;
+
+        // Dup the other KeyHistories under their key locks
+        // to ensure they are decoupled.
+        std::shared_ptr<History> histories[kShards];
+        size_t keys = 0;
+        for (size_t i = 0; i < kShards; ++i) {
+            const auto otherHistory = std::atomic_load(&other.mShards[i].mHistory);
+            histories[i] = std::make_shared<History>();
+            for (const auto &[lkey, lhist] : *otherHistory) {
+                std::lock_guard lock(other.getLockForKey(lkey));
+                histories[i]->emplace(lkey, std::make_shared<KeyHistory>(*lhist));
+            }
+            keys += histories[i]->size();
         }
 
-        // Now that we safely have our own shared pointers, let's dup them
-        // to ensure they are decoupled.  We do this by acquiring the other lock.
-        for (const auto &[lkey, lhist] : mHistory) {
-            std::lock_guard lock2(other.getLockForKey(lkey));
-            mHistory[lkey] = std::make_shared<KeyHistory>(*lhist);
+        std::vector<std::any> garbage;
+        std::lock_guard lock(mLock);
+        for (size_t i = 0; i < kShards; ++i) {
+            garbage.emplace_back(publish(i, std::move(histories[i])));
         }
+        mKeyCount = keys;
+        mGarbageCollectionCount = other.mGarbageCollectionCount.load();
         return *this;
     }
 
@@ -279,39 +406,26 @@ public:
     status_t put(const std::shared_ptr<const mediametrics::Item>& item, bool isTrusted = false) {
         const int64_t time = item->getTimestamp();
         const std::string &key = item->getKey();
+        const size_t hash = hashKey(key);
 
         ALOGV("%s(%zu, %zu): key: %s  isTrusted:%d  size:%zu",
                 __func__, mKeyLowWaterMark, mKeyHighWaterMark,
                 key.c_str(), (int)isTrusted, item->count());
-        std::shared_ptr<KeyHistory> keyHistory;
-        {
-            std::vector<std::any> garbage;
-            std::lock_guard lock(mLock);
-
-            auto it = mHistory.find(key);
-            if (it == mHistory.end()) {
-                if (!isTrusted) return PERMISSION_DENIED;
-
-                (void)gc(garbage);
-
-                // We set the allowUid for client access on key creation.
-                int32_t allowUid = -1;
-                (void)item->get(AMEDIAMETRICS_PROP_ALLOWUID, &allowUid);
-                // no keylock needed here as we are sole owner
-                // until placed on mHistory.
-                keyHistory = std::make_shared<KeyHistory>(
-                    key, allowUid, time);
-                mHistory[key] = keyHistory;
-            } else {
-                keyHistory = it->second;
-            }
+        std::shared_ptr<KeyHistory> keyHistory = findKeyHistory(key, hash);
+        if (keyHistory == nullptr) {
+            if (!isTrusted) return PERMISSION_DENIED;
+
+            // We set the allowUid for client access on key creation.
+            int32_t allowUid = -1;
+            (void)item->get(AMEDIAMETRICS_PROP_ALLOWUID, &allowUid);
+            keyHistory = addKeyHistory(key, hash, allowUid, time);
         }
 
         // deferred contains remote properties (for other keys) to do later.
         std::vector<const mediametrics::Item::Prop *> deferred;
         {
             // handle local properties
-            std::lock_guard lock(getLockForKey(key));
+            std::lock_guard lock(getLockForKey(hash));
             if (!isTrusted) {
                 status_t status = keyHistory->checkPermission(item->getUid());
                 if (status != NO_ERROR) return status;
@@ -340,14 +454,10 @@ public:
             std::string remoteKey = name.substr(1, end - 1);
             std::string remoteName = name.substr(end + 1);
             if (remoteKey.size() == 0 || remoteName.size() == 0) continue;
-            std::shared_ptr<KeyHistory> remoteKeyHistory;
-            {
-                std::lock_guard lock(mLock);
-                auto it = mHistory.find(remoteKey);
-                if (it == mHistory.end()) continue;
-                remoteKeyHistory = it->second;
-            }
-            std::lock_guard lock(getLockForKey(remoteKey));
+            const size_t remoteHash = hashKey(remoteKey);
+            std::shared_ptr<KeyHistory> remoteKeyHistory = findKeyHistory(remoteKey, remoteHash);
+            if (remoteKeyHistory == nullptr) continue;
+            std::lock_guard lock(getLockForKey(remoteHash));
             remoteKeyHistory->putProp(remoteName, prop, time);
         }
         return NO_ERROR;
@@ -356,14 +466,10 @@ public:
     template <typename T>
     status_t get(const std::string &key, const std::string &property,
             T* value, int32_t uidCheck = -1, int64_t time = 0) const {
-        std::shared_ptr<KeyHistory> keyHistory;
-        {
-            std::lock_guard lock(mLock);
-            const auto it = mHistory.find(key);
-            if (it == mHistory.end()) return BAD_VALUE;
-            keyHistory = it->second;
-        }
-        std::lock_guard lock(getLockForKey(key));
+        const size_t hash = hashKey(key);
+        std::shared_ptr<KeyHistory> keyHistory = findKeyHistory(key, hash);
+        if (keyHistory == nullptr) return BAD_VALUE;
+        std::lock_guard lock(getLockForKey(hash));
         return keyHistory->checkPermission(uidCheck)
                 ?: keyHistory->getValue(property, value, time);
     }
@@ -417,16 +523,19 @@ public:
      *  Returns number of keys in the Time Machine.
      */
     size_t size() const {
-        std::lock_guard lock(mLock);
-        return mHistory.size();
+        return mKeyCount;
     }
 
     /**
      * Clears all properties from the Time Machine.
      */
     void clear() {
+        std::vector<std::any> garbage;
         std::lock_guard lock(mLock);
-        mHistory.clear();
+        for (size_t i = 0; i < kShards; ++i) {
+            garbage.emplace_back(publish(i, std::make_shared<History>()));
+        }
+        mKeyCount = 0;
         mGarbageCollectionCount = 0;
     }
 
@@ -444,17 +553,26 @@ public:
      */
     std::pair<std::string, int32_t> dump(
             int32_t lines = INT32_MAX, int64_t sinceNs = 0, const char *prefix = nullptr) const {
-        std::lock_guard lock(mLock);
+        // The shard snapshots keep the keys alive while we dump.
+        std::shared_ptr<const History> histories[kShards];
+        std::vector<std::pair<const std::string*, const KeyHistory*>> keys;
+        for (size_t i = 0; i < kShards; ++i) {
+            histories[i] = std::atomic_load(&mShards[i].mHistory);
+            for (const auto &[key, keyHistory] : *histories[i]) {
+                if (prefix != nullptr && !startsWith(key, prefix)) continue;
+                keys.emplace_back(&key, keyHistory.get());
+            }
+        }
+        std::sort(keys.begin(), keys.end(), [](const auto& a, const auto& b) {
+            return *a.first < *b.first;
+        });
+
         std::stringstream ss;
         int32_t ll = lines;
-
-        for (auto it = prefix != nullptr ? mHistory.lower_bound(prefix) : mHistory.begin();
-                it != mHistory.end();
-                ++it) {
+        for (const auto &[key, keyHistory] : keys) {
             if (ll <= 0) break;
-            if (prefix != nullptr && !startsWith(it->first, prefix)) break;
-            std::lock_guard lock2(getLockForKey(it->first));
-            auto [s, l] = it->second->dump(ll, sinceNs);
+            std::lock_guard lock(getLockForKey(*key));
+            auto [s, l] = keyHistory->dump(ll, sinceNs);
             ss << s;
             ll -= l;
         }
@@ -467,30 +585,76 @@ public:
 
 private:
 
+    static size_t hashKey(const std::string &key) {
+        return std::hash<std::string>{}(key);
+    }
+
     // Obtains the lock for a KeyHistory.
+    std::mutex &getLockForKey(size_t hash) const RETURN_CAPABILITY(mPseudoKeyHistoryLock) {
+        return mKeyLocks[hash % std::size(mKeyLocks)];
+    }
+
     std::mutex &getLockForKey(const std::string &key) const
             RETURN_CAPABILITY(mPseudoKeyHistoryLock) {
-        return mKeyLocks[std::hash<std::string>{}(key) % std::size(mKeyLocks)];
+        return getLockForKey(hashKey(key));
+    }
+
+    // The shard holding a key. Uses different hash bits than the key locks.
+    static size_t getShardForKey(size_t hash) {
+        return hash / KEY_LOCKS % kShards;
+    }
+
+    // Finds a KeyHistory without locking.  Returns nullptr if not found.
+    std::shared_ptr<KeyHistory> findKeyHistory(const std::string &key, size_t hash) const {
+        const auto history = std::atomic_load(&mShards[getShardForKey(hash)].mHistory);
+        const auto it = history->find(key);
+        return it == history->end() ? nullptr : it->second;
     }
 
     // Finds a KeyHistory from a URL.  Returns nullptr if not found.
+    // The longest key that is followed by a '.' in the URL is used.
     std::shared_ptr<KeyHistory> getKeyHistoryFromUrl(
             const std::string& url, std::string* key, std::string *prop) const {
+        for (size_t dot = url.rfind('.'); dot != std::string::npos && dot > 0;
+                dot = url.rfind('.', dot - 1)) {
+            std::string urlKey = url.substr(0, dot);
+            std::shared_ptr<KeyHistory> keyHistory = findKeyHistory(urlKey, hashKey(urlKey));
+            if (keyHistory != nullptr) {
+                if (prop) *prop = url.substr(dot + 1);
+                if (key) *key = std::move(urlKey);
+                return keyHistory;
+            }
+        }
+        return nullptr;
+    }
+
+    // Creates the KeyHistory for a key, unless another thread just did.
+    std::shared_ptr<KeyHistory> addKeyHistory(
+            const std::string &key, size_t hash, int32_t allowUid, int64_t time) {
+        std::vector<std::any> garbage;
         std::lock_guard lock(mLock);
 
-        auto it = mHistory.upper_bound(url);
-        if (it == mHistory.begin()) {
-           return nullptr;
-        }
-        --it;  // go to the actual key, if it exists.
+        const size_t shard = getShardForKey(hash);
+        const auto current = std::atomic_load(&mShards[shard].mHistory);
+        const auto it = current->find(key);
+        if (it != current->end()) return it->second;
+
+        (void)gc(garbage);
+
+        // no keylock needed here as we are sole owner
+        // until placed on mHistory.
+        auto keyHistory = std::make_shared<KeyHistory>(key, allowUid, time);
+        auto history = std::make_shared<History>(*std::atomic_load(&mShards[shard].mHistory));
+        history->emplace(key, keyHistory);
+        garbage.emplace_back(publish(shard, std::move(history)));
+        ++mKeyCount;
+        return keyHistory;
+    }
 
-        const std::string& itKey = it->first;
-        if (strncmp(itKey.c_str(), url.c_str(), itKey.size())) {
-            return nullptr;
-        }
-        if (key) *key = itKey;
-        if (prop) *prop = url.substr(itKey.size() + 1);
-        return it->second;
+    // Replaces the History of a shard, returning the previous one.
+    std::shared_ptr<const History> publish(size_t shard, std::shared_ptr<const History> history)
+            REQUIRES(mLock) {
+        return std::atomic_exchange(&mShards[shard].mHistory, std::move(history));
     }
 
     /**
@@ -506,44 +670,58 @@ private:
      */
     bool gc(std::vector<std::any>& garbage) REQUIRES(mLock) {
         // TODO: something better than this for garbage collection.
-        if (mHistory.size() < mKeyHighWaterMark) return false;
+        if (mKeyCount < mKeyHighWaterMark) return false;
 
-        // erase everything explicitly expired.
-        std::multimap<int64_t, std::string> accessList;
+        std::shared_ptr<History> histories[kShards];
+        // (last modification time, key, shard), ties are broken by key
+        // so the result does not depend on hashing.
+        std::vector<std::tuple<int64_t, std::string, size_t>> accessList;
         // use a stale vector with precise type to avoid type erasure overhead in garbage
         std::vector<std::shared_ptr<KeyHistory>> stale;
 
-        for (auto it = mHistory.begin(); it != mHistory.end();) {
-            const std::string& key = it->first;
-            std::shared_ptr<KeyHistory> &keyHist = it->second;
+        // erase everything explicitly expired.
+        size_t keys = 0;
+        for (size_t i = 0; i < kShards; ++i) {
+            histories[i] = std::make_shared<History>(*std::atomic_load(&mShards[i].mHistory));
+            for (auto it = histories[i]->begin(); it != histories[i]->end();) {
+                const std::string& key = it->first;
+                std::shared_ptr<KeyHistory> &keyHist = it->second;
+
+                std::lock_guard lock(getLockForKey(key));
+                int64_t expireTime = keyHist->getValue("_expire", -1 /* default */);
+                if (expireTime != -1) {
+                    stale.emplace_back(std::move(keyHist));
+                    it = histories[i]->erase(it);
+                } else {
+                    accessList.emplace_back(keyHist->getLastModificationTime(), key, i);
+                    ++it;
+                }
+            }
+            keys += histories[i]->size();
+        }
 
-            std::lock_guard lock(getLockForKey(it->first));
-            int64_t expireTime = keyHist->getValue("_expire", -1 /* default */);
-            if (expireTime != -1) {
+        if (keys > mKeyLowWaterMark) {
+            const size_t toDelete = keys - mKeyLowWaterMark;
+            std::partial_sort(accessList.begin(), accessList.begin() + toDelete,
+                    accessList.end());
+            for (size_t i = 0; i < toDelete; ++i) {
+                const auto &[time, key, shard] = accessList[i];
+                auto it = histories[shard]->find(key);
                 stale.emplace_back(std::move(it->second));
-                it = mHistory.erase(it);
-            } else {
-                accessList.emplace(keyHist->getLastModificationTime(), key);
-                ++it;
+                histories[shard]->erase(it);
             }
+            keys = mKeyLowWaterMark;
         }
 
-        if (mHistory.size() > mKeyLowWaterMark) {
-           const size_t toDelete = mHistory.size() - mKeyLowWaterMark;
-           auto it = accessList.begin();
-           for (size_t i = 0; i < toDelete; ++i) {
-               auto it2 = mHistory.find(it->second);
-               stale.emplace_back(std::move(it2->second));
-               mHistory.erase(it2);
-               ++it;
-           }
+        for (size_t i = 0; i < kShards; ++i) {
+            garbage.emplace_back(publish(i, std::move(histories[i])));
         }
+        mKeyCount = keys;
         garbage.emplace_back(std::move(accessList));
         garbage.emplace_back(std::move(stale));
 
         ALOGD("%s(%zu, %zu): key size:%zu",
-                __func__, mKeyLowWaterMark, mKeyHighWaterMark,
-                mHistory.size());
+                __func__, mKeyLowWaterMark, mKeyHighWaterMark, keys);
 
         ++mGarbageCollectionCount;
         return true;
@@ -557,9 +735,14 @@ private:
     /**
      * Locking Strategy
      *
-     * Each key in the History has a KeyHistory. To get a shared pointer to
-     * the KeyHistory requires a lookup of mHistory under mLock.  Once the shared
-     * pointer to KeyHistory is obtained, the mLock for mHistory can be released.
+     * The keys are spread over kShards shards by hash.  Each shard holds an
+     * immutable History map from key to KeyHistory, published through an
+     * atomic shared pointer.  Looking up a key (for put, get, and dump) loads
+     * the current map without taking a lock.
+     *
+     * Adding or removing keys (key creation, garbage collection, clear) is
+     * rare. It is serialized by mLock, and copies the affected shard's map,
+     * modifies the copy, and publishes it.  Sharding keeps these copies small.
      *
      * Once the shared pointer to the key's KeyHistory is obtained, the KeyHistory
      * can be locked for read and modification through the method getLockForKey().
@@ -569,13 +752,18 @@ private:
      *
      * Once the last shared pointer reference to KeyHistory is released, it is
      * destroyed.  This is done through the garbage collection method.
-     *
-     * This two level locking allows multiple threads to access the TimeMachine
-     * in parallel.
      */
 
-    mutable std::mutex mLock;           // Lock for mHistory
-    History mHistory GUARDED_BY(mLock);
+    static inline constexpr size_t kShards = 16;
+
+    struct Shard {
+        // Loaded with std::atomic_load, replaced with publish() under mLock.
+        std::shared_ptr<const History> mHistory = std::make_shared<const History>();
+    };
+
+    mutable std::mutex mLock;           // Serializes updates of the shards.
+    Shard mShards[kShards];
+    std::atomic<size_t> mKeyCount{};    // Updated under mLock.
 
     // KEY_LOCKS is the number of mutexes for keys.
     // It need not be a power of 2, but faster that way.
@@ -19,6 +19,7 @@
 
 #include <stdio.h>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
@@ -741,6 +742,73 @@ TEST(mediametrics_tests, time_machine_gc) {
   printf("After\n%s\n", timeMachine.dump().first.c_str());
 }
 
+TEST(mediametrics_tests, time_machine_history) {
+  auto item = std::make_shared<mediametrics::Item>("Key");
+  (*item).set("value", (int32_t)0)
+         .setTimestamp(1);
+
+  android::mediametrics::TimeMachine timeMachine;
+  ASSERT_EQ(NO_ERROR, timeMachine.put(item, true));
+
+  // Only the last 50 values are kept.
+  for (int32_t i = 1; i <= 120; ++i) {
+      ASSERT_EQ(NO_ERROR, timeMachine.put("Key.value", i, 100 + i));
+  }
+  int32_t i32;
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Key.value", &i32, -1, 100 + 70));
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1, 100 + 71));
+  ASSERT_EQ(71, i32);
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1));
+  ASSERT_EQ(120, i32);
+
+  // A late value is placed in time order.
+  ASSERT_EQ(NO_ERROR, timeMachine.put("Key.value", (int32_t)-1, 100 + 80));
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1, 100 + 79));
+  ASSERT_EQ(79, i32);
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1, 100 + 80));
+  ASSERT_EQ(-1, i32);
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1));
+  ASSERT_EQ(120, i32);
+
+  // Unchanged values are not recorded again.
+  ASSERT_EQ(NO_ERROR, timeMachine.put("Key.same", (int32_t)7, 300));
+  ASSERT_EQ(NO_ERROR, timeMachine.put("Key.same", (int32_t)7, 301));
+  ASSERT_EQ((size_t)1, countNewlines(timeMachine.dump(INT32_MAX, 300).first.c_str()));
+}
+
+TEST(mediametrics_tests, time_machine_multithread) {
+  android::mediametrics::TimeMachine timeMachine(100, 200);
+  std::atomic<bool> done{};
+  std::thread reader([&] {
+      while (!done) {
+          (void)timeMachine.dump(50);
+          int32_t i32;
+          (void)timeMachine.get("audio.track.1.state", &i32, -1);
+      }
+  });
+  std::vector<std::thread> writers;
+  for (int t = 0; t < 4; ++t) {
+      writers.emplace_back([&timeMachine, t] {
+          for (int i = 0; i < 2000; ++i) {
+              auto item = std::make_shared<mediametrics::Item>(
+                      "audio.track." + std::to_string((t * 97 + i) % 300));
+              (*item).set("state", (int32_t)(i % 3))
+                     .set("[audio.track.1]remote", (int32_t)t)
+                     .setTimestamp(i + 1);
+              ASSERT_EQ(NO_ERROR, timeMachine.put(item, true));
+          }
+      });
+  }
+  for (auto& writer : writers) {
+      writer.join();
+  }
+  done = true;
+  reader.join();
+
+  ASSERT_LE(timeMachine.size(), (size_t)200);
+  ASSERT_LT((size_t)0, timeMachine.getGarbageCollectionCount());
+}
+
 TEST(mediametrics_tests, transaction_log_gc) {
   auto item = std::make_shared<mediametrics::Item>("Key1");
   (*item).set("one", (int32_t)1)